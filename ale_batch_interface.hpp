@@ -0,0 +1,142 @@
+/* *****************************************************************************
+ * Xitari
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ * *****************************************************************************
+ *  ale_batch_interface.hpp
+ *
+ *  A batch of independent emulators running the same ROM, behind calls
+ *  that step or observe all of them at once.
+ **************************************************************************** */
+
+#ifndef __ALE_BATCH_INTERFACE_HPP__
+#define __ALE_BATCH_INTERFACE_HPP__
+
+#include "ale_interface.hpp"
+
+namespace ale {
+
+class M6502Lockstep;
+
+
+// Outcome of one act2() step of one environment of a batch
+struct ALEStepResult {
+    double rewardA;
+    double rewardB;
+    double sideBouncing;
+    bool wallBouncing;
+    int points;
+    bool crash;
+    bool serving;
+    bool gameOver;
+};
+
+
+// This class runs several copies of the same game side by side. Every call
+// steps all of them, and observations are gathered into contiguous arrays
+// indexed by environment, so an agent pays one call per batch instead of
+// one per environment. Each environment is an ordinary ALEInterface, and by
+// default each is stepped in turn by the usual emulator.
+//
+// With lockstep, act2() emulates the frames of all environments together
+// instead, on an M6502Lockstep whose lanes are their processors: the
+// environments at the same program counter execute each instruction one
+// after the other, and an environment that branches away runs on its own
+// processor until it meets the others again. The outcome is exactly that of
+// stepping them in turn. Everything else, stepUntil() included, still goes
+// through each environment in turn. Lockstep is experimental: every memory
+// access still goes to each environment's own devices, so a group shares
+// no work but the scheduling, and on Pong it runs slower than stepping in
+// turn.
+class ALEBatchInterface {
+
+    public:
+
+        /** Creates num_envs environments, each running rom_file. With
+            lockstep, act2() emulates them together, if their emulators
+            allow it (see lockstep()). */
+        ALEBatchInterface(const std::string &rom_file, int num_envs, bool lockstep = false);
+
+        /** Unloads the emulators. */
+        ~ALEBatchInterface();
+
+        /** Number of environments in the batch. */
+        int size() const { return static_cast<int>(m_envs.size()); }
+
+        /** Accesses a single environment of the batch. */
+        ALEInterface &env(int i) { return *m_envs[i]; }
+        const ALEInterface &env(int i) const { return *m_envs[i]; }
+
+        /** Whether act2() emulates the environments in lockstep. False unless
+            asked for, or when the emulator can't run them so (e.g. while its
+            ROM profiler is compiled in). */
+        bool lockstep() const { return m_lockstep.get() != NULL; }
+
+        /** Share of the instructions emulated in lockstep that ran together
+            with another environment rather than alone; 0 before any. */
+        double lockstepShare() const;
+
+        /** Resets every game. */
+        void resetGame();
+
+        /** Resets only the games that have ended; returns how many were reset. */
+        int resetEndedGames();
+
+        /** Applies actionsA[i] and actionsB[i] to environment i, for every i,
+            and stores the outcome in results[i]. results may be NULL. */
+        void act2(const Action *actionsA, const Action *actionsB, ALEStepResult *results);
+
+        /** Steps environment i with actionsA[i] and actionsB[i] until
+            condition holds for it (see ALEInterface::stepUntil()), for
+            every i, and stores what happened in results[i]. */
+        void stepUntil(const ALECondition &condition, const Action *actionsA,
+                       const Action *actionsB, int max_frames, ALEStepUntilResult *results);
+
+        /** Enables/disables screen rendering of every environment. */
+        void enableRendering(bool mode);
+
+        /** Copies the RAM of every environment into ram, which must hold
+            size() * 128 bytes; environment i starts at ram + i * 128. */
+        void getRAM(byte_t *ram) const;
+
+        /** Copies the game state of every environment into features, which
+            must hold size() entries, i.e. size() * ALEFeatures::SIZE floats. */
+        void getFeatures(ALEFeatures *features) const;
+
+        /** Size in bytes of the screen of a single environment. */
+        size_t screenSize() const;
+
+        /** Copies the screen of every environment into screens, which must
+            hold size() * screenSize() pixels. */
+        void getScreens(pixel_t *screens) const;
+
+    private:
+
+        /** Copying is explicitly disallowed. */
+        ALEBatchInterface(const ALEBatchInterface &);
+
+        /** Assignment is explicitly disallowed. */
+        ALEBatchInterface &operator=(const ALEBatchInterface &);
+
+        /** act2() with lockstep. */
+        void actLockstep(const Action *actionsA, const Action *actionsB,
+                         ALEStepResult *results);
+
+        std::vector<ALEInterface*> m_envs;
+        std::unique_ptr<M6502Lockstep> m_lockstep; // Set with lockstep
+};
+
+} // namespace ale
+
+#endif // __ALE_BATCH_INTERFACE_HPP__
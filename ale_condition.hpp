@@ -0,0 +1,84 @@
+/* *****************************************************************************
+ * Xitari
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ * *****************************************************************************
+ *  ale_condition.hpp
+ *
+ *  Conditions over the RAM and game state that ALEInterface::stepUntil()
+ *  steps until, compiled from expressions such as
+ *
+ *      phase == RALLY && ball_x >= 190
+ *      reward_a != 0 || (ram[0x94] & 0x80) != 0
+ *
+ *  Operands are numbers (decimal or 0x hexadecimal), ram[n] (the byte at
+ *  $80 + n, n taken modulo 128, so ram[0x94] is also $94), the ALEFeatures
+ *  ball_x, ball_y, ball_dx, ball_dy, paddle_a, paddle_b, score_a, score_b
+ *  and phase, the phases STOPPED, SERVING, RALLY and OVER, reward_a and
+ *  reward_b (of the latest frame), and frames (stepped so far). Operators,
+ *  loosest first: ||, &&, comparisons (== != < <= > >=), + -, * / % and
+ *  & (bitwise), unary - and !. Everything evaluates to a number; zero is
+ *  false, and x / 0 and x % 0 are zero. Parentheses and unary operators
+ *  nest at most 256 deep.
+ **************************************************************************** */
+
+#ifndef __ALE_CONDITION_HPP__
+#define __ALE_CONDITION_HPP__
+
+#include "ale_interface.hpp"
+
+namespace ale {
+
+
+// What a condition is evaluated on, after a frame
+struct ALEConditionInput {
+    const byte_t *ram;              // The 128 bytes of RAM
+    ALEFeatures features;
+    reward_t reward_a;
+    reward_t reward_b;
+    int frames;
+};
+
+
+class ALECondition {
+
+    public:
+
+        /** Compiles expression; throws std::invalid_argument, giving the
+            position of the problem, if it is malformed. */
+        explicit ALECondition(const std::string &expression);
+
+        /** Whether the condition holds for input. Doesn't allocate. */
+        bool evaluate(const ALEConditionInput &input) const;
+
+        /** The expression it was compiled from. */
+        const std::string &expression() const { return m_expression; }
+
+    private:
+
+        friend class ALEConditionParser;
+
+        // One instruction of the stack machine the expression compiles to
+        struct Op {
+            int code;
+            double value;           // Constant, or index into the RAM or the features
+        };
+
+        std::string m_expression;
+        std::vector<Op> m_program;  // Postfix
+};
+
+} // namespace ale
+
+#endif // __ALE_CONDITION_HPP__
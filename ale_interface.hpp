@@ -47,6 +47,7 @@ class Event;
 class Settings;
 struct RomSettings;
 class StellaEnvironment;
+class ALECondition;
 
 
 // Define possible actions
@@ -178,6 +179,100 @@ class ALERAM {
 };
 
 
+/** Game state decoded from RAM by the game's RomSettings after every frame:
+    a few numbers that an agent can learn from instead of the screen.
+    Positions are in the ROM's own units; games that don't decode their
+    state leave everything zero. */
+struct ALEFeatures {
+
+    // What the game is doing
+    enum Phase {
+        STOPPED = 0,            // Not running, e.g. while the ROM starts up
+        SERVING = 1,            // The ball is out of play, about to be served
+        RALLY   = 2,            // The ball is in play
+        OVER    = 3             // A player has won
+    };
+
+    // Indices of values
+    enum Index {
+        BALL_X,
+        BALL_Y,
+        BALL_DX,                // Ball movement over the last frame; zero
+        BALL_DY,                //   when it wasn't in play throughout
+        PADDLE_A,               // Paddle positions of players A (right) and
+        PADDLE_B,               //   B (left)
+        SCORE_A,
+        SCORE_B,
+        PHASE,                  // A Phase
+        SIZE
+    };
+
+    float values[SIZE];
+};
+
+
+/** An entry of the action script that ALEInterface::stepUntil() plays in a
+    loop: the actions of both players, held for a number of frames. */
+struct ALEScriptedAction {
+    Action actionA;
+    Action actionB;
+    int frames;
+};
+
+
+/** What happened during an ALEInterface::stepUntil(). */
+struct ALEStepUntilResult {
+    int frames;                 // Stepped
+    double rewardA;             // Summed over those frames
+    double rewardB;
+    bool reached;               // The condition held after the last frame
+    bool gameOver;
+};
+
+
+/** Where the time of stepping an environment went, since the stats were
+    last reset. Collected only by builds configured with XITARI_STEP_STATS
+    (cmake -DXITARI_STEP_STATS=ON); other builds leave enabled false and
+    everything zero. */
+struct ALEStepStats {
+
+    enum Stage {
+        CPU,            // 6502 execution (a frame update, less TIA rendering)
+        TIA_RENDER,     // TIA catching the frame up with the CPU
+        ROM_STEP,       // RomSettings::step
+        PROCESS_SCREEN,
+        PROCESS_RAM,
+        RESET,          // Whole resets, their frames included
+        SAVE_STATE,     // Saves and clones of the state
+        LOAD_STATE,     // Loads and restores of the state
+        NUM_STAGES
+    };
+
+    // One bucket of the step latency histogram
+    struct Bucket {
+        double upper;               // Seconds; steps in it took at most this
+        unsigned long long count;
+    };
+
+    ALEStepStats();
+
+    /** Name of a stage, e.g. "tia_render". */
+    static const char *stageName(int stage);
+
+    bool enabled;
+    double seconds[NUM_STAGES];
+    unsigned long long calls[NUM_STAGES];
+
+    // Latency of act() steps, in seconds
+    unsigned long long steps;
+    double step_seconds;            // Total
+    double step_p50;
+    double step_p99;
+    double step_max;
+    std::vector<Bucket> histogram;  // Non-empty buckets, shortest first
+};
+
+
 // This class provides a simplified interface to ALE.
 class ALEInterface {
 
@@ -206,14 +301,30 @@ class ALEInterface {
 
 	void act2(Action actionA,Action actionB,double* rewardA,double* rewardB,double* sideBouncing,bool* wallBouncing,int* points,bool* crash,bool* serving);
 
+        /** Steps with actionA and actionB until condition (see
+            ale_condition.hpp) holds after a frame, the game is over or
+            max_frames frames have been stepped, in one call. Each frame is
+            an act2() step of its own, so recordings and action logs see
+            every one of them. Screens are rendered as usual; disable
+            rendering if only the last one matters. */
+        ALEStepUntilResult stepUntil(const ALECondition &condition, Action actionA,
+                                     Action actionB, int max_frames);
+
+        /** The same, playing script in a loop; it starts over on each call.
+            Throws std::invalid_argument if script is empty or holds an
+            entry for less than a frame. */
+        ALEStepUntilResult stepUntil(const ALECondition &condition,
+                                     const std::vector<ALEScriptedAction> &script,
+                                     int max_frames);
+
 
         /** Returns the vector of legal actions. */
-        ActionVect getLegalActionSet();
-	ActionVect getLegalActionSetB(); 
+        const ActionVect &getLegalActionSet();
+	const ActionVect &getLegalActionSetB(); 
 
         /** Returns a vector describing the minimal set of actions needed to play current game. */
-        ActionVect getMinimalActionSet();
-        ActionVect getMinimalActionSetB();
+        const ActionVect &getMinimalActionSet();
+        const ActionVect &getMinimalActionSetB();
         /** Returns the frame number since the loading of the ROM. */
         int getFrameNumber() const;
 
@@ -236,12 +347,75 @@ class ALEInterface {
         /** Returns a handle to the current game screen. */
         const ALEScreen &getScreen() const;
 
+        /** Enables/disables screen rendering. Disabling it speeds up frames whose screen
+            is never looked at (e.g. skipped frames, RAM-only agents) without changing
+            the emulation; getScreen() is not updated while rendering is disabled. */
+        void enableRendering(bool mode);
+
         /** Writes the screen out to a PNG. */
         bool screenToPNG(const std::string &filename);
 
+        /** Records every following act()/act2() step, with the RAM and, if
+            screens is set, the screen, to a trajectory file (see
+            environment/trajectory_recorder.hpp). Compression and disk
+            writes happen on a background thread. Screens of steps taken
+            with rendering disabled are stale. Throws std::runtime_error if
+            the file can't be created, or the previous recording couldn't
+            be written out. */
+        void startRecording(const std::string &filename, bool screens = false);
+
+        /** Flushes and closes the trajectory file, if recording. Throws
+            std::runtime_error if it couldn't be written out. */
+        void stopRecording();
+
+        /** Logs the actions of every following act()/act2() step to an
+            action log (see environment/action_log.hpp), from which
+            ReplayController re-emulates the run exactly. Resets and
+            restores log the resulting state; every checksum_interval steps
+            a checksum of the RAM and rewards is logged, to catch replays
+            that diverge. Throws std::runtime_error if the file can't be
+            created, or the previous log couldn't be written out. */
+        void startActionLog(const std::string &filename, int checksum_interval = 60);
+
+        /** Closes the action log, if logging. Throws std::runtime_error if
+            it couldn't be written out. */
+        void stopActionLog();
+
+        /** Time spent in each stage of the steps, resets and state saves
+            since the last resetStepStats() (see ALEStepStats). */
+        ALEStepStats getStepStats() const;
+
+        /** Clears the step stats. */
+        void resetStepStats();
+
+        /** Starts recording a timeline of every environment in the process
+            (steps, resets, state saves and loads, and observations, by
+            environment and by thread) to filename, as a Chrome trace. Each
+            thread buffers its own events; they only reach the file on
+            flushTrace() or stopTrace(), so call flushTrace() regularly on
+            long runs. Throws std::runtime_error if the file can't be
+            created. */
+        static void startTrace(const std::string &filename);
+
+        /** Writes the events buffered so far to the trace file. */
+        static void flushTrace();
+
+        /** Stops recording and closes the trace file. */
+        static void stopTrace();
+
         /** Access the current emulator memory state. */
         const ALERAM &getRAM() const;
 
+        /** The emulator's RAM itself, getRAM().size() bytes, without copying.
+            It stays valid as long as this interface and is always up to date
+            (e.g. right after loadState()); copy it to keep an observation. */
+        const byte_t *getRAMView() const;
+
+        /** The game state after the latest frame, as decoded by the game's
+            RomSettings (see ALEFeatures). Like getRAM(), it is updated by
+            steps and resets, not by loading a state. */
+        void getFeatures(ALEFeatures &features) const;
+
         /** Saves the state of the emulator system, overwriting any 
             previously saved state. */
         void saveState();
@@ -281,6 +455,13 @@ class ALEInterface {
         /** Assignment is explicitly disallowed. */
         ALEInterface &operator=(const ALEInterface &);
 
+        /** ALEBatchInterface can emulate the frames of its interfaces together,
+            running act2() in parts: the environment's beginAct() and endAct()
+            around the frame, then finishAct2() for the rest. */
+        friend class ALEBatchInterface;
+        StellaEnvironment &environment();
+        void finishAct2(Action actionA,Action actionB,double* rewardA,double* rewardB,double* sideBouncing,bool* wallBouncing,int* points,bool* crash,bool* serving);
+
         class Impl;
         Impl *m_pimpl;
 };
@@ -0,0 +1,183 @@
+/* *****************************************************************************
+ * Xitari
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ * *****************************************************************************
+ *  ale_batch_check.cpp
+ *
+ *  Determinism check of ALEBatchInterface in lockstep.
+ *
+ *  Usage: ale_batch_check [-envs n] [-frames n] [-seed n] romfile
+ *
+ *  Plays n environments (8) for n frames (3000) through a lockstep batch
+ *  and, next to it, through as many independent ALEInterfaces, with seeded
+ *  random actions per environment. Ended games are reset, and some
+ *  environments are reset or sent back to a snapshot along the way, so
+ *  that they drift apart. After every step the outcome, RAM and screen of
+ *  each environment must match its independent twin, and so must their
+ *  snapshots every 100 frames. Some instructions must have run in groups.
+ *  Prints the share of those and the frame rate of either side.
+ *  The exit status is 1 if any check fails.
+ **************************************************************************** */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "ale_batch_interface.hpp"
+
+using namespace ale;
+
+
+struct Options {
+    int envs;
+    int frames;
+    unsigned seed;
+};
+
+
+static int s_failures = 0;
+
+static void fail(int env, int frame, const std::string &what) {
+    if (s_failures++ < 20)
+        printf("environment %d, frame %d: FAIL, %s\n", env, frame, what.c_str());
+}
+
+
+static void compare(int env, int frame, const ALEStepResult &batch, const ALEStepResult &alone) {
+    if (batch.rewardA != alone.rewardA || batch.rewardB != alone.rewardB)
+        fail(env, frame, "the rewards differ");
+    // While crashed, the Pong settings leave the other events as they were,
+    // which is uninitialized until the first frame without a crash
+    if (batch.crash != alone.crash)
+        fail(env, frame, "the events differ");
+    else if (!batch.crash && (batch.sideBouncing != alone.sideBouncing ||
+                              batch.wallBouncing != alone.wallBouncing ||
+                              batch.points != alone.points || batch.serving != alone.serving))
+        fail(env, frame, "the events differ");
+    if (batch.gameOver != alone.gameOver)
+        fail(env, frame, "the game ends on one side only");
+}
+
+
+static void usage() {
+    fprintf(stderr, "Usage: ale_batch_check [-envs n] [-frames n] [-seed n] romfile\n");
+    exit(1);
+}
+
+
+int main(int argc, char *argv[]) {
+    Options options;
+    options.envs = 8;
+    options.frames = 3000;
+    options.seed = 0;
+
+    std::string rom_file;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg[0] != '-') rom_file = arg;
+        else if (i + 1 >= argc) usage();
+        else if (arg == "-envs") options.envs = std::max(2, atoi(argv[++i]));
+        else if (arg == "-frames") options.frames = std::max(8, atoi(argv[++i]));
+        else if (arg == "-seed") options.seed = strtoul(argv[++i], NULL, 10);
+        else usage();
+    }
+    if (rom_file.empty()) usage();
+
+    try {
+        const int n = options.envs;
+        ALEBatchInterface batch(rom_file, n, true);
+        if (!batch.lockstep())
+            throw std::runtime_error("This build can't run the batch in lockstep");
+
+        std::vector<std::unique_ptr<ALEInterface> > alone;
+        std::vector<std::mt19937> rngs;
+        for (int i = 0; i < n; i++) {
+            alone.emplace_back(new ALEInterface(rom_file));
+            rngs.push_back(std::mt19937(options.seed + i));
+        }
+        const ActionVect &actions_a = alone[0]->getMinimalActionSet();
+        const ActionVect &actions_b = alone[0]->getMinimalActionSetB();
+
+        std::vector<Action> batch_a(n), batch_b(n);
+        std::vector<ALEStepResult> results(n);
+        std::vector<std::string> snapshots(n);
+        std::chrono::steady_clock::duration batch_time(0), alone_time(0);
+
+        for (int f = 0; f < options.frames; f++) {
+            for (int i = 0; i < n; i++) {
+                // Every third environment starts over a quarter in, and every
+                // other one goes back from two thirds to a third
+                bool reset = batch.env(i).gameOver() || (f == options.frames / 4 && i % 3 == 0);
+                if (reset) {
+                    batch.env(i).resetGame();
+                    alone[i]->resetGame();
+                }
+                if (f == options.frames / 3 && i % 2 == 1)
+                    snapshots[i] = alone[i]->getSnapshot();
+                if (f == options.frames * 2 / 3 && i % 2 == 1) {
+                    batch.env(i).restoreSnapshot(snapshots[i]);
+                    alone[i]->restoreSnapshot(snapshots[i]);
+                }
+                batch_a[i] = actions_a[rngs[i]() % actions_a.size()];
+                batch_b[i] = actions_b[rngs[i]() % actions_b.size()];
+            }
+
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            batch.act2(&batch_a[0], &batch_b[0], &results[0]);
+            std::chrono::steady_clock::time_point middle = std::chrono::steady_clock::now();
+            std::vector<ALEStepResult> expected(n);
+            for (int i = 0; i < n; i++) {
+                ALEStepResult &r = expected[i];
+                alone[i]->act2(batch_a[i], batch_b[i], &r.rewardA, &r.rewardB, &r.sideBouncing,
+                               &r.wallBouncing, &r.points, &r.crash, &r.serving);
+                r.gameOver = alone[i]->gameOver();
+            }
+            alone_time += std::chrono::steady_clock::now() - middle;
+            batch_time += middle - start;
+
+            for (int i = 0; i < n; i++) {
+                compare(i, f, results[i], expected[i]);
+                if (!batch.env(i).getRAM().equals(alone[i]->getRAM()))
+                    fail(i, f, "the RAM differs");
+                if (!batch.env(i).getScreen().equals(alone[i]->getScreen()))
+                    fail(i, f, "the screen differs");
+                if (f % 100 == 99 && batch.env(i).getSnapshot() != alone[i]->getSnapshot())
+                    fail(i, f, "the snapshots differ");
+            }
+        }
+
+        double share = batch.lockstepShare();
+        if (share <= 0)
+            fail(-1, options.frames, "no instruction ran in a group");
+        double frames = static_cast<double>(options.frames) * n;
+        printf("grouped: %.1f%% of instructions\n", share * 100);
+        printf("lockstep: %.0f frames/s, alone: %.0f frames/s\n",
+               frames / std::chrono::duration<double>(batch_time).count(),
+               frames / std::chrono::duration<double>(alone_time).count());
+    } catch (const std::exception &e) {
+        fprintf(stderr, "Error: %s\n", e.what());
+        s_failures++;
+    }
+
+    printf("%s\n", s_failures == 0 ? "PASS" : "FAIL");
+    return s_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,531 @@
+/* *****************************************************************************
+ * Xitari
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ * *****************************************************************************
+ *  ale_bench.cpp
+ *
+ *  Micro-benchmarks of the emulation hot paths, reported as JSON so that
+ *  runs can be compared across releases.
+ *
+ *  Usage: ale_bench [-repeats n] [-min_time seconds] [-filter substring]
+ *                   [-threads n] [-output file] romfile
+ *
+ *  Each benchmark is calibrated to run for at least min_time seconds, then
+ *  timed repeats times; the median repeat is reported. Where the kernel
+ *  allows it, hardware counters (perf_event) are reported per operation,
+ *  for the calling thread.
+ *
+ *  tia_update/cpu_low/threads_n updates n emulators at once, one per thread
+ *  (n is the number of cores unless -threads says otherwise), to show how
+ *  the emulation scales when instances share caches: its frames_per_sec is
+ *  the total over all of them.
+ *
+ *  Heap allocations are counted per operation too, through the global
+ *  operator new. The steady-state step and observation paths must not
+ *  allocate: if a benchmark marked allocation-free does, ale_bench exits
+ *  with status 1.
+ **************************************************************************** */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <new>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "ale_interface.hpp"
+#include "ale_condition.hpp"
+#include "bench/emulator.hpp"
+#include "environment/phosphor_blend.hpp"
+#include "environment/stella_environment.hpp"
+
+namespace ale {
+
+// Reaches the private stages of a StellaEnvironment
+class StellaEnvironmentBench {
+  public:
+    static void processScreen(StellaEnvironment &env) { env.processScreen(); }
+    static void processRAM(StellaEnvironment &env) { env.processRAM(); }
+};
+
+} // namespace ale
+
+using namespace ale;
+
+
+// Hardware counters of the calling thread, if perf_event lets us have them
+class PerfCounters {
+  public:
+    static const int NUM_COUNTERS = 4;
+
+    PerfCounters() : m_leader(-1) {
+#ifdef __linux__
+        static const ::uint64_t configs[NUM_COUNTERS] = {
+            PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+            PERF_COUNT_HW_BRANCH_MISSES, PERF_COUNT_HW_CACHE_MISSES
+        };
+        for (int i = 0; i < NUM_COUNTERS; i++) {
+            struct perf_event_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = configs[i];
+            attr.disabled = (i == 0);
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP;
+            int fd = syscall(__NR_perf_event_open, &attr, 0, -1, m_leader, 0);
+            if (fd < 0) {
+                close();
+                return;
+            }
+            if (m_leader < 0) m_leader = fd;
+            m_fds.push_back(fd);
+        }
+#endif
+    }
+
+    ~PerfCounters() { close(); }
+
+    bool available() const { return m_leader >= 0; }
+
+    static const char *name(int i) {
+        static const char *names[NUM_COUNTERS] = {
+            "cycles", "instructions", "branch_misses", "cache_misses"
+        };
+        return names[i];
+    }
+
+    void start() {
+#ifdef __linux__
+        if (!available()) return;
+        ioctl(m_leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(m_leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+    }
+
+    /** Stops counting and adds the counts to totals. */
+    void stop(double *totals) {
+#ifdef __linux__
+        if (!available()) return;
+        ioctl(m_leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+        ::uint64_t values[1 + NUM_COUNTERS];
+        if (read(m_leader, values, sizeof(values)) == (ssize_t)sizeof(values)) {
+            for (int i = 0; i < NUM_COUNTERS; i++)
+                totals[i] += values[1 + i];
+        }
+#endif
+    }
+
+  private:
+    void close() {
+#ifdef __linux__
+        for (size_t i = 0; i < m_fds.size(); i++)
+            ::close(m_fds[i]);
+#endif
+        m_fds.clear();
+        m_leader = -1;
+    }
+
+    int m_leader;
+    std::vector<int> m_fds;
+};
+
+
+// Every heap allocation the process makes
+static std::atomic<unsigned long long> s_allocations(0);
+
+// All kept out of line: inlined into their callers, the malloc() and free()
+// inside get paired with the other side's operator, and GCC warns of a mismatch
+#ifdef __GNUC__
+#define OUT_OF_LINE __attribute__((noinline))
+#else
+#define OUT_OF_LINE
+#endif
+
+OUT_OF_LINE void *operator new(size_t size) {
+    s_allocations.fetch_add(1, std::memory_order_relaxed);
+    void *p = malloc(size > 0 ? size : 1);
+    if (p == NULL) throw std::bad_alloc();
+    return p;
+}
+
+OUT_OF_LINE void *operator new[](size_t size) {
+    return operator new(size);
+}
+
+OUT_OF_LINE void operator delete(void *p) noexcept {
+    free(p);
+}
+
+OUT_OF_LINE void operator delete(void *p, size_t) noexcept {
+    free(p);
+}
+
+OUT_OF_LINE void operator delete[](void *p) noexcept {
+    free(p);
+}
+
+OUT_OF_LINE void operator delete[](void *p, size_t) noexcept {
+    free(p);
+}
+
+
+struct Benchmark {
+    std::string name;
+    int frames_per_op;              // Emulated frames per operation, if any
+    bool allocation_free;           // Fails the run if it allocates
+    std::function<void()> op;
+};
+
+
+struct Options {
+    int repeats;
+    double min_time;
+    int threads;
+    std::string filter;
+    std::string output;
+    std::string rom_file;
+};
+
+
+// Emulators updated side by side, each on a thread of its own. The calling
+// thread updates the first one, so that n emulators take n - 1 threads.
+class ThreadedUpdate {
+  public:
+    // Frames each emulator runs per call, to keep the hand-offs out of the timings
+    static const int FRAMES_PER_RUN = 10;
+
+    ThreadedUpdate(const std::string &rom_file, const std::vector<std::string> &settings,
+                   int num_threads) :
+        m_generation(0),
+        m_pending(0),
+        m_stopping(false) {
+        for (int i = 0; i < num_threads; i++)
+            m_emulators.push_back(new Emulator(rom_file, settings));
+        for (int i = 1; i < num_threads; i++)
+            m_threads.push_back(std::thread(&ThreadedUpdate::work, this, i));
+    }
+
+    ~ThreadedUpdate() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_work_ready.notify_all();
+        for (size_t i = 0; i < m_threads.size(); i++)
+            m_threads[i].join();
+        for (size_t i = 0; i < m_emulators.size(); i++)
+            delete m_emulators[i];
+    }
+
+    int size() const { return static_cast<int>(m_emulators.size()); }
+
+    /** Runs FRAMES_PER_RUN frames on every emulator, and waits for them all. */
+    void run() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_generation++;
+            m_pending = m_threads.size();
+        }
+        m_work_ready.notify_all();
+        update(0);
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_work_done.wait(lock, [this]() { return m_pending == 0; });
+    }
+
+  private:
+    void update(size_t i) {
+        for (int f = 0; f < FRAMES_PER_RUN; f++)
+            m_emulators[i]->media().update();
+    }
+
+    void work(size_t i) {
+        unsigned long generation = 0;
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (true) {
+            m_work_ready.wait(lock, [&]() { return m_stopping || m_generation != generation; });
+            if (m_stopping) return;
+            generation = m_generation;
+            lock.unlock();
+            update(i);
+            lock.lock();
+            if (--m_pending == 0) m_work_done.notify_one();
+        }
+    }
+
+    std::vector<Emulator*> m_emulators;
+    std::vector<std::thread> m_threads;
+    std::mutex m_mutex;
+    std::condition_variable m_work_ready;
+    std::condition_variable m_work_done;
+    unsigned long m_generation;     // Bumped by every run()
+    size_t m_pending;               // Threads yet to finish the current run
+    bool m_stopping;
+};
+
+
+static std::string jsonString(const std::string &s) {
+    std::string out = "\"";
+    for (size_t i = 0; i < s.size(); i++) {
+        if (s[i] == '"' || s[i] == '\\') out += '\\';
+        out += s[i];
+    }
+    return out + "\"";
+}
+
+
+static double now() {
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+static double timeOps(const Benchmark &bench, long ops) {
+    double start = now();
+    for (long i = 0; i < ops; i++)
+        bench.op();
+    return now() - start;
+}
+
+
+// Runs one benchmark and appends its JSON object to json; returns false if
+// it is allocation-free but allocated
+static bool runBenchmark(const Benchmark &bench, const Options &options,
+                         PerfCounters &counters, std::string &json) {
+    // Calibrate: double the count until a run takes a tenth of min_time
+    long ops = 1;
+    double elapsed;
+    while ((elapsed = timeOps(bench, ops)) < options.min_time / 10 && ops < (1L << 40))
+        ops *= 2;
+    ops = std::max(1L, static_cast<long>(ops * options.min_time / std::max(elapsed, 1e-9)));
+
+    std::vector<double> ns_per_op;
+    ns_per_op.reserve(options.repeats);     // So that only the benchmark allocates
+    double totals[PerfCounters::NUM_COUNTERS] = { 0 };
+    unsigned long long allocations = s_allocations.load();
+    for (int r = 0; r < options.repeats; r++) {
+        counters.start();
+        elapsed = timeOps(bench, ops);
+        counters.stop(totals);
+        ns_per_op.push_back(elapsed * 1e9 / ops);
+    }
+    allocations = s_allocations.load() - allocations;
+    double allocations_per_op = allocations / (double(ops) * options.repeats);
+    std::sort(ns_per_op.begin(), ns_per_op.end());
+    double median = ns_per_op[ns_per_op.size() / 2];
+
+    char buffer[512];
+    snprintf(buffer, sizeof(buffer),
+             "    {\"name\": \"%s\", \"iterations\": %ld, \"repeats\": %d, "
+             "\"ns_per_op\": %.2f, \"min_ns_per_op\": %.2f, \"max_ns_per_op\": %.2f, "
+             "\"allocations_per_op\": %.4g",
+             bench.name.c_str(), ops, options.repeats, median,
+             ns_per_op.front(), ns_per_op.back(), allocations_per_op);
+    json += buffer;
+    if (bench.frames_per_op > 0) {
+        snprintf(buffer, sizeof(buffer), ", \"frames_per_sec\": %.1f",
+                 bench.frames_per_op * 1e9 / median);
+        json += buffer;
+    }
+    if (counters.available()) {
+        json += ", \"counters\": {";
+        for (int i = 0; i < PerfCounters::NUM_COUNTERS; i++) {
+            snprintf(buffer, sizeof(buffer), "%s\"%s_per_op\": %.1f", i > 0 ? ", " : "",
+                     PerfCounters::name(i), totals[i] / (double(ops) * options.repeats));
+            json += buffer;
+        }
+        json += "}";
+    }
+    json += "}";
+
+    bool failed = bench.allocation_free && allocations > 0;
+    fprintf(stderr, "%-40s %12.1f ns/op %10.4g allocs/op%s\n", bench.name.c_str(), median,
+            allocations_per_op, failed ? "  FAIL: must not allocate" : "");
+    return !failed;
+}
+
+
+static void usage() {
+    fprintf(stderr, "Usage: ale_bench [-repeats n] [-min_time seconds] "
+                    "[-filter substring] [-threads n] [-output file] romfile\n");
+    exit(1);
+}
+
+
+int main(int argc, char *argv[]) {
+    Options options;
+    options.repeats = 5;
+    options.min_time = 0.2;
+    options.threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg[0] != '-') {
+            options.rom_file = arg;
+            continue;
+        }
+        if (i + 1 >= argc) usage();
+        if (arg == "-repeats") options.repeats = std::max(1, atoi(argv[++i]));
+        else if (arg == "-min_time") options.min_time = atof(argv[++i]);
+        else if (arg == "-filter") options.filter = argv[++i];
+        else if (arg == "-threads") options.threads = std::max(1, atoi(argv[++i]));
+        else if (arg == "-output") options.output = argv[++i];
+        else usage();
+    }
+    if (options.rom_file.empty()) usage();
+
+    bool passed = true;
+    try {
+        // One emulator per CPU core and TIA update mode
+        std::vector<std::string> low, high, low_fast, high_fast;
+        low.push_back("-cpu"); low.push_back("low");
+        high.push_back("-cpu"); high.push_back("high");
+        low_fast = low; low_fast.push_back("-fast_tia_update"); low_fast.push_back("true");
+        high_fast = high; high_fast.push_back("-fast_tia_update"); high_fast.push_back("true");
+        Emulator emu_low(options.rom_file, low), emu_high(options.rom_file, high);
+        Emulator emu_low_fast(options.rom_file, low_fast), emu_high_fast(options.rom_file, high_fast);
+        ThreadedUpdate threaded(options.rom_file, low, options.threads);
+        char threaded_name[64];
+        snprintf(threaded_name, sizeof(threaded_name), "tia_update/cpu_low/threads_%d",
+                 threaded.size());
+
+        ALEInterface ale(options.rom_file);
+        PhosphorBlend blend(emu_low.osystem);
+        ALEScreen screen(ale.getScreen());
+        ALEState *state = emu_low.environment->cloneState();
+        std::string snapshot = ale.getSnapshot();
+        int step = 0;
+
+        // Steps the interface, turning the paddles now and then
+        std::function<void()> act2 = [&]() {
+            double reward_a, reward_b, side_bouncing;
+            bool wall_bouncing, crash, serving;
+            int points;
+            Action a = (Action)(PLAYER_A_UP + (step / 8) % 2 * 3);
+            Action b = (Action)(PLAYER_B_UP + (step / 12) % 2 * 3);
+            ale.act2(a, b, &reward_a, &reward_b, &side_bouncing, &wall_bouncing,
+                     &points, &crash, &serving);
+            if (ale.gameOver()) ale.resetGame();
+            step++;
+        };
+
+        // Reads everything an agent observes after a step
+        volatile long observed = 0;
+        std::function<void()> observe = [&]() {
+            observed += ale.getScreen().getArray()[0] + ale.getRAM().get(0) + ale.lives() +
+                        ale.livesB() + ale.gameOver() + ale.getEpisodeFrameNumber() +
+                        ale.getMinimalActionSet().size() + ale.getMinimalActionSetB().size();
+        };
+
+        // A second of steps in one call, checking a typical condition every frame
+        ALECondition condition("frames >= 60 || (ram[0x90] == 0xFF && phase == RALLY)");
+        std::function<void()> step_until = [&]() {
+            ale.stepUntil(condition, PLAYER_A_UP, PLAYER_B_DOWN, 60);
+            if (ale.gameOver()) ale.resetGame();
+        };
+
+        // Snapshots and states are strings, so saving and loading allocate
+        std::vector<Benchmark> benchmarks = {
+            { "tia_update/cpu_low", 1, true, [&]() { emu_low.media().update(); } },
+            { "tia_update/cpu_high", 1, true, [&]() { emu_high.media().update(); } },
+            { "tia_update/cpu_low/fast_tia_update", 1, true, [&]() { emu_low_fast.media().update(); } },
+            { "tia_update/cpu_high/fast_tia_update", 1, true, [&]() { emu_high_fast.media().update(); } },
+            { "tia_update/cpu_low/no_render", 1, true, [&]() {
+                emu_low.media().enableRendering(false);
+                emu_low.media().update();
+                emu_low.media().enableRendering(true);
+            } },
+            { threaded_name, threaded.size() * ThreadedUpdate::FRAMES_PER_RUN, true,
+              [&]() { threaded.run(); } },
+            { "phosphor_blend/process", 0, true, [&]() { blend.process(screen); } },
+            { "environment/process_screen", 0, true, [&]() {
+                StellaEnvironmentBench::processScreen(*emu_low.environment);
+            } },
+            { "environment/process_ram", 0, true, [&]() {
+                StellaEnvironmentBench::processRAM(*emu_low.environment);
+            } },
+            { "environment/reset", 0, true, [&]() { emu_low.environment->reset(); } },
+            { "ale_state/save", 0, false, [&]() {
+                emu_low.environment->destroyState(emu_low.environment->cloneState());
+            } },
+            { "ale_state/load", 0, false, [&]() { emu_low.environment->restoreState(*state); } },
+            { "ale_interface/get_snapshot", 0, false, [&]() { snapshot = ale.getSnapshot(); } },
+            { "ale_interface/restore_snapshot", 0, false, [&]() { ale.restoreSnapshot(snapshot); } },
+            { "ale_interface/act2", 1, true, act2 },
+            { "ale_interface/act2/no_render", 1, true, [&]() {
+                ale.enableRendering(false);
+                act2();
+                ale.enableRendering(true);
+            } },
+            { "ale_interface/observe", 0, true, observe },
+            { "ale_interface/step_until", 60, true, step_until },
+        };
+
+        PerfCounters counters;
+        std::string json = "{\n  \"context\": {\"rom\": " + jsonString(options.rom_file) + ", ";
+        char buffer[128];
+        snprintf(buffer, sizeof(buffer), "\"repeats\": %d, \"min_time\": %g, \"threads\": %d, "
+                 "\"perf_counters\": %s},\n",
+                 options.repeats, options.min_time, options.threads, counters.available() ? "true" : "false");
+        json += buffer;
+        json += "  \"benchmarks\": [\n";
+
+        bool first = true;
+        for (size_t i = 0; i < benchmarks.size(); i++) {
+            if (benchmarks[i].name.find(options.filter) == std::string::npos)
+                continue;
+            if (!first) json += ",\n";
+            first = false;
+            passed = runBenchmark(benchmarks[i], options, counters, json) && passed;
+        }
+        json += "\n  ]\n}\n";
+
+        emu_low.environment->destroyState(state);
+
+        if (options.output.empty()) {
+            fputs(json.c_str(), stdout);
+        } else {
+            FILE *file = fopen(options.output.c_str(), "w");
+            if (file == NULL) {
+                fprintf(stderr, "Cannot write %s\n", options.output.c_str());
+                return 1;
+            }
+            fputs(json.c_str(), file);
+            fclose(file);
+        }
+    } catch (std::exception &e) {
+        fprintf(stderr, "error: %s\n", e.what());
+        return 1;
+    }
+
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,217 @@
+/* *****************************************************************************
+ * Xitari
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ * *****************************************************************************
+ *  ale_condition_check.cpp
+ *
+ *  Check of the condition expressions ALEInterface::stepUntil() runs.
+ *
+ *  Usage: ale_condition_check
+ *
+ *  Compiles and evaluates a table of expressions over a fixed RAM and
+ *  feature set, covering every operand and operator, precedence, the
+ *  lookahead that tells & from && and ! from !=, hex literals, the folding
+ *  of ram[n] and division by zero. Then compiles malformed expressions,
+ *  which must throw std::invalid_argument with the documented message and
+ *  position, and nests expressions up to and past the nesting limit. No ROM
+ *  is needed. The exit status is 1 if any check fails.
+ **************************************************************************** */
+
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "ale_condition.hpp"
+
+using namespace ale;
+
+
+// Deepest parentheses and unary operators may nest (see ale_condition.hpp)
+static const int MAX_NESTING = 256;
+
+
+static int s_failures = 0;
+
+static void fail(const std::string &expression, const std::string &what) {
+    if (s_failures++ < 20)
+        printf("'%.60s': FAIL, %s\n", expression.c_str(), what.c_str());
+}
+
+
+// Expressions and whether they hold over the input built in main()
+static const struct {
+    const char *expression;
+    bool holds;
+} s_evaluations[] = {
+    // Arithmetic, precedence and associativity
+    { "1 + 2 * 3 == 7", true },
+    { "(1 + 2) * 3 == 9", true },
+    { "10 - 4 - 3 == 3", true },
+    { "8 / 2 / 2 == 2", true },
+    { "7 % 4 == 3", true },
+    { "1.5 * 2 == 3", true },
+    { "-3 + 5 == 2", true },
+    { "--3 == 3", true },
+    { "2 - -1 == 3", true },
+    { "7 / 0 == 0", true },
+    { "7 % 0 == 0", true },
+    { "0x10 == 16 && 0X1f == 31 && 0xff == 255", true },
+    // & binds like *, tighter than comparisons and &&
+    { "6 & 3 == 2", true },
+    { "6&3&&1", true },
+    { "4 & 3 && 1", false },
+    { "4 & 3", false },
+    // Comparisons, and ! apart from !=
+    { "1 != 2", true },
+    { "1!=1", false },
+    { "1 < 2 && 2 <= 2 && 3 > 2 && 3 >= 3", true },
+    { "2 >= 3", false },
+    { "!0", true },
+    { "!1", false },
+    { "!!5", true },
+    { "!(1 != 1)", true },
+    { "-!0 == -1", true },
+    // || is looser than &&
+    { "1 || 0 && 0", true },
+    { "(1 || 0) && 0", false },
+    { "0 || 0", false },
+    { "0", false },
+    { "0.5", true },
+    // RAM, folded modulo 128
+    { "ram[0x14] == 40", true },
+    { "ram[20] == 40", true },
+    { "ram[0x94] == ram[0x14]", true },
+    { "ram[0x7F] == 254", true },
+    { "(ram[0x10] & 0x80) != 0", false },
+    // Features, phases, rewards and frames
+    { "ball_x == 100 && ball_y == 50 && ball_dx == -2 && ball_dy == 1", true },
+    { "paddle_a == 30 && paddle_b == 40", true },
+    { "score_a == 3 && score_b == 5", true },
+    { "phase == RALLY", true },
+    { "phase == SERVING", false },
+    { "STOPPED == 0 && SERVING == 1 && RALLY == 2 && OVER == 3", true },
+    { "reward_a == 1 && reward_b == -1", true },
+    { "frames == 42", true },
+    { "  ball_x>=190||frames>=42  ", true },
+};
+
+
+// Malformed expressions and the message they must throw
+static const struct {
+    const char *expression;
+    const char *message;
+} s_errors[] = {
+    { "", "expected an operand at position 1" },
+    { "1 +", "expected an operand at position 4" },
+    { "(1 + 2", "expected ')' at position 7" },
+    { "ram[x]", "expected a RAM address at position 5" },
+    { "ram[1", "expected ']' at position 6" },
+    { "ram 1", "expected '[' at position 5" },
+    { "foo == 1", "unknown operand 'foo' at position 1" },
+    { "1 2", "unexpected character at position 3" },
+    { "1 = 2", "unexpected character at position 3" },
+    { "1 == 2 == 3", "unexpected character at position 8" },
+    { "1 &&", "expected an operand at position 5" },
+};
+
+
+static void checkEvaluation(const std::string &expression, bool holds,
+                            const ALEConditionInput &input) {
+    try {
+        ALECondition condition(expression);
+        if (condition.expression() != expression)
+            fail(expression, "the expression isn't kept");
+        if (condition.evaluate(input) != holds)
+            fail(expression, holds ? "doesn't hold" : "holds");
+    } catch (const std::invalid_argument &e) {
+        fail(expression, std::string("doesn't compile: ") + e.what());
+    }
+}
+
+
+static void checkError(const std::string &expression, const std::string &message) {
+    try {
+        ALECondition condition(expression);
+        fail(expression, "compiles");
+    } catch (const std::invalid_argument &e) {
+        std::string expected = "Condition '" + expression + "': " + message;
+        if (e.what() != expected)
+            fail(expression, std::string("throws \"") + e.what() + "\", not \"" + expected + "\"");
+    }
+}
+
+
+static std::string nested(const std::string &open, int depth, const std::string &inner,
+                          const std::string &close) {
+    std::string expression;
+    for (int i = 0; i < depth; i++) expression += open;
+    expression += inner;
+    for (int i = 0; i < depth; i++) expression += close;
+    return expression;
+}
+
+
+int main(int argc, char *argv[]) {
+    if (argc > 1) {
+        fprintf(stderr, "Usage: ale_condition_check\n");
+        return 1;
+    }
+
+    std::vector<byte_t> ram(128);
+    for (size_t i = 0; i < ram.size(); i++)
+        ram[i] = static_cast<byte_t>(i * 2);
+    ALEConditionInput input;
+    input.ram = &ram[0];
+    input.features.values[ALEFeatures::BALL_X] = 100;
+    input.features.values[ALEFeatures::BALL_Y] = 50;
+    input.features.values[ALEFeatures::BALL_DX] = -2;
+    input.features.values[ALEFeatures::BALL_DY] = 1;
+    input.features.values[ALEFeatures::PADDLE_A] = 30;
+    input.features.values[ALEFeatures::PADDLE_B] = 40;
+    input.features.values[ALEFeatures::SCORE_A] = 3;
+    input.features.values[ALEFeatures::SCORE_B] = 5;
+    input.features.values[ALEFeatures::PHASE] = ALEFeatures::RALLY;
+    input.reward_a = 1;
+    input.reward_b = -1;
+    input.frames = 42;
+
+    for (size_t i = 0; i < sizeof(s_evaluations) / sizeof(s_evaluations[0]); i++)
+        checkEvaluation(s_evaluations[i].expression, s_evaluations[i].holds, input);
+    for (size_t i = 0; i < sizeof(s_errors) / sizeof(s_errors[0]); i++)
+        checkError(s_errors[i].expression, s_errors[i].message);
+
+    // Up to the limit, counting the operand's own level; then one past it
+    checkEvaluation(nested("(", MAX_NESTING - 1, "1", ")"), true, input);
+    checkEvaluation(nested("!", MAX_NESTING - 1, "0", ""), true, input);
+    checkEvaluation(nested("-(", (MAX_NESTING - 1) / 2, "1", ")") + " == 1", false, input);
+    checkError(nested("(", MAX_NESTING, "1", ")"),
+               "expression too deeply nested at position 257");
+    checkError(nested("!", MAX_NESTING, "0", ""),
+               "expression too deeply nested at position 257");
+    // Far past it, where unbounded recursion would overflow the stack
+    std::string deep = nested("(", 2000000, "1", ")");
+    try {
+        ALECondition condition(deep);
+        fail("(((...1...)))", "compiles");
+    } catch (const std::invalid_argument &) {
+    }
+    // The evaluation stack is bounded too
+    checkError(nested("1 + (", 64, "1", ")"),
+               "expression too deeply nested at position 322");
+
+    printf("%s\n", s_failures == 0 ? "PASS" : "FAIL");
+    return s_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,470 @@
+/* *****************************************************************************
+ * Xitari
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ * *****************************************************************************
+ *  ale_golden.cpp
+ *
+ *  Determinism and throughput regression checks against golden traces.
+ *
+ *  Usage: ale_golden [-record] [-golden dir] [-frames n] [-seed n]
+ *                    [-repeats n] [-threshold percent] [-no_throughput]
+ *                    romfile...
+ *
+ *  Each ROM (one of the Pong variants, chosen by its file name as usual)
+ *  plays a joint-action script drawn from a seeded generator. Every frame
+ *  the CRC-32s of the screen, the RAM and the whole machine state (CPU,
+ *  RIOT and TIA, collision latches included, as ShadowEnvironment
+ *  compares it) and both players' rewards are compared with
+ *  <dir>/<variant>.golden under both CPU cores, and with rendering
+ *  disabled (everything but the screen), with the TIA's scalar renderer
+ *  instead of its SIMD one, and with the TIA catching up on every
+ *  register write instead of combining those that can't change the frame,
+ *  so that all of the emulator's exact paths must agree bit for bit.
+ *  Where a mode's screen differs, the frame is replayed in it and in the
+ *  plainest mode (low CPU core, scalar TIA, no write combining), and the
+ *  pixels that differ are reported. -fast_tia_update is
+ *  left out: it latches collisions during VBLANK, so it plays differently
+ *  by design. The frames/sec of each mode is compared with the one stored
+ *  in the golden file; a drop of more than threshold percent fails too.
+ *
+ *  -record writes the golden files instead, from the low CPU core, after
+ *  checking that every mode reproduces it. The exit status is 1 if any
+ *  check fails.
+ **************************************************************************** */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <zlib/zlib.h>
+
+#include "bench/emulator.hpp"
+#include "emucore/Serializer.hxx"
+#include "emucore/m6502/src/M6502.hxx"
+#include "emucore/m6502/src/System.hxx"
+
+using namespace ale;
+
+
+// What is compared each frame
+struct GoldenFrame {
+    uLong screen;                   // CRC-32 of the screen
+    uLong ram;                      // CRC-32 of the RAM
+    uLong state;                    // CRC-32 of the machine state
+    int reward_a;
+    int reward_b;
+};
+
+
+struct GoldenTrace {
+    std::string rom;
+    unsigned seed;
+    std::vector<GoldenFrame> frames;
+    bool has_state;                 // Older golden files lack the state
+    std::map<std::string, double> frames_per_sec;   // By mode
+};
+
+
+// An emulator configuration the golden trace must hold under
+struct Mode {
+    const char *name;
+    std::vector<std::string> options;
+    bool render;                    // Otherwise the screen is stale
+};
+
+
+struct Options {
+    bool record;
+    std::string golden_dir;
+    int frames;
+    unsigned seed;
+    int repeats;
+    double threshold;               // Percent
+    bool check_throughput;
+};
+
+
+// The players' actions: each holds an action of its minimal set for up to
+// 16 frames. The raw mt19937 output is the same on every platform.
+class ActionScript {
+  public:
+    ActionScript(unsigned seed, const ActionVect &actions_a, const ActionVect &actions_b) :
+        m_rng(seed), m_actions_a(actions_a), m_actions_b(actions_b),
+        m_hold_a(0), m_hold_b(0), m_action_a(PLAYER_A_NOOP), m_action_b(PLAYER_B_NOOP) {}
+
+    void next(Action &action_a, Action &action_b) {
+        choose(m_actions_a, m_hold_a, m_action_a);
+        choose(m_actions_b, m_hold_b, m_action_b);
+        action_a = m_action_a;
+        action_b = m_action_b;
+    }
+
+  private:
+    void choose(const ActionVect &actions, int &hold, Action &action) {
+        if (hold-- > 0) return;
+        action = actions[m_rng() % actions.size()];
+        hold = m_rng() % 16;
+    }
+
+    std::mt19937 m_rng;
+    ActionVect m_actions_a, m_actions_b;
+    int m_hold_a, m_hold_b;
+    Action m_action_a, m_action_b;
+};
+
+
+static double now() {
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+// CRC-32 of everything a saved state holds, less the name of the CPU core,
+// the only part of it that depends on the core
+static uLong stateCRC(Emulator &emu) {
+    System &system = emu.osystem->console().system();
+    Serializer state, name;
+    system.saveState("", state);
+    emu.rom_settings->saveState(state);
+    name.putString(system.m6502().name());
+
+    std::string data = state.get_str(), core = name.get_str();
+    size_t pos = data.find(core);
+    if (pos != std::string::npos)
+        data.erase(pos, core.size());
+    return crc32(0L, reinterpret_cast<const Bytef*>(data.data()), data.size());
+}
+
+
+static std::string variantName(const std::string &rom_file) {
+    size_t slash = rom_file.find_last_of("/\\");
+    std::string name = rom_file.substr(slash == std::string::npos ? 0 : slash + 1);
+    return name.substr(0, name.find('.'));
+}
+
+
+// Plays num_frames frames of the script in mode, appending them to frames
+// if it isn't NULL and leaving the last screen in screen if that isn't;
+// returns the seconds spent emulating
+static double play(const std::string &rom_file, const Mode &mode, unsigned seed,
+                   int num_frames, std::vector<GoldenFrame> *frames,
+                   ALEScreen *screen = NULL) {
+    std::vector<std::string> options = mode.options;
+    char seed_string[16];
+    snprintf(seed_string, sizeof(seed_string), "%u", seed);
+    options.push_back("-random_seed");
+    options.push_back(seed_string);
+
+    Emulator emu(rom_file, options);
+    StellaEnvironment &env = *emu.environment;
+    env.enableRendering(mode.render);
+    ActionScript script(seed, emu.rom_settings->getMinimalActionSet(),
+                        emu.rom_settings->getMinimalActionSetB());
+
+    double seconds = 0;
+    for (int f = 0; f < num_frames; f++) {
+        Action action_a, action_b;
+        script.next(action_a, action_b);
+
+        double start = now();
+        if (env.isTerminal())
+            env.reset();
+        env.act(action_a, action_b);
+        seconds += now() - start;
+
+        if (frames != NULL) {
+            const std::vector<pixel_t> &screen = env.getScreen().getArray();
+            GoldenFrame frame;
+            frame.screen = crc32(0L, &screen[0], screen.size() * sizeof(pixel_t));
+            frame.ram = crc32(0L, env.getRAM().array(), env.getRAM().size());
+            frame.state = stateCRC(emu);
+            frame.reward_a = emu.rom_settings->getReward();
+            frame.reward_b = emu.rom_settings->getRewardB();
+            frames->push_back(frame);
+        }
+    }
+    if (screen != NULL)
+        *screen = env.getScreen();
+    return seconds;
+}
+
+
+// The slowest and plainest of the emulator's paths, which the screens of
+// diverging modes are compared with pixel by pixel
+static const Mode s_reference = {
+    "reference", { "-cpu", "low", "-disable_tia_simd", "true",
+                   "-disable_tia_write_combining", "true" }, true
+};
+
+
+// Replays frame f in mode and in the reference mode, and tells which of
+// its pixels differ between them
+static void reportPixels(const std::string &rom_file, const Mode &mode, unsigned seed,
+                         size_t f) {
+    const Mode &reference = s_reference;
+    ALEScreen expected_screen(0, 0), got_screen(0, 0);
+    play(rom_file, reference, seed, f + 1, NULL, &expected_screen);
+    play(rom_file, mode, seed, f + 1, NULL, &got_screen);
+    const std::vector<pixel_t> &expected = expected_screen.getArray();
+    const std::vector<pixel_t> &got = got_screen.getArray();
+
+    size_t differ = 0, first = 0;
+    for (size_t i = 0; i < got.size(); i++) {
+        if (got[i] != expected[i] && differ++ == 0)
+            first = i;
+    }
+    if (differ == 0) {
+        printf("%s: frame %u matches %s pixel for pixel\n", mode.name, (unsigned)f,
+               reference.name);
+        return;
+    }
+    size_t width = got_screen.width();
+    printf("%s: %u pixels of frame %u differ from %s, the first at row %u, column %u "
+           "(%02x, expected %02x)\n", mode.name, (unsigned)differ, (unsigned)f, reference.name,
+           (unsigned)(first / width), (unsigned)(first % width), got[first], expected[first]);
+}
+
+
+static void writeGolden(const std::string &filename, const GoldenTrace &trace) {
+    FILE *file = fopen(filename.c_str(), "w");
+    if (file == NULL)
+        throw std::runtime_error("Cannot create " + filename);
+
+    fprintf(file, "rom %s\nseed %u\nframes %u\n", trace.rom.c_str(), trace.seed,
+            (unsigned)trace.frames.size());
+    std::map<std::string, double>::const_iterator it;
+    for (it = trace.frames_per_sec.begin(); it != trace.frames_per_sec.end(); ++it)
+        fprintf(file, "frames_per_sec %s %.1f\n", it->first.c_str(), it->second);
+    for (size_t f = 0; f < trace.frames.size(); f++) {
+        const GoldenFrame &frame = trace.frames[f];
+        fprintf(file, "%08lx %08lx %08lx %d %d\n", frame.screen, frame.ram, frame.state,
+                frame.reward_a, frame.reward_b);
+    }
+
+    if (fclose(file) != 0)
+        throw std::runtime_error("Cannot write " + filename);
+}
+
+
+static GoldenTrace readGolden(const std::string &filename) {
+    FILE *file = fopen(filename.c_str(), "r");
+    if (file == NULL)
+        throw std::runtime_error("Cannot open " + filename + "; create it with -record");
+
+    GoldenTrace trace;
+    trace.has_state = true;
+    char rom[256] = "", mode[256], line[256];
+    unsigned num_frames;
+    double frames_per_sec;
+    bool ok = fscanf(file, "rom %255s seed %u frames %u ", rom, &trace.seed, &num_frames) == 3;
+    trace.rom = rom;
+    while (ok && fscanf(file, "frames_per_sec %255s %lf ", mode, &frames_per_sec) == 2)
+        trace.frames_per_sec[mode] = frames_per_sec;
+    // A frame is "screen ram state reward_a reward_b", or without the state
+    //  in files recorded before it was
+    for (unsigned f = 0; ok && f < num_frames; f++) {
+        GoldenFrame frame;
+        ok = fgets(line, sizeof(line), file) != NULL;
+        if (ok && sscanf(line, "%lx %lx %lx %d %d", &frame.screen, &frame.ram, &frame.state,
+                         &frame.reward_a, &frame.reward_b) != 5) {
+            frame.state = 0;
+            ok = f == 0 || !trace.has_state;
+            ok = ok && sscanf(line, "%lx %lx %d %d", &frame.screen, &frame.ram,
+                              &frame.reward_a, &frame.reward_b) == 4;
+            trace.has_state = false;
+        }
+        trace.frames.push_back(frame);
+    }
+    fclose(file);
+
+    if (!ok)
+        throw std::runtime_error(filename + " is not a golden trace");
+    return trace;
+}
+
+
+// Compares frames with the golden ones; returns whether they all match, and
+// in screen_frame the first frame whose screen differs, if any does
+static bool compare(const GoldenTrace &golden, const std::vector<GoldenFrame> &frames,
+                    const Mode &mode, size_t &screen_frame) {
+    size_t diverged = 0, first = 0;
+    screen_frame = golden.frames.size();
+    for (size_t f = 0; f < golden.frames.size(); f++) {
+        const GoldenFrame &a = golden.frames[f], &b = frames[f];
+        bool screen_differs = mode.render && a.screen != b.screen;
+        bool state_differs = golden.has_state && a.state != b.state;
+        if (!screen_differs && !state_differs && a.ram == b.ram &&
+            a.reward_a == b.reward_a && a.reward_b == b.reward_b)
+            continue;
+        if (screen_differs)
+            screen_frame = std::min(screen_frame, f);
+        if (diverged++ > 0) continue;
+
+        first = f;
+        std::string what;
+        if (screen_differs) what += " screen";
+        if (a.ram != b.ram) what += " ram";
+        if (state_differs) what += " state";
+        if (a.reward_a != b.reward_a) what += " reward_a";
+        if (a.reward_b != b.reward_b) what += " reward_b";
+        printf("%s %s: diverges at frame %u:%s (golden %08lx %08lx %08lx %d %d, "
+               "got %08lx %08lx %08lx %d %d)\n", golden.rom.c_str(), mode.name, (unsigned)f,
+               what.c_str(), a.screen, a.ram, a.state, a.reward_a, a.reward_b,
+               b.screen, b.ram, b.state, b.reward_a, b.reward_b);
+    }
+
+    if (diverged > 0) {
+        printf("%s %s: FAIL, %u of %u frames differ from frame %u on\n", golden.rom.c_str(),
+               mode.name, (unsigned)diverged, (unsigned)golden.frames.size(), (unsigned)first);
+        return false;
+    }
+    return true;
+}
+
+
+// Checks rom_file against its golden trace in every mode, recording the
+// trace first if asked to; returns whether every check passed
+static bool checkRom(const std::string &rom_file, const std::vector<Mode> &modes,
+                     const Options &options) {
+    std::string variant = variantName(rom_file);
+    std::string filename = options.golden_dir + "/" + variant + ".golden";
+
+    GoldenTrace golden;
+    if (options.record) {
+        golden.rom = variant;
+        golden.seed = options.seed;
+        golden.has_state = true;
+        play(rom_file, modes[0], golden.seed, options.frames, &golden.frames);
+    } else {
+        golden = readGolden(filename);
+        if (golden.rom != variant)
+            throw std::runtime_error(filename + " was recorded for " + golden.rom);
+    }
+
+    bool passed = true;
+    GoldenTrace measured = golden;
+    for (size_t m = 0; m < modes.size(); m++) {
+        std::vector<GoldenFrame> frames;
+        play(rom_file, modes[m], golden.seed, golden.frames.size(), &frames);
+        size_t screen_frame;
+        if (!compare(golden, frames, modes[m], screen_frame)) {
+            if (screen_frame < golden.frames.size())
+                reportPixels(rom_file, modes[m], golden.seed, screen_frame);
+            passed = false;
+            continue;
+        }
+
+        // The best of the repeats, as the others were disturbed
+        double seconds = 1e30;
+        for (int r = 0; r < options.repeats; r++)
+            seconds = std::min(seconds, play(rom_file, modes[m], golden.seed,
+                                             golden.frames.size(), NULL));
+        double frames_per_sec = golden.frames.size() / std::max(seconds, 1e-9);
+        measured.frames_per_sec[modes[m].name] = frames_per_sec;
+
+        std::map<std::string, double>::const_iterator baseline =
+            golden.frames_per_sec.find(modes[m].name);
+        if (options.record || baseline == golden.frames_per_sec.end()) {
+            printf("%s %s: %u frames match, %.0f frames/sec\n", variant.c_str(),
+                   modes[m].name, (unsigned)golden.frames.size(), frames_per_sec);
+            continue;
+        }
+
+        double change = 100.0 * (frames_per_sec / baseline->second - 1);
+        bool regressed = options.check_throughput && change < -options.threshold;
+        printf("%s %s: %u frames match, %.0f frames/sec (baseline %.0f, %+.1f%%)%s\n",
+               variant.c_str(), modes[m].name, (unsigned)golden.frames.size(),
+               frames_per_sec, baseline->second, change,
+               regressed ? ", FAIL: throughput regressed" : "");
+        if (regressed) passed = false;
+    }
+
+    if (options.record) {
+        if (!passed)
+            throw std::runtime_error("Not recording " + filename +
+                                     ": the modes don't agree with each other");
+        writeGolden(filename, measured);
+        printf("%s: recorded %s\n", variant.c_str(), filename.c_str());
+    }
+    return passed;
+}
+
+
+static void usage() {
+    fprintf(stderr, "Usage: ale_golden [-record] [-golden dir] [-frames n] [-seed n] "
+                    "[-repeats n] [-threshold percent] [-no_throughput] romfile...\n");
+    exit(1);
+}
+
+
+int main(int argc, char *argv[]) {
+    Options options;
+    options.record = false;
+    options.golden_dir = "golden";
+    options.frames = 5000;
+    options.seed = 0;
+    options.repeats = 5;
+    options.threshold = 10;
+    options.check_throughput = true;
+
+    std::vector<std::string> rom_files;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg[0] != '-') rom_files.push_back(arg);
+        else if (arg == "-record") options.record = true;
+        else if (arg == "-no_throughput") options.check_throughput = false;
+        else if (i + 1 >= argc) usage();
+        else if (arg == "-golden") options.golden_dir = argv[++i];
+        else if (arg == "-frames") options.frames = std::max(1, atoi(argv[++i]));
+        else if (arg == "-seed") options.seed = strtoul(argv[++i], NULL, 10);
+        else if (arg == "-repeats") options.repeats = std::max(1, atoi(argv[++i]));
+        else if (arg == "-threshold") options.threshold = atof(argv[++i]);
+        else usage();
+    }
+    if (rom_files.empty()) usage();
+
+    // The first mode is the reference the golden traces are recorded with
+    std::vector<Mode> modes = {
+        { "cpu_low", { "-cpu", "low" }, true },
+        { "cpu_high", { "-cpu", "high" }, true },
+        { "cpu_low/no_render", { "-cpu", "low" }, false },
+        { "cpu_high/no_render", { "-cpu", "high" }, false },
+        { "cpu_low/scalar_tia", { "-cpu", "low", "-disable_tia_simd", "true" }, true },
+        { "cpu_low/scalar_tia/no_render", { "-cpu", "low", "-disable_tia_simd", "true" }, false },
+        { "cpu_low/no_write_combining",
+          { "-cpu", "low", "-disable_tia_write_combining", "true" }, true },
+        { "cpu_low/no_write_combining/no_render",
+          { "-cpu", "low", "-disable_tia_write_combining", "true" }, false },
+    };
+
+    bool passed = true;
+    try {
+        for (size_t r = 0; r < rom_files.size(); r++)
+            passed = checkRom(rom_files[r], modes, options) && passed;
+    } catch (std::exception &e) {
+        fprintf(stderr, "error: %s\n", e.what());
+        return 1;
+    }
+
+    printf("%s\n", passed ? "PASS" : "FAIL");
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,276 @@
+/* *****************************************************************************
+ * Xitari
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ * *****************************************************************************
+ *  ale_replay_check.cpp
+ *
+ *  Check of action logs and of the 'replay' game controller.
+ *
+ *  Usage: ale_replay_check [-frames n] [-interval n] [-seed n] [-dir d]
+ *                          romfile
+ *
+ *  Plays a seeded action script for n frames (3000) through ALEInterface,
+ *  with a reset and a snapshot restore along the way, logging it with
+ *  startActionLog() every -interval steps (50) into d (.). The log must
+ *  replay through ReplayController, alone and next to a copy of itself on
+ *  two workers. Then tampered copies, with a RAM checksum or the rewards of
+ *  a check changed, a step dropped, or the end cut off, must each fail to
+ *  replay, the last also in ActionLogReader itself. On Linux, logging to
+ *  /dev/full must make stopActionLog() throw.
+ *  The exit status is 1 if any check fails.
+ **************************************************************************** */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "bench/emulator.hpp"
+#include "controllers/replay_controller.hpp"
+#include "environment/action_log.hpp"
+
+using namespace ale;
+
+
+struct Options {
+    int frames;
+    int interval;
+    unsigned seed;
+    std::string dir;
+};
+
+
+// Where a record of a log lies, tag included
+struct Record {
+    uInt8 tag;
+    size_t offset;
+    size_t size;
+};
+
+
+static int s_failures = 0;
+
+static void fail(const std::string &file, const std::string &what) {
+    if (s_failures++ < 20)
+        printf("%s: FAIL, %s\n", file.c_str(), what.c_str());
+}
+
+
+// Plays the script, logging it into filename unless that is empty
+static void play(const std::string &rom_file, const Options &options,
+                 const std::string &filename) {
+    ALEInterface ale(rom_file);
+    const ActionVect &actions_a = ale.getMinimalActionSet();
+    const ActionVect &actions_b = ale.getMinimalActionSetB();
+    std::mt19937 rng(options.seed);
+    std::string snapshot;
+
+    ale.startActionLog(filename, options.interval);
+    for (int f = 0; f < options.frames; f++) {
+        // Both log the state they lead to
+        if (f == options.frames / 4 || ale.gameOver())
+            ale.resetGame();
+        if (f == options.frames / 2)
+            snapshot = ale.getSnapshot();
+        if (f == options.frames * 3 / 4)
+            ale.restoreSnapshot(snapshot);
+
+        double reward_a, reward_b, side_bouncing;
+        bool wall_bouncing, crash, serving;
+        int points;
+        Action a = actions_a[rng() % actions_a.size()];
+        Action b = actions_b[rng() % actions_b.size()];
+        ale.act2(a, b, &reward_a, &reward_b, &side_bouncing, &wall_bouncing,
+                 &points, &crash, &serving);
+    }
+    ale.stopActionLog();
+}
+
+
+static bool readFile(const std::string &filename, std::vector<uInt8> &data) {
+    FILE *file = fopen(filename.c_str(), "rb");
+    if (file == NULL) return false;
+    fseek(file, 0, SEEK_END);
+    data.resize(ftell(file));
+    fseek(file, 0, SEEK_SET);
+    bool ok = data.empty() || fread(&data[0], data.size(), 1, file) == 1;
+    fclose(file);
+    return ok;
+}
+
+
+static void writeFile(const std::string &filename, const std::vector<uInt8> &data) {
+    FILE *file = fopen(filename.c_str(), "wb");
+    if (file == NULL || fwrite(&data[0], data.size(), 1, file) != 1 || fclose(file) != 0)
+        throw std::runtime_error("Cannot write " + filename);
+}
+
+
+// Finds the records of a well-formed log
+static std::vector<Record> records(const std::vector<uInt8> &data) {
+    std::vector<Record> found;
+    size_t pos = sizeof(ActionLogHeader);
+    while (pos < data.size()) {
+        Record record;
+        record.tag = data[pos];
+        record.offset = pos;
+        if (record.tag == ACTION_LOG_STEP)
+            record.size = 3;
+        else if (record.tag == ACTION_LOG_CHECK)
+            record.size = 1 + sizeof(ActionLogCheck);
+        else {
+            uInt32 length;
+            memcpy(&length, &data[pos + 1], sizeof(length));
+            record.size = 1 + sizeof(length) + length;
+        }
+        found.push_back(record);
+        pos += record.size;
+    }
+    return found;
+}
+
+
+// Replays logs through a ReplayController; false if it reports a failure
+static bool replays(const std::string &rom_file, const std::string &logs, int num_workers) {
+    char workers[16];
+    snprintf(workers, sizeof(workers), "%d", num_workers);
+    Emulator emu(rom_file, { "-replay_logs", logs, "-replay_num_workers", workers });
+    ReplayController controller(emu.osystem);
+    try {
+        controller.run();
+        return true;
+    } catch (const std::runtime_error &) {
+        return false;
+    }
+}
+
+
+static void usage() {
+    fprintf(stderr, "Usage: ale_replay_check [-frames n] [-interval n] [-seed n] "
+                    "[-dir d] romfile\n");
+    exit(1);
+}
+
+
+int main(int argc, char *argv[]) {
+    Options options;
+    options.frames = 3000;
+    options.interval = 50;
+    options.seed = 0;
+    options.dir = ".";
+
+    std::string rom_file;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg[0] != '-') rom_file = arg;
+        else if (i + 1 >= argc) usage();
+        else if (arg == "-frames") options.frames = std::max(8, atoi(argv[++i]));
+        else if (arg == "-interval") options.interval = std::max(1, atoi(argv[++i]));
+        else if (arg == "-seed") options.seed = strtoul(argv[++i], NULL, 10);
+        else if (arg == "-dir") options.dir = argv[++i];
+        else usage();
+    }
+    if (rom_file.empty()) usage();
+
+    std::vector<std::string> files;
+    try {
+        std::string base = options.dir + "/ale_replay_check";
+        std::string clean = base + ".log", copy = base + "_copy.log";
+        play(rom_file, options, clean);
+        files.push_back(clean);
+
+        std::vector<uInt8> data;
+        if (!readFile(clean, data))
+            throw std::runtime_error("Cannot read " + clean);
+        std::vector<Record> found = records(data);
+        std::vector<Record> checks, steps;
+        for (size_t i = 0; i < found.size(); i++) {
+            if (found[i].tag == ACTION_LOG_CHECK) checks.push_back(found[i]);
+            if (found[i].tag == ACTION_LOG_STEP) steps.push_back(found[i]);
+        }
+        if (steps.size() != (size_t)options.frames)
+            fail(clean, "the log doesn't hold a record per step");
+        if (checks.size() < 2)
+            throw std::runtime_error(clean + " holds too few checks to tamper with");
+
+        if (!replays(rom_file, clean, 1))
+            fail(clean, "the log doesn't replay");
+        writeFile(copy, data);
+        files.push_back(copy);
+        if (!replays(rom_file, clean + "," + copy, 2))
+            fail(clean, "the log doesn't replay next to a copy");
+
+        // Tampered copies, each of which must fail
+        std::vector<uInt8> ram = data;
+        ram[checks[0].offset + 1 + offsetof(ActionLogCheck, ram_checksum)] ^= 1;
+        std::vector<uInt8> rewards = data;
+        double *reward_a = reinterpret_cast<double*>(
+            &rewards[checks.back().offset + 1 + offsetof(ActionLogCheck, reward_a)]);
+        double reward = *reward_a + 1;
+        memcpy(reward_a, &reward, sizeof(reward));
+        std::vector<uInt8> dropped = data;
+        dropped.erase(dropped.begin() + steps[0].offset,
+                      dropped.begin() + steps[0].offset + steps[0].size);
+        std::vector<uInt8> truncated(data.begin(), data.end() - 5);
+
+        const struct {
+            const char *name;
+            const std::vector<uInt8> *data;
+        } tampered[] = {
+            { "ram", &ram }, { "rewards", &rewards }, { "dropped", &dropped },
+            { "truncated", &truncated }
+        };
+        for (size_t i = 0; i < sizeof(tampered) / sizeof(tampered[0]); i++) {
+            std::string name = base + "_" + tampered[i].name + ".log";
+            writeFile(name, *tampered[i].data);
+            files.push_back(name);
+            if (replays(rom_file, name, 1))
+                fail(name, "the tampered log replays");
+        }
+
+        // The truncation must be told apart from divergence
+        ActionLogReader reader(base + "_truncated.log");
+        try {
+            while (reader.next() != 0) {}
+            fail(base + "_truncated.log", "the reader doesn't notice the truncation");
+        } catch (const std::runtime_error &e) {
+            if (std::string(e.what()) != "Truncated action log")
+                fail(base + "_truncated.log", std::string("the reader reports ") + e.what());
+        }
+
+#ifdef __linux__
+        // Every write to /dev/full fails, which stopActionLog() must report
+        try {
+            play(rom_file, options, "/dev/full");
+            fail("/dev/full", "stopActionLog() doesn't report the failed writes");
+        } catch (const std::runtime_error &e) {
+            printf("/dev/full: stopActionLog() reports \"%s\"\n", e.what());
+        }
+#endif
+    } catch (const std::exception &e) {
+        fprintf(stderr, "Error: %s\n", e.what());
+        s_failures++;
+    }
+
+    for (size_t i = 0; i < files.size(); i++)
+        remove(files[i].c_str());
+    printf("%s\n", s_failures == 0 ? "PASS" : "FAIL");
+    return s_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,265 @@
+/* *****************************************************************************
+ * Xitari
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ * *****************************************************************************
+ *  ale_shm_loopback.cpp
+ *
+ *  Loopback check and latency benchmark of the 'shm' game controller.
+ *
+ *  Usage: ale_shm_loopback [-frames n] [-frame_skip n] [-episode_frames n]
+ *                          [-seed n] [-no_screen] romfile
+ *
+ *  Runs an SHMController on a thread of its own and attaches to it through
+ *  shared memory, the way an agent does, as a client playing a seeded
+ *  action script for n frames (10000). Every observation is compared with
+ *  a reference emulator that steps the same actions one frame at a time,
+ *  rendering them all: RAM, frame number, rewards, terminal flag and, unless
+ *  -no_screen, the screen. -episode_frames cuts episodes short so that they
+ *  end in the middle of a frame skip (the client resets them). Then the
+ *  round-trip latency of a step is reported, next to the time the reference
+ *  took to emulate it. The exit status is 1 if any observation differs.
+ **************************************************************************** */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "bench/emulator.hpp"
+#include "controllers/shm_channel.hpp"
+#include "controllers/shm_controller.hpp"
+
+using namespace ale;
+
+
+struct Options {
+    int frames;
+    int frame_skip;
+    int episode_frames;
+    unsigned seed;
+    bool screen;
+};
+
+
+// The agent side of the shared-memory region
+class Client {
+  public:
+    Client(const std::string &name, const Options &options) : m_base(NULL), m_size(0) {
+        int fd;
+        while ((fd = shm_open(name.c_str(), O_RDWR, 0)) < 0)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+        // The controller sizes the object, then lays out the header
+        struct stat st;
+        do fstat(fd, &st); while (st.st_size < (off_t)sizeof(ShmHeader));
+        m_size = st.st_size;
+        void *region = mmap(NULL, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (region == MAP_FAILED)
+            throw std::runtime_error("Cannot map shared memory " + name);
+        m_base = static_cast<char*>(region);
+        m_header = reinterpret_cast<ShmHeader*>(m_base);
+        while (m_header->magic.load() != SHM_MAGIC)
+            std::this_thread::yield();
+
+        m_header->frame_skip = options.frame_skip;
+        m_header->send_screen = options.screen;
+        m_header->agent_pid = getpid();
+        m_header->attached.store(1);
+        shmWake(m_header->attached, m_header->observations.waiters);
+    }
+
+    ~Client() { munmap(m_base, m_size); }
+
+    /** Waits for the next observation; it stays valid until pop(). */
+    const ShmObservation &observation() {
+        int slot;
+        while ((slot = shmBeginPop(m_header->observations, m_header->num_slots, 1000)) < 0) {}
+        return *reinterpret_cast<const ShmObservation*>(
+            m_base + m_header->obs_offset + slot * m_header->obs_size);
+    }
+
+    void pop() { shmEndPop(m_header->observations); }
+
+    void act(Action action_a, Action action_b) {
+        int slot;
+        while ((slot = shmBeginPush(m_header->actions, m_header->num_slots, 1000)) < 0) {}
+        ShmAction *action = reinterpret_cast<ShmAction*>(m_base + m_header->action_offset) + slot;
+        action->player_a = action_a;
+        action->player_b = action_b;
+        shmEndPush(m_header->actions);
+    }
+
+    const ShmHeader &header() const { return *m_header; }
+
+  private:
+    char *m_base;
+    size_t m_size;
+    ShmHeader *m_header;
+};
+
+
+// Steps the reference like the controller does, but drawing every frame
+static void stepReference(Emulator &reference, Action action_a, Action action_b,
+                          int frame_skip, reward_t &reward_a, reward_t &reward_b) {
+    reward_a = reward_b = 0;
+    if (action_a == SYSTEM_RESET) {
+        reference.environment->reset();
+        return;
+    }
+    for (int i = 0; i < frame_skip; i++) {
+        if (i > 0 && reference.environment->isTerminal())
+            break;
+        reference.environment->act(action_a, action_b);
+        reward_a += reference.rom_settings->getReward();
+        reward_b += reference.rom_settings->getRewardB();
+    }
+}
+
+
+static double percentile(std::vector<double> values, double p) {
+    std::sort(values.begin(), values.end());
+    return values[std::min(values.size() - 1, (size_t)(p * values.size()))];
+}
+
+
+static void usage() {
+    fprintf(stderr, "Usage: ale_shm_loopback [-frames n] [-frame_skip n] [-episode_frames n] "
+                    "[-seed n] [-no_screen] romfile\n");
+    exit(1);
+}
+
+
+int main(int argc, char *argv[]) {
+    Options options;
+    options.frames = 10000;
+    options.frame_skip = 4;
+    options.episode_frames = 0;
+    options.seed = 0;
+    options.screen = true;
+
+    std::string rom_file;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg[0] != '-') rom_file = arg;
+        else if (arg == "-no_screen") options.screen = false;
+        else if (i + 1 >= argc) usage();
+        else if (arg == "-frames") options.frames = std::max(1, atoi(argv[++i]));
+        else if (arg == "-frame_skip") options.frame_skip = std::max(1, atoi(argv[++i]));
+        else if (arg == "-episode_frames") options.episode_frames = std::max(0, atoi(argv[++i]));
+        else if (arg == "-seed") options.seed = strtoul(argv[++i], NULL, 10);
+        else usage();
+    }
+    if (rom_file.empty()) usage();
+
+    char name[64];
+    snprintf(name, sizeof(name), "/xitari-loopback-%d", (int)getpid());
+    char frames[16], episode_frames[16];
+    snprintf(frames, sizeof(frames), "%d", options.frames);
+    snprintf(episode_frames, sizeof(episode_frames), "%d", options.episode_frames);
+    std::vector<std::string> settings = {
+        "-shm_name", name, "-max_num_frames", frames,
+        "-max_num_frames_per_episode", episode_frames,
+    };
+
+    int mismatches = 0;
+    try {
+        Emulator server(rom_file, settings), reference(rom_file, settings);
+        SHMController controller(server.osystem);
+        std::thread thread([&]() { controller.run(); });
+
+        Client client(name, options);
+        const ShmHeader &header = client.header();
+        const ActionVect &actions_a = reference.rom_settings->getMinimalActionSet();
+        const ActionVect &actions_b = reference.rom_settings->getMinimalActionSetB();
+        std::mt19937 rng(options.seed);
+
+        // The reference only steps while the controller waits for an action,
+        //  so that the two don't compete for a core during the round trip
+        std::vector<double> latencies, emulation;
+        reward_t reward_a = 0, reward_b = 0;
+        Action action_a = PLAYER_A_NOOP, action_b = PLAYER_B_NOOP;
+        std::chrono::steady_clock::time_point sent = std::chrono::steady_clock::now();
+        for (int step = 0; ; step++) {
+            const ShmObservation &obs = client.observation();
+            if (step > 0) {
+                latencies.push_back(std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - sent).count());
+
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                stepReference(reference, action_a, action_b, options.frame_skip,
+                              reward_a, reward_b);
+                emulation.push_back(std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - start).count());
+            }
+            if (obs.flags & SHM_OBS_EXITING) {
+                client.pop();
+                break;
+            }
+
+            const StellaEnvironment &env = *reference.environment;
+            const byte_t *ram = reinterpret_cast<const byte_t*>(&obs + 1);
+            const pixel_t *screen = ram + header.ram_size;
+            bool terminal = (obs.flags & SHM_OBS_TERMINAL) != 0;
+            const char *what = NULL;
+            if (obs.frame != (uint32_t)env.getFrameNumber()) what = "frame number";
+            else if (memcmp(ram, env.getRAM().array(), header.ram_size) != 0) what = "RAM";
+            else if (obs.reward_a != (int32_t)reward_a || obs.reward_b != (int32_t)reward_b)
+                what = "rewards";
+            else if (terminal != env.isTerminal()) what = "terminal flag";
+            else if (options.screen && memcmp(screen, &env.getScreen().getArray()[0],
+                                              header.width * header.height) != 0)
+                what = "screen";
+            if (what != NULL && mismatches++ < 10)
+                fprintf(stderr, "Step %d, frame %u%s: the %s differs from the reference\n",
+                        step, obs.frame, terminal ? " (terminal)" : "", what);
+            client.pop();
+
+            action_a = SYSTEM_RESET;
+            action_b = PLAYER_B_NOOP;
+            if (!terminal) {
+                action_a = actions_a[rng() % actions_a.size()];
+                action_b = actions_b[rng() % actions_b.size()];
+            }
+            sent = std::chrono::steady_clock::now();
+            client.act(action_a, action_b);
+        }
+        thread.join();
+
+        if (latencies.empty())
+            throw std::runtime_error("The controller sent no observation");
+        printf("%zu steps of %d frames%s: round trip p50 %.1f us, p99 %.1f us; "
+               "emulation p50 %.1f us\n", latencies.size(), options.frame_skip,
+               options.screen ? " with screens" : "", percentile(latencies, 0.5) * 1e6,
+               percentile(latencies, 0.99) * 1e6, percentile(emulation, 0.5) * 1e6);
+    } catch (const std::exception &e) {
+        fprintf(stderr, "Error: %s\n", e.what());
+        return 1;
+    }
+
+    printf("%s\n", mismatches == 0 ? "PASS" : "FAIL");
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,371 @@
+/* *****************************************************************************
+ * Xitari
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ * *****************************************************************************
+ *  ale_trajectory_check.cpp
+ *
+ *  Round-trip check of trajectory files.
+ *
+ *  Usage: ale_trajectory_check [-frames n] [-steps_per_chunk n]
+ *                              [-episode_frames n] [-seed n] [-dir d] romfile
+ *
+ *  Plays a seeded action script for n frames (2000), cutting episodes at
+ *  -episode_frames (301) so that they end in the middle of chunks of
+ *  -steps_per_chunk steps (50), and records every step with a
+ *  TrajectoryWriter into d (.): stored with screens, zlib-compressed with
+ *  screens, as screen deltas, as palette codes, and zlib-compressed
+ *  without screens. Each file is read back with a TrajectoryReader and,
+ *  through its index, with a TrajectoryDataset, and every step, RAM,
+ *  screen, episode and frame stack is compared with what was played. Both
+ *  readers must refuse a file whose header has no steps per chunk or a
+ *  record size that doesn't match its layout, and on Linux, writing to
+ *  /dev/full must make close() throw.
+ *  The exit status is 1 if any check fails.
+ **************************************************************************** */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "bench/emulator.hpp"
+#include "environment/trajectory_dataset.hpp"
+#include "environment/trajectory_recorder.hpp"
+
+using namespace ale;
+
+
+struct Options {
+    int frames;
+    int steps_per_chunk;
+    int episode_frames;
+    unsigned seed;
+    std::string dir;
+};
+
+
+// What was played, to compare the files with
+struct Played {
+    std::vector<TrajectoryStep> steps;
+    std::vector<uInt8> ram;         // ram_size bytes a step
+    std::vector<uInt8> screens;     // width * height bytes a step
+    std::vector<::uint64_t> episode_starts;
+    uInt32 ram_size, width, height;
+};
+
+
+static int s_failures = 0;
+
+static void fail(const std::string &file, const std::string &what) {
+    if (s_failures++ < 20)
+        printf("%s: FAIL, %s\n", file.c_str(), what.c_str());
+}
+
+
+static std::string stepText(const char *what, ::uint64_t t) {
+    char text[96];
+    snprintf(text, sizeof(text), "%s of step %llu differs", what, (unsigned long long)t);
+    return text;
+}
+
+
+static void play(const std::string &rom_file, const Options &options, Played &played) {
+    char episode_frames[16];
+    snprintf(episode_frames, sizeof(episode_frames), "%d", options.episode_frames);
+    Emulator emu(rom_file, { "-max_num_frames_per_episode", episode_frames });
+    StellaEnvironment &env = *emu.environment;
+    const ActionVect &actions_a = emu.rom_settings->getMinimalActionSet();
+    const ActionVect &actions_b = emu.rom_settings->getMinimalActionSetB();
+    std::mt19937 rng(options.seed);
+
+    played.ram_size = env.getRAM().size();
+    played.width = env.getScreen().width();
+    played.height = env.getScreen().height();
+    for (int f = 0; f < options.frames; f++) {
+        if (f == 0 || env.isTerminal()) {
+            if (f > 0) env.reset();
+            played.episode_starts.push_back(played.steps.size());
+        }
+
+        TrajectoryStep step;
+        step.action_a = actions_a[rng() % actions_a.size()];
+        step.action_b = actions_b[rng() % actions_b.size()];
+        env.act(static_cast<Action>(step.action_a), static_cast<Action>(step.action_b));
+        step.frame = env.getFrameNumber();
+        step.episode_frame = env.getEpisodeFrameNumber();
+        step.reward_a = emu.rom_settings->getReward();
+        step.reward_b = emu.rom_settings->getRewardB();
+        step.side_bouncing = emu.rom_settings->getSideBouncing();
+        step.points = emu.rom_settings->getPoints();
+        step.wall_bouncing = emu.rom_settings->getWallBouncing();
+        step.crash = emu.rom_settings->getCrash();
+        step.serving = emu.rom_settings->getServing();
+        step.game_over = env.isTerminal();
+        played.steps.push_back(step);
+
+        const uInt8 *ram = env.getRAM().array();
+        played.ram.insert(played.ram.end(), ram, ram + played.ram_size);
+        const std::vector<pixel_t> &screen = env.getScreen().getArray();
+        played.screens.insert(played.screens.end(), screen.begin(), screen.end());
+    }
+}
+
+
+// Compares the chunks in filename's index with the compression asked for
+static void checkIndex(const std::string &filename, const Options &options, uInt32 compression) {
+    FILE *file = fopen((filename + ".idx").c_str(), "rb");
+    TrajectoryIndexHeader header;
+    std::vector<TrajectoryIndexChunk> chunks;
+    bool ok = file != NULL && fread(&header, sizeof(header), 1, file) == 1;
+    if (ok) {
+        chunks.resize(header.num_chunks);
+        ok = chunks.empty() || fread(&chunks[0], sizeof(chunks[0]), chunks.size(), file) == chunks.size();
+    }
+    if (file != NULL) fclose(file);
+    if (!ok) {
+        fail(filename, "the index can't be read");
+        return;
+    }
+
+    size_t expected = (options.frames + options.steps_per_chunk - 1) / options.steps_per_chunk;
+    if (chunks.size() != expected)
+        fail(filename, "the index has the wrong number of chunks");
+    for (size_t c = 0; c < chunks.size(); c++) {
+        if (chunks[c].compression != compression)
+            fail(filename, "a chunk isn't compressed as asked");
+    }
+}
+
+
+static void checkFile(const std::string &filename, const Played &played,
+                      const Options &options, uInt32 compression, bool screens) {
+    const size_t num_steps = played.steps.size();
+    const size_t screen_size = played.width * played.height;
+    {
+        TrajectoryWriter writer(filename, played.ram_size, played.width, played.height,
+                                screens, options.steps_per_chunk, compression);
+        for (size_t t = 0; t < num_steps; t++)
+            writer.record(played.steps[t], &played.ram[t * played.ram_size],
+                          &played.screens[t * screen_size]);
+        writer.close();
+    }
+    checkIndex(filename, options, compression);
+
+    TrajectoryStep step;
+    std::vector<uInt8> ram(played.ram_size), screen(screen_size);
+
+    // In order, from the start
+    TrajectoryReader reader(filename);
+    size_t t = 0;
+    for (; reader.next(step, &ram[0], &screen[0]); t++) {
+        if (t >= num_steps) continue;
+        if (memcmp(&step, &played.steps[t], sizeof(step)) != 0)
+            fail(filename, stepText("the reader's record", t));
+        if (memcmp(&ram[0], &played.ram[t * played.ram_size], played.ram_size) != 0)
+            fail(filename, stepText("the reader's RAM", t));
+        if (screens && memcmp(&screen[0], &played.screens[t * screen_size], screen_size) != 0)
+            fail(filename, stepText("the reader's screen", t));
+    }
+    if (t != num_steps)
+        fail(filename, "the reader returns the wrong number of steps");
+
+    // At random, through the index
+    TrajectoryDataset dataset(filename, 4, 2);
+    if (dataset.numSteps() != num_steps)
+        fail(filename, "the dataset has the wrong number of steps");
+    if (dataset.numEpisodes() != played.episode_starts.size())
+        fail(filename, "the dataset has the wrong number of episodes");
+    for (size_t e = 0; e < std::min(dataset.numEpisodes(), played.episode_starts.size()); e++) {
+        ::uint64_t end = e + 1 < played.episode_starts.size() ? played.episode_starts[e + 1] : num_steps;
+        if (dataset.episode(e).first_step != played.episode_starts[e] ||
+            dataset.episode(e).num_steps != end - played.episode_starts[e])
+            fail(filename, "an episode of the index has the wrong steps");
+    }
+
+    std::mt19937 rng(options.seed);
+    for (size_t i = 0; i < num_steps; i++) {
+        ::uint64_t s = rng() % num_steps;
+        dataset.getStep(s, step, &ram[0], &screen[0]);
+        if (memcmp(&step, &played.steps[s], sizeof(step)) != 0 ||
+            memcmp(&ram[0], &played.ram[s * played.ram_size], played.ram_size) != 0 ||
+            (screens && memcmp(&screen[0], &played.screens[s * screen_size], screen_size) != 0))
+            fail(filename, stepText("the dataset's step", s));
+    }
+
+    // Minibatches of stacked observations, reaching back across chunks
+    //  and up to the starts of episodes
+    const int stack = 4, batch = 32;
+    const size_t obs_size = dataset.observationSize();
+    std::vector<::uint64_t> steps(batch);
+    std::vector<uInt8> frames(batch * stack * obs_size);
+    std::vector<Int32> actions_a(batch);
+    for (size_t b = 0; b < num_steps / batch; b++) {
+        for (int i = 0; i < batch; i++)
+            steps[i] = rng() % num_steps;
+        dataset.getBatch(&steps[0], batch, stack, &frames[0], &actions_a[0], NULL, NULL, NULL);
+        for (int i = 0; i < batch; i++) {
+            ::uint64_t start = *(std::upper_bound(played.episode_starts.begin(),
+                                                played.episode_starts.end(), steps[i]) - 1);
+            for (int k = 0; k < stack; k++) {
+                ::uint64_t back = stack - 1 - k;
+                ::uint64_t s = steps[i] - std::min(back, steps[i] - start);
+                const uInt8 *expected = screens ? &played.screens[s * screen_size] :
+                                                  &played.ram[s * played.ram_size];
+                if (memcmp(&frames[(i * stack + k) * obs_size], expected, obs_size) != 0)
+                    fail(filename, stepText("a stacked observation", steps[i]));
+            }
+            if (actions_a[i] != played.steps[steps[i]].action_a)
+                fail(filename, stepText("the batch's action", steps[i]));
+        }
+    }
+
+    remove(filename.c_str());
+    remove((filename + ".idx").c_str());
+    printf("%s: %u steps, %u episodes read back\n", filename.c_str(),
+           (unsigned)num_steps, (unsigned)played.episode_starts.size());
+}
+
+
+// Headers with a layout the readers mustn't trust, which both must refuse
+static void checkMalformedHeaders(const std::string &filename, const Played &played,
+                                  const Options &options) {
+    const size_t screen_size = played.width * played.height;
+    {
+        TrajectoryWriter writer(filename, played.ram_size, played.width, played.height,
+                                true, options.steps_per_chunk, TRAJECTORY_STORED);
+        for (size_t t = 0; t < played.steps.size(); t++)
+            writer.record(played.steps[t], &played.ram[t * played.ram_size],
+                          &played.screens[t * screen_size]);
+        writer.close();
+    }
+    TrajectoryFileHeader header;
+    FILE *file = fopen(filename.c_str(), "r+b");
+    if (file == NULL || fread(&header, sizeof(header), 1, file) != 1) {
+        fail(filename, "the header can't be read");
+        if (file != NULL) fclose(file);
+        return;
+    }
+
+    static const char *what[] = {
+        "no steps per chunk", "a short record size", "a long record size",
+        "a wider screen", "no screens"
+    };
+    for (int m = 0; m < 5; m++) {
+        TrajectoryFileHeader malformed = header;
+        switch (m) {
+            case 0: malformed.steps_per_chunk = 0; break;
+            case 1: malformed.record_size--; break;
+            case 2: malformed.record_size++; break;
+            case 3: malformed.width++; break;
+            case 4: malformed.flags &= ~TRAJECTORY_SCREENS; break;
+        }
+        fseek(file, 0, SEEK_SET);
+        fwrite(&malformed, sizeof(malformed), 1, file);
+        fflush(file);
+
+        try {
+            TrajectoryReader reader(filename);
+            fail(filename, std::string("the reader accepts ") + what[m]);
+        } catch (const std::runtime_error &) {
+        }
+        try {
+            TrajectoryDataset dataset(filename, 2, 1);
+            fail(filename, std::string("the dataset accepts ") + what[m]);
+        } catch (const std::runtime_error &) {
+        }
+    }
+    fclose(file);
+
+    remove(filename.c_str());
+    remove((filename + ".idx").c_str());
+    printf("%s: malformed headers refused\n", filename.c_str());
+}
+
+
+#ifdef __linux__
+// Every write to /dev/full fails, which close() must report
+static void checkWriteError(const Played &played, const Options &options) {
+    const size_t screen_size = played.width * played.height;
+    TrajectoryWriter writer("/dev/full", played.ram_size, played.width, played.height,
+                            true, options.steps_per_chunk, TRAJECTORY_STORED);
+    for (size_t t = 0; t < played.steps.size(); t++)
+        writer.record(played.steps[t], &played.ram[t * played.ram_size],
+                      &played.screens[t * screen_size]);
+    try {
+        writer.close();
+        fail("/dev/full", "close() doesn't report the failed writes");
+    }
+    catch (const std::runtime_error &e) {
+        printf("/dev/full: close() reports \"%s\"\n", e.what());
+    }
+}
+#endif
+
+
+static void usage() {
+    fprintf(stderr, "Usage: ale_trajectory_check [-frames n] [-steps_per_chunk n] "
+                    "[-episode_frames n] [-seed n] [-dir d] romfile\n");
+    exit(1);
+}
+
+
+int main(int argc, char *argv[]) {
+    Options options;
+    options.frames = 2000;
+    options.steps_per_chunk = 50;
+    options.episode_frames = 301;
+    options.seed = 0;
+    options.dir = ".";
+
+    std::string rom_file;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg[0] != '-') rom_file = arg;
+        else if (i + 1 >= argc) usage();
+        else if (arg == "-frames") options.frames = std::max(1, atoi(argv[++i]));
+        else if (arg == "-steps_per_chunk") options.steps_per_chunk = std::max(1, atoi(argv[++i]));
+        else if (arg == "-episode_frames") options.episode_frames = std::max(0, atoi(argv[++i]));
+        else if (arg == "-seed") options.seed = strtoul(argv[++i], NULL, 10);
+        else if (arg == "-dir") options.dir = argv[++i];
+        else usage();
+    }
+    if (rom_file.empty()) usage();
+
+    try {
+        Played played;
+        play(rom_file, options, played);
+
+        std::string base = options.dir + "/ale_trajectory_check";
+        checkFile(base + "_stored.trj", played, options, TRAJECTORY_STORED, true);
+        checkFile(base + "_zlib.trj", played, options, TRAJECTORY_ZLIB, true);
+        checkFile(base + "_delta.trj", played, options, TRAJECTORY_DELTA, true);
+        checkFile(base + "_palette.trj", played, options, TRAJECTORY_PALETTE, true);
+        checkFile(base + "_zlib_ram.trj", played, options, TRAJECTORY_ZLIB, false);
+        checkMalformedHeaders(base + "_malformed.trj", played, options);
+#ifdef __linux__
+        checkWriteError(played, options);
+#endif
+    } catch (const std::exception &e) {
+        fprintf(stderr, "Error: %s\n", e.what());
+        return 1;
+    }
+
+    printf("%s\n", s_failures == 0 ? "PASS" : "FAIL");
+    return s_failures == 0 ? 0 : 1;
+}
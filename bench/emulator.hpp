@@ -0,0 +1,81 @@
+/* *****************************************************************************
+ * Xitari
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ * *****************************************************************************
+ *  emulator.hpp
+ *
+ *  A bare emulator for the tools in bench/, set up the way ALEInterface
+ *  does it but with its pieces in reach and its settings on the command
+ *  line.
+ **************************************************************************** */
+
+#ifndef __BENCH_EMULATOR_HPP__
+#define __BENCH_EMULATOR_HPP__
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "ale_interface.hpp"
+#include "emucore/OSystem.hxx"
+#include "emucore/Settings.hxx"
+#include "environment/stella_environment.hpp"
+#include "games/Roms.hpp"
+
+namespace ale {
+
+struct Emulator {
+    OSystem *osystem;
+    Settings *settings;
+    RomSettings *rom_settings;
+    StellaEnvironment *environment;
+
+    /** Loads rom_file with the given command-line options, e.g. -cpu high;
+        the random seed is 0 unless the options say otherwise. */
+    Emulator(const std::string &rom_file, const std::vector<std::string> &options) :
+        osystem(NULL), settings(NULL), rom_settings(NULL), environment(NULL) {
+        std::vector<std::string> args;
+        args.push_back("xitari");
+        args.push_back("-random_seed");
+        args.push_back("0");
+        args.insert(args.end(), options.begin(), options.end());
+        args.push_back(rom_file);
+
+        std::vector<char*> argv;
+        for (size_t i = 0; i < args.size(); i++)
+            argv.push_back(const_cast<char*>(args[i].c_str()));
+
+        rom_settings = buildRomRLWrapper(rom_file);
+        if (rom_settings == NULL)
+            throw std::invalid_argument("Unsupported ROM " + rom_file);
+        createOSystem(argv.size(), &argv[0], osystem, settings);
+        osystem->settings().setBool("disable_color_averaging", true);
+        environment = new StellaEnvironment(osystem, rom_settings);
+        environment->reset();
+    }
+
+    ~Emulator() {
+        delete environment;
+        delete osystem;
+        delete settings;
+        delete rom_settings;
+    }
+
+    MediaSource &media() { return osystem->console().mediaSource(); }
+};
+
+} // namespace ale
+
+#endif // __BENCH_EMULATOR_HPP__
@@ -49,6 +49,30 @@ void setDefaultSettings(Settings &settings) {
     // FIFO controller settings
     settings.setBool("run_length_encoding", true);
 
+    // Shared-memory controller settings
+    settings.setString("shm_name", "/xitari");
+
+    // Server controller settings
+    settings.setString("server_socket", "xitari.sock");
+    settings.setString("server_host", "127.0.0.1");
+    settings.setInt("server_port", 0);
+    settings.setInt("server_num_envs", 1);
+    settings.setInt("server_num_threads", 0);
+
+    // Dataset controller settings
+    settings.setInt("dataset_frames", 1000000);
+    settings.setInt("dataset_num_workers", 0);
+    settings.setString("dataset_policy", "random_agent");
+    settings.setString("dataset_script", "0");
+    settings.setString("dataset_prefix", "dataset");
+    settings.setInt("dataset_shard_frames", 100000);
+    settings.setBool("dataset_screens", false);
+
+    // Replay controller settings
+    settings.setString("replay_logs", "");
+    settings.setInt("replay_num_workers", 0);
+    settings.setInt("replay_render_every", 0);
+
     // Environment customization settings
     settings.setBool("record_trajectory", false);
     settings.setBool("restricted_action_set", false);
@@ -56,9 +80,18 @@ void setDefaultSettings(Settings &settings) {
     settings.setBool("use_environment_distribution", false);
     settings.setString("random_seed", "time");
     settings.setBool("disable_color_averaging", false);
+    settings.setBool("disable_tia_write_combining", false);
+    settings.setBool("disable_tia_simd", false);
+    settings.setBool("shadow_execution", false);
+    settings.setString("shadow_prefix", "shadow");
 
     // Display Settings
     settings.setBool("display_screen", false);
+
+    // Profiling settings
+    settings.setString("trace_file", "");
+    // Only in builds configured with XITARI_ROM_PROFILER
+    settings.setString("rom_profile", "");
 }
 
 }
@@ -0,0 +1,187 @@
+/* *****************************************************************************
+ * Xitari
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ * *****************************************************************************
+ *  ale_batch_interface.cpp
+ *
+ *  Steps a batch of emulators running the same ROM, in turn or in lockstep.
+ **************************************************************************** */
+
+#include "ale_batch_interface.hpp"
+#include "emucore/TIA.hxx"
+#include "emucore/m6502/src/M6502Lockstep.hxx"
+#include "emucore/m6502/src/System.hxx"
+#include "environment/stella_environment.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+namespace ale {
+
+
+ALEBatchInterface::ALEBatchInterface(const std::string &rom_file, int num_envs,
+                                     bool lockstep) {
+    if (num_envs <= 0)
+        throw std::invalid_argument("ALEBatchInterface needs at least one environment");
+
+    m_envs.reserve(num_envs);
+    try {
+        for (int i = 0; i < num_envs; i++)
+            m_envs.push_back(new ALEInterface(rom_file));
+    } catch (...) {
+        for (size_t i = 0; i < m_envs.size(); i++)
+            delete m_envs[i];
+        throw;
+    }
+
+    if (lockstep) {
+        std::vector<System*> systems;
+        for (size_t i = 0; i < m_envs.size(); i++) {
+            System &system = m_envs[i]->environment().system();
+            if (!M6502Lockstep::supports(system))
+                return;
+            systems.push_back(&system);
+        }
+        m_lockstep.reset(new M6502Lockstep(&systems[0], systems.size()));
+    }
+}
+
+
+ALEBatchInterface::~ALEBatchInterface() {
+    for (size_t i = 0; i < m_envs.size(); i++)
+        delete m_envs[i];
+}
+
+
+double ALEBatchInterface::lockstepShare() const {
+    if (m_lockstep.get() == NULL)
+        return 0;
+    double grouped = m_lockstep->groupedInstructions();
+    double total = grouped + m_lockstep->aloneInstructions();
+    return total > 0 ? grouped / total : 0;
+}
+
+
+void ALEBatchInterface::resetGame() {
+    for (size_t i = 0; i < m_envs.size(); i++)
+        m_envs[i]->resetGame();
+}
+
+
+int ALEBatchInterface::resetEndedGames() {
+    int num_reset = 0;
+    for (size_t i = 0; i < m_envs.size(); i++) {
+        if (m_envs[i]->gameOver()) {
+            m_envs[i]->resetGame();
+            num_reset++;
+        }
+    }
+    return num_reset;
+}
+
+
+void ALEBatchInterface::act2(const Action *actionsA, const Action *actionsB,
+                             ALEStepResult *results) {
+    if (m_lockstep.get() != NULL) {
+        actLockstep(actionsA, actionsB, results);
+        return;
+    }
+
+    ALEStepResult scratch;
+    for (size_t i = 0; i < m_envs.size(); i++) {
+        ALEStepResult &r = (results != NULL) ? results[i] : scratch;
+        m_envs[i]->act2(actionsA[i], actionsB[i], &r.rewardA, &r.rewardB,
+                        &r.sideBouncing, &r.wallBouncing, &r.points, &r.crash,
+                        &r.serving);
+        r.gameOver = m_envs[i]->gameOver();
+    }
+}
+
+
+// act2() in lockstep: each environment's act() and act2() with the frame in
+// the middle, i.e. the TIA's update(), run for all of them at once
+void ALEBatchInterface::actLockstep(const Action *actionsA, const Action *actionsB,
+                                   ALEStepResult *results) {
+    // The environments in a terminal state emulate nothing
+    std::vector<uInt32> lanes;
+    for (size_t i = 0; i < m_envs.size(); i++) {
+        if (m_envs[i]->environment().beginAct(actionsA[i], actionsB[i]))
+            lanes.push_back(i);
+    }
+
+    if (!lanes.empty()) {
+        for (size_t k = 0; k < lanes.size(); k++)
+            m_envs[lanes[k]]->environment().system().tia().startUpdate();
+        m_lockstep->execute(&lanes[0], lanes.size(), TIA::ourInstructionsPerUpdate);
+        for (size_t k = 0; k < lanes.size(); k++) {
+            StellaEnvironment &environment = m_envs[lanes[k]]->environment();
+            environment.system().tia().finishUpdate();
+            environment.endAct();
+        }
+    }
+
+    ALEStepResult scratch;
+    for (size_t i = 0; i < m_envs.size(); i++) {
+        ALEStepResult &r = (results != NULL) ? results[i] : scratch;
+        m_envs[i]->finishAct2(actionsA[i], actionsB[i], &r.rewardA, &r.rewardB,
+                              &r.sideBouncing, &r.wallBouncing, &r.points, &r.crash,
+                              &r.serving);
+        r.gameOver = m_envs[i]->gameOver();
+    }
+}
+
+
+void ALEBatchInterface::stepUntil(const ALECondition &condition, const Action *actionsA,
+                                  const Action *actionsB, int max_frames,
+                                  ALEStepUntilResult *results) {
+    for (size_t i = 0; i < m_envs.size(); i++)
+        results[i] = m_envs[i]->stepUntil(condition, actionsA[i], actionsB[i], max_frames);
+}
+
+
+void ALEBatchInterface::enableRendering(bool mode) {
+    for (size_t i = 0; i < m_envs.size(); i++)
+        m_envs[i]->enableRendering(mode);
+}
+
+
+void ALEBatchInterface::getRAM(byte_t *ram) const {
+    for (size_t i = 0; i < m_envs.size(); i++) {
+        const ALERAM &env_ram = m_envs[i]->getRAM();
+        memcpy(ram + i * env_ram.size(), env_ram.array(), env_ram.size());
+    }
+}
+
+
+void ALEBatchInterface::getFeatures(ALEFeatures *features) const {
+    for (size_t i = 0; i < m_envs.size(); i++)
+        m_envs[i]->getFeatures(features[i]);
+}
+
+
+size_t ALEBatchInterface::screenSize() const {
+    return m_envs[0]->getScreen().arraySize();
+}
+
+
+void ALEBatchInterface::getScreens(pixel_t *screens) const {
+    const size_t screen_size = screenSize();
+    for (size_t i = 0; i < m_envs.size(); i++) {
+        const ALEScreen &screen = m_envs[i]->getScreen();
+        memcpy(screens + i * screen_size, &screen.getArray()[0], screen_size);
+    }
+}
+
+} // namespace ale
@@ -0,0 +1,324 @@
+/* *****************************************************************************
+ * Xitari
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ * *****************************************************************************
+ *  ale_condition.cpp
+ *
+ *  Compiles condition expressions into a small stack machine, and runs it.
+ **************************************************************************** */
+
+#include "ale_condition.hpp"
+
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+namespace ale {
+
+// Deepest the evaluation stack of a condition may get
+#define CONDITION_STACK_SIZE 64
+
+// Deepest parentheses and unary operators may nest, to bound the parser's
+//  recursion
+#define CONDITION_MAX_NESTING 256
+
+enum ConditionOpCode {
+    OP_CONST,
+    OP_RAM,
+    OP_FEATURE,
+    OP_REWARD_A,
+    OP_REWARD_B,
+    OP_FRAMES,
+    OP_NEG,
+    OP_NOT,
+    OP_ADD,
+    OP_SUB,
+    OP_MUL,
+    OP_DIV,
+    OP_MOD,
+    OP_BITAND,
+    OP_EQ,
+    OP_NE,
+    OP_LT,
+    OP_LE,
+    OP_GT,
+    OP_GE,
+    OP_AND,
+    OP_OR
+};
+
+
+// Names of the operands other than ram[n]
+static const struct {
+    const char *name;
+    int code;
+    double value;
+} s_operands[] = {
+    { "ball_x", OP_FEATURE, ALEFeatures::BALL_X },
+    { "ball_y", OP_FEATURE, ALEFeatures::BALL_Y },
+    { "ball_dx", OP_FEATURE, ALEFeatures::BALL_DX },
+    { "ball_dy", OP_FEATURE, ALEFeatures::BALL_DY },
+    { "paddle_a", OP_FEATURE, ALEFeatures::PADDLE_A },
+    { "paddle_b", OP_FEATURE, ALEFeatures::PADDLE_B },
+    { "score_a", OP_FEATURE, ALEFeatures::SCORE_A },
+    { "score_b", OP_FEATURE, ALEFeatures::SCORE_B },
+    { "phase", OP_FEATURE, ALEFeatures::PHASE },
+    { "STOPPED", OP_CONST, ALEFeatures::STOPPED },
+    { "SERVING", OP_CONST, ALEFeatures::SERVING },
+    { "RALLY", OP_CONST, ALEFeatures::RALLY },
+    { "OVER", OP_CONST, ALEFeatures::OVER },
+    { "reward_a", OP_REWARD_A, 0 },
+    { "reward_b", OP_REWARD_B, 0 },
+    { "frames", OP_FRAMES, 0 },
+};
+
+
+// Recursive descent parser, emitting the program in postfix order as it goes
+class ALEConditionParser {
+
+    public:
+
+        ALEConditionParser(ALECondition &condition) :
+            m_condition(condition),
+            m_text(condition.m_expression.c_str()),
+            m_pos(0),
+            m_depth(0),
+            m_nesting(0) {}
+
+        void parse() {
+            parseOr();
+            skipSpaces();
+            if (m_text[m_pos] != '\0')
+                fail("unexpected character");
+        }
+
+    private:
+
+        void parseOr() {
+            parseAnd();
+            while (accept("||")) {
+                parseAnd();
+                emit(OP_OR);
+            }
+        }
+
+        void parseAnd() {
+            parseComparison();
+            while (accept("&&")) {
+                parseComparison();
+                emit(OP_AND);
+            }
+        }
+
+        void parseComparison() {
+            parseSum();
+            int code;
+            if (accept("==")) code = OP_EQ;
+            else if (accept("!=")) code = OP_NE;
+            else if (accept("<=")) code = OP_LE;
+            else if (accept(">=")) code = OP_GE;
+            else if (accept("<")) code = OP_LT;
+            else if (accept(">")) code = OP_GT;
+            else return;
+            parseSum();
+            emit(code);
+        }
+
+        void parseSum() {
+            parseProduct();
+            while (true) {
+                if (accept("+")) { parseProduct(); emit(OP_ADD); }
+                else if (accept("-")) { parseProduct(); emit(OP_SUB); }
+                else return;
+            }
+        }
+
+        void parseProduct() {
+            parseUnary();
+            while (true) {
+                if (accept("*")) { parseUnary(); emit(OP_MUL); }
+                else if (accept("/")) { parseUnary(); emit(OP_DIV); }
+                else if (accept("%")) { parseUnary(); emit(OP_MOD); }
+                // Not the first half of &&
+                else if (peek("&") && !peek("&&")) { accept("&"); parseUnary(); emit(OP_BITAND); }
+                else return;
+            }
+        }
+
+        // Every level of parentheses or unary operators recurses through here
+        void parseUnary() {
+            if (++m_nesting > CONDITION_MAX_NESTING)
+                fail("expression too deeply nested");
+            if (accept("-")) { parseUnary(); emit(OP_NEG); }
+            // Not the first half of !=
+            else if (peek("!") && !peek("!=")) { accept("!"); parseUnary(); emit(OP_NOT); }
+            else parsePrimary();
+            m_nesting--;
+        }
+
+        void parsePrimary() {
+            skipSpaces();
+            if (accept("(")) {
+                parseOr();
+                expect(")");
+                return;
+            }
+
+            if (isdigit(static_cast<unsigned char>(m_text[m_pos]))) {
+                emit(OP_CONST, parseNumber());
+                return;
+            }
+
+            size_t start = m_pos;
+            while (isalnum(static_cast<unsigned char>(m_text[m_pos])) || m_text[m_pos] == '_')
+                m_pos++;
+            std::string name(m_text + start, m_pos - start);
+            if (name.empty()) {
+                m_pos = start;
+                fail("expected an operand");
+            }
+
+            if (name == "ram") {
+                expect("[");
+                skipSpaces();
+                if (!isdigit(static_cast<unsigned char>(m_text[m_pos])))
+                    fail("expected a RAM address");
+                double address = parseNumber();
+                expect("]");
+                emit(OP_RAM, static_cast<int>(address) & 0x7F);
+                return;
+            }
+
+            for (size_t i = 0; i < sizeof(s_operands) / sizeof(s_operands[0]); i++) {
+                if (name == s_operands[i].name) {
+                    emit(s_operands[i].code, s_operands[i].value);
+                    return;
+                }
+            }
+            m_pos = start;
+            fail("unknown operand '" + name + "'");
+        }
+
+        double parseNumber() {
+            const char *start = m_text + m_pos;
+            char *end;
+            double value;
+            if (start[0] == '0' && (start[1] == 'x' || start[1] == 'X'))
+                value = static_cast<double>(strtol(start, &end, 16));
+            else
+                value = strtod(start, &end);
+            m_pos += end - start;
+            return value;
+        }
+
+        void skipSpaces() {
+            while (isspace(static_cast<unsigned char>(m_text[m_pos])))
+                m_pos++;
+        }
+
+        bool peek(const char *token) {
+            skipSpaces();
+            return strncmp(m_text + m_pos, token, strlen(token)) == 0;
+        }
+
+        bool accept(const char *token) {
+            if (!peek(token)) return false;
+            m_pos += strlen(token);
+            return true;
+        }
+
+        void expect(const char *token) {
+            if (!accept(token))
+                fail(std::string("expected '") + token + "'");
+        }
+
+        // Appends an instruction, keeping track of how deep the stack gets
+        void emit(int code, double value = 0) {
+            ALECondition::Op op = { code, value };
+            m_condition.m_program.push_back(op);
+
+            if (code <= OP_FRAMES) m_depth++;
+            else if (code > OP_NOT) m_depth--;
+            if (m_depth > CONDITION_STACK_SIZE)
+                fail("expression too deeply nested");
+        }
+
+        void fail(const std::string &message) {
+            char position[32];
+            snprintf(position, sizeof(position), " at position %d",
+                     static_cast<int>(m_pos) + 1);
+            throw std::invalid_argument("Condition '" + m_condition.m_expression + "': " +
+                                        message + position);
+        }
+
+        ALECondition &m_condition;
+        const char *m_text;
+        size_t m_pos;
+        int m_depth;                // Of the evaluation stack
+        int m_nesting;              // Of parseUnary() calls
+};
+
+
+ALECondition::ALECondition(const std::string &expression) :
+    m_expression(expression) {
+
+    ALEConditionParser(*this).parse();
+}
+
+
+bool ALECondition::evaluate(const ALEConditionInput &input) const {
+    double stack[CONDITION_STACK_SIZE];
+    int top = -1;
+
+    for (size_t i = 0; i < m_program.size(); i++) {
+        const Op &op = m_program[i];
+        switch (op.code) {
+            case OP_CONST: stack[++top] = op.value; break;
+            case OP_RAM: stack[++top] = input.ram[static_cast<int>(op.value)]; break;
+            case OP_FEATURE: stack[++top] = input.features.values[static_cast<int>(op.value)]; break;
+            case OP_REWARD_A: stack[++top] = input.reward_a; break;
+            case OP_REWARD_B: stack[++top] = input.reward_b; break;
+            case OP_FRAMES: stack[++top] = input.frames; break;
+            case OP_NEG: stack[top] = -stack[top]; break;
+            case OP_NOT: stack[top] = (stack[top] == 0); break;
+            default: {
+                double rhs = stack[top--];
+                double &lhs = stack[top];
+                switch (op.code) {
+                    case OP_ADD: lhs += rhs; break;
+                    case OP_SUB: lhs -= rhs; break;
+                    case OP_MUL: lhs *= rhs; break;
+                    case OP_DIV: lhs = (rhs == 0) ? 0 : lhs / rhs; break;
+                    case OP_MOD: lhs = (rhs == 0) ? 0 : fmod(lhs, rhs); break;
+                    case OP_BITAND: lhs = static_cast<long>(lhs) & static_cast<long>(rhs); break;
+                    case OP_EQ: lhs = (lhs == rhs); break;
+                    case OP_NE: lhs = (lhs != rhs); break;
+                    case OP_LT: lhs = (lhs < rhs); break;
+                    case OP_LE: lhs = (lhs <= rhs); break;
+                    case OP_GT: lhs = (lhs > rhs); break;
+                    case OP_GE: lhs = (lhs >= rhs); break;
+                    case OP_AND: lhs = (lhs != 0 && rhs != 0); break;
+                    case OP_OR: lhs = (lhs != 0 || rhs != 0); break;
+                }
+            }
+        }
+    }
+    return stack[0] != 0;
+}
+
+} // namespace ale
@@ -1,4 +1,5 @@
 #include "ale_interface.hpp"
+#include "ale_condition.hpp"
 
 #include "emucore/FSNode.hxx"
 #include "emucore/OSystem.hxx"
@@ -9,7 +10,10 @@
 #include "games/Roms.hpp"
 #include "common/Defaults.hpp"
 #include "common/display_screen.h"
+#include "common/timeline.hpp"
 #include "environment/stella_environment.hpp"
+#include "environment/action_log.hpp"
+#include "environment/trajectory_recorder.hpp"
 #include "games/RomSettings.hpp"
 
 #include <stdexcept>
@@ -164,15 +168,23 @@ class ALEInterface::Impl {
         reward_t act(Action action);
         void act2(Action actionA,Action actionB,double* rewardA,double* rewardB,double* sideBouncing,bool* wallBouncing,int* points,bool* crash,bool* serving);
 
+        // What act2() does once the environment has acted
+        void finishAct2(Action actionA,Action actionB,double* rewardA,double* rewardB,double* sideBouncing,bool* wallBouncing,int* points,bool* crash,bool* serving);
+
+        // Plays the script_length entries of script in a loop until condition holds
+        ALEStepUntilResult stepUntil(const ALECondition &condition,
+                                     const ALEScriptedAction *script,
+                                     size_t script_length, int max_frames);
+
         // Returns the vector of legal actions.
-        ActionVect getLegalActionSet();
-        ActionVect getLegalActionSetB();
+        const ActionVect &getLegalActionSet();
+        const ActionVect &getLegalActionSetB();
 
 
 
         // Returns the vector of the minimal set of actions needed to play the game.
-        ActionVect getMinimalActionSet();
-	ActionVect getMinimalActionSetB();
+        const ActionVect &getMinimalActionSet();
+	const ActionVect &getMinimalActionSetB();
         // Minimum possible instantaneous reward.
         reward_t minReward() const;
 
@@ -195,12 +207,33 @@ class ALEInterface::Impl {
         // Returns the current game screen
         const ALEScreen &getScreen() const;
 
+        // Enables/disables screen rendering
+        void enableRendering(bool mode);
+
         // Writes a screen out to PNG
         bool screenToPNG(const std::string &filename);
 
+        // Starts/stops recording every step to a trajectory file
+        void startRecording(const std::string &filename, bool screens);
+        void stopRecording();
+
+        // Starts/stops logging actions for replay
+        void startActionLog(const std::string &filename, int checksum_interval);
+        void stopActionLog();
+
+        // Returns/clears the time spent in each stage of stepping
+        ALEStepStats getStepStats() const;
+        void resetStepStats();
+
         // Returns the current RAM content
         const ALERAM &getRAM() const;
 
+        // Returns the emulator's RAM itself
+        const byte_t *getRAMView() const;
+
+        // Returns the game state decoded from RAM
+        void getFeatures(ALEFeatures &features) const;
+
         // Saves the state of the system
         void saveState();
 
@@ -218,6 +251,7 @@ class ALEInterface::Impl {
         const Settings &settings() const;
         const RomSettings &romSettings() const;
         const StellaEnvironment &environment() const;
+        StellaEnvironment &environment();
 
         /** Get the current version of the ALE interface.
             Major versions indicate significant changes that might break backward compatibility.
@@ -239,6 +273,12 @@ class ALEInterface::Impl {
         // Loads and initializes a game. After this call the game should be ready to play.
         void loadROM(const std::string &rom_file);
 
+        // Appends the step just taken to the trajectory being recorded
+        void recordStep(Action actionA, Action actionB);
+
+        // Appends the step just taken to the action log
+        void logStep(Action actionA, Action actionB);
+
         std::auto_ptr<Emulator> m_emu;
         std::auto_ptr<RomSettings> m_rom_settings;
 
@@ -246,6 +286,8 @@ class ALEInterface::Impl {
 	reward_t m_episode_scoreB;
         bool m_display_active;    // Should the screen be displayed or not
         int m_max_num_frames;     // Maximum number of frames for each episode
+        std::unique_ptr<TrajectoryWriter> m_recorder; // Set while recording
+        std::unique_ptr<ActionLogWriter> m_action_log; // Set while logging actions
 };
 
 
@@ -297,7 +339,10 @@ void ALEInterface::Impl::loadROM(const std::string &rom_file) {
 
 
 bool ALEInterface::Impl::loadState() {
-    return m_emu->environment->load();
+    bool loaded = m_emu->environment->load();
+    if (loaded && m_action_log.get())
+        m_action_log->state(getSnapshot());
+    return loaded;
 }
 
 
@@ -308,6 +353,9 @@ bool ALEInterface::Impl::game_over() const {
 
 void ALEInterface::Impl::reset_game() {
     m_emu->environment->reset();
+    // Resets may draw on the random seed, so replay starts from the result
+    if (m_action_log.get())
+        m_action_log->state(getSnapshot());
 }
 
 
@@ -326,6 +374,8 @@ void ALEInterface::Impl::restoreSnapshot(const std::string &snapshot) {
     ALEState state(snapshot);
 
     m_emu->environment->restoreState(state);
+    if (m_action_log.get())
+        m_action_log->state(snapshot);
 }
 
 
@@ -334,11 +384,26 @@ const ALERAM &ALEInterface::Impl::getRAM() const {
 }
 
 
+const byte_t *ALEInterface::Impl::getRAMView() const {
+    return m_emu->environment->getRAMView();
+}
+
+
+void ALEInterface::Impl::getFeatures(ALEFeatures &features) const {
+    m_rom_settings->getFeatures(features);
+}
+
+
 const ALEScreen &ALEInterface::Impl::getScreen() const {
     return m_emu->environment->getScreen();
 }
 
 
+void ALEInterface::Impl::enableRendering(bool mode) {
+    m_emu->environment->enableRendering(mode);
+}
+
+
 void ALEInterface::Impl::setMaxNumFrames(int newMax) {
     m_max_num_frames = newMax;
 }
@@ -354,22 +419,22 @@ int ALEInterface::Impl::getFrameNumber() const {
 }
 
 
-ActionVect ALEInterface::Impl::getMinimalActionSet() {
+const ActionVect &ALEInterface::Impl::getMinimalActionSet() {
 
     return m_rom_settings->getMinimalActionSet();
 }
 
-ActionVect ALEInterface::Impl::getMinimalActionSetB() {
+const ActionVect &ALEInterface::Impl::getMinimalActionSetB() {
 
     return m_rom_settings->getMinimalActionSetB();
 }
 
-ActionVect ALEInterface::Impl::getLegalActionSet() {
+const ActionVect &ALEInterface::Impl::getLegalActionSet() {
     
     return m_rom_settings->getAllActions();
 }
 
-ActionVect ALEInterface::Impl::getLegalActionSetB() {
+const ActionVect &ALEInterface::Impl::getLegalActionSetB() {
     
     return m_rom_settings->getAllActionsB();
 }
@@ -399,8 +464,12 @@ int ALEInterface::Impl::livesB() const {
 reward_t ALEInterface::Impl::act(Action action) {
     if (action < PLAYER_B_NOOP) {
         m_emu->environment->act(action, PLAYER_B_NOOP);
+        if (m_recorder.get()) recordStep(action, PLAYER_B_NOOP);
+        if (m_action_log.get()) logStep(action, PLAYER_B_NOOP);
     } else {
         m_emu->environment->act(PLAYER_A_NOOP, action);
+        if (m_recorder.get()) recordStep(PLAYER_A_NOOP, action);
+        if (m_action_log.get()) logStep(PLAYER_A_NOOP, action);
     }
     reward_t reward = m_rom_settings->getReward();
 
@@ -417,6 +486,11 @@ reward_t ALEInterface::Impl::act(Action action) {
 void ALEInterface::Impl::act2(Action actionA,Action actionB,double* rewardA,double* rewardB,double* sideBouncing,bool* wallBouncing,int* points,bool* crash,bool* serving) {
     
     m_emu->environment->act(actionA, actionB);
+    finishAct2(actionA, actionB, rewardA, rewardB, sideBouncing, wallBouncing, points, crash, serving);
+}
+
+void ALEInterface::Impl::finishAct2(Action actionA,Action actionB,double* rewardA,double* rewardB,double* sideBouncing,bool* wallBouncing,int* points,bool* crash,bool* serving) {
+
     (*rewardA)      = m_rom_settings->getReward();
     (*rewardB)      = m_rom_settings->getRewardB();
     (*sideBouncing) = m_rom_settings->getSideBouncing();
@@ -424,6 +498,11 @@ void ALEInterface::Impl::act2(Action actionA,Action actionB,double* rewardA,doub
     (*crash) = m_rom_settings->getCrash();
     (*points) = m_rom_settings->getPoints();
     (*serving) = m_rom_settings->getServing();
+
+    if (m_recorder.get())
+        recordStep(actionA, actionB);
+    if (m_action_log.get())
+        logStep(actionA, actionB);
     
     // sanity check rewards
     assert((*rewardA) <= m_rom_settings->maxReward());
@@ -438,6 +517,43 @@ void ALEInterface::Impl::act2(Action actionA,Action actionB,double* rewardA,doub
 }
 
 
+ALEStepUntilResult ALEInterface::Impl::stepUntil(const ALECondition &condition,
+                                                 const ALEScriptedAction *script,
+                                                 size_t script_length, int max_frames) {
+    ALEStepUntilResult result = { 0, 0, 0, false, false };
+    ALEConditionInput input;
+    input.ram = getRAMView();
+
+    size_t entry = 0;
+    int held = 0;
+    while (result.frames < max_frames && !game_over()) {
+        double side_bouncing;
+        bool wall_bouncing, crash, serving;
+        int points;
+        act2(script[entry].actionA, script[entry].actionB, &input.reward_a, &input.reward_b,
+             &side_bouncing, &wall_bouncing, &points, &crash, &serving);
+        if (++held == script[entry].frames) {
+            held = 0;
+            entry = (entry + 1) % script_length;
+        }
+
+        result.frames++;
+        result.rewardA += input.reward_a;
+        result.rewardB += input.reward_b;
+
+        getFeatures(input.features);
+        input.frames = result.frames;
+        if (condition.evaluate(input)) {
+            result.reached = true;
+            break;
+        }
+    }
+
+    result.gameOver = game_over();
+    return result;
+}
+
+
 ALEInterface::Impl::Impl(const std::string &rom_file) :
     m_episode_score(0),
     m_display_active(false)
@@ -468,6 +584,83 @@ const StellaEnvironment &ALEInterface::Impl::environment() const {
     return *m_emu->environment;
 }
 
+StellaEnvironment &ALEInterface::Impl::environment() {
+
+    return *m_emu->environment;
+}
+
+
+void ALEInterface::Impl::startRecording(const std::string &filename, bool screens) {
+    const ALEScreen &screen = getScreen();
+    // Close any previous recording before creating the new file
+    stopRecording();
+    m_recorder.reset(new TrajectoryWriter(filename, getRAM().size(),
+        screen.width(), screen.height(), screens));
+}
+
+
+void ALEInterface::Impl::stopRecording() {
+    // Let go of the recorder first, so that it is gone even if closing throws
+    std::unique_ptr<TrajectoryWriter> recorder(m_recorder.release());
+    if (recorder.get())
+        recorder->close();
+}
+
+
+void ALEInterface::Impl::startActionLog(const std::string &filename, int checksum_interval) {
+    // Close any previous log before creating the new file
+    stopActionLog();
+    m_action_log.reset(new ActionLogWriter(filename, checksum_interval));
+    m_action_log->state(getSnapshot());
+}
+
+
+void ALEInterface::Impl::stopActionLog() {
+    // Let go of the log first, so that it is gone even if closing throws
+    std::unique_ptr<ActionLogWriter> action_log(m_action_log.release());
+    if (action_log.get())
+        action_log->close();
+}
+
+
+ALEStepStats ALEInterface::Impl::getStepStats() const {
+    ALEStepStats stats;
+    m_emu->environment->getStepStats(stats);
+    return stats;
+}
+
+
+void ALEInterface::Impl::resetStepStats() {
+    m_emu->environment->resetStepStats();
+}
+
+
+void ALEInterface::Impl::logStep(Action actionA, Action actionB) {
+    const ALERAM &ram = getRAM();
+    m_action_log->step(actionA, actionB, m_rom_settings->getReward(),
+                       m_rom_settings->getRewardB(), ram.array(), ram.size(),
+                       getFrameNumber());
+}
+
+
+void ALEInterface::Impl::recordStep(Action actionA, Action actionB) {
+    TrajectoryStep step;
+    step.frame = getFrameNumber();
+    step.episode_frame = getEpisodeFrameNumber();
+    step.action_a = actionA;
+    step.action_b = actionB;
+    step.reward_a = m_rom_settings->getReward();
+    step.reward_b = m_rom_settings->getRewardB();
+    step.side_bouncing = m_rom_settings->getSideBouncing();
+    step.points = m_rom_settings->getPoints();
+    step.wall_bouncing = m_rom_settings->getWallBouncing();
+    step.crash = m_rom_settings->getCrash();
+    step.serving = m_rom_settings->getServing();
+    step.game_over = game_over();
+
+    m_recorder->record(step, getRAM().array(), &getScreen().getArray()[0]);
+}
+
 
 bool ALEInterface::Impl::screenToPNG(const std::string &filename) {
 
@@ -530,11 +723,26 @@ const ALERAM &ALEInterface::getRAM() const {
 }
 
 
+const byte_t *ALEInterface::getRAMView() const {
+    return m_pimpl->getRAMView();
+}
+
+
+void ALEInterface::getFeatures(ALEFeatures &features) const {
+    m_pimpl->getFeatures(features);
+}
+
+
 const ALEScreen &ALEInterface::getScreen() const {
     return m_pimpl->getScreen();
 }
 
 
+void ALEInterface::enableRendering(bool mode) {
+    m_pimpl->enableRendering(mode);
+}
+
+
 void ALEInterface::setMaxNumFrames(int newMax) {
     m_pimpl->setMaxNumFrames(newMax);
 }
@@ -550,18 +758,18 @@ int ALEInterface::getFrameNumber() const {
 }
 
 
-ActionVect ALEInterface::getMinimalActionSet() {
+const ActionVect &ALEInterface::getMinimalActionSet() {
     return m_pimpl->getMinimalActionSet();
 }
 
-ActionVect ALEInterface::getMinimalActionSetB() {
+const ActionVect &ALEInterface::getMinimalActionSetB() {
     return m_pimpl->getMinimalActionSetB();
 }
 
-ActionVect ALEInterface::getLegalActionSet() {
+const ActionVect &ALEInterface::getLegalActionSet() {
     return m_pimpl->getLegalActionSet();
 }
-ActionVect ALEInterface::getLegalActionSetB() {
+const ActionVect &ALEInterface::getLegalActionSetB() {
     return m_pimpl->getLegalActionSetB();
 }
 
@@ -590,6 +798,33 @@ void ALEInterface::act2(Action actionA,Action actionB,double* rewardA,double* re
      m_pimpl->act2(actionA,actionB,rewardA,rewardB,sideBouncing, wallBouncing, points,crash,serving);
 }
 
+StellaEnvironment &ALEInterface::environment() {
+
+    return m_pimpl->environment();
+}
+
+void ALEInterface::finishAct2(Action actionA,Action actionB,double* rewardA,double* rewardB,double* sideBouncing,bool* wallBouncing,int* points,bool* crash,bool* serving){
+     m_pimpl->finishAct2(actionA,actionB,rewardA,rewardB,sideBouncing, wallBouncing, points,crash,serving);
+}
+
+ALEStepUntilResult ALEInterface::stepUntil(const ALECondition &condition, Action actionA,
+                                           Action actionB, int max_frames) {
+    ALEScriptedAction script = { actionA, actionB, 1 };
+    return m_pimpl->stepUntil(condition, &script, 1, max_frames);
+}
+
+ALEStepUntilResult ALEInterface::stepUntil(const ALECondition &condition,
+                                           const std::vector<ALEScriptedAction> &script,
+                                           int max_frames) {
+    if (script.empty())
+        throw std::invalid_argument("stepUntil needs a non-empty action script");
+    for (size_t i = 0; i < script.size(); i++) {
+        if (script[i].frames < 1)
+            throw std::invalid_argument("stepUntil's action script holds an entry for less than a frame");
+    }
+    return m_pimpl->stepUntil(condition, &script[0], script.size(), max_frames);
+}
+
 ALEInterface::ALEInterface(const std::string &rom_file) :
     m_pimpl(new ALEInterface::Impl(rom_file))
 {
@@ -608,6 +843,60 @@ bool ALEInterface::screenToPNG(const std::string &filename) {
 }
 
 
+void ALEInterface::startRecording(const std::string &filename, bool screens) {
+
+    m_pimpl->startRecording(filename, screens);
+}
+
+
+void ALEInterface::stopRecording() {
+
+    m_pimpl->stopRecording();
+}
+
+
+void ALEInterface::startActionLog(const std::string &filename, int checksum_interval) {
+
+    m_pimpl->startActionLog(filename, checksum_interval);
+}
+
+
+void ALEInterface::stopActionLog() {
+
+    m_pimpl->stopActionLog();
+}
+
+
+ALEStepStats ALEInterface::getStepStats() const {
+
+    return m_pimpl->getStepStats();
+}
+
+
+void ALEInterface::resetStepStats() {
+
+    m_pimpl->resetStepStats();
+}
+
+
+void ALEInterface::startTrace(const std::string &filename) {
+
+    Timeline::start(filename);
+}
+
+
+void ALEInterface::flushTrace() {
+
+    Timeline::flush();
+}
+
+
+void ALEInterface::stopTrace() {
+
+    Timeline::stop();
+}
+
+
 ALEInterface::~ALEInterface() {
     delete m_pimpl;
 }
@@ -635,6 +924,29 @@ const ALEScreen &ALEScreen::operator=(const ALEScreen &rhs) {
 }
 
 
+ALEStepStats::ALEStepStats() :
+    enabled(false),
+    steps(0),
+    step_seconds(0),
+    step_p50(0),
+    step_p99(0),
+    step_max(0) {
+    for (int s = 0; s < NUM_STAGES; s++) {
+        seconds[s] = 0;
+        calls[s] = 0;
+    }
+}
+
+
+const char *ALEStepStats::stageName(int stage) {
+    static const char *names[NUM_STAGES] = {
+        "cpu", "tia_render", "rom_step", "process_screen", "process_ram",
+        "reset", "save_state", "load_state"
+    };
+    return (stage >= 0 && stage < NUM_STAGES) ? names[stage] : "unknown";
+}
+
+
 ALERAM::ALERAM() {}
 
 
@@ -0,0 +1,176 @@
+/* *****************************************************************************
+ * Xitari
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ * *****************************************************************************
+ *  screen_delta.cpp
+ *
+ *  Encodes a stream of screens as differences from the previous one.
+ **************************************************************************** */
+
+#include "screen_delta.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define SCREEN_DELTA_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace ale {
+
+// Unchanged gaps up to this long are sent as literals: a new run would cost
+// at least as much
+#define MAX_MERGED_GAP 2
+
+
+static inline uInt32 countTrailingZeros(uInt32 mask) {
+#if defined(__GNUC__)
+    return __builtin_ctz(mask);
+#else
+    uInt32 n = 0;
+    while (!(mask & 1)) { mask >>= 1; n++; }
+    return n;
+#endif
+}
+
+
+// Returns the first i in [pos, size) where a and b differ (equal == false),
+// or agree (equal == true); size if there is none.
+template<bool equal>
+static size_t findPixel(const uInt8 *a, const uInt8 *b, size_t pos, size_t size) {
+#ifdef SCREEN_DELTA_SSE2
+    for (; pos + 16 <= size; pos += 16) {
+        __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + pos));
+        __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + pos));
+        uInt32 mask = _mm_movemask_epi8(_mm_cmpeq_epi8(va, vb));
+        if (!equal) mask ^= 0xFFFF;
+        if (mask != 0)
+            return pos + countTrailingZeros(mask);
+    }
+#endif
+    for (; pos < size; pos++) {
+        if ((a[pos] == b[pos]) == equal)
+            return pos;
+    }
+    return size;
+}
+
+
+static inline uInt8 *writeVarint(uInt8 *out, size_t value) {
+    while (value >= 0x80) {
+        *out++ = static_cast<uInt8>(value | 0x80);
+        value >>= 7;
+    }
+    *out++ = static_cast<uInt8>(value);
+    return out;
+}
+
+
+static inline bool readVarint(const uInt8 *&data, const uInt8 *end, size_t &value) {
+    value = 0;
+    for (int shift = 0; data < end && shift < 64; shift += 7) {
+        uInt8 b = *data++;
+        value |= static_cast<size_t>(b & 0x7F) << shift;
+        if (!(b & 0x80))
+            return true;
+    }
+    return false;
+}
+
+
+ScreenDeltaEncoder::ScreenDeltaEncoder(size_t frame_size) :
+    m_reference(frame_size, 0) {
+}
+
+
+size_t ScreenDeltaEncoder::maxEncodedSize(size_t frame_size) {
+    // Every run but the last is followed by a gap longer than MAX_MERGED_GAP,
+    // and a run header takes at most two 10-byte varints
+    size_t max_runs = frame_size / (MAX_MERGED_GAP + 2) + 1;
+    return frame_size + max_runs * 20;
+}
+
+
+size_t ScreenDeltaEncoder::encode(const uInt8 *frame, uInt8 *out) {
+    const size_t size = m_reference.size();
+    uInt8 *ref = &m_reference[0];
+    uInt8 *start_out = out;
+
+    size_t last_end = 0;
+    size_t start = findPixel<false>(frame, ref, 0, size);
+    while (start < size) {
+        size_t end = findPixel<true>(frame, ref, start, size);
+
+        // Swallow short unchanged gaps into the literal run
+        size_t next = size;
+        while (end < size) {
+            next = findPixel<false>(frame, ref, end, size);
+            if (next >= size || next - end > MAX_MERGED_GAP)
+                break;
+            end = findPixel<true>(frame, ref, next, size);
+        }
+
+        out = writeVarint(out, start - last_end);
+        out = writeVarint(out, end - start);
+        memcpy(out, frame + start, end - start);
+        memcpy(ref + start, frame + start, end - start);
+        out += end - start;
+
+        last_end = end;
+        start = (end < size) ? next : size;
+    }
+
+    return out - start_out;
+}
+
+
+void ScreenDeltaEncoder::reset() {
+    std::fill(m_reference.begin(), m_reference.end(), 0);
+}
+
+
+ScreenDeltaDecoder::ScreenDeltaDecoder(size_t frame_size) :
+    m_frame(frame_size, 0) {
+}
+
+
+bool ScreenDeltaDecoder::decode(const uInt8 *data, size_t length) {
+    const uInt8 *end = data + length;
+    size_t pos = 0;
+
+    while (data < end) {
+        size_t skip, literal;
+        if (!readVarint(data, end, skip) || !readVarint(data, end, literal))
+            return false;
+        if (skip > m_frame.size() - pos || literal > m_frame.size() - pos - skip ||
+            literal > static_cast<size_t>(end - data))
+            return false;
+
+        pos += skip;
+        memcpy(&m_frame[pos], data, literal);
+        pos += literal;
+        data += literal;
+    }
+
+    return true;
+}
+
+
+void ScreenDeltaDecoder::reset() {
+    std::fill(m_frame.begin(), m_frame.end(), 0);
+}
+
+} // namespace ale
@@ -0,0 +1,92 @@
+/* *****************************************************************************
+ * Xitari
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ * *****************************************************************************
+ *  screen_delta.hpp
+ *
+ *  Encodes a stream of screens as differences from the previous one.
+ *
+ *  An encoded screen is a sequence of runs, each made of two LEB128
+ *  varints, the number of unchanged pixels to skip and the number of
+ *  literal pixels that follow, and then the literal pixels themselves.
+ *  Pixels past the last run are unchanged. An identical screen therefore
+ *  encodes to zero bytes.
+ **************************************************************************** */
+
+#ifndef __SCREEN_DELTA_HPP__
+#define __SCREEN_DELTA_HPP__
+
+#include <cstddef>
+#include <vector>
+
+#include "emucore/m6502/src/bspf/src/bspf.hxx"
+
+namespace ale {
+
+
+class ScreenDeltaEncoder {
+
+    public:
+
+        /** Creates an encoder for screens of frame_size pixels. The first
+            screen is encoded against an all-zero one. */
+        ScreenDeltaEncoder(size_t frame_size);
+
+        /** Largest possible encoding of a screen of frame_size pixels. */
+        static size_t maxEncodedSize(size_t frame_size);
+
+        /** Encodes frame against the previously encoded one into out, which
+            must hold maxEncodedSize() bytes. Returns the encoded size. */
+        size_t encode(const uInt8 *frame, uInt8 *out);
+
+        /** Makes the next screen encode against an all-zero one, for
+            decoders that start from scratch. */
+        void reset();
+
+        size_t frameSize() const { return m_reference.size(); }
+
+    private:
+
+        std::vector<uInt8> m_reference; // Last screen encoded
+};
+
+
+class ScreenDeltaDecoder {
+
+    public:
+
+        /** Creates a decoder for screens of frame_size pixels, starting from
+            an all-zero screen. */
+        ScreenDeltaDecoder(size_t frame_size);
+
+        /** Applies an encoded screen. Returns false, leaving the screen
+            partially updated, if the data is malformed. */
+        bool decode(const uInt8 *data, size_t length);
+
+        /** Resets the screen to all zeros, to match ScreenDeltaEncoder::reset(). */
+        void reset();
+
+        /** The current screen. */
+        const uInt8 *frame() const { return &m_frame[0]; }
+        size_t frameSize() const { return m_frame.size(); }
+
+    private:
+
+        std::vector<uInt8> m_frame;
+};
+
+} // namespace ale
+
+#endif // __SCREEN_DELTA_HPP__
@@ -0,0 +1,173 @@
+/* *****************************************************************************
+ * Xitari
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ * *****************************************************************************
+ *  screen_palette.cpp
+ *
+ *  Compacts screens to the handful of colours a ROM actually uses.
+ **************************************************************************** */
+
+#include "screen_palette.hpp"
+
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define SCREEN_PALETTE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace ale {
+
+
+ScreenPalette::ScreenPalette() {
+    clear();
+}
+
+
+void ScreenPalette::compact(const uInt8 *frame, size_t n, uInt8 *codes) {
+    for (size_t i = 0; i < n; i++) {
+        uInt8 colour = frame[i];
+        if (!m_known[colour]) {
+            m_known[colour] = true;
+            m_codes[colour] = static_cast<uInt8>(m_size);
+            m_colours[m_size++] = colour;
+        }
+        codes[i] = m_codes[colour];
+    }
+}
+
+
+void ScreenPalette::expand(const uInt8 *codes, size_t n, uInt8 *frame) const {
+    for (size_t i = 0; i < n; i++)
+        frame[i] = m_colours[codes[i]];
+}
+
+
+int ScreenPalette::codeBits() const {
+    if (m_size <= 2) return 1;
+    if (m_size <= 4) return 2;
+    if (m_size <= 16) return 4;
+    return 8;
+}
+
+
+void ScreenPalette::clear() {
+    memset(m_codes, 0, sizeof(m_codes));
+    memset(m_known, 0, sizeof(m_known));
+    memset(m_colours, 0, sizeof(m_colours));
+    m_size = 0;
+}
+
+
+size_t packedCodesSize(size_t n, int bits) {
+    return (n * bits + 7) / 8;
+}
+
+
+size_t codesBufferSize(size_t n) {
+    return (n + 15) & ~static_cast<size_t>(15);
+}
+
+
+// Packing goes in rounds, each merging pairs of neighbouring values of
+// 'bits' bits into one of 2 * bits bits, until they fill bytes; unpacking
+// runs the rounds backwards. Counts are kept even by the zero padding up
+// to codesBufferSize().
+
+// data[i] = data[2i] | data[2i + 1] << bits, for i < n / 2
+static void mergePairs(uInt8 *data, size_t n, int bits) {
+    size_t i = 0;
+#ifdef SCREEN_PALETTE_SSE2
+    // Seen as 16-bit lanes, each pair is a lane: fold its high byte into
+    //  the low one, then narrow the lanes back to bytes. Blocks are written
+    //  below where they are read, so this works in place.
+    const __m128i low = _mm_set1_epi16(0x00FF);
+    const __m128i shift = _mm_cvtsi32_si128(bits);
+    for (; 2 * i + 32 <= n; i += 16) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 2 * i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 2 * i + 16));
+        a = _mm_or_si128(_mm_and_si128(a, low), _mm_sll_epi16(_mm_srli_epi16(a, 8), shift));
+        b = _mm_or_si128(_mm_and_si128(b, low), _mm_sll_epi16(_mm_srli_epi16(b, 8), shift));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(data + i), _mm_packus_epi16(a, b));
+    }
+#endif
+    for (; 2 * i < n; i++)
+        data[i] = static_cast<uInt8>(data[2 * i] | (data[2 * i + 1] << bits));
+}
+
+
+// data[2i] = data[i] & mask, data[2i + 1] = data[i] >> bits, for i < n / 2
+static void splitPairs(uInt8 *data, size_t n, int bits) {
+    const uInt8 mask = static_cast<uInt8>((1 << bits) - 1);
+    size_t i = n / 2;
+
+    // Go backwards, so that nothing is overwritten before it is read
+#ifdef SCREEN_PALETTE_SSE2
+    const __m128i vmask = _mm_set1_epi8(static_cast<char>(mask));
+    const __m128i shift = _mm_cvtsi32_si128(bits);
+    // Values that have to stay put until the vector loop reaches them
+    size_t tail = i % 16;
+    while (tail > 0) {
+        i--; tail--;
+        uInt8 v = data[i];
+        data[2 * i] = v & mask;
+        data[2 * i + 1] = v >> bits;
+    }
+    while (i >= 16) {
+        i -= 16;
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        // The byte-wise shift is done on 16-bit lanes, so mask afterwards
+        __m128i lo = _mm_and_si128(v, vmask);
+        __m128i hi = _mm_and_si128(_mm_srl_epi16(v, shift), vmask);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(data + 2 * i), _mm_unpacklo_epi8(lo, hi));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(data + 2 * i + 16), _mm_unpackhi_epi8(lo, hi));
+    }
+#endif
+    while (i > 0) {
+        i--;
+        uInt8 v = data[i];
+        data[2 * i] = v & mask;
+        data[2 * i + 1] = v >> bits;
+    }
+}
+
+
+size_t packCodes(uInt8 *codes, size_t n, int bits) {
+    size_t count = codesBufferSize(n);
+    memset(codes + n, 0, count - n);
+
+    for (int b = bits; b < 8; b *= 2) {
+        mergePairs(codes, count, b);
+        count /= 2;
+    }
+    return packedCodesSize(n, bits);
+}
+
+
+void unpackCodes(uInt8 *data, size_t n, int bits) {
+    size_t count = codesBufferSize(n);
+
+    // Walk the rounds of packCodes() backwards
+    int rounds = 0;
+    for (int b = bits; b < 8; b *= 2)
+        rounds++;
+
+    for (int r = rounds; r > 0; r--) {
+        int b = bits << (r - 1);
+        splitPairs(data, count >> (r - 1), b);
+    }
+}
+
+} // namespace ale
@@ -0,0 +1,91 @@
+/* *****************************************************************************
+ * Xitari
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ * *****************************************************************************
+ *  screen_palette.hpp
+ *
+ *  Compacts screens to the handful of colours a ROM actually uses.
+ *
+ *  A ScreenPalette hands out codes 0, 1, 2, ... to palette indices in the
+ *  order they first appear, and never changes a code once given, so codes
+ *  from different frames of a run can be compared directly. Codes are then
+ *  bit-packed at the smallest width that holds the palette (1, 2 or 4 bits;
+ *  8 past 16 colours), low-order bits first: at 4 bits, pixel 0 is the low
+ *  nibble of byte 0.
+ **************************************************************************** */
+
+#ifndef __SCREEN_PALETTE_HPP__
+#define __SCREEN_PALETTE_HPP__
+
+#include <cstddef>
+
+#include "emucore/m6502/src/bspf/src/bspf.hxx"
+
+namespace ale {
+
+
+class ScreenPalette {
+
+    public:
+
+        ScreenPalette();
+
+        /** Maps the n pixels of frame to codes, giving new codes to colours
+            not seen before. */
+        void compact(const uInt8 *frame, size_t n, uInt8 *codes);
+
+        /** Maps n codes back to palette indices. */
+        void expand(const uInt8 *codes, size_t n, uInt8 *frame) const;
+
+        /** Number of colours seen so far. */
+        int size() const { return m_size; }
+
+        /** Palette index of a code. */
+        uInt8 colour(int code) const { return m_colours[code]; }
+
+        /** Smallest code width (1, 2, 4 or 8 bits) that holds every code. */
+        int codeBits() const;
+
+        /** Forgets every colour. */
+        void clear();
+
+    private:
+
+        uInt8 m_codes[256];   // Code of each palette index, if m_known
+        bool m_known[256];
+        uInt8 m_colours[256]; // Palette index of each code
+        int m_size;
+};
+
+
+/** Number of bytes n codes take when packed at bits per code. */
+size_t packedCodesSize(size_t n, int bits);
+
+/** Size of the scratch buffer packCodes()/unpackCodes() work in: n rounded
+    up to a multiple of 16. */
+size_t codesBufferSize(size_t n);
+
+/** Packs n codes of at most bits bits in place; codes must hold
+    codesBufferSize(n) bytes. Returns packedCodesSize(n, bits). */
+size_t packCodes(uInt8 *codes, size_t n, int bits);
+
+/** Inverse of packCodes(): unpacks the packedCodesSize(n, bits) bytes at
+    the start of data, which must hold codesBufferSize(n) bytes, into n
+    codes in place. */
+void unpackCodes(uInt8 *data, size_t n, int bits);
+
+} // namespace ale
+
+#endif // __SCREEN_PALETTE_HPP__
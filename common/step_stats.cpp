@@ -0,0 +1,160 @@
+/* *****************************************************************************
+ * Xitari
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ * *****************************************************************************
+ *  step_stats.cpp
+ *
+ *  Per-stage timing of environment steps (see ALEStepStats).
+ **************************************************************************** */
+
+#include "step_stats.hpp"
+
+#ifdef __USE_STEP_STATS
+
+#include <chrono>
+#include <cstring>
+
+namespace ale {
+
+
+static inline int mostSignificantBit(::uint64_t x) {
+#if defined(__GNUC__)
+    return 63 - __builtin_clzll(x);
+#else
+    int n = 0;
+    while (x >>= 1) n++;
+    return n;
+#endif
+}
+
+
+// Bucket b >= 8 holds [(4 + b % 4) << (b / 4 - 2), (5 + b % 4) << (b / 4 - 2));
+// buckets 0 to 3 hold 0 to 3 ticks exactly, and 4 to 7 are never used.
+static inline int bucketOf(::uint64_t ticks) {
+    if (ticks < 4) return static_cast<int>(ticks);
+    int msb = mostSignificantBit(ticks);
+    return 4 * msb + static_cast<int>((ticks >> (msb - 2)) & 3);
+}
+
+
+static double bucketLower(int bucket) {
+    if (bucket < 8) return bucket;
+    return static_cast<double>(4 + bucket % 4) * static_cast<double>(1ULL << (bucket / 4 - 2));
+}
+
+
+static double bucketUpper(int bucket) {
+    if (bucket < 8) return bucket + 1;
+    return static_cast<double>(5 + bucket % 4) * static_cast<double>(1ULL << (bucket / 4 - 2));
+}
+
+
+// Measured once, against steady_clock, the first time stats are read
+static double ticksPerSecond() {
+#ifdef STEP_STATS_RDTSC
+    static const double rate = [] {
+        typedef std::chrono::steady_clock Clock;
+        Clock::time_point start = Clock::now();
+        ::uint64_t start_ticks = stepStatsTicks();
+        Clock::time_point now;
+        do {
+            now = Clock::now();
+        } while (now - start < std::chrono::milliseconds(20));
+        ::uint64_t ticks = stepStatsTicks() - start_ticks;
+        return ticks / std::chrono::duration<double>(now - start).count();
+    }();
+    return rate;
+#else
+    return 1e9;
+#endif
+}
+
+
+StepStats::StepStats() {
+    clear(0, 0);
+}
+
+
+void StepStats::addStep(::uint64_t ticks) {
+    m_steps++;
+    m_step_ticks += ticks;
+    if (ticks > m_step_max) m_step_max = ticks;
+    m_histogram[bucketOf(ticks)]++;
+}
+
+
+void StepStats::fill(ALEStepStats &stats, ::uint64_t render_ticks,
+                     ::uint64_t render_calls) const {
+    double scale = 1.0 / ticksPerSecond();
+
+    stats.enabled = true;
+    for (int s = 0; s < ALEStepStats::NUM_STAGES; s++) {
+        stats.seconds[s] = m_ticks[s] * scale;
+        stats.calls[s] = m_calls[s];
+    }
+
+    // The CPU stage was timed around whole frame updates, rendering included
+    ::uint64_t render = render_ticks - m_render_ticks;
+    ::uint64_t cpu = m_ticks[ALEStepStats::CPU];
+    stats.seconds[ALEStepStats::CPU] = (cpu > render ? cpu - render : 0) * scale;
+    stats.seconds[ALEStepStats::TIA_RENDER] = render * scale;
+    stats.calls[ALEStepStats::TIA_RENDER] = render_calls - m_render_calls;
+
+    stats.steps = m_steps;
+    stats.step_seconds = m_step_ticks * scale;
+    stats.step_max = m_step_max * scale;
+    stats.histogram.clear();
+    for (int b = 0; b < STEP_STATS_BUCKETS; b++) {
+        if (m_histogram[b] == 0) continue;
+        ALEStepStats::Bucket bucket = { bucketUpper(b) * scale, m_histogram[b] };
+        stats.histogram.push_back(bucket);
+    }
+
+    // Percentiles, interpolated within their bucket
+    double *percentiles[] = { &stats.step_p50, &stats.step_p99 };
+    double fractions[] = { 0.5, 0.99 };
+    for (int p = 0; p < 2; p++) {
+        *percentiles[p] = 0;
+        double rank = fractions[p] * m_steps;
+        ::uint64_t seen = 0;
+        for (int b = 0; b < STEP_STATS_BUCKETS; b++) {
+            if (m_histogram[b] == 0 || seen + m_histogram[b] < rank) {
+                seen += m_histogram[b];
+                continue;
+            }
+            double within = (rank - seen) / m_histogram[b];
+            double ticks = bucketLower(b) + within * (bucketUpper(b) - bucketLower(b));
+            if (ticks > m_step_max) ticks = static_cast<double>(m_step_max);
+            *percentiles[p] = ticks * scale;
+            break;
+        }
+    }
+}
+
+
+void StepStats::clear(::uint64_t render_ticks, ::uint64_t render_calls) {
+    memset(m_ticks, 0, sizeof(m_ticks));
+    memset(m_calls, 0, sizeof(m_calls));
+    memset(m_histogram, 0, sizeof(m_histogram));
+    m_render_ticks = render_ticks;
+    m_render_calls = render_calls;
+    m_steps = 0;
+    m_step_ticks = 0;
+    m_step_max = 0;
+}
+
+} // namespace ale
+
+#endif // __USE_STEP_STATS
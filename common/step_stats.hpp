@@ -0,0 +1,115 @@
+/* *****************************************************************************
+ * Xitari
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ * *****************************************************************************
+ *  step_stats.hpp
+ *
+ *  Per-stage timing of environment steps (see ALEStepStats).
+ *
+ *  Everything here is compiled in only when __USE_STEP_STATS is defined
+ *  (cmake -DXITARI_STEP_STATS=ON). Stages are timed in ticks, the time
+ *  stamp counter on x86 and steady_clock nanoseconds elsewhere, and only
+ *  turned into seconds when the stats are read.
+ **************************************************************************** */
+
+#ifndef __STEP_STATS_HPP__
+#define __STEP_STATS_HPP__
+
+#ifdef __USE_STEP_STATS
+
+#include <stdint.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define STEP_STATS_RDTSC
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define STEP_STATS_RDTSC
+#else
+#include <chrono>
+#endif
+
+#include "ale_interface.hpp"
+
+namespace ale {
+
+// Latency buckets: four per power of two of ticks
+#define STEP_STATS_BUCKETS 256
+
+
+static inline ::uint64_t stepStatsTicks() {
+#ifdef STEP_STATS_RDTSC
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+
+// Accumulates the ticks of each stage and the latency of each step
+class StepStats {
+
+    public:
+
+        StepStats();
+
+        void add(int stage, ::uint64_t ticks) {
+            m_ticks[stage] += ticks;
+            m_calls[stage]++;
+        }
+
+        void addStep(::uint64_t ticks);
+
+        /** Fills stats. render_ticks and render_calls are the TIA's
+            totals; their growth since clear() is the rendering time, which
+            is taken out of the CPU stage. */
+        void fill(ALEStepStats &stats, ::uint64_t render_ticks, ::uint64_t render_calls) const;
+
+        /** Starts over; render_ticks and render_calls as for fill(). */
+        void clear(::uint64_t render_ticks, ::uint64_t render_calls);
+
+    private:
+
+        ::uint64_t m_ticks[ALEStepStats::NUM_STAGES];
+        ::uint64_t m_calls[ALEStepStats::NUM_STAGES];
+        ::uint64_t m_render_ticks;      // TIA totals at the last clear()
+        ::uint64_t m_render_calls;
+
+        ::uint64_t m_steps;
+        ::uint64_t m_step_ticks;
+        ::uint64_t m_step_max;
+        ::uint64_t m_histogram[STEP_STATS_BUCKETS];
+};
+
+} // namespace ale
+
+// Times the code between them into a stage of stats
+#define STEP_STATS_BEGIN(name) ::uint64_t step_stats_##name = stepStatsTicks()
+#define STEP_STATS_END(stats, name, stage) \
+    (stats).add((stage), stepStatsTicks() - step_stats_##name)
+// Same, as the latency of a whole step
+#define STEP_STATS_END_STEP(stats, name) \
+    (stats).addStep(stepStatsTicks() - step_stats_##name)
+
+#else
+
+#define STEP_STATS_BEGIN(name)
+#define STEP_STATS_END(stats, name, stage)
+#define STEP_STATS_END_STEP(stats, name)
+
+#endif // __USE_STEP_STATS
+
+#endif // __STEP_STATS_HPP__
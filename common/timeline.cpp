@@ -0,0 +1,261 @@
+/* *****************************************************************************
+ * Xitari
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ * *****************************************************************************
+ *  timeline.cpp
+ *
+ *  Records when each environment steps, resets, saves and observes, on
+ *  which thread, as a Chrome trace.
+ **************************************************************************** */
+
+#include "timeline.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace ale {
+
+// Events a thread may record between two flushes before it drops some
+#define TIMELINE_RING_SIZE 65536
+
+// Process ids of the two views of the trace
+#define TIMELINE_THREADS_PID 1
+#define TIMELINE_ENVIRONMENTS_PID 2
+
+
+struct TimelineEvent {
+    ::uint64_t start;
+    ::uint64_t duration;
+    const char *name;
+    int env;
+};
+
+
+// Single-producer/single-consumer ring: its thread records, flush() drains
+struct TimelineRing {
+    std::vector<TimelineEvent> events;
+    std::atomic<size_t> head;       // Written by the thread
+    std::atomic<size_t> tail;       // Written by flush()
+    std::atomic< ::uint64_t> dropped;
+    std::atomic<bool> finished;     // The thread has exited
+    int thread;
+    bool named;                     // Its track is named in the current file
+};
+
+
+// Marks the thread's ring finished when the thread exits, so that flush()
+// frees it once drained
+struct TimelineThread {
+    TimelineRing *ring;
+
+    TimelineThread() : ring(NULL) {}
+    ~TimelineThread() {
+        if (ring != NULL) ring->finished.store(true, std::memory_order_release);
+    }
+};
+
+
+std::atomic<bool> Timeline::s_active(false);
+
+static std::atomic<int> s_next_env(0);
+static thread_local TimelineThread t_thread;
+
+// Everything below is guarded by s_mutex
+static std::mutex s_mutex;
+static std::vector<TimelineRing*> s_rings;
+static int s_next_thread = 0;
+static FILE *s_file = NULL;
+static bool s_first_event = true;
+static ::uint64_t s_origin = 0;
+static ::uint64_t s_dropped = 0;
+static std::vector<bool> s_named_envs;
+
+
+::uint64_t Timeline::now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+int Timeline::newEnvironment() {
+    return s_next_env.fetch_add(1);
+}
+
+
+void Timeline::record(const char *name, int env, ::uint64_t start) {
+    ::uint64_t end = now();
+
+    TimelineRing *ring = t_thread.ring;
+    if (ring == NULL) {
+        ring = new TimelineRing();
+        ring->events.resize(TIMELINE_RING_SIZE);
+        ring->head.store(0);
+        ring->tail.store(0);
+        ring->dropped.store(0);
+        ring->finished.store(false);
+        ring->named = false;
+
+        std::lock_guard<std::mutex> lock(s_mutex);
+        ring->thread = s_next_thread++;
+        s_rings.push_back(ring);
+        t_thread.ring = ring;
+    }
+
+    size_t head = ring->head.load(std::memory_order_relaxed);
+    if (head - ring->tail.load(std::memory_order_acquire) >= ring->events.size()) {
+        ring->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    TimelineEvent &event = ring->events[head % ring->events.size()];
+    event.start = start;
+    event.duration = end - start;
+    event.name = name;
+    event.env = env;
+    ring->head.store(head + 1, std::memory_order_release);
+}
+
+
+// Comma-separates the events of s_file
+static void beginEvent() {
+    if (!s_first_event) fputs(",\n", s_file);
+    s_first_event = false;
+}
+
+
+static void writeTrackName(int pid, int tid, const char *kind, int number) {
+    beginEvent();
+    fprintf(s_file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,"
+            "\"args\":{\"name\":\"%s %d\"}}", pid, tid, kind, number);
+}
+
+
+static void writeProcessName(int pid, const char *name) {
+    beginEvent();
+    fprintf(s_file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,"
+            "\"args\":{\"name\":\"%s\"}}", pid, name);
+}
+
+
+// Drains every ring into s_file; s_mutex must be held
+static void drain() {
+    for (size_t r = 0; r < s_rings.size(); ) {
+        TimelineRing *ring = s_rings[r];
+        // Read before head, so that a finished ring is known to be complete
+        bool finished = ring->finished.load(std::memory_order_acquire);
+        size_t head = ring->head.load(std::memory_order_acquire);
+        size_t tail = ring->tail.load(std::memory_order_relaxed);
+        s_dropped += ring->dropped.exchange(0, std::memory_order_relaxed);
+
+        if (s_file != NULL && tail != head && !ring->named) {
+            writeTrackName(TIMELINE_THREADS_PID, ring->thread, "thread", ring->thread);
+            ring->named = true;
+        }
+
+        for (; s_file != NULL && tail != head; tail++) {
+            const TimelineEvent &event = ring->events[tail % ring->events.size()];
+            // Left over from before the trace started
+            if (event.start < s_origin) continue;
+
+            if (event.env >= 0) {
+                if (static_cast<size_t>(event.env) >= s_named_envs.size())
+                    s_named_envs.resize(event.env + 1, false);
+                if (!s_named_envs[event.env]) {
+                    writeTrackName(TIMELINE_ENVIRONMENTS_PID, event.env, "env", event.env);
+                    s_named_envs[event.env] = true;
+                }
+            }
+
+            double ts = (event.start - s_origin) / 1000.0;
+            double dur = event.duration / 1000.0;
+            beginEvent();
+            fprintf(s_file, "{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,"
+                    "\"pid\":%d,\"tid\":%d,\"args\":{\"env\":%d}}", event.name, ts, dur,
+                    TIMELINE_THREADS_PID, ring->thread, event.env);
+            if (event.env >= 0) {
+                beginEvent();
+                fprintf(s_file, "{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,"
+                        "\"pid\":%d,\"tid\":%d,\"args\":{\"thread\":%d}}", event.name, ts,
+                        dur, TIMELINE_ENVIRONMENTS_PID, event.env, ring->thread);
+            }
+        }
+        ring->tail.store(head, std::memory_order_release);
+
+        if (finished) {
+            delete ring;
+            s_rings.erase(s_rings.begin() + r);
+        }
+        else
+            r++;
+    }
+    if (s_file != NULL)
+        fflush(s_file);
+}
+
+
+void Timeline::start(const std::string &filename) {
+    stop();
+
+    std::lock_guard<std::mutex> lock(s_mutex);
+
+    // Throw away whatever was recorded before
+    drain();
+
+    s_file = fopen(filename.c_str(), "w");
+    if (s_file == NULL)
+        throw std::runtime_error("Cannot create trace file " + filename);
+
+    for (size_t r = 0; r < s_rings.size(); r++)
+        s_rings[r]->named = false;
+    s_named_envs.clear();
+    s_dropped = 0;
+    s_origin = now();
+
+    fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n", s_file);
+    s_first_event = true;
+    writeProcessName(TIMELINE_THREADS_PID, "threads");
+    writeProcessName(TIMELINE_ENVIRONMENTS_PID, "environments");
+
+    s_active.store(true);
+}
+
+
+void Timeline::flush() {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    drain();
+}
+
+
+void Timeline::stop() {
+    s_active.store(false);
+
+    std::lock_guard<std::mutex> lock(s_mutex);
+    if (s_file == NULL)
+        return;
+
+    drain();
+    beginEvent();
+    fprintf(s_file, "{\"name\":\"dropped_events\",\"ph\":\"M\",\"pid\":%d,"
+            "\"args\":{\"count\":%llu}}", TIMELINE_THREADS_PID,
+            static_cast<unsigned long long>(s_dropped));
+    fputs("\n]}\n", s_file);
+    fclose(s_file);
+    s_file = NULL;
+}
+
+} // namespace ale
@@ -0,0 +1,97 @@
+/* *****************************************************************************
+ * Xitari
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ * *****************************************************************************
+ *  timeline.hpp
+ *
+ *  Records when each environment steps, resets, saves and observes, on
+ *  which thread, as a Chrome trace (chrome://tracing, ui.perfetto.dev).
+ *
+ *  Each thread appends complete ("X") events to a ring of its own, so
+ *  recording never takes a lock; Timeline::flush() drains the rings into
+ *  the trace file. Every event appears twice in the file: once on its
+ *  thread's track, under "threads", and once on its environment's track,
+ *  under "environments". While tracing is off a TimelineScope costs one
+ *  relaxed atomic load.
+ **************************************************************************** */
+
+#ifndef __TIMELINE_HPP__
+#define __TIMELINE_HPP__
+
+#include <atomic>
+#include <stdint.h>
+#include <string>
+
+namespace ale {
+
+
+class Timeline {
+
+    public:
+
+        /** Starts tracing into filename, closing any previous trace; throws
+            std::runtime_error if the file can't be created. */
+        static void start(const std::string &filename);
+
+        /** Writes every event recorded so far out to the trace file. Events
+            that found their thread's ring full were dropped; their number
+            is written with the trace. */
+        static void flush();
+
+        /** Stops tracing, flushes and closes the trace file. */
+        static void stop();
+
+        static bool active() { return s_active.load(std::memory_order_relaxed); }
+
+        /** A new environment number, for the environments' tracks. */
+        static int newEnvironment();
+
+        /** Records the event [start, now) of env; name must be a literal. */
+        static void record(const char *name, int env, ::uint64_t start);
+
+        /** Monotonic nanoseconds. */
+        static ::uint64_t now();
+
+    private:
+
+        static std::atomic<bool> s_active;
+};
+
+
+// Records the scope it lives in as an event, if tracing is on
+class TimelineScope {
+
+    public:
+
+        TimelineScope(const char *name, int env) :
+            m_name(Timeline::active() ? name : NULL),
+            m_env(env),
+            m_start(m_name != NULL ? Timeline::now() : 0) {}
+
+        ~TimelineScope() {
+            if (m_name != NULL)
+                Timeline::record(m_name, m_env, m_start);
+        }
+
+    private:
+
+        const char *m_name;
+        int m_env;
+        ::uint64_t m_start;
+};
+
+} // namespace ale
+
+#endif // __TIMELINE_HPP__
@@ -55,6 +55,48 @@ ALEController::ALEController(OSystem* osystem):
   }
 }
 
+void ALEController::emulateFrames(Action a, Action b, int num_frames, bool render,
+                                  reward_t &reward_a, reward_t &reward_b) {
+  // Special actions (reset, save/load state) are applied only once
+  if (a >= RESET || num_frames < 1)
+    num_frames = 1;
+
+  if (!render || num_frames <= 2) {
+    runFrames(a, b, num_frames, render ? 0 : num_frames, reward_a, reward_b);
+  }
+  else {
+    // Which frames are the last two is only known once the game has, or hasn't,
+    //  ended: if it ends early, the frames that ran are emulated again from the
+    //  same state, drawing the right ones
+    const ALEState* start = m_environment.cloneState();
+    int frames_run = runFrames(a, b, num_frames, num_frames - 2, reward_a, reward_b);
+    if (frames_run < num_frames) {
+      m_environment.restoreState(*start);
+      runFrames(a, b, frames_run, frames_run - 2, reward_a, reward_b);
+    }
+    m_environment.destroyState(start);
+  }
+
+  m_environment.enableRendering(render);
+}
+
+int ALEController::runFrames(Action a, Action b, int num_frames, int first_rendered,
+                             reward_t &reward_a, reward_t &reward_b) {
+  reward_a = 0;
+  reward_b = 0;
+
+  for (int i = 0; i < num_frames; i++) {
+    if (i > 0 && m_environment.isTerminal())
+      return i;
+
+    m_environment.enableRendering(i >= first_rendered);
+    applyActions(a, b);
+    reward_a += m_settings->getReward();
+    reward_b += m_settings->getRewardB();
+  }
+  return num_frames;
+}
+
 void ALEController::display() {
   DisplayScreen* display = m_osystem->p_display_screen;
 
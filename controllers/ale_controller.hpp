@@ -54,9 +54,22 @@ class ALEController {
 
     /** Applies the given action to the environment (e.g. by emulating or resetting) */
     void applyActions(Action a, Action b); 
+
+    /** Applies the given actions for num_frames frames (special actions only once),
+      *  stopping early once the game ends, and sums the rewards. If render is set, the
+      *  last two frames that actually run are drawn (they are blended when colour
+      *  averaging) and the ones before are not; rendering is left set to render. */
+    void emulateFrames(Action a, Action b, int num_frames, bool render,
+                       reward_t &reward_a, reward_t &reward_b);
     /** Support for SDL display... available to all controllers. Simply call it from run(). */
     void display();
 
+  private:
+    /** Applies the actions for up to num_frames frames, drawing those from
+      *  first_rendered on; returns how many ran before the game ended. */
+    int runFrames(Action a, Action b, int num_frames, int first_rendered,
+                  reward_t &reward_a, reward_t &reward_b);
+
   protected:
     OSystem* m_osystem;
     std::auto_ptr<RomSettings> m_settings;
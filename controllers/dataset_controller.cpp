@@ -0,0 +1,225 @@
+/* *****************************************************************************
+ * Xitari
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ * *****************************************************************************
+ *  dataset_controller.cpp
+ *
+ *  The DatasetController class generates trajectory datasets in bulk.
+ **************************************************************************** */
+
+#include "dataset_controller.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+using namespace ale;
+
+// Frames a worker claims from the budget at a time
+#define DATASET_CLAIM_BLOCK 1024
+
+DatasetController::DatasetController(OSystem* _osystem) :
+  ALEController(_osystem),
+  m_single_action(PLAYER_A_NOOP),
+  m_epsilon(0),
+  m_claimed(0),
+  m_done(0),
+  m_shards(0),
+  m_running(0),
+  m_failed(false) {
+  Settings& settings = m_osystem->settings();
+
+  // StellaEnvironment draws the stochastic start from the global rand(),
+  //  which the workers would race on
+  if (settings.getBool("use_environment_distribution"))
+    throw std::invalid_argument("use_environment_distribution is not supported by "
+                                "the dataset controller");
+
+  int num_workers = settings.getInt("dataset_num_workers");
+  if (num_workers <= 0)
+    num_workers = std::max(1u, std::thread::hardware_concurrency());
+  m_envs.reset(new ALEBatchInterface(settings.getString("rom_file"), num_workers));
+  m_actions_a = m_envs->env(0).getMinimalActionSet();
+  m_actions_b = m_envs->env(0).getMinimalActionSetB();
+
+  // The agents' own rules, but drawn from a generator per worker: rand()
+  //  is neither thread-safe nor reproducible across threads
+  std::string policy = settings.getString("dataset_policy");
+  if (policy == "random_agent") {
+    m_policy = POLICY_RANDOM;
+  }
+  else if (policy == "single_action_agent") {
+    m_policy = POLICY_SINGLE_ACTION;
+    m_epsilon = settings.getFloat("agent_epsilon", true);
+    m_single_action = (Action)settings.getInt("agent_action", true);
+  }
+  else if (policy == "scripted_agent") {
+    m_policy = POLICY_SCRIPTED;
+    std::istringstream script(settings.getString("dataset_script"));
+    std::string action;
+    while (std::getline(script, action, ','))
+      m_script.push_back((Action)atoi(action.c_str()));
+    if (m_script.empty())
+      throw std::invalid_argument("dataset_script holds no actions");
+  }
+  else {
+    throw std::invalid_argument("Invalid dataset policy: " + policy);
+  }
+
+  if (settings.getString("random_seed") == "time")
+    m_seed = (unsigned)time(0);
+  else
+    m_seed = (unsigned)settings.getInt("random_seed");
+
+  m_prefix = settings.getString("dataset_prefix");
+  m_screens = settings.getBool("dataset_screens");
+  m_budget = std::max(0, settings.getInt("dataset_frames"));
+  m_shard_frames = std::max(1, settings.getInt("dataset_shard_frames"));
+}
+
+DatasetController::~DatasetController() {
+}
+
+std::string DatasetController::shardName(int w, int s) const {
+  char suffix[32];
+  snprintf(suffix, sizeof(suffix), "-%03d-%05d.traj", w, s);
+  return m_prefix + suffix;
+}
+
+void DatasetController::chooseActions(std::mt19937& rng, size_t step,
+                                      Action& a, Action& b) {
+  std::uniform_int_distribution<size_t> pick_a(0, m_actions_a.size() - 1);
+  std::uniform_int_distribution<size_t> pick_b(0, m_actions_b.size() - 1);
+  std::uniform_real_distribution<float> coin(0, 1);
+
+  switch (m_policy) {
+    case POLICY_RANDOM:
+      a = m_actions_a[pick_a(rng)];
+      b = m_actions_b[pick_b(rng)];
+      break;
+    case POLICY_SINGLE_ACTION:
+      // Player B mirrors player A's action
+      a = (coin(rng) < m_epsilon) ? m_actions_a[pick_a(rng)] : m_single_action;
+      b = (coin(rng) < m_epsilon) ? m_actions_b[pick_b(rng)] :
+          (Action)(m_single_action + PLAYER_B_NOOP);
+      break;
+    case POLICY_SCRIPTED:
+      a = m_script[step % m_script.size()];
+      b = (Action)(m_script[(step + m_script.size() / 2) % m_script.size()] + PLAYER_B_NOOP);
+      break;
+  }
+}
+
+void DatasetController::work(int w) {
+  try {
+    play(w);
+  } catch (std::exception& e) {
+    if (!m_failed.exchange(true))
+      m_error = e.what();
+    // Leave nothing for the other workers
+    m_claimed = m_budget;
+  }
+  m_running--;
+}
+
+void DatasetController::play(int w) {
+  ALEInterface& env = m_envs->env(w);
+  std::seed_seq seed = { m_seed, (unsigned)w };
+  std::mt19937 rng(seed);
+
+  // Without screens, nothing ever looks at them
+  env.enableRendering(m_screens);
+
+  int shard = 0;
+  uint64_t shard_steps = 0;
+  size_t episode_step = 0;
+  env.startRecording(shardName(w, shard), m_screens);
+  m_shards++;
+
+  for (;;) {
+    uint64_t first = m_claimed.fetch_add(DATASET_CLAIM_BLOCK);
+    if (first >= m_budget)
+      break;
+    uint64_t count = std::min<uint64_t>(DATASET_CLAIM_BLOCK, m_budget - first);
+
+    for (uint64_t i = 0; i < count; i++) {
+      if (env.gameOver()) {
+        env.resetGame();
+        episode_step = 0;
+      }
+      if (shard_steps == m_shard_frames) {
+        env.startRecording(shardName(w, ++shard), m_screens);
+        m_shards++;
+        shard_steps = 0;
+      }
+
+      Action a, b;
+      chooseActions(rng, episode_step, a, b);
+      double reward_a, reward_b, side_bouncing;
+      bool wall_bouncing, crash, serving;
+      int points;
+      env.act2(a, b, &reward_a, &reward_b, &side_bouncing, &wall_bouncing,
+               &points, &crash, &serving);
+      episode_step++;
+      shard_steps++;
+    }
+    m_done += count;
+  }
+
+  env.stopRecording();
+}
+
+void DatasetController::run() {
+  int num_workers = m_envs->size();
+  fprintf(stderr, "Generating %llu frames with %d workers into %s-*.traj\n",
+          (unsigned long long)m_budget, num_workers, m_prefix.c_str());
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  std::vector<std::thread> workers;
+  m_running = num_workers;
+  for (int w = 0; w < num_workers; w++)
+    workers.push_back(std::thread(&DatasetController::work, this, w));
+
+  // Report progress while the workers run
+  uint64_t last_done = 0;
+  std::chrono::steady_clock::time_point last = start;
+  while (m_running.load() > 0) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    double elapsed = std::chrono::duration<double>(now - last).count();
+    if (elapsed >= 10) {
+      uint64_t done = m_done.load();
+      fprintf(stderr, "%llu/%llu frames, %.0f frames/sec\n", (unsigned long long)done,
+              (unsigned long long)m_budget, (done - last_done) / elapsed);
+      last_done = done;
+      last = now;
+    }
+  }
+
+  for (size_t w = 0; w < workers.size(); w++)
+    workers[w].join();
+  if (m_failed.load())
+    throw std::runtime_error(m_error);
+
+  double elapsed = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+  fprintf(stderr, "Generated %llu frames in %d shards in %.2f s: %.0f frames/sec\n",
+          (unsigned long long)m_done.load(), m_shards.load(), elapsed,
+          elapsed > 0 ? m_done.load() / elapsed : 0.0);
+}
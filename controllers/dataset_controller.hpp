@@ -0,0 +1,89 @@
+/* *****************************************************************************
+ * Xitari
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ * *****************************************************************************
+ *  dataset_controller.hpp
+ *
+ *  The DatasetController class generates trajectory datasets in bulk: a
+ *  pool of worker threads, each with its own emulator, plays the loaded ROM
+ *  with a fixed policy for both players and records every step to sharded
+ *  trajectory files (see environment/trajectory_recorder.hpp) until a frame
+ *  budget is spent.
+ **************************************************************************** */
+
+#ifndef __DATASET_CONTROLLER_HPP__
+#define __DATASET_CONTROLLER_HPP__
+
+#include "ale_controller.hpp"
+
+#include <atomic>
+#include <memory>
+#include <random>
+#include <stdint.h>
+
+#include "ale_batch_interface.hpp"
+
+namespace ale {
+
+class DatasetController : public ALEController {
+  public:
+    DatasetController(OSystem* osystem);
+    virtual ~DatasetController();
+
+    virtual void run();
+
+  private:
+    enum Policy { POLICY_RANDOM, POLICY_SINGLE_ACTION, POLICY_SCRIPTED };
+
+    /** Worker thread body */
+    void work(int w);
+    /** Plays environment w until the budget is spent */
+    void play(int w);
+    /** Picks both players' actions for the given step of an episode */
+    void chooseActions(std::mt19937& rng, size_t step, Action& a, Action& b);
+    /** Name of shard s of worker w */
+    std::string shardName(int w, int s) const;
+
+  private:
+    std::unique_ptr<ALEBatchInterface> m_envs;
+
+    // Policy
+    Policy m_policy;
+    ActionVect m_actions_a, m_actions_b; // Random choices of each player
+    Action m_single_action;
+    float m_epsilon;
+    std::vector<Action> m_script;        // Player A's; B plays it shifted by half
+    unsigned m_seed;
+
+    // Output
+    std::string m_prefix;
+    bool m_screens;
+    uint64_t m_shard_frames;
+
+    // Frames are handed out to workers in blocks, out of m_budget
+    uint64_t m_budget;
+    std::atomic<uint64_t> m_claimed;
+    std::atomic<uint64_t> m_done;
+    std::atomic<int> m_shards;
+    std::atomic<int> m_running;
+
+    // First error a worker ran into; the others stop on it
+    std::atomic<bool> m_failed;
+    std::string m_error;
+};
+
+} // namespace ale
+
+#endif // __DATASET_CONTROLLER_HPP__
@@ -34,8 +34,16 @@
 #include "fifo_controller.hpp"
 
 #include <stdio.h>
+#include <cctype>
+#include <cstdlib>
 #include <cstring>
 #include <cassert>
+#include <stdexcept>
+
+#ifdef WIN32
+#include <io.h>
+#include <fcntl.h>
+#endif
 
 using namespace ale;
 
@@ -60,7 +68,16 @@ inline void appendByte(char *buf, uInt8 v) {
 
 FIFOController::FIFOController(OSystem* _osystem, bool named_pipes) :
   ALEController(_osystem),
-  m_named_pipes(named_pipes) {
+  m_named_pipes(named_pipes),
+  m_binary(false),
+  m_delta_screen(false),
+  m_packed_screen(false),
+  m_render(true),
+  m_reward(0),
+  m_reward_b(0),
+  m_buffer(204800, '\0'),
+  m_delta(m_environment.getScreen().arraySize()),
+  m_palette_sent(0) {
   m_max_num_frames = m_osystem->settings().getInt("max_num_frames");
   m_run_length_encoding = m_osystem->settings().getBool("run_length_encoding");
 }
@@ -78,22 +95,32 @@ void FIFOController::run() {
 
   // Main loop
   while (!isDone()) {
-    // @todo frame skip
     // Send data over to agent
     sendData();
     // Read agent's response & process it
     readAction(action_a, action_b);
 
     // Emulate Atari forward
-    applyActions(action_a, action_b);
+    emulate(action_a, action_b);
 
     // Update display if needed
     display();
   }
 
   // Send a termination signal to the agent, if they're still around
-  if (!feof(m_fout))
-    fprintf (m_fout, "DIE\n");
+  if (!feof(m_fout)) {
+    if (m_binary) {
+      writeRecord('D', NULL, 0);
+      fflush(m_fout);
+    }
+    else
+      fprintf (m_fout, "DIE\n");
+  }
+}
+
+void FIFOController::emulate(Action action_a, Action action_b) {
+  // Only the frames that can end up in the screen we send are drawn
+  emulateFrames(action_a, action_b, m_frame_skip, m_render, m_reward, m_reward_b);
 }
 
 bool FIFOController::isDone() {
@@ -135,6 +162,38 @@ void FIFOController::handshake() {
   m_frame_skip = atoi(token);
   token = strtok(NULL, ",\n");
   m_send_rl = atoi(token);
+  // The protocol field is optional; older agents only speak text. Refuse
+  //  any protocol this build doesn't speak rather than answer in another
+  token = strtok(NULL, ",\n");
+  int protocol = 0;
+  if (token != NULL) {
+    char* end;
+    long value = strtol(token, &end, 10);
+    while (isspace((unsigned char)*end))
+      end++;
+    if (end == token || *end != '\0' || value < 0 || value > 3)
+      throw std::invalid_argument("Unsupported FIFO protocol: " + std::string(token));
+    protocol = (int)value;
+  }
+  m_binary = protocol >= 1;
+  m_delta_screen = protocol == 2;
+  if (m_delta_screen)
+    m_delta_buffer.resize(ScreenDeltaEncoder::maxEncodedSize(m_delta.frameSize()));
+  m_packed_screen = protocol == 3;
+  if (m_packed_screen)
+    m_codes.resize(1 + codesBufferSize(m_delta.frameSize()));
+
+#ifdef WIN32
+  if (m_binary) {
+    _setmode(_fileno(m_fout), _O_BINARY);
+    _setmode(_fileno(m_fin), _O_BINARY);
+  }
+#endif
+
+  // Nobody looks at the screen: let the TIA skip drawing it
+  m_render = m_send_screen || m_osystem->p_display_screen != NULL;
+  if (!m_render)
+    m_environment.enableRendering(false);
 }
 
 void FIFOController::openNamedPipes() {
@@ -156,29 +215,68 @@ void FIFOController::sendData() {
   if (m_send_ram) sendRAM();
   if (m_send_screen) sendScreen();
   if (m_send_rl) sendRL();
-  // Send the terminating newline
-  fputc('\n', m_fout);
+  // Send the terminating newline (or record)
+  if (m_binary)
+    writeRecord('E', NULL, 0);
+  else
+    fputc('\n', m_fout);
   fflush(m_fout);
 }
 
+void FIFOController::writeRecord(char tag, const void* payload, uInt32 length) {
+  char header[1 + sizeof(length)];
+  header[0] = tag;
+  memcpy(header + 1, &length, sizeof(length));
+
+  fwrite(header, sizeof(header), 1, m_fout);
+  if (length > 0)
+    fwrite(payload, length, 1, m_fout);
+}
+
 void FIFOController::sendScreen() {
   // Obtain the screen from the environment
   const ALEScreen& screen = m_environment.getScreen();
 
-  std::vector<char> buffer(204800,'\0');
+  if (m_delta_screen) {
+    size_t size = m_delta.encode(&screen.getArray()[0], &m_delta_buffer[0]);
+    writeRecord('U', &m_delta_buffer[0], (uInt32)size);
+    return;
+  }
+  if (m_packed_screen) {
+    size_t n = screen.arraySize();
+    m_palette.compact(&screen.getArray()[0], n, &m_codes[1]);
+    if (m_palette.size() > m_palette_sent) {
+      std::vector<uInt8> colours(m_palette.size());
+      for (int i = 0; i < m_palette.size(); i++)
+        colours[i] = m_palette.colour(i);
+      writeRecord('C', &colours[0], (uInt32)colours.size());
+      m_palette_sent = m_palette.size();
+    }
+
+    int bits = m_palette.codeBits();
+    m_codes[0] = (uInt8)bits;
+    size_t size = packCodes(&m_codes[1], n, bits);
+    writeRecord('P', &m_codes[0], (uInt32)(1 + size));
+    return;
+  }
+  // Binary mode sends the palette indices as they are
+  if (m_binary) {
+    writeRecord('S', &screen.getArray()[0], (uInt32)screen.arraySize());
+    return;
+  }
+
   int sn;
 
   // Encode the screen into a char buffer
   if (m_run_length_encoding)
-    sn = stringScreenRLE(screen, &buffer[0]);
+    sn = stringScreenRLE(screen, &m_buffer[0]);
   else
-    sn = stringScreenFull(screen, &buffer[0]);
+    sn = stringScreenFull(screen, &m_buffer[0]);
 
   // Append terminating stuff, send
-  buffer[sn] = ':';
-  buffer[sn+1] = 0;
+  m_buffer[sn] = ':';
 
-  fputs(&buffer[0], m_fout);
+  fwrite(&m_buffer[0], sn + 1, 1, m_fout);
 }
 
 int FIFOController::stringScreenRLE(const ALEScreen& screen, char* buffer) {
@@ -232,30 +330,53 @@ int FIFOController::stringScreenFull(const ALEScreen& screen, char* buffer) {
 void FIFOController::sendRAM() {
   const ALERAM& ram = m_environment.getRAM();
 
-  std::vector<char> buffer(204800,'\0');
+  if (m_binary) {
+    writeRecord('R', ram.array(), (uInt32)ram.size());
+    return;
+  }
+
   int sn = 0;
 
   // Convert the RAM bytes into a string
   for (size_t i = 0; i < ram.size(); i++) {
     byte_t b = ram.get(static_cast<unsigned int>(i));
-    appendByte(&buffer[0] + sn, b);
+    appendByte(&m_buffer[0] + sn, b);
     sn += 2;
   }
 
   // Output RAM
-  buffer[sn] = ':';
-  buffer[sn+1] = 0;
-  fputs(&buffer[0], m_fout);
+  m_buffer[sn] = ':';
+  fwrite(&m_buffer[0], sn + 1, 1, m_fout);
 }
 
 void FIFOController::sendRL() {
-  int r = m_settings->getReward();
+  int r = (int)m_reward;
   bool is_terminal = m_environment.isTerminal();
 
+  if (m_binary) {
+    Int32 rl[3] = { is_terminal, r, (Int32)m_reward_b };
+    writeRecord('L', rl, sizeof(rl));
+    return;
+  }
+
   fprintf(m_fout, "%d,%d:", is_terminal, r);
 }
 
 void FIFOController::readAction(Action& action_a, Action& action_b) {
+  if (m_binary) {
+    Int32 actions[2];
+    if (fread(actions, sizeof(actions), 1, m_fin) != 1) {
+      // The agent is gone; isDone() will notice
+      action_a = PLAYER_A_NOOP;
+      action_b = PLAYER_B_NOOP;
+      return;
+    }
+
+    action_a = (Action)actions[0];
+    action_b = (Action)actions[1];
+    return;
+  }
+
   // Read the new action from the pipe, as a comma-separated pair
   char in_buffer[2048];
   fgets (in_buffer, sizeof(in_buffer), m_fin);
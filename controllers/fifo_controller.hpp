@@ -29,12 +29,38 @@
  *
  *  The FIFOController class implements an Agent/ALE interface via stdin/stdout
  *  or named pipes.
+ *
+ *  The agent answers the "<width>-<height>" greeting with
+ *  "<send_screen>,<send_ram>,<frame_skip>,<send_rl>[,<binary>]", binary being
+ *  0 (text, the default) to 3; any other value fails the handshake. Each action
+ *  is then repeated for frame_skip frames (at least one) with the rewards
+ *  summed. In text mode observations are hex-encoded, ':'-terminated fields
+ *  on one line and actions are "<a>,<b>" lines. In binary mode (binary = 1 to 3)
+ *  each observation is a sequence of records, a one-byte tag followed by a
+ *  uint32 payload length and the payload:
+ *    'R'  RAM, 128 bytes
+ *    'S'  screen, width * height palette indices
+ *    'U'  screen update, the changes since the previous screen encoded as
+ *         described in common/screen_delta.hpp (sent instead of 'S' when
+ *         binary = 2; the first one is relative to an all-zero screen)
+ *    'P'  packed screen (sent instead of 'S' when binary = 3), a uint8 code
+ *         width followed by the screen's codes packed as described in
+ *         common/screen_palette.hpp
+ *    'C'  palette, the palette index of every code given so far; sent
+ *         before a 'P' record whenever new colours appeared
+ *    'L'  int32 terminal, int32 reward A, int32 reward B
+ *    'E'  end of observation (empty)
+ *    'D'  ALE is exiting (empty, sent instead of an observation)
+ *  and each action is two int32s, player A's then player B's. Numbers are in
+ *  native byte order.
  **************************************************************************** */
 
 #ifndef __FIFO_CONTROLLER_HPP__
 #define __FIFO_CONTROLLER_HPP__
 
 #include "ale_controller.hpp"
+#include "common/screen_delta.hpp"
+#include "common/screen_palette.hpp"
 
 namespace ale {
 
@@ -53,6 +79,12 @@ class FIFOController : public ALEController {
     void sendData();
     void readAction(Action& action_a, Action& action_b);
 
+    // Applies the agent's action, repeated over the frame skip
+    void emulate(Action action_a, Action action_b);
+
+    // Writes a binary protocol record
+    void writeRecord(char tag, const void* payload, uInt32 length);
+
     void sendScreen();
     int stringScreenRLE(const ALEScreen& screen, char * buffer);
     int stringScreenFull(const ALEScreen& screen, char * buffer);
@@ -69,7 +101,23 @@ class FIFOController : public ALEController {
     bool m_send_screen; // Agent requested screen data
     bool m_send_ram; // Agent requested RAM data
     bool m_send_rl; // Agent requested RL data
-    
+    bool m_binary; // Agent requested the binary protocol
+    bool m_delta_screen; // Agent requested screens as updates
+    bool m_packed_screen; // Agent requested palette-packed screens
+    bool m_render; // Whether anybody looks at the screen
+
+    reward_t m_reward; // Player A's reward summed over the last frame skip
+    reward_t m_reward_b; // Player B's reward summed over the last frame skip
+
+    std::vector<char> m_buffer; // Text encoding buffer, reused across frames
+
+    ScreenDeltaEncoder m_delta; // Previous screen sent, for screen updates
+    std::vector<uInt8> m_delta_buffer;
+
+    ScreenPalette m_palette; // Colours of the packed screens
+    int m_palette_sent; // Number of colours the agent knows of
+    std::vector<uInt8> m_codes; // Packing buffer
+
     FILE* m_fout; 
     FILE* m_fin; 
 
@@ -0,0 +1,160 @@
+/* *****************************************************************************
+ * Xitari
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ * *****************************************************************************
+ *  replay_controller.cpp
+ *
+ *  The ReplayController class re-emulates action logs and checks them.
+ **************************************************************************** */
+
+#include "replay_controller.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <zlib/zlib.h>
+
+#include "environment/action_log.hpp"
+
+using namespace ale;
+
+ReplayController::ReplayController(OSystem* _osystem) :
+  ALEController(_osystem),
+  m_next_log(0) {
+  Settings& settings = m_osystem->settings();
+
+  std::istringstream logs(settings.getString("replay_logs"));
+  std::string log;
+  while (std::getline(logs, log, ','))
+    if (!log.empty()) m_logs.push_back(log);
+  if (m_logs.empty())
+    throw std::invalid_argument("replay_logs names no action logs");
+  m_results.resize(m_logs.size());
+
+  m_render_every = std::max(0, settings.getInt("replay_render_every"));
+
+  int num_workers = settings.getInt("replay_num_workers");
+  if (num_workers <= 0)
+    num_workers = std::max(1u, std::thread::hardware_concurrency());
+  num_workers = std::min(num_workers, (int)m_logs.size());
+  m_envs.reset(new ALEBatchInterface(settings.getString("rom_file"), num_workers));
+}
+
+ReplayController::~ReplayController() {
+}
+
+void ReplayController::replay(ALEInterface& env, const std::string& name, Result& result) {
+  ActionLogReader log(name);
+
+  // Only the steps whose frames are written out need rendering
+  bool rendering = false;
+  env.enableRendering(false);
+
+  double reward_a = 0, reward_b = 0;
+  for (uInt8 tag; (tag = log.next()) != 0; ) {
+    if (tag == ACTION_LOG_STATE) {
+      env.restoreSnapshot(log.snapshot());
+    }
+    else if (tag == ACTION_LOG_STEP) {
+      bool render = m_render_every > 0 && (result.steps + 1) % m_render_every == 0;
+      if (render != rendering)
+        env.enableRendering(rendering = render);
+
+      double step_a, step_b, side_bouncing;
+      bool wall_bouncing, crash, serving;
+      int points;
+      env.act2((Action)log.actionA(), (Action)log.actionB(), &step_a, &step_b,
+               &side_bouncing, &wall_bouncing, &points, &crash, &serving);
+      reward_a += step_a;
+      reward_b += step_b;
+      result.steps++;
+
+      if (render) {
+        std::ostringstream png;
+        png << name << "." << result.steps << ".png";
+        env.screenToPNG(png.str());
+      }
+    }
+    else if (tag == ACTION_LOG_CHECK) {
+      const ActionLogCheck& check = log.check();
+      const ALERAM& ram = env.getRAM();
+      const char* what = NULL;
+      if (check.step != result.steps)
+        what = "step count";
+      else if (check.frame != env.getFrameNumber())
+        what = "frame number";
+      else if (check.ram_checksum != crc32(0L, ram.array(), ram.size()))
+        what = "RAM";
+      else if (check.reward_a != reward_a || check.reward_b != reward_b)
+        what = "rewards";
+      if (what != NULL) {
+        std::ostringstream error;
+        error << what << " diverged by step " << result.steps;
+        result.error = error.str();
+        return;
+      }
+    }
+  }
+}
+
+void ReplayController::work(int w) {
+  for (size_t i; (i = m_next_log.fetch_add(1)) < m_logs.size(); ) {
+    Result& result = m_results[i];
+    result.steps = 0;
+    try {
+      replay(m_envs->env(w), m_logs[i], result);
+    } catch (std::exception& e) {
+      result.error = e.what();
+    }
+  }
+}
+
+void ReplayController::run() {
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  std::vector<std::thread> workers;
+  for (int w = 1; w < m_envs->size(); w++)
+    workers.push_back(std::thread(&ReplayController::work, this, w));
+  work(0);
+  for (size_t w = 0; w < workers.size(); w++)
+    workers[w].join();
+  double elapsed = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+
+  uint64_t steps = 0;
+  size_t failed = 0;
+  for (size_t i = 0; i < m_logs.size(); i++) {
+    const Result& result = m_results[i];
+    steps += result.steps;
+    if (result.error.empty()) {
+      fprintf(stderr, "%s: %llu steps OK\n", m_logs[i].c_str(),
+              (unsigned long long)result.steps);
+    } else {
+      fprintf(stderr, "%s: FAILED, %s\n", m_logs[i].c_str(), result.error.c_str());
+      failed++;
+    }
+  }
+  fprintf(stderr, "Replayed %llu steps of %d logs in %.2f s: %.0f steps/sec\n",
+          (unsigned long long)steps, (int)m_logs.size(), elapsed,
+          elapsed > 0 ? steps / elapsed : 0.0);
+
+  if (failed > 0) {
+    std::ostringstream error;
+    error << failed << " of " << m_logs.size() << " action logs failed to replay";
+    throw std::runtime_error(error.str());
+  }
+}
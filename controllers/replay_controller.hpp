@@ -0,0 +1,67 @@
+/* *****************************************************************************
+ * Xitari
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ * *****************************************************************************
+ *  replay_controller.hpp
+ *
+ *  The ReplayController class re-emulates action logs (see
+ *  environment/action_log.hpp) as fast as it can, checking the RAM and
+ *  rewards against the checksums in the logs. Screens are only rendered
+ *  for the steps whose frames are asked for; several logs are replayed at
+ *  once on a pool of worker threads.
+ **************************************************************************** */
+
+#ifndef __REPLAY_CONTROLLER_HPP__
+#define __REPLAY_CONTROLLER_HPP__
+
+#include "ale_controller.hpp"
+
+#include <atomic>
+#include <memory>
+#include <stdint.h>
+
+#include "ale_batch_interface.hpp"
+
+namespace ale {
+
+class ReplayController : public ALEController {
+  public:
+    ReplayController(OSystem* osystem);
+    virtual ~ReplayController();
+
+    virtual void run();
+
+  private:
+    struct Result {
+      uint64_t steps;
+      std::string error; // Empty if the log replayed faithfully
+    };
+
+    /** Worker thread body: replays logs on environment w until none are left */
+    void work(int w);
+    /** Replays one log */
+    void replay(ALEInterface& env, const std::string& log, Result& result);
+
+  private:
+    std::unique_ptr<ALEBatchInterface> m_envs;
+    std::vector<std::string> m_logs;
+    std::vector<Result> m_results;
+    std::atomic<size_t> m_next_log;
+    int m_render_every; // Steps between frames written out, 0 for none
+};
+
+} // namespace ale
+
+#endif // __REPLAY_CONTROLLER_HPP__
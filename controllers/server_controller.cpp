@@ -0,0 +1,457 @@
+/* *****************************************************************************
+ * Xitari
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ * *****************************************************************************
+ *  server_controller.cpp
+ *
+ *  The ServerController class hosts many environments and serves batched
+ *  requests for them over a socket.
+ **************************************************************************** */
+
+#include "server_controller.hpp"
+
+#include <stdexcept>
+
+#ifndef WIN32
+#include <cerrno>
+#include <cstring>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace ale;
+
+// Largest batch and snapshot we accept, to bound what a bad request allocates
+#define SERVER_MAX_ENTRIES (1 << 20)
+#define SERVER_MAX_SNAPSHOT (1 << 24)
+
+static bool readFully(int fd, void* data, size_t length) {
+  char* p = static_cast<char*>(data);
+  while (length > 0) {
+    ssize_t n = read(fd, p, length);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return false;
+    p += n;
+    length -= n;
+  }
+  return true;
+}
+
+static bool writeFully(int fd, const void* data, size_t length) {
+  const char* p = static_cast<const char*>(data);
+  while (length > 0) {
+    ssize_t n = write(fd, p, length);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return false;
+    p += n;
+    length -= n;
+  }
+  return true;
+}
+
+ServerController::ServerController(OSystem* _osystem) :
+  ALEController(_osystem),
+  m_listen_fd(-1),
+  m_obs_size(0),
+  m_stamp(0),
+  m_job(NULL),
+  m_next_entry(0),
+  m_busy_workers(0),
+  m_generation(0),
+  m_stopping(false) {
+  memset(&m_request, 0, sizeof(m_request));
+
+  Settings& settings = m_osystem->settings();
+  int num_envs = settings.getInt("server_num_envs");
+  m_envs.reset(new ALEBatchInterface(settings.getString("rom_file"), num_envs));
+  m_env_stamp.resize(num_envs, 0);
+
+  // The calling thread works on batches too
+  int num_threads = settings.getInt("server_num_threads");
+  if (num_threads <= 0)
+    num_threads = std::max(1u, std::thread::hardware_concurrency());
+  for (int i = 1; i < num_threads; i++)
+    m_workers.push_back(std::thread(&ServerController::work, this));
+}
+
+ServerController::~ServerController() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stopping = true;
+  }
+  m_work_ready.notify_all();
+  for (size_t i = 0; i < m_workers.size(); i++)
+    m_workers[i].join();
+
+  if (m_listen_fd >= 0) {
+    close(m_listen_fd);
+    if (!m_socket_path.empty())
+      unlink(m_socket_path.c_str());
+  }
+}
+
+void ServerController::run() {
+  // A client going away mid-write must not kill the server
+  signal(SIGPIPE, SIG_IGN);
+
+  listen();
+
+  bool quit = false;
+  while (!quit) {
+    int fd = accept(m_listen_fd, NULL, NULL);
+    if (fd < 0) {
+      if (errno == EINTR) continue;
+      throw std::runtime_error(std::string("Cannot accept connection: ") + strerror(errno));
+    }
+
+    if (m_socket_path.empty()) {
+      int one = 1;
+      setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+
+    quit = !serve(fd);
+    close(fd);
+  }
+}
+
+void ServerController::listen() {
+  Settings& settings = m_osystem->settings();
+  int port = settings.getInt("server_port");
+
+  if (port > 0) {
+    std::string host = settings.getString("server_host");
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    if (inet_pton(AF_INET, host.c_str(), &address.sin_addr) != 1)
+      throw std::runtime_error("Invalid server_host: " + host);
+
+    m_listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    if (m_listen_fd >= 0)
+      setsockopt(m_listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (m_listen_fd < 0 ||
+        bind(m_listen_fd, (struct sockaddr*)&address, sizeof(address)) != 0)
+      throw std::runtime_error(std::string("Cannot bind TCP socket: ") + strerror(errno));
+
+    std::cerr << "Serving " << m_envs->size() << " environments on "
+              << host << ":" << port << std::endl;
+  }
+  else {
+    std::string path = settings.getString("server_socket");
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path))
+      throw std::runtime_error("server_socket path is too long: " + path);
+    strcpy(address.sun_path, path.c_str());
+
+    // Remove a socket left behind by a previous run
+    unlink(path.c_str());
+    m_listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (m_listen_fd < 0 ||
+        bind(m_listen_fd, (struct sockaddr*)&address, sizeof(address)) != 0)
+      throw std::runtime_error("Cannot bind Unix socket " + path + ": " + strerror(errno));
+    m_socket_path = path;
+
+    std::cerr << "Serving " << m_envs->size() << " environments on "
+              << path << std::endl;
+  }
+
+  if (::listen(m_listen_fd, 8) != 0)
+    throw std::runtime_error(std::string("Cannot listen: ") + strerror(errno));
+}
+
+bool ServerController::serve(int fd) {
+  const ALEScreen& screen = m_envs->env(0).getScreen();
+
+  ServerHello hello;
+  hello.magic = SERVER_MAGIC;
+  hello.version = SERVER_VERSION;
+  hello.num_envs = m_envs->size();
+  hello.width = screen.width();
+  hello.height = screen.height();
+  hello.ram_size = m_envs->env(0).getRAM().size();
+  if (!writeFully(fd, &hello, sizeof(hello)))
+    return true;
+
+  while (handleRequest(fd)) {
+    if (m_request.type == SERVER_QUIT)
+      return false;
+  }
+  return true;
+}
+
+bool ServerController::handleRequest(int fd) {
+  if (!readFully(fd, &m_request, sizeof(m_request)))
+    return false;
+
+  ServerResponse response;
+  response.status = SERVER_OK;
+  response.count = m_request.count;
+
+  // Anything we can't parse leaves the stream in an unknown state: answer,
+  //  then drop the connection
+  bool known = m_request.type >= SERVER_STEP && m_request.type <= SERVER_QUIT;
+  if (!known || m_request.count > SERVER_MAX_ENTRIES) {
+    response.status = SERVER_BAD_REQUEST;
+    response.count = 0;
+    writeFully(fd, &response, sizeof(response));
+    return false;
+  }
+  if (m_request.type == SERVER_QUIT) {
+    response.count = 0;
+    return writeFully(fd, &response, sizeof(response));
+  }
+
+  if (!readEntries(fd, m_request)) {
+    response.status = SERVER_BAD_REQUEST;
+    response.count = 0;
+    return writeFully(fd, &response, sizeof(response)) && !m_entry_env.empty();
+  }
+
+  if (m_request.type == SERVER_SAVE) {
+    runBatch(&ServerController::saveEntry);
+
+    if (!writeFully(fd, &response, sizeof(response)))
+      return false;
+    for (size_t i = 0; i < m_entry_env.size(); i++) {
+      uint32_t header[2] = { m_entry_env[i], (uint32_t)m_entry_snapshot[i].size() };
+      if (!writeFully(fd, header, sizeof(header)) ||
+          !writeFully(fd, m_entry_snapshot[i].data(), m_entry_snapshot[i].size()))
+        return false;
+    }
+    return true;
+  }
+
+  // The other requests answer with one fixed-size observation per entry
+  m_obs_size = sizeof(ServerObservation);
+  if (m_request.flags & SERVER_SEND_RAM)
+    m_obs_size += m_envs->env(0).getRAM().size();
+  if (m_request.flags & SERVER_SEND_SCREEN)
+    m_obs_size += m_envs->screenSize();
+  m_output.resize(m_obs_size * m_entry_env.size());
+
+  if (m_request.type == SERVER_STEP)
+    runBatch(&ServerController::stepEntry);
+  else if (m_request.type == SERVER_RESET)
+    runBatch(&ServerController::resetEntry);
+  else
+    runBatch(&ServerController::restoreEntry);
+
+  return writeFully(fd, &response, sizeof(response)) &&
+    writeFully(fd, m_output.data(), m_output.size());
+}
+
+bool ServerController::readEntries(int fd, const ServerRequest& request) {
+  size_t count = request.count;
+  m_entry_env.resize(count);
+  m_entry_a.resize(count);
+  m_entry_b.resize(count);
+  m_entry_snapshot.resize(count);
+
+  // Read the whole request even if it is invalid, so that the stream stays
+  //  in sync; a short read clears m_entry_env to drop the connection
+  bool valid = true;
+  m_stamp++;
+  for (size_t i = 0; i < count; i++) {
+    uint32_t env;
+    if (!readFully(fd, &env, sizeof(env))) {
+      m_entry_env.clear();
+      return false;
+    }
+
+    if (request.type == SERVER_STEP) {
+      int32_t actions[2];
+      if (!readFully(fd, actions, sizeof(actions))) {
+        m_entry_env.clear();
+        return false;
+      }
+      m_entry_a[i] = (Action)actions[0];
+      m_entry_b[i] = (Action)actions[1];
+    }
+    else if (request.type == SERVER_RESTORE) {
+      uint32_t length;
+      if (!readFully(fd, &length, sizeof(length)) || length > SERVER_MAX_SNAPSHOT) {
+        m_entry_env.clear();
+        return false;
+      }
+      m_entry_snapshot[i].resize(length);
+      if (length > 0 && !readFully(fd, &m_entry_snapshot[i][0], length)) {
+        m_entry_env.clear();
+        return false;
+      }
+    }
+
+    // Each environment may appear only once, as entries run concurrently
+    if (env >= m_env_stamp.size() || m_env_stamp[env] == m_stamp)
+      valid = false;
+    else
+      m_env_stamp[env] = m_stamp;
+    m_entry_env[i] = env;
+  }
+
+  return valid;
+}
+
+void ServerController::runBatch(void (ServerController::*job)(size_t)) {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_job = job;
+    m_next_entry = 0;
+    m_busy_workers = m_workers.size();
+    m_generation++;
+  }
+  m_work_ready.notify_all();
+
+  drainBatch();
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_work_done.wait(lock, [this] { return m_busy_workers == 0; });
+}
+
+void ServerController::work() {
+  uint32_t generation = 0;
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_work_ready.wait(lock, [&] { return m_stopping || m_generation != generation; });
+      if (m_stopping) return;
+      generation = m_generation;
+    }
+
+    drainBatch();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (--m_busy_workers == 0)
+      m_work_done.notify_one();
+  }
+}
+
+void ServerController::drainBatch() {
+  for (;;) {
+    size_t i;
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (m_next_entry >= m_entry_env.size()) return;
+      i = m_next_entry++;
+    }
+    (this->*m_job)(i);
+  }
+}
+
+void ServerController::stepEntry(size_t i) {
+  ALEInterface& env = m_envs->env(m_entry_env[i]);
+  bool send_screen = (m_request.flags & SERVER_SEND_SCREEN) != 0;
+  int num_frames = std::max(1, (int)m_request.frame_skip);
+
+  // Colour averaging is off, so only the last frame reaches the screen
+  reward_t reward_a, reward_b;
+  if (!send_screen || num_frames == 1) {
+    runFrames(i, num_frames, send_screen ? 0 : num_frames, reward_a, reward_b);
+  }
+  else {
+    // Which frame is the last is only known once the game has, or hasn't,
+    //  ended: if it ends early, the frames that ran are emulated again from
+    //  the same state, drawing the last one
+    std::string start = env.getSnapshot();
+    int frames_run = runFrames(i, num_frames, num_frames - 1, reward_a, reward_b);
+    if (frames_run < num_frames) {
+      env.restoreSnapshot(start);
+      runFrames(i, frames_run, frames_run - 1, reward_a, reward_b);
+    }
+  }
+
+  writeObservation(i, reward_a, reward_b);
+}
+
+int ServerController::runFrames(size_t i, int num_frames, int first_rendered,
+                                reward_t& reward_a, reward_t& reward_b) {
+  ALEInterface& env = m_envs->env(m_entry_env[i]);
+  ALEStepResult result;
+  reward_a = 0;
+  reward_b = 0;
+
+  for (int f = 0; f < num_frames; f++) {
+    if (f > 0 && env.gameOver())
+      return f;
+
+    env.enableRendering(f >= first_rendered);
+    env.act2(m_entry_a[i], m_entry_b[i], &result.rewardA, &result.rewardB,
+             &result.sideBouncing, &result.wallBouncing, &result.points,
+             &result.crash, &result.serving);
+    reward_a += result.rewardA;
+    reward_b += result.rewardB;
+  }
+  return num_frames;
+}
+
+void ServerController::resetEntry(size_t i) {
+  ALEInterface& env = m_envs->env(m_entry_env[i]);
+  env.enableRendering(true);
+  env.resetGame();
+  writeObservation(i, 0, 0);
+}
+
+void ServerController::saveEntry(size_t i) {
+  m_entry_snapshot[i] = m_envs->env(m_entry_env[i]).getSnapshot();
+}
+
+void ServerController::restoreEntry(size_t i) {
+  // The restored state doesn't include a screen; the one sent is stale
+  m_envs->env(m_entry_env[i]).restoreSnapshot(m_entry_snapshot[i]);
+  writeObservation(i, 0, 0);
+}
+
+void ServerController::writeObservation(size_t i, reward_t reward_a, reward_t reward_b) {
+  const ALEInterface& env = m_envs->env(m_entry_env[i]);
+  char* data = &m_output[i * m_obs_size];
+
+  ServerObservation obs;
+  obs.env = m_entry_env[i];
+  obs.flags = env.gameOver() ? SERVER_OBS_GAME_OVER : 0;
+  obs.reward_a = (int32_t)reward_a;
+  obs.reward_b = (int32_t)reward_b;
+  memcpy(data, &obs, sizeof(obs));
+  data += sizeof(obs);
+
+  if (m_request.flags & SERVER_SEND_RAM) {
+    const ALERAM& ram = env.getRAM();
+    memcpy(data, ram.array(), ram.size());
+    data += ram.size();
+  }
+  if (m_request.flags & SERVER_SEND_SCREEN) {
+    const ALEScreen& screen = env.getScreen();
+    memcpy(data, &screen.getArray()[0], screen.arraySize());
+  }
+}
+
+#else
+
+using namespace ale;
+
+ServerController::ServerController(OSystem* system):
+  ALEController(system) {
+}
+
+void ServerController::run() {
+  throw std::runtime_error("Server mode unavailable on this platform.");
+}
+#endif // WIN32
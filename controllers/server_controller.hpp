@@ -0,0 +1,124 @@
+/* *****************************************************************************
+ * Xitari
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ * *****************************************************************************
+ *  server_controller.hpp
+ *
+ *  The ServerController class hosts many environments running the loaded
+ *  ROM and serves batched requests for them over a Unix domain or TCP
+ *  socket (see server_protocol.hpp). The entries of a batch are spread over
+ *  a pool of worker threads.
+ **************************************************************************** */
+
+#ifndef __SERVER_CONTROLLER_HPP__
+#define __SERVER_CONTROLLER_HPP__
+
+#include "ale_controller.hpp"
+
+#ifndef WIN32
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "ale_batch_interface.hpp"
+#include "server_protocol.hpp"
+
+namespace ale {
+
+class ServerController : public ALEController {
+  public:
+    ServerController(OSystem* osystem);
+    virtual ~ServerController();
+
+    virtual void run();
+
+  private:
+    /** Opens the listening socket */
+    void listen();
+    /** Serves one client until it disconnects; false once it asked us to quit */
+    bool serve(int fd);
+    /** Reads and answers one request; false when the connection should close */
+    bool handleRequest(int fd);
+
+    /** Reads the entries of a request and checks their environment ids */
+    bool readEntries(int fd, const ServerRequest& request);
+    /** Runs stepEntry/resetEntry/... over the current batch on the workers */
+    void runBatch(void (ServerController::*job)(size_t));
+
+    void stepEntry(size_t i);
+    /** Steps entry i for up to num_frames frames, drawing those from
+        first_rendered on; returns how many ran before the game ended */
+    int runFrames(size_t i, int num_frames, int first_rendered,
+                  reward_t& reward_a, reward_t& reward_b);
+    void resetEntry(size_t i);
+    void saveEntry(size_t i);
+    void restoreEntry(size_t i);
+    /** Writes the observation of entry i into its slot of m_output */
+    void writeObservation(size_t i, reward_t reward_a, reward_t reward_b);
+
+    /** Worker thread body */
+    void work();
+    /** Processes entries of the current batch until there are none left */
+    void drainBatch();
+
+  private:
+    std::unique_ptr<ALEBatchInterface> m_envs;
+    int m_listen_fd;
+    std::string m_socket_path; // Set when listening on a Unix domain socket
+
+    // Current request
+    ServerRequest m_request;
+    size_t m_obs_size; // Size of an observation record for this request
+    std::vector<uint32_t> m_entry_env;
+    std::vector<Action> m_entry_a;
+    std::vector<Action> m_entry_b;
+    std::vector<std::string> m_entry_snapshot;
+    std::vector<uint32_t> m_env_stamp; // Last request each env appeared in
+    uint32_t m_stamp;
+    std::vector<char> m_output; // Observation records, filled by the workers
+
+    // Worker pool
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_work_ready;
+    std::condition_variable m_work_done;
+    void (ServerController::*m_job)(size_t);
+    size_t m_next_entry; // Guarded by m_mutex
+    size_t m_busy_workers; // Guarded by m_mutex
+    uint32_t m_generation; // Bumped for every batch
+    bool m_stopping;
+};
+
+} // namespace ale
+
+#else
+
+namespace ale {
+
+class ServerController : public ALEController {
+  public:
+    ServerController(OSystem* osystem);
+    virtual ~ServerController() {}
+
+    /** This prints an error message and terminate. */
+    virtual void run();
+};
+
+} // namespace ale
+
+#endif // WIN32
+
+#endif // __SERVER_CONTROLLER_HPP__
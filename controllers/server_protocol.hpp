@@ -0,0 +1,108 @@
+/* *****************************************************************************
+ * Xitari
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ * *****************************************************************************
+ *  server_protocol.hpp
+ *
+ *  Wire format of the 'server' game controller, which hosts many
+ *  environments in one process. Only depends on the standard library so
+ *  clients can include it on their own. Everything is in native byte order.
+ *
+ *  On connection the server sends a ServerHello. The client then sends
+ *  requests, each a ServerRequest followed by count entries, and gets one
+ *  ServerResponse followed by count records (none if status isn't
+ *  SERVER_OK). Entries and records by request type:
+ *
+ *    SERVER_STEP     entry:  uint32 env, int32 action A, int32 action B
+ *                    record: ServerObservation
+ *    SERVER_RESET    entry:  uint32 env
+ *                    record: ServerObservation
+ *    SERVER_SAVE     entry:  uint32 env
+ *                    record: uint32 env, uint32 length, length snapshot bytes
+ *    SERVER_RESTORE  entry:  uint32 env, uint32 length, length snapshot bytes
+ *                    record: ServerObservation
+ *    SERVER_QUIT     no entries or records; the server exits
+ *
+ *  A ServerObservation is followed by the RAM if SERVER_SEND_RAM was set,
+ *  then by the screen's palette indices if SERVER_SEND_SCREEN was set. A
+ *  step that doesn't ask for the screen doesn't draw it, and snapshots
+ *  don't hold one, so the screen sent after SERVER_RESTORE is stale until
+ *  the next step. Records come back in the order of the entries. An
+ *  environment may appear only once per request.
+ **************************************************************************** */
+
+#ifndef __SERVER_PROTOCOL_HPP__
+#define __SERVER_PROTOCOL_HPP__
+
+#include <stdint.h>
+
+namespace ale {
+
+static const uint32_t SERVER_MAGIC = 0x56525358; // "XSRV"
+static const uint32_t SERVER_VERSION = 1;
+
+// Request types
+static const uint8_t SERVER_STEP = 1;
+static const uint8_t SERVER_RESET = 2;
+static const uint8_t SERVER_SAVE = 3;
+static const uint8_t SERVER_RESTORE = 4;
+static const uint8_t SERVER_QUIT = 5;
+
+// Request flags
+static const uint8_t SERVER_SEND_RAM = 0x1;
+static const uint8_t SERVER_SEND_SCREEN = 0x2;
+
+// Response status
+static const uint32_t SERVER_OK = 0;
+static const uint32_t SERVER_BAD_REQUEST = 1;
+
+// Observation flags
+static const uint32_t SERVER_OBS_GAME_OVER = 0x1;
+
+
+struct ServerHello {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t num_envs;
+    uint32_t width;                 // Screen geometry, in pixels
+    uint32_t height;
+    uint32_t ram_size;              // In bytes
+};
+
+
+struct ServerRequest {
+    uint8_t type;
+    uint8_t flags;
+    uint16_t frame_skip;            // SERVER_STEP: frames per action, 0 means 1
+    uint32_t count;                 // Number of entries that follow
+};
+
+
+struct ServerResponse {
+    uint32_t status;
+    uint32_t count;                 // Number of records that follow
+};
+
+
+struct ServerObservation {
+    uint32_t env;
+    uint32_t flags;
+    int32_t reward_a;               // Rewards summed over the frame skip
+    int32_t reward_b;
+};
+
+} // namespace ale
+
+#endif // __SERVER_PROTOCOL_HPP__
@@ -0,0 +1,199 @@
+/* *****************************************************************************
+ * Xitari
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ * *****************************************************************************
+ *  shm_channel.hpp
+ *
+ *  Layout of the shared-memory region used by the 'shm' game controller, and
+ *  the single-producer/single-consumer rings both sides use to talk through
+ *  it. This header only depends on the standard library and POSIX so agents
+ *  can include it on their own.
+ *
+ *  ALE creates the region (shm_open) and lays it out as
+ *    ShmHeader | observation slots | action slots
+ *  then sets ShmHeader::magic. The agent maps it, fills in frame_skip,
+ *  send_screen and agent_pid and sets ShmHeader::attached. From then on ALE
+ *  pushes an observation, the agent pushes an action, and so on. The last
+ *  observation has SHM_OBS_EXITING set.
+ **************************************************************************** */
+
+#ifndef __SHM_CHANNEL_HPP__
+#define __SHM_CHANNEL_HPP__
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#else
+#include <sched.h>
+#endif
+
+namespace ale {
+
+static const uint32_t SHM_MAGIC = 0x4d485358; // "XSHM"
+static const uint32_t SHM_VERSION = 1;
+
+// Number of slots of each ring. The protocol is lockstep, so two are plenty.
+static const uint32_t SHM_NUM_SLOTS = 2;
+
+// Observation flags
+static const uint32_t SHM_OBS_TERMINAL = 0x1;
+static const uint32_t SHM_OBS_EXITING = 0x2;
+
+
+// Producer/consumer counters of one ring. Slot i % num_slots holds the i-th
+// message. Each counter sits on its own cache line so the two sides don't
+// bounce a line back and forth.
+struct ShmRing {
+    std::atomic<uint32_t> head;     // Messages written, owned by the producer
+    char pad0[64 - sizeof(std::atomic<uint32_t>)];
+    std::atomic<uint32_t> tail;     // Messages read, owned by the consumer
+    char pad1[64 - sizeof(std::atomic<uint32_t>)];
+    std::atomic<uint32_t> waiters;  // Processes sleeping on head or tail
+    char pad2[64 - sizeof(std::atomic<uint32_t>)];
+};
+
+
+struct ShmHeader {
+    std::atomic<uint32_t> magic;    // SHM_MAGIC once the region is laid out
+    uint32_t version;
+    uint32_t width;                 // Screen geometry, in pixels
+    uint32_t height;
+    uint32_t ram_size;              // In bytes
+    uint32_t num_slots;
+    uint32_t obs_size;              // Bytes per observation slot
+    uint32_t obs_offset;            // Offsets of the slot arrays from the header
+    uint32_t action_offset;
+
+    // Filled in by the agent before it sets attached
+    int32_t frame_skip;             // Frames each action is repeated for
+    int32_t send_screen;            // Whether observations carry the screen
+    int32_t agent_pid;              // Lets ALE notice a dead agent
+    std::atomic<uint32_t> attached;
+
+    char pad[64 - 13 * sizeof(uint32_t)];
+
+    ShmRing observations;           // ALE -> agent
+    ShmRing actions;                // Agent -> ALE
+};
+
+
+// Observation slot; ram_size bytes of RAM and, when requested, width * height
+// palette indices follow it.
+struct ShmObservation {
+    uint32_t flags;
+    uint32_t frame;                 // Frame number of the environment
+    int32_t reward_a;               // Rewards summed over the frame skip
+    int32_t reward_b;
+};
+
+
+struct ShmAction {
+    int32_t player_a;
+    int32_t player_b;
+};
+
+
+inline size_t shmObservationSize(uint32_t width, uint32_t height, uint32_t ram_size) {
+    // Keep every slot cache line aligned
+    size_t size = sizeof(ShmObservation) + ram_size + width * height;
+    return (size + 63) & ~(size_t)63;
+}
+
+
+// Blocks until *word no longer holds value, or until timeout_ms elapses.
+// Spins briefly first: when both sides are running the answer usually comes
+// back sooner than a sleep and wake-up would take.
+inline void shmWait(std::atomic<uint32_t>& word, uint32_t value,
+                    std::atomic<uint32_t>& waiters, int timeout_ms) {
+    for (int i = 0; i < 2000; i++) {
+        if (word.load(std::memory_order_acquire) != value) return;
+    }
+#ifdef __linux__
+    struct timespec timeout;
+    timeout.tv_sec = timeout_ms / 1000;
+    timeout.tv_nsec = (timeout_ms % 1000) * 1000000L;
+
+    waiters.fetch_add(1);
+    // The kernel rechecks the value, so a post between our load and the
+    //  syscall is not lost
+    if (word.load() == value)
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT, value,
+                &timeout, NULL, 0);
+    waiters.fetch_sub(1);
+#else
+    (void)waiters; (void)timeout_ms;
+    sched_yield();
+#endif
+}
+
+
+// Wakes whoever sleeps in shmWait() on word
+inline void shmWake(std::atomic<uint32_t>& word, std::atomic<uint32_t>& waiters) {
+#ifdef __linux__
+    if (waiters.load() > 0)
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE, 1,
+                NULL, NULL, 0);
+#else
+    (void)word; (void)waiters;
+#endif
+}
+
+
+// Producer side: returns the slot index to write, or -1 if the ring stayed
+// full for timeout_ms.
+inline int shmBeginPush(ShmRing& ring, uint32_t num_slots, int timeout_ms) {
+    uint32_t head = ring.head.load(std::memory_order_relaxed);
+    uint32_t tail = ring.tail.load(std::memory_order_acquire);
+    if (head - tail >= num_slots) {
+        shmWait(ring.tail, tail, ring.waiters, timeout_ms);
+        if (head - ring.tail.load(std::memory_order_acquire) >= num_slots)
+            return -1;
+    }
+    return head % num_slots;
+}
+
+inline void shmEndPush(ShmRing& ring) {
+    ring.head.store(ring.head.load(std::memory_order_relaxed) + 1);
+    shmWake(ring.head, ring.waiters);
+}
+
+
+// Consumer side: returns the slot index to read, or -1 if the ring stayed
+// empty for timeout_ms.
+inline int shmBeginPop(ShmRing& ring, uint32_t num_slots, int timeout_ms) {
+    uint32_t tail = ring.tail.load(std::memory_order_relaxed);
+    uint32_t head = ring.head.load(std::memory_order_acquire);
+    if (head == tail) {
+        shmWait(ring.head, head, ring.waiters, timeout_ms);
+        if (ring.head.load(std::memory_order_acquire) == tail)
+            return -1;
+    }
+    return tail % num_slots;
+}
+
+inline void shmEndPop(ShmRing& ring) {
+    ring.tail.store(ring.tail.load(std::memory_order_relaxed) + 1);
+    shmWake(ring.tail, ring.waiters);
+}
+
+} // namespace ale
+
+#endif // __SHM_CHANNEL_HPP__
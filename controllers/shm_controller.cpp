@@ -0,0 +1,218 @@
+/* *****************************************************************************
+ * Xitari
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ * *****************************************************************************
+ *  shm_controller.cpp
+ *
+ *  The SHMController class implements an Agent/ALE interface through a POSIX
+ *  shared-memory region.
+ **************************************************************************** */
+
+#include "shm_controller.hpp"
+
+#include <stdexcept>
+
+#ifndef WIN32
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+using namespace ale;
+
+// How long to sleep between checks that the agent is still alive
+#define SHM_POLL_MS 1000
+
+SHMController::SHMController(OSystem* _osystem) :
+  ALEController(_osystem),
+  m_header(NULL),
+  m_region_size(0),
+  m_observations(NULL),
+  m_actions(NULL),
+  m_frame_skip(1),
+  m_send_screen(true),
+  m_render(true),
+  m_agent_gone(false),
+  m_reward(0),
+  m_reward_b(0) {
+  m_name = m_osystem->settings().getString("shm_name");
+  m_max_num_frames = m_osystem->settings().getInt("max_num_frames");
+}
+
+SHMController::~SHMController() {
+  if (m_header != NULL) {
+    munmap(m_header, m_region_size);
+    shm_unlink(m_name.c_str());
+  }
+}
+
+void SHMController::run() {
+  Action action_a, action_b;
+
+  // First perform handshaking
+  handshake();
+
+  // Main loop
+  while (!isDone()) {
+    // Send data over to agent
+    if (!sendObservation(m_environment.isTerminal() ? SHM_OBS_TERMINAL : 0))
+      break;
+    // Read agent's response & process it
+    if (!readAction(action_a, action_b))
+      break;
+
+    // Emulate Atari forward
+    emulate(action_a, action_b);
+
+    // Update display if needed
+    display();
+  }
+
+  // Send a termination signal to the agent, if they're still around
+  if (!m_agent_gone)
+    sendObservation(SHM_OBS_EXITING);
+}
+
+bool SHMController::isDone() {
+  // Die once we reach enough samples
+  return (m_agent_gone ||
+    (m_max_num_frames > 0 && m_environment.getFrameNumber() >= m_max_num_frames));
+}
+
+bool SHMController::agentAlive() const {
+  return kill(m_header->agent_pid, 0) == 0 || errno != ESRCH;
+}
+
+void SHMController::handshake() {
+  const ALEScreen& screen = m_environment.getScreen();
+  uint32_t width = (uint32_t)screen.width();
+  uint32_t height = (uint32_t)screen.height();
+  uint32_t ram_size = (uint32_t)m_environment.getRAM().size();
+
+  size_t obs_size = shmObservationSize(width, height, ram_size);
+  size_t obs_offset = sizeof(ShmHeader);
+  size_t action_offset = obs_offset + SHM_NUM_SLOTS * obs_size;
+  m_region_size = action_offset + SHM_NUM_SLOTS * sizeof(ShmAction);
+
+  // Start from a fresh object, in case a previous run died without cleaning up
+  shm_unlink(m_name.c_str());
+  int fd = shm_open(m_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd < 0)
+    throw std::runtime_error("Cannot create shared memory " + m_name + ": " + strerror(errno));
+
+  if (ftruncate(fd, m_region_size) != 0) {
+    close(fd);
+    shm_unlink(m_name.c_str());
+    throw std::runtime_error("Cannot size shared memory " + m_name + ": " + strerror(errno));
+  }
+
+  void* region = mmap(NULL, m_region_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (region == MAP_FAILED) {
+    shm_unlink(m_name.c_str());
+    throw std::runtime_error("Cannot map shared memory " + m_name + ": " + strerror(errno));
+  }
+
+  // The object comes zero-filled, which is a valid initial state for the rings
+  m_header = static_cast<ShmHeader*>(region);
+  m_observations = static_cast<char*>(region) + obs_offset;
+  m_actions = reinterpret_cast<ShmAction*>(static_cast<char*>(region) + action_offset);
+
+  m_header->version = SHM_VERSION;
+  m_header->width = width;
+  m_header->height = height;
+  m_header->ram_size = ram_size;
+  m_header->num_slots = SHM_NUM_SLOTS;
+  m_header->obs_size = (uint32_t)obs_size;
+  m_header->obs_offset = (uint32_t)obs_offset;
+  m_header->action_offset = (uint32_t)action_offset;
+  m_header->magic.store(SHM_MAGIC);
+
+  std::cerr << "Waiting for an agent to attach to shared memory " << m_name << std::endl;
+  while (m_header->attached.load() == 0)
+    shmWait(m_header->attached, 0, m_header->observations.waiters, SHM_POLL_MS);
+
+  m_frame_skip = m_header->frame_skip;
+  m_send_screen = m_header->send_screen != 0;
+
+  // Nobody looks at the screen: let the TIA skip drawing it
+  m_render = m_send_screen || m_osystem->p_display_screen != NULL;
+  m_environment.enableRendering(m_render);
+}
+
+bool SHMController::sendObservation(uint32_t flags) {
+  int slot;
+  while ((slot = shmBeginPush(m_header->observations, SHM_NUM_SLOTS, SHM_POLL_MS)) < 0) {
+    if (!agentAlive()) {
+      m_agent_gone = true;
+      return false;
+    }
+  }
+
+  char* data = m_observations + slot * m_header->obs_size;
+  ShmObservation* obs = reinterpret_cast<ShmObservation*>(data);
+  obs->flags = flags;
+  obs->frame = (uint32_t)m_environment.getFrameNumber();
+  obs->reward_a = (int32_t)m_reward;
+  obs->reward_b = (int32_t)m_reward_b;
+
+  // Copy the observation straight into the slot
+  data += sizeof(ShmObservation);
+  memcpy(data, m_environment.getRAM().array(), m_header->ram_size);
+  if (m_send_screen) {
+    data += m_header->ram_size;
+    memcpy(data, &m_environment.getScreen().getArray()[0],
+           m_header->width * m_header->height);
+  }
+
+  shmEndPush(m_header->observations);
+  return true;
+}
+
+bool SHMController::readAction(Action& action_a, Action& action_b) {
+  int slot;
+  while ((slot = shmBeginPop(m_header->actions, SHM_NUM_SLOTS, SHM_POLL_MS)) < 0) {
+    if (!agentAlive()) {
+      m_agent_gone = true;
+      return false;
+    }
+  }
+
+  action_a = (Action)m_actions[slot].player_a;
+  action_b = (Action)m_actions[slot].player_b;
+
+  shmEndPop(m_header->actions);
+  return true;
+}
+
+void SHMController::emulate(Action action_a, Action action_b) {
+  // Only the frames that can end up in the screen we send are drawn
+  emulateFrames(action_a, action_b, m_frame_skip, m_render, m_reward, m_reward_b);
+}
+
+#else
+
+using namespace ale;
+
+SHMController::SHMController(OSystem* system):
+  ALEController(system) {
+}
+
+void SHMController::run() {
+  throw std::runtime_error("Shared-memory interface unavailable on this platform.");
+}
+#endif // WIN32
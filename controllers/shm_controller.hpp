@@ -0,0 +1,95 @@
+/* *****************************************************************************
+ * Xitari
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ * *****************************************************************************
+ *  shm_controller.hpp
+ *
+ *  The SHMController class implements an Agent/ALE interface through a POSIX
+ *  shared-memory region (see shm_channel.hpp for its layout). Observations
+ *  and actions are exchanged without going through the kernel unless one
+ *  side has to sleep.
+ **************************************************************************** */
+
+#ifndef __SHM_CONTROLLER_HPP__
+#define __SHM_CONTROLLER_HPP__
+
+#include "ale_controller.hpp"
+
+#ifndef WIN32
+#include "shm_channel.hpp"
+
+namespace ale {
+
+class SHMController : public ALEController {
+  public:
+    SHMController(OSystem* osystem);
+    virtual ~SHMController();
+
+    virtual void run();
+
+  private:
+    /** Creates the shared region and waits for the agent to attach */
+    void handshake();
+
+    bool isDone();
+    /** Whether the agent process still exists */
+    bool agentAlive() const;
+
+    /** Publishes the current observation; flags are SHM_OBS_* bits */
+    bool sendObservation(uint32_t flags);
+    /** Waits for the agent's next action; false if the agent went away */
+    bool readAction(Action& action_a, Action& action_b);
+
+    /** Applies the agent's action, repeated over the frame skip */
+    void emulate(Action action_a, Action action_b);
+
+  private:
+    std::string m_name; // Name of the shared-memory object
+    int m_max_num_frames; // Maximum number of total frames before we stop
+
+    ShmHeader* m_header;
+    size_t m_region_size;
+    char* m_observations;
+    ShmAction* m_actions;
+
+    int m_frame_skip;  // Requested frame skip
+    bool m_send_screen; // Agent requested screen data
+    bool m_render; // Whether anybody looks at the screen
+    bool m_agent_gone; // The agent stopped answering
+
+    reward_t m_reward; // Player A's reward summed over the last frame skip
+    reward_t m_reward_b; // Player B's reward summed over the last frame skip
+};
+
+} // namespace ale
+
+#else
+
+namespace ale {
+
+class SHMController : public ALEController {
+  public:
+    SHMController(OSystem* osystem);
+    virtual ~SHMController() {}
+
+    /** This prints an error message and terminate. */
+    virtual void run();
+};
+
+} // namespace ale
+
+#endif // WIN32
+
+#endif // __SHM_CONTROLLER_HPP__
@@ -178,6 +178,16 @@ Console::Console(OSystem* osystem, Cartridge* cart, const Properties& props)
   myCart = cart;
   myRiot = m6532;
 
+#ifdef __USE_ROM_PROFILER
+  myProfiler = 0;
+  myProfilePrefix = myOSystem->settings().getString("rom_profile");
+  if(!myProfilePrefix.empty())
+  {
+    myProfiler = new RomProfiler(*cart);
+    mySystem->setProfiler(myProfiler);
+  }
+#endif
+
   // Query some info about this console
   std::ostringstream buf;
   buf << "  Cart Name: " << myProperties.get(Cartridge_Name) << std::endl
@@ -229,6 +239,17 @@ Console::Console(OSystem* osystem, Cartridge* cart, const Properties& props)
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 Console::~Console()
 {
+#ifdef __USE_ROM_PROFILER
+  if(myProfiler)
+  {
+    if(!myProfiler->writeReport(myProfilePrefix + ".txt") ||
+       !myProfiler->writeDump(myProfilePrefix + ".prof"))
+      std::cerr << "Cannot write the ROM profile to " << myProfilePrefix << std::endl;
+    mySystem->setProfiler(0);
+    delete myProfiler;
+  }
+#endif
+
   delete mySystem;
   delete mySwitches;
   delete myControllers[0];
@@ -37,6 +37,7 @@ class System;
 #include "Cart.hxx"
 #include "M6532.hxx"
 #include "AtariVox.hxx"
+#include "RomProfiler.hxx"
 
 namespace ale {
 
@@ -124,6 +125,16 @@ class Console
     */
     M6532& riot() const { return *myRiot; }
 
+#ifdef __USE_ROM_PROFILER
+    /**
+      Get the ROM profiler, or the null pointer if rom_profile isn't set.
+      Its report and dump are written when the console is destroyed.
+
+      @return The profiler
+    */
+    RomProfiler* profiler() const { return myProfiler; }
+#endif
+
     /**
       Set the properties to those given
 
@@ -292,6 +303,12 @@ class Console
     AtariVox *vox;
 #endif
 
+#ifdef __USE_ROM_PROFILER
+    // Profiler fed by the system, and where its output goes
+    RomProfiler* myProfiler;
+    std::string myProfilePrefix;
+#endif
+
     // The currently defined display format (NTSC/PAL/PAL60)
     std::string myDisplayFormat;
 
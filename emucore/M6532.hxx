@@ -115,6 +115,14 @@ class M6532 : public Device
     */
     virtual void poke(uInt16 address, uInt8 value);
 
+    /**
+      Get the 128 bytes of RAM ($80-$FF) without going through the system,
+      which leaves the data bus untouched
+
+      @return The RAM, updated in place as the system runs
+    */
+    const uInt8* ram() const { return myRAM; }
+
   private:
     // Reference to the console
     const Console& myConsole;
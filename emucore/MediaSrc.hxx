@@ -72,6 +72,16 @@ class MediaSource
     */
     virtual uInt8* previousFrameBuffer() const = 0;
 
+    /**
+      Enables/disables writing pixels into the frame buffer.  While
+      disabled, all emulation-visible state (object positions, collision
+      latches, ...) is still updated exactly, but the frame buffer is left
+      untouched.  Intended for frames whose screen is never observed.
+
+      @param mode  Whether frames should be rendered
+    */
+    virtual void enableRendering(bool mode) = 0;
+
   public:
     /**
       Answers the height of the frame buffer
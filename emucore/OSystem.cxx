@@ -329,8 +329,10 @@ bool OSystem::createConsole(const std::string& romfile)
     Properties props;
     if(queryConsoleInfo(image, size, md5, &cart, props))
     {
-      // Create an instance of the 2600 game console
-      mySettings->setString("cpu", "low");
+      // Create an instance of the 2600 game console. ALE runs on the
+      //  low-compatibility CPU unless the high one is asked for.
+      if(mySettings->getString("cpu") != "high")
+        mySettings->setString("cpu", "low");
       myConsole = new Console(this, cart, props);
       //ALE  myEventHandler->reset(EventHandler::S_EMULATE);
       //ALE  createFrameBuffer(false);  // Takes care of initializeVideo()
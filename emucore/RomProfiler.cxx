@@ -0,0 +1,288 @@
+//============================================================================
+//
+//   SSSS    tt          lll  lll
+//  SS  SS   tt           ll   ll
+//  SS     tttttt  eeee   ll   ll   aaaa
+//   SSSS    tt   ee  ee  ll   ll      aa
+//      SS   tt   eeeeee  ll   ll   aaaaa  --  "An Atari 2600 VCS Emulator"
+//  SS  SS   tt   ee      ll   ll  aa  aa
+//   SSSS     ttt  eeeee llll llll  aaaaa
+//
+// Copyright (c) 1995-2007 by Bradford W. Mott and the Stella team
+//
+// See the file "license" for information on usage and redistribution of
+// this file, and for a DISCLAIMER OF ALL WARRANTIES.
+//============================================================================
+
+#include "RomProfiler.hxx"
+
+#ifdef __USE_ROM_PROFILER
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "Cart.hxx"
+#include "m6502/src/M6502.hxx"
+
+using namespace ale;
+
+namespace ale {
+
+// Gives RomProfiler the 6502's mnemonic table
+class RomProfilerMnemonics : public M6502
+{
+  public:
+    static const char* mnemonic(uInt8 opcode)
+    {
+      return ourInstructionMnemonicTable[opcode];
+    }
+};
+
+} // namespace ale
+
+static const char* ourTIAReadNames[16] = {
+  "CXM0P", "CXM1P", "CXP0FB", "CXP1FB", "CXM0FB", "CXM1FB", "CXBLPF", "CXPPMM",
+  "INPT0", "INPT1", "INPT2", "INPT3", "INPT4", "INPT5", "", ""
+};
+
+static const char* ourTIAWriteNames[64] = {
+  "VSYNC", "VBLANK", "WSYNC", "RSYNC", "NUSIZ0", "NUSIZ1", "COLUP0", "COLUP1",
+  "COLUPF", "COLUBK", "CTRLPF", "REFP0", "REFP1", "PF0", "PF1", "PF2",
+  "RESP0", "RESP1", "RESM0", "RESM1", "RESBL", "AUDC0", "AUDC1", "AUDF0",
+  "AUDF1", "AUDV0", "AUDV1", "GRP0", "GRP1", "ENAM0", "ENAM1", "ENABL",
+  "HMP0", "HMP1", "HMM0", "HMM1", "HMBL", "VDELP0", "VDELP1", "VDELBL",
+  "RESMP0", "RESMP1", "HMOVE", "HMCLR", "CXCLR", "", "", "",
+  "", "", "", "", "", "", "", "",
+  "", "", "", "", "", "", "", ""
+};
+
+static const char* ourRIOTReadNames[8] = {
+  "SWCHA", "SWACNT", "SWCHB", "SWBCNT", "INTIM", "TIMINT", "INTIM", "TIMINT"
+};
+
+static const char* ourRIOTWriteNames[32] = {
+  "SWCHA", "SWACNT", "SWCHB", "SWBCNT", "", "", "", "",
+  "", "", "", "", "", "", "", "",
+  "", "", "", "", "TIM1T", "TIM8T", "TIM64T", "T1024T",
+  "", "", "", "", "", "", "", ""
+};
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+RomProfiler::RomProfiler(Cartridge& cart)
+  : myCart(cart)
+{
+  clear();
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+RomProfiler::Counters& RomProfiler::counters(uInt16 pc)
+{
+  // A12 selects the cartridge; below it, code can only be running from RAM
+  if(!(pc & 0x1000))
+    return myRAM[pc & 0x0FFF];
+
+  // Carts without bankswitching answer -1 or 0
+  int bank = std::max(myCart.bank(), 0);
+  size_t index = ((size_t)bank << 12) | (pc & 0x0FFF);
+  if(index >= myBanks.size())
+  {
+    Counters zero = { 0, 0, 0 };
+    myBanks.resize(((size_t)bank + 1) << 12, zero);
+  }
+  return myBanks[index];
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void RomProfiler::read(uInt16 addr)
+{
+  if((addr & 0x1080) == 0)
+    myTIAReads[addr & 0x0F]++;
+  else if((addr & 0x1280) == 0x0280)
+    myRIOTReads[addr & 0x07]++;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void RomProfiler::write(uInt16 addr)
+{
+  if((addr & 0x1080) == 0)
+    myTIAWrites[addr & 0x3F]++;
+  else if((addr & 0x1280) == 0x0280)
+    myRIOTWrites[addr & 0x17]++;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void RomProfiler::clear()
+{
+  Counters zero = { 0, 0, 0 };
+  int banks = std::max(myCart.bankCount(), 1);
+  myBanks.assign((size_t)banks << 12, zero);
+  myRAM.assign(0x1000, zero);
+
+  memset(myTIAReads, 0, sizeof(myTIAReads));
+  memset(myTIAWrites, 0, sizeof(myTIAWrites));
+  memset(myRIOTReads, 0, sizeof(myRIOTReads));
+  memset(myRIOTWrites, 0, sizeof(myRIOTWrites));
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void RomProfiler::collect(std::vector<RomProfileInstruction>& instructions,
+                          std::vector<RomProfileRegister>& registers) const
+{
+  RomProfileInstruction entry;
+  memset(&entry, 0, sizeof(entry));
+  for(size_t i = 0; i < myBanks.size() + myRAM.size(); ++i)
+  {
+    bool ram = i >= myBanks.size();
+    const Counters& counters = ram ? myRAM[i - myBanks.size()] : myBanks[i];
+    if(counters.instructions == 0)
+      continue;
+
+    entry.bank = ram ? ROM_PROFILE_RAM_BANK : (uInt16)(i >> 12);
+    entry.pc = ram ? (uInt16)(i - myBanks.size()) : (uInt16)(0x1000 | (i & 0x0FFF));
+    entry.opcode = counters.opcode;
+    entry.instructions = counters.instructions;
+    entry.cycles = counters.cycles;
+    instructions.push_back(entry);
+  }
+
+  RomProfileRegister reg;
+  memset(&reg, 0, sizeof(reg));
+  for(uInt16 addr = 0; addr < 0x40; ++addr)
+  {
+    reg.address = addr;
+    reg.reads = myTIAReads[addr];
+    reg.writes = myTIAWrites[addr];
+    if(reg.reads || reg.writes)
+      registers.push_back(reg);
+  }
+  for(uInt16 addr = 0; addr < 0x20; ++addr)
+  {
+    reg.address = 0x280 | addr;
+    reg.reads = myRIOTReads[addr];
+    reg.writes = myRIOTWrites[addr];
+    if(reg.reads || reg.writes)
+      registers.push_back(reg);
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+static bool moreCycles(const RomProfileInstruction& a, const RomProfileInstruction& b)
+{
+  return a.cycles > b.cycles;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+static bool moreAccesses(const RomProfileRegister& a, const RomProfileRegister& b)
+{
+  return a.reads + a.writes > b.reads + b.writes;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+static std::string registerName(const RomProfileRegister& reg)
+{
+  // Reads and writes of the same address reach different registers
+  std::string read, write;
+  if(reg.address < 0x40)
+  {
+    if(reg.reads) read = ourTIAReadNames[reg.address & 0x0F];
+    if(reg.writes) write = ourTIAWriteNames[reg.address];
+  }
+  else
+  {
+    if(reg.reads) read = ourRIOTReadNames[reg.address & 0x07];
+    if(reg.writes) write = ourRIOTWriteNames[reg.address & 0x1F];
+  }
+
+  if(read.empty() || write.empty() || read == write)
+    return read.empty() ? write : read;
+  return read + "/" + write;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+bool RomProfiler::writeReport(const std::string& filename) const
+{
+  std::vector<RomProfileInstruction> instructions;
+  std::vector<RomProfileRegister> registers;
+  collect(instructions, registers);
+  std::stable_sort(instructions.begin(), instructions.end(), moreCycles);
+  std::stable_sort(registers.begin(), registers.end(), moreAccesses);
+
+  FILE* file = fopen(filename.c_str(), "w");
+  if(file == NULL)
+    return false;
+
+  ::uint64_t totalInstructions = 0, totalCycles = 0;
+  for(size_t i = 0; i < instructions.size(); ++i)
+  {
+    totalInstructions += instructions[i].instructions;
+    totalCycles += instructions[i].cycles;
+  }
+
+  fprintf(file, "%llu instructions, %llu cycles, %u addresses\n\n",
+          (unsigned long long)totalInstructions, (unsigned long long)totalCycles,
+          (unsigned)instructions.size());
+  fprintf(file, "%5s %6s %-5s %14s %14s %7s %7s %7s\n", "bank", "pc", "op",
+          "instructions", "cycles", "cycles%", "cumul%", "cyc/ins");
+
+  ::uint64_t cumulative = 0;
+  for(size_t i = 0; i < instructions.size(); ++i)
+  {
+    const RomProfileInstruction& entry = instructions[i];
+    cumulative += entry.cycles;
+
+    char bank[8];
+    if(entry.bank == ROM_PROFILE_RAM_BANK)
+      strcpy(bank, "ram");
+    else
+      sprintf(bank, "%u", entry.bank);
+
+    fprintf(file, "%5s  $%04X %-5s %14llu %14llu %7.2f %7.2f %7.2f\n",
+            bank, entry.pc, RomProfilerMnemonics::mnemonic(entry.opcode),
+            (unsigned long long)entry.instructions,
+            (unsigned long long)entry.cycles,
+            totalCycles ? 100.0 * entry.cycles / totalCycles : 0.0,
+            totalCycles ? 100.0 * cumulative / totalCycles : 0.0,
+            (double)entry.cycles / entry.instructions);
+  }
+
+  fprintf(file, "\n%6s %-14s %14s %14s\n", "addr", "register", "reads", "writes");
+  for(size_t i = 0; i < registers.size(); ++i)
+  {
+    const RomProfileRegister& reg = registers[i];
+    fprintf(file, " $%04X %-14s %14llu %14llu\n", reg.address,
+            registerName(reg).c_str(), (unsigned long long)reg.reads,
+            (unsigned long long)reg.writes);
+  }
+
+  return fclose(file) == 0;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+bool RomProfiler::writeDump(const std::string& filename) const
+{
+  std::vector<RomProfileInstruction> instructions;
+  std::vector<RomProfileRegister> registers;
+  collect(instructions, registers);
+
+  FILE* file = fopen(filename.c_str(), "wb");
+  if(file == NULL)
+    return false;
+
+  RomProfileHeader header;
+  header.magic = ROM_PROFILE_MAGIC;
+  header.version = ROM_PROFILE_VERSION;
+  header.num_instructions = instructions.size();
+  header.num_registers = registers.size();
+
+  bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+  if(!instructions.empty())
+    ok = ok && fwrite(&instructions[0], sizeof(RomProfileInstruction),
+                      instructions.size(), file) == instructions.size();
+  if(!registers.empty())
+    ok = ok && fwrite(&registers[0], sizeof(RomProfileRegister),
+                      registers.size(), file) == registers.size();
+  return (fclose(file) == 0) && ok;
+}
+
+#endif // __USE_ROM_PROFILER
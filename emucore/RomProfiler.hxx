@@ -0,0 +1,150 @@
+//============================================================================
+//
+//   SSSS    tt          lll  lll
+//  SS  SS   tt           ll   ll
+//  SS     tttttt  eeee   ll   ll   aaaa
+//   SSSS    tt   ee  ee  ll   ll      aa
+//      SS   tt   eeeeee  ll   ll   aaaaa  --  "An Atari 2600 VCS Emulator"
+//  SS  SS   tt   ee      ll   ll  aa  aa
+//   SSSS     ttt  eeeee llll llll  aaaaa
+//
+// Copyright (c) 1995-2007 by Bradford W. Mott and the Stella team
+//
+// See the file "license" for information on usage and redistribution of
+// this file, and for a DISCLAIMER OF ALL WARRANTIES.
+//============================================================================
+
+#ifndef ROM_PROFILER_HXX
+#define ROM_PROFILER_HXX
+
+#ifdef __USE_ROM_PROFILER
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "m6502/src/bspf/src/bspf.hxx"
+
+namespace ale {
+
+class Cartridge;
+
+// Raw profile dump: a RomProfileHeader, num_instructions
+// RomProfileInstruction and num_registers RomProfileRegister, in native
+// byte order
+static const uInt32 ROM_PROFILE_MAGIC = 0x46525058; // "XPRF"
+static const uInt32 ROM_PROFILE_VERSION = 1;
+
+// Bank of instructions executed from RAM rather than the cartridge
+static const uInt16 ROM_PROFILE_RAM_BANK = 0xFFFF;
+
+struct RomProfileHeader {
+  uInt32 magic;
+  uInt32 version;
+  uInt32 num_instructions;
+  uInt32 num_registers;
+};
+
+struct RomProfileInstruction {
+  uInt16 bank;
+  uInt16 pc;                  // 13-bit address
+  uInt8 opcode;
+  uInt8 padding[3];
+  ::uint64_t instructions;
+  ::uint64_t cycles;          // System cycles, WSYNC stalls included
+};
+
+struct RomProfileRegister {
+  uInt16 address;             // Folded onto the register's first mirror
+  uInt16 padding[3];
+  ::uint64_t reads;
+  ::uint64_t writes;
+};
+
+/**
+  Counts the instructions and cycles executed at each (bank, PC) and the
+  accesses to each TIA and RIOT register, to show which parts of a game
+  kernel the emulation time goes to.
+
+  It only exists in builds configured with XITARI_ROM_PROFILER, which
+  defines __USE_ROM_PROFILER; the Console then creates one when the
+  rom_profile setting is given, and the 6502 cores and the System feed it.
+*/
+class RomProfiler
+{
+  public:
+    struct Counters
+    {
+      ::uint64_t instructions;
+      ::uint64_t cycles;
+      uInt8 opcode;
+
+      void add(uInt8 op, uInt32 numCycles)
+      {
+        opcode = op;
+        instructions++;
+        cycles += numCycles;
+      }
+    };
+
+  public:
+    /**
+      Create a profiler for the given cartridge's banks
+    */
+    RomProfiler(Cartridge& cart);
+
+  public:
+    /**
+      Answer the counters of the instruction at the given address in the
+      current bank; the caller adds to them once the instruction is done
+    */
+    Counters& counters(uInt16 pc);
+
+    /**
+      Count a read/write of the given address, if it is a TIA or RIOT
+      register
+    */
+    void read(uInt16 addr);
+    void write(uInt16 addr);
+
+    /**
+      Forget everything counted so far
+    */
+    void clear();
+
+    /**
+      Write a report of the instructions, most cycles first, and of the
+      register accesses, most first
+    */
+    bool writeReport(const std::string& filename) const;
+
+    /**
+      Write the raw counts (see RomProfileHeader)
+    */
+    bool writeDump(const std::string& filename) const;
+
+  private:
+    void collect(std::vector<RomProfileInstruction>& instructions,
+                 std::vector<RomProfileRegister>& registers) const;
+
+  private:
+    Cartridge& myCart;
+
+    // 4K of counters per cartridge bank, indexed by (bank, pc & 0xFFF)
+    std::vector<Counters> myBanks;
+
+    // Counters of code running from RAM, indexed by pc & 0xFFF
+    std::vector<Counters> myRAM;
+
+    // Accesses of TIA (0x00-0x3F) and RIOT (0x280-0x29F) registers
+    ::uint64_t myTIAReads[0x40];
+    ::uint64_t myTIAWrites[0x40];
+    ::uint64_t myRIOTReads[0x20];
+    ::uint64_t myRIOTWrites[0x20];
+};
+
+} // namespace ale
+
+#endif // __USE_ROM_PROFILER
+
+#endif
@@ -273,7 +273,7 @@ void Settings::usage() {
        "\n"
        " Main arguments:\n"
        "   -help -- prints out help information\n\n"
-       "   -game_controller [internal|fifo|fifo_named"
+       "   -game_controller [internal|fifo|fifo_named|shm|server|dataset|replay"
 #ifdef __USE_RLGLUE
        "|rlglue"
 #endif
@@ -283,6 +283,11 @@ void Settings::usage() {
        "                            subclass controls the game\n"   
        "            - 'fifo':       Control occurs through FIFO pipes\n"
        "            - 'fifo_named': Control occurs through named FIFO pipes\n"
+       "            - 'shm':        Control occurs through shared memory\n"
+       "            - 'server':     Many environments are served over a socket\n"
+       "            - 'dataset':    Worker threads play the game and record\n"
+       "                            trajectory files\n"
+       "            - 'replay':     Action logs are re-emulated and checked\n"
 #ifdef __USE_RLGLUE
        "            - 'rlglue':     External control via RL-Glue\n"
 #endif
@@ -313,7 +318,8 @@ void Settings::usage() {
        "      Should be >= 2.\n"
        "    default: 4\n\n"
        "   -use_environment_distribution [true|false]  -- if true, the environment start\n" 
-       "      state is drawn from a distribution of states\n"
+       "      state is drawn from a distribution of states; not supported by the\n"
+       "      dataset controller\n"
        "    default: false\n\n"
        "   -use_starting_actions [true|false] -- if true, a game-specific sequence\n"
        "      of actions is applied after each reset\n"
@@ -326,11 +332,69 @@ void Settings::usage() {
        "    default: false\n\n"
        "   -disable_color_averaging [true|false] -- if true, disables color averaging\n" 
        "    default: false\n\n"
+       "   -disable_tia_write_combining [true|false] -- if true, the TIA catches up\n"
+       "      the frame on every register write, even those that can't change it\n"
+       "    default: false\n\n"
+       "   -disable_tia_simd [true|false] -- if true, the TIA draws every pixel with\n"
+       "      its scalar renderer instead of 16 at a time\n"
+       "    default: false\n\n"
+       "   -shadow_execution [true|false] -- if true, every environment runs a\n"
+       "      reference emulator (low CPU core, no TIA write combining, scalar TIA\n"
+       "      renderer, every frame rendered) in lockstep and reports the first\n"
+       "      frame they diverge on\n"
+       "    default: false\n\n"
+       "   -shadow_prefix [path] -- where the states of a divergence are written\n"
+       "    default: shadow\n\n"
        "\n"
        " FIFO arguments:\n"
        "   -run_length_encoding [true|false] -- if true, encodes data using run-length encoding\n"
        "    default: true\n\n"
        "\n"
+       " Shared-memory arguments:\n"
+       "   -shm_name [name] -- name of the POSIX shared-memory object to create\n"
+       "    default: /xitari\n\n"
+       "\n"
+       " Server arguments:\n"
+       "   -server_num_envs n -- number of environments to host\n"
+       "    default: 1\n\n"
+       "   -server_num_threads n -- worker threads per batch, 0 for one per core\n"
+       "    default: 0\n\n"
+       "   -server_socket [path] -- Unix domain socket to listen on\n"
+       "    default: xitari.sock\n\n"
+       "   -server_port n -- listen on this TCP port instead, if non-zero\n"
+       "    default: 0\n\n"
+       "   -server_host [address] -- address to bind the TCP port to\n"
+       "    default: 127.0.0.1\n\n"
+       "\n"
+       " Dataset arguments:\n"
+       "   -dataset_frames n -- total number of frames to generate\n"
+       "    default: 1000000\n\n"
+       "   -dataset_num_workers n -- worker threads, each with its own emulator,\n"
+       "      0 for one per core\n"
+       "    default: 0\n\n"
+       "   -dataset_policy [random_agent|single_action_agent|scripted_agent]\n"
+       "      Policy played by both players; single_action_agent takes\n"
+       "      agent_action and agent_epsilon\n"
+       "    default: random_agent\n\n"
+       "   -dataset_script [a,b,...] -- actions cycled through by scripted_agent;\n"
+       "      player B plays them half a cycle behind\n"
+       "    default: 0\n\n"
+       "   -dataset_prefix [path] -- trajectory files are <path>-<worker>-<shard>.traj\n"
+       "    default: dataset\n\n"
+       "   -dataset_shard_frames n -- frames per trajectory file\n"
+       "    default: 100000\n\n"
+       "   -dataset_screens [true|false] -- if true, records screens as well as RAM\n"
+       "    default: false\n\n"
+       "\n"
+       " Replay arguments:\n"
+       "   -replay_logs [log,log,...] -- action logs to replay\n"
+       "    default: not set\n\n"
+       "   -replay_num_workers n -- logs replayed at once, 0 for one per core\n"
+       "    default: 0\n\n"
+       "   -replay_render_every n -- writes the screen of every n-th step out to\n"
+       "      <log>.<step>.png; other steps aren't rendered. 0 for none\n"
+       "    default: 0\n\n"
+       "\n"
        " Internal Controller arguments:\n"
        "   -player_agent [random_agent|single_action_agent"
 #ifdef __USE_SDL
@@ -350,6 +414,18 @@ void Settings::usage() {
        "   -rd [A/B]\n"
        "     Right player difficulty. B (default) means easy.\n"
        "\n"
+       "   -trace_file [path]\n"
+       "     Records a timeline of every environment's steps, resets, state\n"
+       "     saves/loads and observations, by environment and by thread, to\n"
+       "     path as a Chrome trace (chrome://tracing, ui.perfetto.dev).\n"
+       "\n"
+#ifdef __USE_ROM_PROFILER
+       "   -rom_profile [prefix]\n"
+       "     Profiles the ROM, writing instructions and cycles per bank and PC\n"
+       "     and TIA/RIOT register accesses to <prefix>.txt (sorted report) and\n"
+       "     <prefix>.prof (raw dump) when it is unloaded.\n"
+       "\n"
+#endif
     ; // Closing the std::std::cerr statement
 }
 
@@ -448,6 +524,18 @@ void Settings::setString(const std::string& key, const std::string& value)
     setExternal(key, value);
 }
 
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void Settings::copyFrom(const Settings& settings)
+{
+  const SettingsArray& internal = settings.getInternalSettings();
+  for(unsigned int i = 0; i < internal.size(); ++i)
+    setInternal(internal[i].key, internal[i].value);
+
+  const SettingsArray& external = settings.getExternalSettings();
+  for(unsigned int i = 0; i < external.size(); ++i)
+    setExternal(external[i].key, external[i].value);
+}
+
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 void Settings::getSize(const std::string& key, int& x, int& y) const
 {
@@ -78,6 +78,14 @@ class Settings
     */
     void validate();
 
+    /**
+      Set every setting of the given object in this one as well, e.g. to
+      configure a second emulator like the first.
+
+      @param settings The settings to copy
+    */
+    void copyFrom(const Settings& settings);
+
     /**
       This method should be called to display usage information.
     */
@@ -32,11 +32,26 @@
 #include "m6502/src/System.hxx"
 #include "m6502/src/M6502.hxx"
 #include "common/GuiUtils.hxx"
+#include "common/step_stats.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define TIA_SSE2
+#include <emmintrin.h>
+#endif
 
 using namespace ale;
 
 #define HBLANK 68
 
+// Reads four consecutive object mask bytes.  The mask pointers follow the
+// object positions pixel by pixel, so they need not be uInt32 aligned.
+static inline uInt32 maskWord(const uInt8* mask)
+{
+  uInt32 word;
+  memcpy(&word, mask, sizeof(word));
+  return word;
+}
+
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 TIA::TIA(const Console& console, Settings& settings)
     : myConsole(console),
@@ -98,22 +113,17 @@ TIA::TIA(const Console& console, Settings& settings)
     }
   }
 
-  for(i = 0; i < 640; ++i)
-    ourDisabledMaskTable[i] = 0;
-
-  // Compute all of the mask tables
-  computeBallMaskTable();
-  computeCollisionTable();
-  computeMissleMaskTable();
-  computePlayerMaskTable();
-  computePlayerPositionResetWhenTable();
-  computePlayerReflectTable();
-  computePlayfieldMaskTable();
-
   // Init stats counters
   myFrameCounter = 0;
 
   fastUpdate = settings.getBool("fast_tia_update", false);
+  myCombineWrites = !settings.getBool("disable_tia_write_combining", false);
+  myUseSIMD = !settings.getBool("disable_tia_simd", false);
+  myRenderingEnabled = true;
+#ifdef __USE_STEP_STATS
+  myRenderTicks = 0;
+  myRenderCalls = 0;
+#endif
 }
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -180,12 +190,12 @@ void TIA::reset()
   // Some default values for the "current" variables
   myCurrentGRP0 = 0;
   myCurrentGRP1 = 0;
-  myCurrentBLMask = ourBallMaskTable[0][0];
-  myCurrentM0Mask = ourMissleMaskTable[0][0][0];
-  myCurrentM1Mask = ourMissleMaskTable[0][0][0];
-  myCurrentP0Mask = ourPlayerMaskTable[0][0][0];
-  myCurrentP1Mask = ourPlayerMaskTable[0][0][0];
-  myCurrentPFMask = ourPlayfieldTable[0];
+  myCurrentBLMask = ourTables.ballMask[0];
+  myCurrentM0Mask = ourTables.missleMask[0][0];
+  myCurrentM1Mask = ourTables.missleMask[0][0];
+  myCurrentP0Mask = ourTables.playerMask[0][0];
+  myCurrentP1Mask = ourTables.playerMask[0][0];
+  myCurrentPFMask = ourTables.playfield[0];
 
   myLastHMOVEClock = 0;
   myHMOVEBlankEnabled = false;
@@ -369,12 +379,12 @@ bool TIA::save(Serializer& out)
     out.putInt(myCurrentGRP1);
 
 // pointers
-//  myCurrentBLMask = ourBallMaskTable[0][0];
-//  myCurrentM0Mask = ourMissleMaskTable[0][0][0];
-//  myCurrentM1Mask = ourMissleMaskTable[0][0][0];
-//  myCurrentP0Mask = ourPlayerMaskTable[0][0][0];
-//  myCurrentP1Mask = ourPlayerMaskTable[0][0][0];
-//  myCurrentPFMask = ourPlayfieldTable[0];
+//  myCurrentBLMask = ourTables.ballMask[0];
+//  myCurrentM0Mask = ourTables.missleMask[0][0];
+//  myCurrentM1Mask = ourTables.missleMask[0][0];
+//  myCurrentP0Mask = ourTables.playerMask[0][0];
+//  myCurrentP1Mask = ourTables.playerMask[0][0];
+//  myCurrentPFMask = ourTables.playfield[0];
 
     out.putInt(myLastHMOVEClock);
     out.putBool(myHMOVEBlankEnabled);
@@ -466,12 +476,12 @@ bool TIA::load(Deserializer& in)
     myCurrentGRP1 = (uInt8) in.getInt();
 
 // pointers
-//  myCurrentBLMask = ourBallMaskTable[0][0];
-//  myCurrentM0Mask = ourMissleMaskTable[0][0][0];
-//  myCurrentM1Mask = ourMissleMaskTable[0][0][0];
-//  myCurrentP0Mask = ourPlayerMaskTable[0][0][0];
-//  myCurrentP1Mask = ourPlayerMaskTable[0][0][0];
-//  myCurrentPFMask = ourPlayfieldTable[0];
+//  myCurrentBLMask = ourTables.ballMask[0];
+//  myCurrentM0Mask = ourTables.missleMask[0][0];
+//  myCurrentM1Mask = ourTables.missleMask[0][0];
+//  myCurrentP0Mask = ourTables.playerMask[0][0];
+//  myCurrentP1Mask = ourTables.playerMask[0][0];
+//  myCurrentPFMask = ourTables.playfield[0];
 
     myLastHMOVEClock = (Int32) in.getInt();
     myHMOVEBlankEnabled = in.getBool();
@@ -503,6 +513,17 @@ bool TIA::load(Deserializer& in)
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 void TIA::update()
+{
+  startUpdate();
+
+  // Execute instructions until frame is finished, or a breakpoint/trap hits
+  mySystem->m6502().execute(ourInstructionsPerUpdate);
+
+  finishUpdate();
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void TIA::startUpdate()
 {
   // if we've finished a frame, start a new one
   if(!myPartialFrameFlag)
@@ -512,10 +533,11 @@ void TIA::update()
   // TIA::poke() will set this flag to false, so we'll know whether the
   // frame got finished or interrupted by the debugger hitting a break/trap.
   myPartialFrameFlag = true;
+}
 
-  // Execute instructions until frame is finished, or a breakpoint/trap hits
-  mySystem->m6502().execute(25000);
-
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void TIA::finishUpdate()
+{
   // TODO: have code here that handles errors....
 
   uInt32 totalClocks = (mySystem->cycles() * 3) - myClockWhenFrameStarted;
@@ -523,7 +545,7 @@ void TIA::update()
 
   if(myPartialFrameFlag) {
     // grey out old frame contents
-    if(!myFrameGreyed) greyOutFrame();
+    if(!myFrameGreyed && myRenderingEnabled) greyOutFrame();
     myFrameGreyed = true;
   } else {
     endFrame();
@@ -628,17 +650,32 @@ void TIA::setSound(Sound& sound)
 }
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-void TIA::computeBallMaskTable()
+constexpr TIA::Tables TIA::computeTables()
+{
+  // The disabled mask table is left all zeros
+  Tables tables = { };
+
+  computeBallMaskTable(tables);
+  computeCollisionTable(tables);
+  computeMissleMaskTable(tables);
+  computePlayerMaskTable(tables);
+  computePlayerReflectTable(tables);
+  computePlayfieldMaskTable(tables);
+
+  return tables;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+constexpr void TIA::computeBallMaskTable(Tables& tables)
 {
-  // First, calculate masks for alignment 0
   for(Int32 size = 0; size < 4; ++size)
   {
-    Int32 x;
+    Int32 x = 0;
 
     // Set all of the masks to false to start with
     for(x = 0; x < 160; ++x)
     {
-      ourBallMaskTable[0][size][x] = false;
+      tables.ballMask[size][x] = false;
     }
 
     // Set the necessary fields true
@@ -646,96 +683,82 @@ void TIA::computeBallMaskTable()
     {
       if((x >= 0) && (x < (1 << size)))
       {
-        ourBallMaskTable[0][size][x % 160] = true;
+        tables.ballMask[size][x % 160] = true;
       }
     }
 
     // Copy fields into the wrap-around area of the mask
     for(x = 0; x < 160; ++x)
     {
-      ourBallMaskTable[0][size][x + 160] = ourBallMaskTable[0][size][x];
-    }
-  }
-
-  // Now, copy data for alignments of 1, 2 and 3
-  for(uInt32 align = 1; align < 4; ++align)
-  {
-    for(uInt32 size = 0; size < 4; ++size)
-    {
-      for(uInt32 x = 0; x < 320; ++x)
-      {
-        ourBallMaskTable[align][size][x] =
-            ourBallMaskTable[0][size][(x + 320 - align) % 320];
-      }
+      tables.ballMask[size][x + 160] = tables.ballMask[size][x];
     }
   }
 }
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-void TIA::computeCollisionTable()
+constexpr void TIA::computeCollisionTable(Tables& tables)
 {
   for(uInt8 i = 0; i < 64; ++i)
   {
-    ourCollisionTable[i] = 0;
+    tables.collision[i] = 0;
 
     if((i & myM0Bit) && (i & myP1Bit))    // M0-P1
-      ourCollisionTable[i] |= 0x0001;
+      tables.collision[i] |= 0x0001;
 
     if((i & myM0Bit) && (i & myP0Bit))    // M0-P0
-      ourCollisionTable[i] |= 0x0002;
+      tables.collision[i] |= 0x0002;
 
     if((i & myM1Bit) && (i & myP0Bit))    // M1-P0
-      ourCollisionTable[i] |= 0x0004;
+      tables.collision[i] |= 0x0004;
 
     if((i & myM1Bit) && (i & myP1Bit))    // M1-P1
-      ourCollisionTable[i] |= 0x0008;
+      tables.collision[i] |= 0x0008;
 
     if((i & myP0Bit) && (i & myPFBit))    // P0-PF
-      ourCollisionTable[i] |= 0x0010;
+      tables.collision[i] |= 0x0010;
 
     if((i & myP0Bit) && (i & myBLBit))    // P0-BL
-      ourCollisionTable[i] |= 0x0020;
+      tables.collision[i] |= 0x0020;
 
     if((i & myP1Bit) && (i & myPFBit))    // P1-PF
-      ourCollisionTable[i] |= 0x0040;
+      tables.collision[i] |= 0x0040;
 
     if((i & myP1Bit) && (i & myBLBit))    // P1-BL
-      ourCollisionTable[i] |= 0x0080;
+      tables.collision[i] |= 0x0080;
 
     if((i & myM0Bit) && (i & myPFBit))    // M0-PF
-      ourCollisionTable[i] |= 0x0100;
+      tables.collision[i] |= 0x0100;
 
     if((i & myM0Bit) && (i & myBLBit))    // M0-BL
-      ourCollisionTable[i] |= 0x0200;
+      tables.collision[i] |= 0x0200;
 
     if((i & myM1Bit) && (i & myPFBit))    // M1-PF
-      ourCollisionTable[i] |= 0x0400;
+      tables.collision[i] |= 0x0400;
 
     if((i & myM1Bit) && (i & myBLBit))    // M1-BL
-      ourCollisionTable[i] |= 0x0800;
+      tables.collision[i] |= 0x0800;
 
     if((i & myBLBit) && (i & myPFBit))    // BL-PF
-      ourCollisionTable[i] |= 0x1000;
+      tables.collision[i] |= 0x1000;
 
     if((i & myP0Bit) && (i & myP1Bit))    // P0-P1
-      ourCollisionTable[i] |= 0x2000;
+      tables.collision[i] |= 0x2000;
 
     if((i & myM0Bit) && (i & myM1Bit))    // M0-M1
-      ourCollisionTable[i] |= 0x4000;
+      tables.collision[i] |= 0x4000;
   }
 }
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-void TIA::computeMissleMaskTable()
+constexpr void TIA::computeMissleMaskTable(Tables& tables)
 {
-  // First, calculate masks for alignment 0
-  Int32 x, size, number;
+  Int32 x = 0, size = 0, number = 0;
 
   // Clear the missle table to start with
   for(number = 0; number < 8; ++number)
     for(size = 0; size < 4; ++size)
       for(x = 0; x < 160; ++x)
-        ourMissleMaskTable[0][number][size][x] = false;
+        tables.missleMask[number][size][x] = false;
 
   for(number = 0; number < 8; ++number)
   {
@@ -747,89 +770,72 @@ void TIA::computeMissleMaskTable()
         if((number == 0x00) || (number == 0x05) || (number == 0x07))
         {
           if((x >= 0) && (x < (1 << size)))
-            ourMissleMaskTable[0][number][size][x % 160] = true;
+            tables.missleMask[number][size][x % 160] = true;
         }
         // Two copies - close
         else if(number == 0x01)
         {
           if((x >= 0) && (x < (1 << size)))
-            ourMissleMaskTable[0][number][size][x % 160] = true;
+            tables.missleMask[number][size][x % 160] = true;
           else if(((x - 16) >= 0) && ((x - 16) < (1 << size)))
-            ourMissleMaskTable[0][number][size][x % 160] = true;
+            tables.missleMask[number][size][x % 160] = true;
         }
         // Two copies - medium
         else if(number == 0x02)
         {
           if((x >= 0) && (x < (1 << size)))
-            ourMissleMaskTable[0][number][size][x % 160] = true;
+            tables.missleMask[number][size][x % 160] = true;
           else if(((x - 32) >= 0) && ((x - 32) < (1 << size)))
-            ourMissleMaskTable[0][number][size][x % 160] = true;
+            tables.missleMask[number][size][x % 160] = true;
         }
         // Three copies - close
         else if(number == 0x03)
         {
           if((x >= 0) && (x < (1 << size)))
-            ourMissleMaskTable[0][number][size][x % 160] = true;
+            tables.missleMask[number][size][x % 160] = true;
           else if(((x - 16) >= 0) && ((x - 16) < (1 << size)))
-            ourMissleMaskTable[0][number][size][x % 160] = true;
+            tables.missleMask[number][size][x % 160] = true;
           else if(((x - 32) >= 0) && ((x - 32) < (1 << size)))
-            ourMissleMaskTable[0][number][size][x % 160] = true;
+            tables.missleMask[number][size][x % 160] = true;
         }
         // Two copies - wide
         else if(number == 0x04)
         {
           if((x >= 0) && (x < (1 << size)))
-            ourMissleMaskTable[0][number][size][x % 160] = true;
+            tables.missleMask[number][size][x % 160] = true;
           else if(((x - 64) >= 0) && ((x - 64) < (1 << size)))
-            ourMissleMaskTable[0][number][size][x % 160] = true;
+            tables.missleMask[number][size][x % 160] = true;
         }
         // Three copies - medium
         else if(number == 0x06)
         {
           if((x >= 0) && (x < (1 << size)))
-            ourMissleMaskTable[0][number][size][x % 160] = true;
+            tables.missleMask[number][size][x % 160] = true;
           else if(((x - 32) >= 0) && ((x - 32) < (1 << size)))
-            ourMissleMaskTable[0][number][size][x % 160] = true;
+            tables.missleMask[number][size][x % 160] = true;
           else if(((x - 64) >= 0) && ((x - 64) < (1 << size)))
-            ourMissleMaskTable[0][number][size][x % 160] = true;
+            tables.missleMask[number][size][x % 160] = true;
         }
       }
 
       // Copy data into wrap-around area
       for(x = 0; x < 160; ++x)
-        ourMissleMaskTable[0][number][size][x + 160] =
-          ourMissleMaskTable[0][number][size][x];
-    }
-  }
-
-  // Now, copy data for alignments of 1, 2 and 3
-  for(uInt32 align = 1; align < 4; ++align)
-  {
-    for(number = 0; number < 8; ++number)
-    {
-      for(size = 0; size < 4; ++size)
-      {
-        for(x = 0; x < 320; ++x)
-        {
-          ourMissleMaskTable[align][number][size][x] =
-            ourMissleMaskTable[0][number][size][(x + 320 - align) % 320];
-        }
-      }
+        tables.missleMask[number][size][x + 160] =
+          tables.missleMask[number][size][x];
     }
   }
 }
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-void TIA::computePlayerMaskTable()
+constexpr void TIA::computePlayerMaskTable(Tables& tables)
 {
-  // First, calculate masks for alignment 0
-  Int32 x, enable, mode;
+  Int32 x = 0, enable = 0, mode = 0;
 
   // Set the player mask table to all zeros
   for(enable = 0; enable < 2; ++enable)
     for(mode = 0; mode < 8; ++mode)
       for(x = 0; x < 160; ++x)
-        ourPlayerMaskTable[0][enable][mode][x] = 0x00;
+        tables.playerMask[enable][mode][x] = 0x00;
 
   // Now, compute the player mask table
   for(enable = 0; enable < 2; ++enable)
@@ -841,222 +847,106 @@ void TIA::computePlayerMaskTable()
         if(mode == 0x00)
         {
           if((enable == 0) && (x >= 0) && (x < 8))
-            ourPlayerMaskTable[0][enable][mode][x % 160] = 0x80 >> x;
+            tables.playerMask[enable][mode][x % 160] = 0x80 >> x;
         }
         else if(mode == 0x01)
         {
           if((enable == 0) && (x >= 0) && (x < 8))
-            ourPlayerMaskTable[0][enable][mode][x % 160] = 0x80 >> x;
+            tables.playerMask[enable][mode][x % 160] = 0x80 >> x;
           else if(((x - 16) >= 0) && ((x - 16) < 8))
-            ourPlayerMaskTable[0][enable][mode][x % 160] = 0x80 >> (x - 16);
+            tables.playerMask[enable][mode][x % 160] = 0x80 >> (x - 16);
         }
         else if(mode == 0x02)
         {
           if((enable == 0) && (x >= 0) && (x < 8))
-            ourPlayerMaskTable[0][enable][mode][x % 160] = 0x80 >> x;
+            tables.playerMask[enable][mode][x % 160] = 0x80 >> x;
           else if(((x - 32) >= 0) && ((x - 32) < 8))
-            ourPlayerMaskTable[0][enable][mode][x % 160] = 0x80 >> (x - 32);
+            tables.playerMask[enable][mode][x % 160] = 0x80 >> (x - 32);
         }
         else if(mode == 0x03)
         {
           if((enable == 0) && (x >= 0) && (x < 8))
-            ourPlayerMaskTable[0][enable][mode][x % 160] = 0x80 >> x;
+            tables.playerMask[enable][mode][x % 160] = 0x80 >> x;
           else if(((x - 16) >= 0) && ((x - 16) < 8))
-            ourPlayerMaskTable[0][enable][mode][x % 160] = 0x80 >> (x - 16);
+            tables.playerMask[enable][mode][x % 160] = 0x80 >> (x - 16);
           else if(((x - 32) >= 0) && ((x - 32) < 8))
-            ourPlayerMaskTable[0][enable][mode][x % 160] = 0x80 >> (x - 32);
+            tables.playerMask[enable][mode][x % 160] = 0x80 >> (x - 32);
         }
         else if(mode == 0x04)
         {
           if((enable == 0) && (x >= 0) && (x < 8))
-            ourPlayerMaskTable[0][enable][mode][x % 160] = 0x80 >> x;
+            tables.playerMask[enable][mode][x % 160] = 0x80 >> x;
           else if(((x - 64) >= 0) && ((x - 64) < 8))
-            ourPlayerMaskTable[0][enable][mode][x % 160] = 0x80 >> (x - 64);
+            tables.playerMask[enable][mode][x % 160] = 0x80 >> (x - 64);
         }
         else if(mode == 0x05)
         {
           // For some reason in double size mode the player's output
           // is delayed by one pixel thus we use > instead of >=
           if((enable == 0) && (x > 0) && (x <= 16))
-            ourPlayerMaskTable[0][enable][mode][x % 160] = 0x80 >> ((x - 1)/2);
+            tables.playerMask[enable][mode][x % 160] = 0x80 >> ((x - 1)/2);
         }
         else if(mode == 0x06)
         {
           if((enable == 0) && (x >= 0) && (x < 8))
-            ourPlayerMaskTable[0][enable][mode][x % 160] = 0x80 >> x;
+            tables.playerMask[enable][mode][x % 160] = 0x80 >> x;
           else if(((x - 32) >= 0) && ((x - 32) < 8))
-            ourPlayerMaskTable[0][enable][mode][x % 160] = 0x80 >> (x - 32);
+            tables.playerMask[enable][mode][x % 160] = 0x80 >> (x - 32);
           else if(((x - 64) >= 0) && ((x - 64) < 8))
-            ourPlayerMaskTable[0][enable][mode][x % 160] = 0x80 >> (x - 64);
+            tables.playerMask[enable][mode][x % 160] = 0x80 >> (x - 64);
         }
         else if(mode == 0x07)
         {
           // For some reason in quad size mode the player's output
           // is delayed by one pixel thus we use > instead of >=
           if((enable == 0) && (x > 0) && (x <= 32))
-            ourPlayerMaskTable[0][enable][mode][x % 160] = 0x80 >> ((x - 1)/4);
+            tables.playerMask[enable][mode][x % 160] = 0x80 >> ((x - 1)/4);
         }
       }
 
       // Copy data into wrap-around area
       for(x = 0; x < 160; ++x)
       {
-        ourPlayerMaskTable[0][enable][mode][x + 160] =
-            ourPlayerMaskTable[0][enable][mode][x];
-      }
-    }
-  }
-
-  // Now, copy data for alignments of 1, 2 and 3
-  for(uInt32 align = 1; align < 4; ++align)
-  {
-    for(enable = 0; enable < 2; ++enable)
-    {
-      for(mode = 0; mode < 8; ++mode)
-      {
-        for(x = 0; x < 320; ++x)
-        {
-          ourPlayerMaskTable[align][enable][mode][x] =
-              ourPlayerMaskTable[0][enable][mode][(x + 320 - align) % 320];
-        }
+        tables.playerMask[enable][mode][x + 160] =
+            tables.playerMask[enable][mode][x];
       }
     }
   }
 }
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-void TIA::computePlayerPositionResetWhenTable()
+Int8 TIA::playerPositionResetWhen(uInt32 mode, uInt32 oldx, uInt32 newx)
 {
-  uInt32 mode, oldx, newx;
-
-  // Loop through all player modes, all old player positions, and all new
-  // player positions and determine where the new position is located:
-  // 1 means the new position is within the display of an old copy of the
-  // player, -1 means the new position is within the delay portion of an
-  // old copy of the player, and 0 means it's neither of these two
-  for(mode = 0; mode < 8; ++mode)
+  // Copies of the player present in each normal sized mode, one bit per
+  // 16 pixel slot starting at the player's position
+  static const uInt8 ourCopySlots[8] = {
+    0x01, 0x03, 0x05, 0x07, 0x11, 0x01, 0x15, 0x01
+  };
+
+  // Determine where the new position is located: 1 means the new position
+  // is within the display of an old copy of the player, -1 means the new
+  // position is within the delay portion of an old copy of the player, and
+  // 0 means it's neither of these two
+  uInt32 dx = (newx + 160 - oldx) % 160;
+
+  if(mode == 0x05 || mode == 0x07)
   {
-    for(oldx = 0; oldx < 160; ++oldx)
-    {
-      // Set everything to 0 for non-delay/non-display section
-      for(newx = 0; newx < 160; ++newx)
-      {
-        ourPlayerPositionResetWhenTable[mode][oldx][newx] = 0;
-      }
-
-      // Now, we'll set the entries for non-delay/non-display section
-      for(newx = 0; newx < 160 + 72 + 5; ++newx)
-      {
-        if(mode == 0x00)
-        {
-          if((newx >= oldx) && (newx < (oldx + 4)))
-            ourPlayerPositionResetWhenTable[mode][oldx][newx % 160] = -1;
-
-          if((newx >= oldx + 4) && (newx < (oldx + 4 + 8)))
-            ourPlayerPositionResetWhenTable[mode][oldx][newx % 160] = 1;
-        }
-        else if(mode == 0x01)
-        {
-          if((newx >= oldx) && (newx < (oldx + 4)))
-            ourPlayerPositionResetWhenTable[mode][oldx][newx % 160] = -1;
-          else if((newx >= (oldx + 16)) && (newx < (oldx + 16 + 4)))
-            ourPlayerPositionResetWhenTable[mode][oldx][newx % 160] = -1;
-
-          if((newx >= oldx + 4) && (newx < (oldx + 4 + 8)))
-            ourPlayerPositionResetWhenTable[mode][oldx][newx % 160] = 1;
-          else if((newx >= oldx + 16 + 4) && (newx < (oldx + 16 + 4 + 8)))
-            ourPlayerPositionResetWhenTable[mode][oldx][newx % 160] = 1;
-        }
-        else if(mode == 0x02)
-        {
-          if((newx >= oldx) && (newx < (oldx + 4)))
-            ourPlayerPositionResetWhenTable[mode][oldx][newx % 160] = -1;
-          else if((newx >= (oldx + 32)) && (newx < (oldx + 32 + 4)))
-            ourPlayerPositionResetWhenTable[mode][oldx][newx % 160] = -1;
-
-          if((newx >= oldx + 4) && (newx < (oldx + 4 + 8)))
-            ourPlayerPositionResetWhenTable[mode][oldx][newx % 160] = 1;
-          else if((newx >= oldx + 32 + 4) && (newx < (oldx + 32 + 4 + 8)))
-            ourPlayerPositionResetWhenTable[mode][oldx][newx % 160] = 1;
-        }
-        else if(mode == 0x03)
-        {
-          if((newx >= oldx) && (newx < (oldx + 4)))
-            ourPlayerPositionResetWhenTable[mode][oldx][newx % 160] = -1;
-          else if((newx >= (oldx + 16)) && (newx < (oldx + 16 + 4)))
-            ourPlayerPositionResetWhenTable[mode][oldx][newx % 160] = -1;
-          else if((newx >= (oldx + 32)) && (newx < (oldx + 32 + 4)))
-            ourPlayerPositionResetWhenTable[mode][oldx][newx % 160] = -1;
-
-          if((newx >= oldx + 4) && (newx < (oldx + 4 + 8)))
-            ourPlayerPositionResetWhenTable[mode][oldx][newx % 160] = 1;
-          else if((newx >= oldx + 16 + 4) && (newx < (oldx + 16 + 4 + 8)))
-            ourPlayerPositionResetWhenTable[mode][oldx][newx % 160] = 1;
-          else if((newx >= oldx + 32 + 4) && (newx < (oldx + 32 + 4 + 8)))
-            ourPlayerPositionResetWhenTable[mode][oldx][newx % 160] = 1;
-        }
-        else if(mode == 0x04)
-        {
-          if((newx >= oldx) && (newx < (oldx + 4)))
-            ourPlayerPositionResetWhenTable[mode][oldx][newx % 160] = -1;
-          else if((newx >= (oldx + 64)) && (newx < (oldx + 64 + 4)))
-            ourPlayerPositionResetWhenTable[mode][oldx][newx % 160] = -1;
-
-          if((newx >= oldx + 4) && (newx < (oldx + 4 + 8)))
-            ourPlayerPositionResetWhenTable[mode][oldx][newx % 160] = 1;
-          else if((newx >= oldx + 64 + 4) && (newx < (oldx + 64 + 4 + 8)))
-            ourPlayerPositionResetWhenTable[mode][oldx][newx % 160] = 1;
-        }
-        else if(mode == 0x05)
-        {
-          if((newx >= oldx) && (newx < (oldx + 4)))
-            ourPlayerPositionResetWhenTable[mode][oldx][newx % 160] = -1;
-
-          if((newx >= oldx + 4) && (newx < (oldx + 4 + 16)))
-            ourPlayerPositionResetWhenTable[mode][oldx][newx % 160] = 1;
-        }
-        else if(mode == 0x06)
-        {
-          if((newx >= oldx) && (newx < (oldx + 4)))
-            ourPlayerPositionResetWhenTable[mode][oldx][newx % 160] = -1;
-          else if((newx >= (oldx + 32)) && (newx < (oldx + 32 + 4)))
-            ourPlayerPositionResetWhenTable[mode][oldx][newx % 160] = -1;
-          else if((newx >= (oldx + 64)) && (newx < (oldx + 64 + 4)))
-            ourPlayerPositionResetWhenTable[mode][oldx][newx % 160] = -1;
-
-          if((newx >= oldx + 4) && (newx < (oldx + 4 + 8)))
-            ourPlayerPositionResetWhenTable[mode][oldx][newx % 160] = 1;
-          else if((newx >= oldx + 32 + 4) && (newx < (oldx + 32 + 4 + 8)))
-            ourPlayerPositionResetWhenTable[mode][oldx][newx % 160] = 1;
-          else if((newx >= oldx + 64 + 4) && (newx < (oldx + 64 + 4 + 8)))
-            ourPlayerPositionResetWhenTable[mode][oldx][newx % 160] = 1;
-        }
-        else if(mode == 0x07)
-        {
-          if((newx >= oldx) && (newx < (oldx + 4)))
-            ourPlayerPositionResetWhenTable[mode][oldx][newx % 160] = -1;
-
-          if((newx >= oldx + 4) && (newx < (oldx + 4 + 32)))
-            ourPlayerPositionResetWhenTable[mode][oldx][newx % 160] = 1;
-        }
-      }
-
-      // Let's do a sanity check on our table entries
-      uInt32 s1 = 0, s2 = 0;
-      for(newx = 0; newx < 160; ++newx)
-      {
-        if(ourPlayerPositionResetWhenTable[mode][oldx][newx] == -1)
-          ++s1;
-        if(ourPlayerPositionResetWhenTable[mode][oldx][newx] == 1)
-          ++s2;
-      }
-      assert((s1 % 4 == 0) && (s2 % 8 == 0));
-    }
+    // A single double or quad sized copy
+    if(dx < 4)
+      return -1;
+    return (dx < 4 + ((mode == 0x05) ? 16 : 32)) ? 1 : 0;
   }
+
+  if(!(ourCopySlots[mode] & (1 << (dx >> 4))))
+    return 0;
+  else if((dx & 0x0F) < 4)
+    return -1;
+  else
+    return ((dx & 0x0F) < 4 + 8) ? 1 : 0;
 }
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-void TIA::computePlayerReflectTable()
+constexpr void TIA::computePlayerReflectTable(Tables& tables)
 {
   for(uInt16 i = 0; i < 256; ++i)
   {
@@ -1067,47 +957,47 @@ void TIA::computePlayerReflectTable()
       r = (r << 1) | ((i & t) ? 0x01 : 0x00);
     }
 
-    ourPlayerReflectTable[i] = r;
+    tables.playerReflect[i] = r;
   }
 }
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-void TIA::computePlayfieldMaskTable()
+constexpr void TIA::computePlayfieldMaskTable(Tables& tables)
 {
-  Int32 x;
+  Int32 x = 0;
 
   // Compute playfield mask table for non-reflected mode
   for(x = 0; x < 160; ++x)
   {
     if(x < 16)
-      ourPlayfieldTable[0][x] = 0x00001 << (x / 4);
+      tables.playfield[0][x] = 0x00001 << (x / 4);
     else if(x < 48)
-      ourPlayfieldTable[0][x] = 0x00800 >> ((x - 16) / 4);
+      tables.playfield[0][x] = 0x00800 >> ((x - 16) / 4);
     else if(x < 80)
-      ourPlayfieldTable[0][x] = 0x01000 << ((x - 48) / 4);
+      tables.playfield[0][x] = 0x01000 << ((x - 48) / 4);
     else if(x < 96)
-      ourPlayfieldTable[0][x] = 0x00001 << ((x - 80) / 4);
+      tables.playfield[0][x] = 0x00001 << ((x - 80) / 4);
     else if(x < 128)
-      ourPlayfieldTable[0][x] = 0x00800 >> ((x - 96) / 4);
+      tables.playfield[0][x] = 0x00800 >> ((x - 96) / 4);
     else if(x < 160)
-      ourPlayfieldTable[0][x] = 0x01000 << ((x - 128) / 4);
+      tables.playfield[0][x] = 0x01000 << ((x - 128) / 4);
   }
 
   // Compute playfield mask table for reflected mode
   for(x = 0; x < 160; ++x)
   {
     if(x < 16)
-      ourPlayfieldTable[1][x] = 0x00001 << (x / 4);
+      tables.playfield[1][x] = 0x00001 << (x / 4);
     else if(x < 48)
-      ourPlayfieldTable[1][x] = 0x00800 >> ((x - 16) / 4);
+      tables.playfield[1][x] = 0x00800 >> ((x - 16) / 4);
     else if(x < 80)
-      ourPlayfieldTable[1][x] = 0x01000 << ((x - 48) / 4);
+      tables.playfield[1][x] = 0x01000 << ((x - 48) / 4);
     else if(x < 112)
-      ourPlayfieldTable[1][x] = 0x80000 >> ((x - 80) / 4);
+      tables.playfield[1][x] = 0x80000 >> ((x - 80) / 4);
     else if(x < 144)
-      ourPlayfieldTable[1][x] = 0x00010 << ((x - 112) / 4);
+      tables.playfield[1][x] = 0x00010 << ((x - 112) / 4);
     else if(x < 160)
-      ourPlayfieldTable[1][x] = 0x00008 >> ((x - 144) / 4);
+      tables.playfield[1][x] = 0x00008 >> ((x - 144) / 4);
   }
 }
 
@@ -1141,7 +1031,7 @@ void TIA::updateFrameScanline(uInt32 clocksToUpdate, uInt32 hpos)
       case myPFBit:
       case myPFBit | PriorityBit:
       {
-        uInt32* mask = &myCurrentPFMask[hpos];
+        const uInt32* mask = &myCurrentPFMask[hpos];
 
         // Update a uInt8 at a time until reaching a uInt32 boundary
         for (; ((uintptr_t)myFramePointer & 0x03) && (myFramePointer < ending);
@@ -1162,7 +1052,7 @@ void TIA::updateFrameScanline(uInt32 clocksToUpdate, uInt32 hpos)
       case myPFBit | ScoreBit:
       case myPFBit | ScoreBit | PriorityBit:
       {
-        uInt32* mask = &myCurrentPFMask[hpos];
+        const uInt32* mask = &myCurrentPFMask[hpos];
 
         // Update a uInt8 at a time until reaching a uInt32 boundary
         for(; ((uintptr_t)myFramePointer & 0x03) && (myFramePointer < ending);
@@ -1188,11 +1078,11 @@ void TIA::updateFrameScanline(uInt32 clocksToUpdate, uInt32 hpos)
       case myP0Bit | PriorityBit:
       case myP0Bit | ScoreBit | PriorityBit:
       {
-        uInt8* mP0 = &myCurrentP0Mask[hpos];
+        const uInt8* mP0 = &myCurrentP0Mask[hpos];
 
         while(myFramePointer < ending)
         {
-          if(!((uintptr_t)myFramePointer & 0x03) && !*(uInt32*)mP0)
+          if(!((uintptr_t)myFramePointer & 0x03) && !maskWord(mP0))
           {
             *(uInt32*)myFramePointer = myCOLUBK;
             mP0 += 4; myFramePointer += 4;
@@ -1212,11 +1102,11 @@ void TIA::updateFrameScanline(uInt32 clocksToUpdate, uInt32 hpos)
       case myP1Bit | PriorityBit:
       case myP1Bit | ScoreBit | PriorityBit:
       {
-        uInt8* mP1 = &myCurrentP1Mask[hpos];
+        const uInt8* mP1 = &myCurrentP1Mask[hpos];
 
         while(myFramePointer < ending)
         {
-          if(!((uintptr_t)myFramePointer & 0x03) && !*(uInt32*)mP1)
+          if(!((uintptr_t)myFramePointer & 0x03) && !maskWord(mP1))
           {
             *(uInt32*)myFramePointer = myCOLUBK;
             mP1 += 4; myFramePointer += 4;
@@ -1236,13 +1126,13 @@ void TIA::updateFrameScanline(uInt32 clocksToUpdate, uInt32 hpos)
       case myP0Bit | myP1Bit | PriorityBit:
       case myP0Bit | myP1Bit | ScoreBit | PriorityBit:
       {
-        uInt8* mP0 = &myCurrentP0Mask[hpos];
-        uInt8* mP1 = &myCurrentP1Mask[hpos];
+        const uInt8* mP0 = &myCurrentP0Mask[hpos];
+        const uInt8* mP1 = &myCurrentP1Mask[hpos];
 
         while(myFramePointer < ending)
         {
-          if(!((uintptr_t)myFramePointer & 0x03) && !*(uInt32*)mP0 &&
-              !*(uInt32*)mP1)
+          if(!((uintptr_t)myFramePointer & 0x03) && !maskWord(mP0) &&
+              !maskWord(mP1))
           {
             *(uInt32*)myFramePointer = myCOLUBK;
             mP0 += 4; mP1 += 4; myFramePointer += 4;
@@ -1253,7 +1143,7 @@ void TIA::updateFrameScanline(uInt32 clocksToUpdate, uInt32 hpos)
                 myCOLUP0 : ((myCurrentGRP1 & *mP1) ? myCOLUP1 : myCOLUBK);
 
             if((myCurrentGRP0 & *mP0) && (myCurrentGRP1 & *mP1))
-              myCollision |= ourCollisionTable[myP0Bit | myP1Bit];
+              myCollision |= ourTables.collision[myP0Bit | myP1Bit];
 
             ++mP0; ++mP1; ++myFramePointer;
           }
@@ -1267,11 +1157,11 @@ void TIA::updateFrameScanline(uInt32 clocksToUpdate, uInt32 hpos)
       case myM0Bit | PriorityBit:
       case myM0Bit | ScoreBit | PriorityBit:
       {
-        uInt8* mM0 = &myCurrentM0Mask[hpos];
+        const uInt8* mM0 = &myCurrentM0Mask[hpos];
 
         while(myFramePointer < ending)
         {
-          if(!((uintptr_t)myFramePointer & 0x03) && !*(uInt32*)mM0)
+          if(!((uintptr_t)myFramePointer & 0x03) && !maskWord(mM0))
           {
             *(uInt32*)myFramePointer = myCOLUBK;
             mM0 += 4; myFramePointer += 4;
@@ -1291,11 +1181,11 @@ void TIA::updateFrameScanline(uInt32 clocksToUpdate, uInt32 hpos)
       case myM1Bit | PriorityBit:
       case myM1Bit | ScoreBit | PriorityBit:
       {
-        uInt8* mM1 = &myCurrentM1Mask[hpos];
+        const uInt8* mM1 = &myCurrentM1Mask[hpos];
 
         while(myFramePointer < ending)
         {
-          if(!((uintptr_t)myFramePointer & 0x03) && !*(uInt32*)mM1)
+          if(!((uintptr_t)myFramePointer & 0x03) && !maskWord(mM1))
           {
             *(uInt32*)myFramePointer = myCOLUBK;
             mM1 += 4; myFramePointer += 4;
@@ -1315,11 +1205,11 @@ void TIA::updateFrameScanline(uInt32 clocksToUpdate, uInt32 hpos)
       case myBLBit | PriorityBit:
       case myBLBit | ScoreBit | PriorityBit:
       {
-        uInt8* mBL = &myCurrentBLMask[hpos];
+        const uInt8* mBL = &myCurrentBLMask[hpos];
 
         while(myFramePointer < ending)
         {
-          if(!((uintptr_t)myFramePointer & 0x03) && !*(uInt32*)mBL)
+          if(!((uintptr_t)myFramePointer & 0x03) && !maskWord(mBL))
           {
             *(uInt32*)myFramePointer = myCOLUBK;
             mBL += 4; myFramePointer += 4;
@@ -1339,12 +1229,12 @@ void TIA::updateFrameScanline(uInt32 clocksToUpdate, uInt32 hpos)
       case myM0Bit | myM1Bit | PriorityBit:
       case myM0Bit | myM1Bit | ScoreBit | PriorityBit:
       {
-        uInt8* mM0 = &myCurrentM0Mask[hpos];
-        uInt8* mM1 = &myCurrentM1Mask[hpos];
+        const uInt8* mM0 = &myCurrentM0Mask[hpos];
+        const uInt8* mM1 = &myCurrentM1Mask[hpos];
 
         while(myFramePointer < ending)
         {
-          if(!((uintptr_t)myFramePointer & 0x03) && !*(uInt32*)mM0 && !*(uInt32*)mM1)
+          if(!((uintptr_t)myFramePointer & 0x03) && !maskWord(mM0) && !maskWord(mM1))
           {
             *(uInt32*)myFramePointer = myCOLUBK;
             mM0 += 4; mM1 += 4; myFramePointer += 4;
@@ -1354,7 +1244,7 @@ void TIA::updateFrameScanline(uInt32 clocksToUpdate, uInt32 hpos)
             *myFramePointer = *mM0 ? myCOLUP0 : (*mM1 ? myCOLUP1 : myCOLUBK);
 
             if(*mM0 && *mM1)
-              myCollision |= ourCollisionTable[myM0Bit | myM1Bit];
+              myCollision |= ourTables.collision[myM0Bit | myM1Bit];
 
             ++mM0; ++mM1; ++myFramePointer;
           }
@@ -1366,12 +1256,12 @@ void TIA::updateFrameScanline(uInt32 clocksToUpdate, uInt32 hpos)
       case myBLBit | myM0Bit:
       case myBLBit | myM0Bit | ScoreBit:
       {
-        uInt8* mBL = &myCurrentBLMask[hpos];
-        uInt8* mM0 = &myCurrentM0Mask[hpos];
+        const uInt8* mBL = &myCurrentBLMask[hpos];
+        const uInt8* mM0 = &myCurrentM0Mask[hpos];
 
         while(myFramePointer < ending)
         {
-          if(!((uintptr_t)myFramePointer & 0x03) && !*(uInt32*)mBL && !*(uInt32*)mM0)
+          if(!((uintptr_t)myFramePointer & 0x03) && !maskWord(mBL) && !maskWord(mM0))
           {
             *(uInt32*)myFramePointer = myCOLUBK;
             mBL += 4; mM0 += 4; myFramePointer += 4;
@@ -1381,7 +1271,7 @@ void TIA::updateFrameScanline(uInt32 clocksToUpdate, uInt32 hpos)
             *myFramePointer = (*mM0 ? myCOLUP0 : (*mBL ? myCOLUPF : myCOLUBK));
 
             if(*mBL && *mM0)
-              myCollision |= ourCollisionTable[myBLBit | myM0Bit];
+              myCollision |= ourTables.collision[myBLBit | myM0Bit];
 
             ++mBL; ++mM0; ++myFramePointer;
           }
@@ -1393,12 +1283,12 @@ void TIA::updateFrameScanline(uInt32 clocksToUpdate, uInt32 hpos)
       case myBLBit | myM0Bit | PriorityBit:
       case myBLBit | myM0Bit | ScoreBit | PriorityBit:
       {
-        uInt8* mBL = &myCurrentBLMask[hpos];
-        uInt8* mM0 = &myCurrentM0Mask[hpos];
+        const uInt8* mBL = &myCurrentBLMask[hpos];
+        const uInt8* mM0 = &myCurrentM0Mask[hpos];
 
         while(myFramePointer < ending)
         {
-          if(!((uintptr_t)myFramePointer & 0x03) && !*(uInt32*)mBL && !*(uInt32*)mM0)
+          if(!((uintptr_t)myFramePointer & 0x03) && !maskWord(mBL) && !maskWord(mM0))
           {
             *(uInt32*)myFramePointer = myCOLUBK;
             mBL += 4; mM0 += 4; myFramePointer += 4;
@@ -1408,7 +1298,7 @@ void TIA::updateFrameScanline(uInt32 clocksToUpdate, uInt32 hpos)
             *myFramePointer = (*mBL ? myCOLUPF : (*mM0 ? myCOLUP0 : myCOLUBK));
 
             if(*mBL && *mM0)
-              myCollision |= ourCollisionTable[myBLBit | myM0Bit];
+              myCollision |= ourTables.collision[myBLBit | myM0Bit];
 
             ++mBL; ++mM0; ++myFramePointer;
           }
@@ -1420,13 +1310,13 @@ void TIA::updateFrameScanline(uInt32 clocksToUpdate, uInt32 hpos)
       case myBLBit | myM1Bit:
       case myBLBit | myM1Bit | ScoreBit:
       {
-        uInt8* mBL = &myCurrentBLMask[hpos];
-        uInt8* mM1 = &myCurrentM1Mask[hpos];
+        const uInt8* mBL = &myCurrentBLMask[hpos];
+        const uInt8* mM1 = &myCurrentM1Mask[hpos];
 
         while(myFramePointer < ending)
         {
-          if(!((uintptr_t)myFramePointer & 0x03) && !*(uInt32*)mBL &&
-              !*(uInt32*)mM1)
+          if(!((uintptr_t)myFramePointer & 0x03) && !maskWord(mBL) &&
+              !maskWord(mM1))
           {
             *(uInt32*)myFramePointer = myCOLUBK;
             mBL += 4; mM1 += 4; myFramePointer += 4;
@@ -1436,7 +1326,7 @@ void TIA::updateFrameScanline(uInt32 clocksToUpdate, uInt32 hpos)
             *myFramePointer = (*mM1 ? myCOLUP1 : (*mBL ? myCOLUPF : myCOLUBK));
 
             if(*mBL && *mM1)
-              myCollision |= ourCollisionTable[myBLBit | myM1Bit];
+              myCollision |= ourTables.collision[myBLBit | myM1Bit];
 
             ++mBL; ++mM1; ++myFramePointer;
           }
@@ -1448,13 +1338,13 @@ void TIA::updateFrameScanline(uInt32 clocksToUpdate, uInt32 hpos)
       case myBLBit | myM1Bit | PriorityBit:
       case myBLBit | myM1Bit | ScoreBit | PriorityBit:
       {
-        uInt8* mBL = &myCurrentBLMask[hpos];
-        uInt8* mM1 = &myCurrentM1Mask[hpos];
+        const uInt8* mBL = &myCurrentBLMask[hpos];
+        const uInt8* mM1 = &myCurrentM1Mask[hpos];
 
         while(myFramePointer < ending)
         {
-          if(!((uintptr_t)myFramePointer & 0x03) && !*(uInt32*)mBL &&
-              !*(uInt32*)mM1)
+          if(!((uintptr_t)myFramePointer & 0x03) && !maskWord(mBL) &&
+              !maskWord(mM1))
           {
             *(uInt32*)myFramePointer = myCOLUBK;
             mBL += 4; mM1 += 4; myFramePointer += 4;
@@ -1464,7 +1354,7 @@ void TIA::updateFrameScanline(uInt32 clocksToUpdate, uInt32 hpos)
             *myFramePointer = (*mBL ? myCOLUPF : (*mM1 ? myCOLUP1 : myCOLUBK));
 
             if(*mBL && *mM1)
-              myCollision |= ourCollisionTable[myBLBit | myM1Bit];
+              myCollision |= ourTables.collision[myBLBit | myM1Bit];
 
             ++mBL; ++mM1; ++myFramePointer;
           }
@@ -1476,12 +1366,12 @@ void TIA::updateFrameScanline(uInt32 clocksToUpdate, uInt32 hpos)
       case myBLBit | myP1Bit:
       case myBLBit | myP1Bit | ScoreBit:
       {
-        uInt8* mBL = &myCurrentBLMask[hpos];
-        uInt8* mP1 = &myCurrentP1Mask[hpos];
+        const uInt8* mBL = &myCurrentBLMask[hpos];
+        const uInt8* mP1 = &myCurrentP1Mask[hpos];
 
         while(myFramePointer < ending)
         {
-          if(!((uintptr_t)myFramePointer & 0x03) && !*(uInt32*)mP1 && !*(uInt32*)mBL)
+          if(!((uintptr_t)myFramePointer & 0x03) && !maskWord(mP1) && !maskWord(mBL))
           {
             *(uInt32*)myFramePointer = myCOLUBK;
             mBL += 4; mP1 += 4; myFramePointer += 4;
@@ -1492,7 +1382,7 @@ void TIA::updateFrameScanline(uInt32 clocksToUpdate, uInt32 hpos)
                 (*mBL ? myCOLUPF : myCOLUBK);
 
             if(*mBL && (myCurrentGRP1 & *mP1))
-              myCollision |= ourCollisionTable[myBLBit | myP1Bit];
+              myCollision |= ourTables.collision[myBLBit | myP1Bit];
 
             ++mBL; ++mP1; ++myFramePointer;
           }
@@ -1504,12 +1394,12 @@ void TIA::updateFrameScanline(uInt32 clocksToUpdate, uInt32 hpos)
       case myBLBit | myP1Bit | PriorityBit:
       case myBLBit | myP1Bit | PriorityBit | ScoreBit:
       {
-        uInt8* mBL = &myCurrentBLMask[hpos];
-        uInt8* mP1 = &myCurrentP1Mask[hpos];
+        const uInt8* mBL = &myCurrentBLMask[hpos];
+        const uInt8* mP1 = &myCurrentP1Mask[hpos];
 
         while(myFramePointer < ending)
         {
-          if(!((uintptr_t)myFramePointer & 0x03) && !*(uInt32*)mP1 && !*(uInt32*)mBL)
+          if(!((uintptr_t)myFramePointer & 0x03) && !maskWord(mP1) && !maskWord(mBL))
           {
             *(uInt32*)myFramePointer = myCOLUBK;
             mBL += 4; mP1 += 4; myFramePointer += 4;
@@ -1520,7 +1410,7 @@ void TIA::updateFrameScanline(uInt32 clocksToUpdate, uInt32 hpos)
                 ((myCurrentGRP1 & *mP1) ? myCOLUP1 : myCOLUBK);
 
             if(*mBL && (myCurrentGRP1 & *mP1))
-              myCollision |= ourCollisionTable[myBLBit | myP1Bit];
+              myCollision |= ourTables.collision[myBLBit | myP1Bit];
 
             ++mBL; ++mP1; ++myFramePointer;
           }
@@ -1531,12 +1421,12 @@ void TIA::updateFrameScanline(uInt32 clocksToUpdate, uInt32 hpos)
       // Playfield and Player 0 are enabled and playfield priority is not set
       case myPFBit | myP0Bit:
       {
-        uInt32* mPF = &myCurrentPFMask[hpos];
-        uInt8* mP0 = &myCurrentP0Mask[hpos];
+        const uInt32* mPF = &myCurrentPFMask[hpos];
+        const uInt8* mP0 = &myCurrentP0Mask[hpos];
 
         while(myFramePointer < ending)
         {
-          if(!((uintptr_t)myFramePointer & 0x03) && !*(uInt32*)mP0)
+          if(!((uintptr_t)myFramePointer & 0x03) && !maskWord(mP0))
           {
             *(uInt32*)myFramePointer = (myPF & *mPF) ? myCOLUPF : myCOLUBK;
             mPF += 4; mP0 += 4; myFramePointer += 4;
@@ -1547,7 +1437,7 @@ void TIA::updateFrameScanline(uInt32 clocksToUpdate, uInt32 hpos)
                   myCOLUP0 : ((myPF & *mPF) ? myCOLUPF : myCOLUBK);
 
             if((myPF & *mPF) && (myCurrentGRP0 & *mP0))
-              myCollision |= ourCollisionTable[myPFBit | myP0Bit];
+              myCollision |= ourTables.collision[myPFBit | myP0Bit];
 
             ++mPF; ++mP0; ++myFramePointer;
           }
@@ -1559,12 +1449,12 @@ void TIA::updateFrameScanline(uInt32 clocksToUpdate, uInt32 hpos)
       // Playfield and Player 0 are enabled and playfield priority is set
       case myPFBit | myP0Bit | PriorityBit:
       {
-        uInt32* mPF = &myCurrentPFMask[hpos];
-        uInt8* mP0 = &myCurrentP0Mask[hpos];
+        const uInt32* mPF = &myCurrentPFMask[hpos];
+        const uInt8* mP0 = &myCurrentP0Mask[hpos];
 
         while(myFramePointer < ending)
         {
-          if(!((uintptr_t)myFramePointer & 0x03) && !*(uInt32*)mP0)
+          if(!((uintptr_t)myFramePointer & 0x03) && !maskWord(mP0))
           {
             *(uInt32*)myFramePointer = (myPF & *mPF) ? myCOLUPF : myCOLUBK;
             mPF += 4; mP0 += 4; myFramePointer += 4;
@@ -1575,7 +1465,7 @@ void TIA::updateFrameScanline(uInt32 clocksToUpdate, uInt32 hpos)
                 ((myCurrentGRP0 & *mP0) ? myCOLUP0 : myCOLUBK);
 
             if((myPF & *mPF) && (myCurrentGRP0 & *mP0))
-              myCollision |= ourCollisionTable[myPFBit | myP0Bit];
+              myCollision |= ourTables.collision[myPFBit | myP0Bit];
 
             ++mPF; ++mP0; ++myFramePointer;
           }
@@ -1587,12 +1477,12 @@ void TIA::updateFrameScanline(uInt32 clocksToUpdate, uInt32 hpos)
       // Playfield and Player 1 are enabled and playfield priority is not set
       case myPFBit | myP1Bit:
       {
-        uInt32* mPF = &myCurrentPFMask[hpos];
-        uInt8* mP1 = &myCurrentP1Mask[hpos];
+        const uInt32* mPF = &myCurrentPFMask[hpos];
+        const uInt8* mP1 = &myCurrentP1Mask[hpos];
 
         while(myFramePointer < ending)
         {
-          if(!((uintptr_t)myFramePointer & 0x03) && !*(uInt32*)mP1)
+          if(!((uintptr_t)myFramePointer & 0x03) && !maskWord(mP1))
           {
             *(uInt32*)myFramePointer = (myPF & *mPF) ? myCOLUPF : myCOLUBK;
             mPF += 4; mP1 += 4; myFramePointer += 4;
@@ -1603,7 +1493,7 @@ void TIA::updateFrameScanline(uInt32 clocksToUpdate, uInt32 hpos)
                   myCOLUP1 : ((myPF & *mPF) ? myCOLUPF : myCOLUBK);
 
             if((myPF & *mPF) && (myCurrentGRP1 & *mP1))
-              myCollision |= ourCollisionTable[myPFBit | myP1Bit];
+              myCollision |= ourTables.collision[myPFBit | myP1Bit];
 
             ++mPF; ++mP1; ++myFramePointer;
           }
@@ -1615,12 +1505,12 @@ void TIA::updateFrameScanline(uInt32 clocksToUpdate, uInt32 hpos)
       // Playfield and Player 1 are enabled and playfield priority is set
       case myPFBit | myP1Bit | PriorityBit:
       {
-        uInt32* mPF = &myCurrentPFMask[hpos];
-        uInt8* mP1 = &myCurrentP1Mask[hpos];
+        const uInt32* mPF = &myCurrentPFMask[hpos];
+        const uInt8* mP1 = &myCurrentP1Mask[hpos];
 
         while(myFramePointer < ending)
         {
-          if(!((uintptr_t)myFramePointer & 0x03) && !*(uInt32*)mP1)
+          if(!((uintptr_t)myFramePointer & 0x03) && !maskWord(mP1))
           {
             *(uInt32*)myFramePointer = (myPF & *mPF) ? myCOLUPF : myCOLUBK;
             mPF += 4; mP1 += 4; myFramePointer += 4;
@@ -1631,7 +1521,7 @@ void TIA::updateFrameScanline(uInt32 clocksToUpdate, uInt32 hpos)
                 ((myCurrentGRP1 & *mP1) ? myCOLUP1 : myCOLUBK);
 
             if((myPF & *mPF) && (myCurrentGRP1 & *mP1))
-              myCollision |= ourCollisionTable[myPFBit | myP1Bit];
+              myCollision |= ourTables.collision[myPFBit | myP1Bit];
 
             ++mPF; ++mP1; ++myFramePointer;
           }
@@ -1644,12 +1534,12 @@ void TIA::updateFrameScanline(uInt32 clocksToUpdate, uInt32 hpos)
       case myPFBit | myBLBit:
       case myPFBit | myBLBit | PriorityBit:
       {
-        uInt32* mPF = &myCurrentPFMask[hpos];
-        uInt8* mBL = &myCurrentBLMask[hpos];
+        const uInt32* mPF = &myCurrentPFMask[hpos];
+        const uInt8* mBL = &myCurrentBLMask[hpos];
 
         while(myFramePointer < ending)
         {
-          if(!((uintptr_t)myFramePointer & 0x03) && !*(uInt32*)mBL)
+          if(!((uintptr_t)myFramePointer & 0x03) && !maskWord(mBL))
           {
             *(uInt32*)myFramePointer = (myPF & *mPF) ? myCOLUPF : myCOLUBK;
             mPF += 4; mBL += 4; myFramePointer += 4;
@@ -1659,7 +1549,7 @@ void TIA::updateFrameScanline(uInt32 clocksToUpdate, uInt32 hpos)
             *myFramePointer = ((myPF & *mPF) || *mBL) ? myCOLUPF : myCOLUBK;
 
             if((myPF & *mPF) && *mBL)
-              myCollision |= ourCollisionTable[myPFBit | myBLBit];
+              myCollision |= ourTables.collision[myPFBit | myBLBit];
 
             ++mPF; ++mBL; ++myFramePointer;
           }
@@ -1670,6 +1560,9 @@ void TIA::updateFrameScanline(uInt32 clocksToUpdate, uInt32 hpos)
       // Handle all of the other cases
       default:
       {
+        if(myUseSIMD)
+          hpos = updateFrameScanlineSIMD(ending, hpos, true);
+
         for(; myFramePointer < ending; ++myFramePointer, ++hpos)
         {
           uInt8 enabled = (myPF & myCurrentPFMask[hpos]) ? myPFBit : 0;
@@ -1689,7 +1582,7 @@ void TIA::updateFrameScanline(uInt32 clocksToUpdate, uInt32 hpos)
           if((myEnabledObjects & myM0Bit) && myCurrentM0Mask[hpos])
             enabled |= myM0Bit;
 
-          myCollision |= ourCollisionTable[enabled];
+          myCollision |= ourTables.collision[enabled];
           *myFramePointer = myColor[myPriorityEncoder[hpos < 80 ? 0 : 1]
               [enabled | myPlayfieldPriorityAndScore]];
         }
@@ -1700,6 +1593,135 @@ void TIA::updateFrameScanline(uInt32 clocksToUpdate, uInt32 hpos)
   myFramePointer = ending;
 }
 
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+uInt32 TIA::updateFrameScanlineSIMD(uInt8* ending, uInt32 hpos, bool render)
+{
+#ifdef TIA_SSE2
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i grp0 = _mm_set1_epi8((char)myCurrentGRP0);
+  const __m128i grp1 = _mm_set1_epi8((char)myCurrentGRP1);
+  const __m128i pf = _mm_set1_epi32((int)myPF);
+  const __m128i lanes = _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7,
+                                      8, 9, 10, 11, 12, 13, 14, 15);
+
+  // Disabled missles and ball read from the all-zero mask table
+  const uInt8* mBL = (myEnabledObjects & myBLBit) ?
+      myCurrentBLMask : ourTables.disabledMask;
+  const uInt8* mM0 = (myEnabledObjects & myM0Bit) ?
+      myCurrentM0Mask : ourTables.disabledMask;
+  const uInt8* mM1 = (myEnabledObjects & myM1Bit) ?
+      myCurrentM1Mask : ourTables.disabledMask;
+
+  const __m128i colubk = _mm_set1_epi8((char)myCOLUBK);
+  const __m128i colupf = _mm_set1_epi8((char)myCOLUPF);
+  const __m128i colup0 = _mm_set1_epi8((char)myCOLUP0);
+  const __m128i colup1 = _mm_set1_epi8((char)myCOLUP1);
+  const bool priority = (myPlayfieldPriorityAndScore & PriorityBit) != 0;
+  const bool score = (myPlayfieldPriorityAndScore & ScoreBit) != 0;
+
+  for(; myFramePointer + 16 <= ending; myFramePointer += 16, hpos += 16)
+  {
+    // Each of these is 0xFF for the pixels where the object is NOT present
+    const __m128i* mPF = (const __m128i*)&myCurrentPFMask[hpos];
+    __m128i noPF = _mm_packs_epi16(
+        _mm_packs_epi32(
+          _mm_cmpeq_epi32(_mm_and_si128(_mm_loadu_si128(mPF), pf), zero),
+          _mm_cmpeq_epi32(_mm_and_si128(_mm_loadu_si128(mPF + 1), pf), zero)),
+        _mm_packs_epi32(
+          _mm_cmpeq_epi32(_mm_and_si128(_mm_loadu_si128(mPF + 2), pf), zero),
+          _mm_cmpeq_epi32(_mm_and_si128(_mm_loadu_si128(mPF + 3), pf), zero)));
+    __m128i noBL = _mm_cmpeq_epi8(
+        _mm_loadu_si128((const __m128i*)&mBL[hpos]), zero);
+    __m128i noM0 = _mm_cmpeq_epi8(
+        _mm_loadu_si128((const __m128i*)&mM0[hpos]), zero);
+    __m128i noM1 = _mm_cmpeq_epi8(
+        _mm_loadu_si128((const __m128i*)&mM1[hpos]), zero);
+    __m128i noP0 = _mm_cmpeq_epi8(_mm_and_si128(
+        _mm_loadu_si128((const __m128i*)&myCurrentP0Mask[hpos]), grp0), zero);
+    __m128i noP1 = _mm_cmpeq_epi8(_mm_and_si128(
+        _mm_loadu_si128((const __m128i*)&myCurrentP1Mask[hpos]), grp1), zero);
+
+    // Assemble the per-pixel object bits
+    __m128i enabled = _mm_or_si128(
+        _mm_or_si128(
+          _mm_andnot_si128(noPF, _mm_set1_epi8(myPFBit)),
+          _mm_andnot_si128(noBL, _mm_set1_epi8(myBLBit))),
+        _mm_or_si128(
+          _mm_or_si128(
+            _mm_andnot_si128(noP0, _mm_set1_epi8(myP0Bit)),
+            _mm_andnot_si128(noM0, _mm_set1_epi8(myM0Bit))),
+          _mm_or_si128(
+            _mm_andnot_si128(noP1, _mm_set1_epi8(myP1Bit)),
+            _mm_andnot_si128(noM1, _mm_set1_epi8(myM1Bit)))));
+
+    // Only pixels with more than one object bit set can collide
+    __m128i multiple = _mm_and_si128(enabled,
+        _mm_sub_epi8(enabled, _mm_set1_epi8(1)));
+    if(_mm_movemask_epi8(_mm_cmpeq_epi8(multiple, zero)) != 0xFFFF)
+    {
+      uInt8 bits[16];
+      _mm_storeu_si128((__m128i*)bits, enabled);
+      for(uInt32 i = 0; i < 16; ++i)
+        myCollision |= ourTables.collision[bits[i]];
+    }
+
+    if(!render)
+      continue;
+
+    // Resolve priorities the same way myPriorityEncoder does: starting from
+    // the lowest priority, each object's color replaces the current one
+    // wherever the object is present
+    __m128i noP0M0 = _mm_and_si128(noP0, noM0);
+    __m128i noP1M1 = _mm_and_si128(noP1, noM1);
+    __m128i color = colubk;
+
+    if(priority)
+    {
+      __m128i noPFBL = _mm_and_si128(noPF, noBL);
+
+      color = _mm_or_si128(_mm_andnot_si128(noP1M1, colup1),
+                           _mm_and_si128(noP1M1, color));
+      color = _mm_or_si128(_mm_andnot_si128(noP0M0, colup0),
+                           _mm_and_si128(noP0M0, color));
+      color = _mm_or_si128(_mm_andnot_si128(noPFBL, colupf),
+                           _mm_and_si128(noPFBL, color));
+    }
+    else
+    {
+      __m128i pfColor = colupf;
+      __m128i scoreLeft = zero;
+
+      if(score)
+      {
+        // Playfield takes player 0's color left of pixel 80, player 1's after
+        __m128i x = _mm_add_epi8(_mm_set1_epi8((char)hpos), lanes);
+        __m128i left = _mm_cmpeq_epi8(_mm_min_epu8(x, _mm_set1_epi8(79)), x);
+        pfColor = _mm_or_si128(_mm_and_si128(left, colup0),
+                               _mm_andnot_si128(left, colup1));
+        scoreLeft = _mm_andnot_si128(noPF, left);
+      }
+
+      color = _mm_or_si128(_mm_andnot_si128(noBL, colupf),
+                           _mm_and_si128(noBL, color));
+      color = _mm_or_si128(_mm_andnot_si128(noPF, pfColor),
+                           _mm_and_si128(noPF, color));
+
+      // Player 1 doesn't cover a left half score playfield, which already
+      // has player 0's color
+      __m128i noP1Shown = _mm_or_si128(noP1M1, scoreLeft);
+      color = _mm_or_si128(_mm_andnot_si128(noP1Shown, colup1),
+                           _mm_and_si128(noP1Shown, color));
+      color = _mm_or_si128(_mm_andnot_si128(noP0M0, colup0),
+                           _mm_and_si128(noP0M0, color));
+    }
+
+    _mm_storeu_si128((__m128i*)myFramePointer, color);
+  }
+#endif
+
+  return hpos;
+}
+
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 void TIA::updateFrame(Int32 clock)
 {
@@ -1712,6 +1734,10 @@ void TIA::updateFrame(Int32 clock)
     return;
   }
 
+#ifdef __USE_STEP_STATS
+  uint64_t start = stepStatsTicks();
+#endif
+
   // Truncate the number of cycles to update to the stop display point
   if(clock > myClockStopDisplay)
   {
@@ -1765,7 +1791,16 @@ void TIA::updateFrame(Int32 clock)
     // Update as much of the scanline as we can
     if(clocksToUpdate != 0)
     {
-      if (fastUpdate)
+      if (!myRenderingEnabled)
+      {
+        // Collisions aren't latched during VBLANK (see updateFrameScanline)
+        if(myVBLANK & 0x02)
+          myFramePointer += clocksToUpdate;
+        else
+          updateFrameScanlineFast(clocksToUpdate,
+            clocksFromStartOfScanLine - HBLANK);
+      }
+      else if (fastUpdate)
         updateFrameScanlineFast(clocksToUpdate,
           clocksFromStartOfScanLine - HBLANK);
       else
@@ -1777,7 +1812,8 @@ void TIA::updateFrame(Int32 clock)
         (clocksFromStartOfScanLine < (HBLANK + 8)))
     {
       Int32 blanks = (HBLANK + 8) - clocksFromStartOfScanLine;
-      memset(oldFramePointer, 0, blanks);
+      if(myRenderingEnabled)
+        memset(oldFramePointer, 0, blanks);
 
       if((clocksToUpdate + clocksFromStartOfScanLine) >= (HBLANK + 8))
       {
@@ -1791,15 +1827,13 @@ void TIA::updateFrame(Int32 clock)
       myFramePointer -= (160 - myFrameWidth - myFrameXStart);
 
       // Yes, so set PF mask based on current CTRLPF reflection state
-      myCurrentPFMask = ourPlayfieldTable[myCTRLPF & 0x01];
+      myCurrentPFMask = ourTables.playfield[myCTRLPF & 0x01];
 
       // TODO: These should be reset right after the first copy of the player
       // has passed.  However, for now we'll just reset at the end of the
       // scanline since the other way would be to slow (01/21/99).
-      myCurrentP0Mask = &ourPlayerMaskTable[myPOSP0 & 0x03]
-          [0][myNUSIZ0 & 0x07][160 - (myPOSP0 & 0xFC)];
-      myCurrentP1Mask = &ourPlayerMaskTable[myPOSP1 & 0x03]
-          [0][myNUSIZ1 & 0x07][160 - (myPOSP1 & 0xFC)];
+      myCurrentP0Mask = &ourTables.playerMask[0][myNUSIZ0 & 0x07][160 - myPOSP0];
+      myCurrentP1Mask = &ourTables.playerMask[0][myNUSIZ1 & 0x07][160 - myPOSP1];
 
       // Handle the "Cosmic Ark" TIA bug if it's enabled
       if(myM0CosmicArkMotionEnabled)
@@ -1818,24 +1852,28 @@ void TIA::updateFrame(Int32 clock)
         if(myM0CosmicArkCounter == 1)
         {
           // Stretch this missle so it's at least 2 pixels wide
-          myCurrentM0Mask = &ourMissleMaskTable[myPOSM0 & 0x03]
-              [myNUSIZ0 & 0x07][((myNUSIZ0 & 0x30) >> 4) | 0x01]
-              [160 - (myPOSM0 & 0xFC)];
+          myCurrentM0Mask = &ourTables.missleMask[myNUSIZ0 & 0x07]
+              [((myNUSIZ0 & 0x30) >> 4) | 0x01][160 - myPOSM0];
         }
         else if(myM0CosmicArkCounter == 2)
         {
           // Missle is disabled on this line
-          myCurrentM0Mask = &ourDisabledMaskTable[0];
+          myCurrentM0Mask = &ourTables.disabledMask[0];
         }
         else
         {
-          myCurrentM0Mask = &ourMissleMaskTable[myPOSM0 & 0x03]
-              [myNUSIZ0 & 0x07][(myNUSIZ0 & 0x30) >> 4][160 - (myPOSM0 & 0xFC)];
+          myCurrentM0Mask = &ourTables.missleMask[myNUSIZ0 & 0x07]
+              [(myNUSIZ0 & 0x30) >> 4][160 - myPOSM0];
         }
       }
     }
   }
   while(myClockAtLastUpdate < clock);
+
+#ifdef __USE_STEP_STATS
+  myRenderTicks += stepStatsTicks() - start;
+  myRenderCalls++;
+#endif
 }
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -1862,7 +1900,6 @@ void TIA::greyOutFrame()
           tmp >>= 1;
           myCurrentFrameBuffer[ (s - myYStart) * 160 + i] = tmp;
       }
-
 }
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -1980,6 +2017,95 @@ uInt8 TIA::peek(uInt16 addr)
   }
 }
 
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+inline bool TIA::pokeAltersFrame(uInt16 addr, uInt8 value) const
+{
+  // While VBLANK is on the scanline update ignores the graphics registers
+  // (unless the fast update is latching collisions anyway), so writes to
+  // them can be deferred until VBLANK itself is written
+  const bool blanked = (myVBLANK & 0x02) && !fastUpdate;
+
+  switch(addr)
+  {
+    case 0x02:    // Wait for leading edge of HBLANK
+    case 0x03:    // Reset horizontal sync counter
+    case 0x15:    // Audio control 0
+    case 0x16:    // Audio control 1
+    case 0x17:    // Audio frequency 0
+    case 0x18:    // Audio frequency 1
+    case 0x19:    // Audio volume 0
+    case 0x1A:    // Audio volume 1
+    case 0x20:    // Horizontal Motion Player 0
+    case 0x21:    // Horizontal Motion Player 1
+    case 0x23:    // Horizontal Motion Missle 1
+    case 0x24:    // Horizontal Motion Ball
+    case 0x2b:    // Clear horizontal motion registers
+      return false;
+
+    case 0x06:    // Color-Luminance Player 0
+    case 0x07:    // Color-Luminance Player 1
+    case 0x08:    // Color-Luminance Playfield
+    case 0x09:    // Color-Luminance Background
+    {
+      if(blanked)
+        return false;
+
+      // Only a change of color matters
+      uInt32 color = (uInt32)(value & 0xfe);
+      if(myColorLossEnabled && (myScanlineCountForLastFrame & 0x01))
+      {
+        color |= 0x01;
+      }
+      color = (color << 8) | color;
+      color = (color << 16) | color;
+
+      const uInt32& current = (addr == 0x06) ? myCOLUP0 :
+          (addr == 0x07) ? myCOLUP1 : (addr == 0x08) ? myCOLUPF : myCOLUBK;
+      return color != current;
+    }
+
+    case 0x0B:    // Reflect Player 0
+      return !blanked && (((value & 0x08) != 0) != myREFP0);
+
+    case 0x0C:    // Reflect Player 1
+      return !blanked && (((value & 0x08) != 0) != myREFP1);
+
+    case 0x0D:    // Playfield register byte 0
+    case 0x0E:    // Playfield register byte 1
+    case 0x0F:    // Playfield register byte 2
+    {
+      if(blanked)
+        return false;
+
+      // Only a change of the playfield bits or of their enabled bit matters
+      uInt32 pf;
+      if(addr == 0x0D)
+        pf = (myPF & 0x000FFFF0) | ((value >> 4) & 0x0F);
+      else if(addr == 0x0E)
+        pf = (myPF & 0x000FF00F) | ((uInt32)value << 4);
+      else
+        pf = (myPF & 0x00000FFF) | ((uInt32)value << 12);
+
+      const uInt8 enabled = (pf == 0 || !myBitEnabled[TIA::PF]) ? 0 : myPFBit;
+      return (pf != myPF) || (enabled != (myEnabledObjects & myPFBit));
+    }
+
+    case 0x1B:    // Graphics Player 0
+    case 0x1C:    // Graphics Player 1
+    case 0x1D:    // Enable Missile 0 graphics
+    case 0x1E:    // Enable Missile 1 graphics
+    case 0x1F:    // Enable Ball graphics
+    case 0x25:    // Vertial Delay Player 0
+    case 0x26:    // Vertial Delay Player 1
+    case 0x27:    // Vertial Delay Ball
+      return !blanked;
+
+    default:
+      // Unused addresses never change the frame
+      return addr < 0x2d;
+  }
+}
+
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 void TIA::poke(uInt16 addr, uInt8 value)
 {
@@ -1996,8 +2122,10 @@ void TIA::poke(uInt16 addr, uInt8 value)
     delay = d[(x / 3) & 3];
   }
 
-  // Update frame to current CPU cycle before we make any changes!
-  updateFrame(clock + delay);
+  // Update frame to current CPU cycle before we make any changes!  Writes
+  // which can't change the frame are left for the next update to cover.
+  if(!myCombineWrites || pokeAltersFrame(addr, value))
+    updateFrame(clock + delay);
 
   // If a VSYNC hasn't been generated in time go ahead and end the frame
   if(((clock - myClockWhenFrameStarted) / 228) > myMaximumNumberOfScanlines)
@@ -2079,11 +2207,10 @@ void TIA::poke(uInt16 addr, uInt8 value)
       // TODO: Technically the "enable" part, [0], should depend on the current
       // enabled or disabled state.  This mean we probably need a data member
       // to maintain that state (01/21/99).
-      myCurrentP0Mask = &ourPlayerMaskTable[myPOSP0 & 0x03]
-          [0][myNUSIZ0 & 0x07][160 - (myPOSP0 & 0xFC)];
+      myCurrentP0Mask = &ourTables.playerMask[0][myNUSIZ0 & 0x07][160 - myPOSP0];
 
-      myCurrentM0Mask = &ourMissleMaskTable[myPOSM0 & 0x03]
-          [myNUSIZ0 & 0x07][(myNUSIZ0 & 0x30) >> 4][160 - (myPOSM0 & 0xFC)];
+      myCurrentM0Mask = &ourTables.missleMask[myNUSIZ0 & 0x07]
+          [(myNUSIZ0 & 0x30) >> 4][160 - myPOSM0];
 
       break;
     }
@@ -2095,11 +2222,10 @@ void TIA::poke(uInt16 addr, uInt8 value)
       // TODO: Technically the "enable" part, [0], should depend on the current
       // enabled or disabled state.  This mean we probably need a data member
       // to maintain that state (01/21/99).
-      myCurrentP1Mask = &ourPlayerMaskTable[myPOSP1 & 0x03]
-          [0][myNUSIZ1 & 0x07][160 - (myPOSP1 & 0xFC)];
+      myCurrentP1Mask = &ourTables.playerMask[0][myNUSIZ1 & 0x07][160 - myPOSP1];
 
-      myCurrentM1Mask = &ourMissleMaskTable[myPOSM1 & 0x03]
-          [myNUSIZ1 & 0x07][(myNUSIZ1 & 0x30) >> 4][160 - (myPOSM1 & 0xFC)];
+      myCurrentM1Mask = &ourTables.missleMask[myNUSIZ1 & 0x07]
+          [(myNUSIZ1 & 0x30) >> 4][160 - myPOSM1];
 
       break;
     }
@@ -2165,11 +2291,11 @@ void TIA::poke(uInt16 addr, uInt8 value)
       // we're still on the left hand side of the playfield
       if(((clock - myClockWhenFrameStarted) % 228) < (68 + 79))
       {
-        myCurrentPFMask = ourPlayfieldTable[myCTRLPF & 0x01];
+        myCurrentPFMask = ourTables.playfield[myCTRLPF & 0x01];
       }
 
-      myCurrentBLMask = &ourBallMaskTable[myPOSBL & 0x03]
-          [(myCTRLPF & 0x30) >> 4][160 - (myPOSBL & 0xFC)];
+      myCurrentBLMask = &ourTables.ballMask[(myCTRLPF & 0x30) >> 4]
+          [160 - myPOSBL];
 
       break;
     }
@@ -2180,7 +2306,7 @@ void TIA::poke(uInt16 addr, uInt8 value)
       if(((value & 0x08) && !myREFP0) || (!(value & 0x08) && myREFP0))
       {
         myREFP0 = (value & 0x08);
-        myCurrentGRP0 = ourPlayerReflectTable[myCurrentGRP0];
+        myCurrentGRP0 = ourTables.playerReflect[myCurrentGRP0];
       }
       break;
     }
@@ -2191,7 +2317,7 @@ void TIA::poke(uInt16 addr, uInt8 value)
       if(((value & 0x08) && !myREFP1) || (!(value & 0x08) && myREFP1))
       {
         myREFP1 = (value & 0x08);
-        myCurrentGRP1 = ourPlayerReflectTable[myCurrentGRP1];
+        myCurrentGRP1 = ourTables.playerReflect[myCurrentGRP1];
       }
       break;
     }
@@ -2238,7 +2364,7 @@ void TIA::poke(uInt16 addr, uInt8 value)
       const Int32 newx = hpos < HBLANK ? 3 : (((hpos - HBLANK) + 5) % 160);
 
       // Find out under what condition the player is being reset
-      const Int8 when = ourPlayerPositionResetWhenTable[myNUSIZ0 & 7][myPOSP0][newx];
+      const Int8 when = playerPositionResetWhen(myNUSIZ0 & 7, myPOSP0, newx);
 
       switch (when)
       {
@@ -2255,8 +2381,8 @@ void TIA::poke(uInt16 addr, uInt8 value)
 
           myPOSP0 = newx;
           // Setup the mask to skip the first copy of the player
-          myCurrentP0Mask = &ourPlayerMaskTable[myPOSP0 & 0x03]
-            [1][myNUSIZ0 & 0x07][160 - (myPOSP0 & 0xFC)];
+          myCurrentP0Mask = &ourTables.playerMask[1]
+            [myNUSIZ0 & 0x07][160 - myPOSP0];
           break;
 
         // Player is being reset during the delay section of one of its copies
@@ -2264,8 +2390,8 @@ void TIA::poke(uInt16 addr, uInt8 value)
 
           myPOSP0 = newx;
           // So we setup the mask to display all copies of the player
-          myCurrentP0Mask = &ourPlayerMaskTable[myPOSP0 & 0x03]
-            [0][myNUSIZ0 & 0x07][160 - (myPOSP0 & 0xFC)];
+          myCurrentP0Mask = &ourTables.playerMask[0]
+            [myNUSIZ0 & 0x07][160 - myPOSP0];
           break;
 
         default:
@@ -2281,7 +2407,7 @@ void TIA::poke(uInt16 addr, uInt8 value)
       const Int32 newx = hpos < HBLANK ? 3 : (((hpos - HBLANK) + 5) % 160);
 
       // Find out under what condition the player is being reset
-      Int8 when = ourPlayerPositionResetWhenTable[myNUSIZ1 & 7][myPOSP1][newx];
+      Int8 when = playerPositionResetWhen(myNUSIZ1 & 7, myPOSP1, newx);
 
       // Player is being reset during the display of one of its copies
       if(when == 1)
@@ -2295,8 +2421,8 @@ void TIA::poke(uInt16 addr, uInt8 value)
         myPOSP1 = newx;
 
         // Setup the mask to skip the first copy of the player
-        myCurrentP1Mask = &ourPlayerMaskTable[myPOSP1 & 0x03]
-            [1][myNUSIZ1 & 0x07][160 - (myPOSP1 & 0xFC)];
+        myCurrentP1Mask = &ourTables.playerMask[1]
+            [myNUSIZ1 & 0x07][160 - myPOSP1];
       }
       // Player is being reset in neither the delay nor display section
       else if(when == 0)
@@ -2304,8 +2430,8 @@ void TIA::poke(uInt16 addr, uInt8 value)
         myPOSP1 = newx;
 
         // So we setup the mask to skip the first copy of the player
-        myCurrentP1Mask = &ourPlayerMaskTable[myPOSP1 & 0x03]
-            [1][myNUSIZ1 & 0x07][160 - (myPOSP1 & 0xFC)];
+        myCurrentP1Mask = &ourTables.playerMask[1]
+            [myNUSIZ1 & 0x07][160 - myPOSP1];
       }
       // Player is being reset during the delay section of one of its copies
       else if(when == -1)
@@ -2313,8 +2439,8 @@ void TIA::poke(uInt16 addr, uInt8 value)
         myPOSP1 = newx;
 
         // So we setup the mask to display all copies of the player
-        myCurrentP1Mask = &ourPlayerMaskTable[myPOSP1 & 0x03]
-            [0][myNUSIZ1 & 0x07][160 - (myPOSP1 & 0xFC)];
+        myCurrentP1Mask = &ourTables.playerMask[0]
+            [myNUSIZ1 & 0x07][160 - myPOSP1];
       }
       break;
     }
@@ -2332,8 +2458,8 @@ void TIA::poke(uInt16 addr, uInt8 value)
         myPOSM0 = 8;
       }
 
-      myCurrentM0Mask = &ourMissleMaskTable[myPOSM0 & 0x03]
-          [myNUSIZ0 & 0x07][(myNUSIZ0 & 0x30) >> 4][160 - (myPOSM0 & 0xFC)];
+      myCurrentM0Mask = &ourTables.missleMask[myNUSIZ0 & 0x07]
+          [(myNUSIZ0 & 0x30) >> 4][160 - myPOSM0];
       break;
     }
 
@@ -2350,8 +2476,8 @@ void TIA::poke(uInt16 addr, uInt8 value)
         myPOSM1 = 3;
       }
 
-      myCurrentM1Mask = &ourMissleMaskTable[myPOSM1 & 0x03]
-          [myNUSIZ1 & 0x07][(myNUSIZ1 & 0x30) >> 4][160 - (myPOSM1 & 0xFC)];
+      myCurrentM1Mask = &ourTables.missleMask[myNUSIZ1 & 0x07]
+          [(myNUSIZ1 & 0x30) >> 4][160 - myPOSM1];
       break;
     }
 
@@ -2396,8 +2522,8 @@ void TIA::poke(uInt16 addr, uInt8 value)
           break;
       }
 
-      myCurrentBLMask = &ourBallMaskTable[myPOSBL & 0x03]
-          [(myCTRLPF & 0x30) >> 4][160 - (myPOSBL & 0xFC)];
+      myCurrentBLMask = &ourTables.ballMask[(myCTRLPF & 0x30) >> 4]
+          [160 - myPOSBL];
       break;
     }
 
@@ -2460,11 +2586,11 @@ void TIA::poke(uInt16 addr, uInt8 value)
 
       // Get the "current" data for GRP0 base on delay register and reflect
       uInt8 grp0 = myVDELP0 ? myDGRP0 : myGRP0;
-      myCurrentGRP0 = myREFP0 ? ourPlayerReflectTable[grp0] : grp0;
+      myCurrentGRP0 = myREFP0 ? ourTables.playerReflect[grp0] : grp0;
 
       // Get the "current" data for GRP1 base on delay register and reflect
       uInt8 grp1 = myVDELP1 ? myDGRP1 : myGRP1;
-      myCurrentGRP1 = myREFP1 ? ourPlayerReflectTable[grp1] : grp1;
+      myCurrentGRP1 = myREFP1 ? ourTables.playerReflect[grp1] : grp1;
 
       // Set enabled object bits
       if(myCurrentGRP0 != 0)
@@ -2493,11 +2619,11 @@ void TIA::poke(uInt16 addr, uInt8 value)
 
       // Get the "current" data for GRP0 base on delay register
       const uInt8 grp0 = myVDELP0 ? myDGRP0 : myGRP0;
-      myCurrentGRP0 = myREFP0 ? ourPlayerReflectTable[grp0] : grp0;
+      myCurrentGRP0 = myREFP0 ? ourTables.playerReflect[grp0] : grp0;
 
       // Get the "current" data for GRP1 base on delay register
       const uInt8 grp1 = myVDELP1 ? myDGRP1 : myGRP1;
-      myCurrentGRP1 = myREFP1 ? ourPlayerReflectTable[grp1] : grp1;
+      myCurrentGRP1 = myREFP1 ? ourTables.playerReflect[grp1] : grp1;
 
       // Set enabled object bits
       if(myCurrentGRP0 != 0)
@@ -2596,7 +2722,7 @@ void TIA::poke(uInt16 addr, uInt8 value)
       myVDELP0 = value & 0x01;
 
       const uInt8 grp0 = myVDELP0 ? myDGRP0 : myGRP0;
-      myCurrentGRP0 = myREFP0 ? ourPlayerReflectTable[grp0] : grp0;
+      myCurrentGRP0 = myREFP0 ? ourTables.playerReflect[grp0] : grp0;
 
       if(myCurrentGRP0 != 0)
         myEnabledObjects |= myP0Bit;
@@ -2610,7 +2736,7 @@ void TIA::poke(uInt16 addr, uInt8 value)
       myVDELP1 = value & 0x01;
 
       const uInt8 grp1 = myVDELP1 ? myDGRP1 : myGRP1;
-      myCurrentGRP1 = myREFP1 ? ourPlayerReflectTable[grp1] : grp1;
+      myCurrentGRP1 = myREFP1 ? ourTables.playerReflect[grp1] : grp1;
 
       if(myCurrentGRP1 != 0)
         myEnabledObjects |= myP1Bit;
@@ -2644,8 +2770,8 @@ void TIA::poke(uInt16 addr, uInt8 value)
           middle = 4;
 
         myPOSM0 = (myPOSP0 + middle) % 160;
-        myCurrentM0Mask = &ourMissleMaskTable[myPOSM0 & 0x03]
-            [myNUSIZ0 & 0x07][(myNUSIZ0 & 0x30) >> 4][160 - (myPOSM0 & 0xFC)];
+        myCurrentM0Mask = &ourTables.missleMask[myNUSIZ0 & 0x07]
+            [(myNUSIZ0 & 0x30) >> 4][160 - myPOSM0];
       }
 
       myRESMP0 = value & 0x02;
@@ -2672,8 +2798,8 @@ void TIA::poke(uInt16 addr, uInt8 value)
           middle = 4;
 
         myPOSM1 = (myPOSP1 + middle) % 160;
-        myCurrentM1Mask = &ourMissleMaskTable[myPOSM1 & 0x03]
-            [myNUSIZ1 & 0x07][(myNUSIZ1 & 0x30) >> 4][160 - (myPOSM1 & 0xFC)];
+        myCurrentM1Mask = &ourTables.missleMask[myNUSIZ1 & 0x07]
+            [(myNUSIZ1 & 0x30) >> 4][160 - myPOSM1];
       }
 
       myRESMP1 = value & 0x02;
@@ -2728,18 +2854,16 @@ void TIA::poke(uInt16 addr, uInt8 value)
       else if(myPOSBL < 0)
         myPOSBL += 160;
 
-      myCurrentBLMask = &ourBallMaskTable[myPOSBL & 0x03]
-          [(myCTRLPF & 0x30) >> 4][160 - (myPOSBL & 0xFC)];
+      myCurrentBLMask = &ourTables.ballMask[(myCTRLPF & 0x30) >> 4]
+          [160 - myPOSBL];
 
-      myCurrentP0Mask = &ourPlayerMaskTable[myPOSP0 & 0x03]
-          [0][myNUSIZ0 & 0x07][160 - (myPOSP0 & 0xFC)];
-      myCurrentP1Mask = &ourPlayerMaskTable[myPOSP1 & 0x03]
-          [0][myNUSIZ1 & 0x07][160 - (myPOSP1 & 0xFC)];
+      myCurrentP0Mask = &ourTables.playerMask[0][myNUSIZ0 & 0x07][160 - myPOSP0];
+      myCurrentP1Mask = &ourTables.playerMask[0][myNUSIZ1 & 0x07][160 - myPOSP1];
 
-      myCurrentM0Mask = &ourMissleMaskTable[myPOSM0 & 0x03]
-          [myNUSIZ0 & 0x07][(myNUSIZ0 & 0x30) >> 4][160 - (myPOSM0 & 0xFC)];
-      myCurrentM1Mask = &ourMissleMaskTable[myPOSM1 & 0x03]
-          [myNUSIZ1 & 0x07][(myNUSIZ1 & 0x30) >> 4][160 - (myPOSM1 & 0xFC)];
+      myCurrentM0Mask = &ourTables.missleMask[myNUSIZ0 & 0x07]
+          [(myNUSIZ0 & 0x30) >> 4][160 - myPOSM0];
+      myCurrentM1Mask = &ourTables.missleMask[myNUSIZ1 & 0x07]
+          [(myNUSIZ1 & 0x30) >> 4][160 - myPOSM1];
 
       // Remember what clock HMOVE occured at
       myLastHMOVEClock = clock;
@@ -2771,15 +2895,6 @@ void TIA::poke(uInt16 addr, uInt8 value)
   }
 }
 
-// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-uInt8 TIA::ourBallMaskTable[4][4][512];
-
-// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-uInt16 TIA::ourCollisionTable[64];
-
-// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-uInt8 TIA::ourDisabledMaskTable[1024];
-
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 const Int16 TIA::ourPokeDelayTable[64] = {
    0,  1,  0,  0,  8,  8,  0,  0,  0,  0,  0,  1,  1, -1, -1, -1,
@@ -2788,9 +2903,6 @@ const Int16 TIA::ourPokeDelayTable[64] = {
    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
 };
 
-// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-uInt8 TIA::ourMissleMaskTable[4][8][4][512];
-
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 const bool TIA::ourHMOVEBlankEnableCycles[128] = {
   true,  true,  true,  true,  true,  true,  true,  true,  true,  true,   // 00
@@ -2884,16 +2996,7 @@ const Int32 TIA::ourCompleteMotionTable[128][16] = {
 };
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-uInt8 TIA::ourPlayerMaskTable[4][2][8][512];
-
-// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-Int8 TIA::ourPlayerPositionResetWhenTable[8][256][256];
-
-// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-uInt8 TIA::ourPlayerReflectTable[256];
-
-// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-uInt32 TIA::ourPlayfieldTable[2][256];
+constexpr TIA::Tables TIA::ourTables = TIA::computeTables();
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 TIA::TIA(const TIA& c)
@@ -2964,13 +3067,13 @@ inline void TIA::updateFrameScanlineFast(uInt32 clocksToUpdate, uInt32 hpos)
       case myP0Bit | myP1Bit | PriorityBit:
       case myP0Bit | myP1Bit | ScoreBit | PriorityBit:
       {
-        uInt8* mP0 = &myCurrentP0Mask[hpos];
-        uInt8* mP1 = &myCurrentP1Mask[hpos];
+        const uInt8* mP0 = &myCurrentP0Mask[hpos];
+        const uInt8* mP1 = &myCurrentP1Mask[hpos];
 
         while(myFramePointer < ending)
         {
-          if(!((uintptr_t)myFramePointer & 0x03) && !*(uInt32*)mP0 &&
-              !*(uInt32*)mP1)
+          if(!((uintptr_t)myFramePointer & 0x03) && !maskWord(mP0) &&
+              !maskWord(mP1))
           {
             // @strip *(uInt32*)myFramePointer = myCOLUBK;
             mP0 += 4; mP1 += 4; myFramePointer += 4;
@@ -2982,7 +3085,7 @@ inline void TIA::updateFrameScanlineFast(uInt32 clocksToUpdate, uInt32 hpos)
             */
 
             if((myCurrentGRP0 & *mP0) && (myCurrentGRP1 & *mP1))
-              myCollision |= ourCollisionTable[myP0Bit | myP1Bit];
+              myCollision |= ourTables.collision[myP0Bit | myP1Bit];
 
             ++mP0; ++mP1; ++myFramePointer;
           }
@@ -3020,12 +3123,12 @@ inline void TIA::updateFrameScanlineFast(uInt32 clocksToUpdate, uInt32 hpos)
       case myM0Bit | myM1Bit | PriorityBit:
       case myM0Bit | myM1Bit | ScoreBit | PriorityBit:
       {
-        uInt8* mM0 = &myCurrentM0Mask[hpos];
-        uInt8* mM1 = &myCurrentM1Mask[hpos];
+        const uInt8* mM0 = &myCurrentM0Mask[hpos];
+        const uInt8* mM1 = &myCurrentM1Mask[hpos];
 
         while(myFramePointer < ending)
         {
-          if(!((uintptr_t)myFramePointer & 0x03) && !*(uInt32*)mM0 && !*(uInt32*)mM1)
+          if(!((uintptr_t)myFramePointer & 0x03) && !maskWord(mM0) && !maskWord(mM1))
           {
             // @strip *(uInt32*)myFramePointer = myCOLUBK;
             mM0 += 4; mM1 += 4; myFramePointer += 4;
@@ -3035,7 +3138,7 @@ inline void TIA::updateFrameScanlineFast(uInt32 clocksToUpdate, uInt32 hpos)
             // @strip *myFramePointer = *mM0 ? myCOLUP0 : (*mM1 ? myCOLUP1 : myCOLUBK);
 
             if(*mM0 && *mM1)
-              myCollision |= ourCollisionTable[myM0Bit | myM1Bit];
+              myCollision |= ourTables.collision[myM0Bit | myM1Bit];
 
             ++mM0; ++mM1; ++myFramePointer;
           }
@@ -3047,12 +3150,12 @@ inline void TIA::updateFrameScanlineFast(uInt32 clocksToUpdate, uInt32 hpos)
       case myBLBit | myM0Bit:
       case myBLBit | myM0Bit | ScoreBit:
       {
-        uInt8* mBL = &myCurrentBLMask[hpos];
-        uInt8* mM0 = &myCurrentM0Mask[hpos];
+        const uInt8* mBL = &myCurrentBLMask[hpos];
+        const uInt8* mM0 = &myCurrentM0Mask[hpos];
 
         while(myFramePointer < ending)
         {
-          if(!((uintptr_t)myFramePointer & 0x03) && !*(uInt32*)mBL && !*(uInt32*)mM0)
+          if(!((uintptr_t)myFramePointer & 0x03) && !maskWord(mBL) && !maskWord(mM0))
           {
             // @strip *(uInt32*)myFramePointer = myCOLUBK;
             mBL += 4; mM0 += 4; myFramePointer += 4;
@@ -3062,7 +3165,7 @@ inline void TIA::updateFrameScanlineFast(uInt32 clocksToUpdate, uInt32 hpos)
             // @strip *myFramePointer = (*mM0 ? myCOLUP0 : (*mBL ? myCOLUPF : myCOLUBK));
 
             if(*mBL && *mM0)
-              myCollision |= ourCollisionTable[myBLBit | myM0Bit];
+              myCollision |= ourTables.collision[myBLBit | myM0Bit];
 
             ++mBL; ++mM0; ++myFramePointer;
           }
@@ -3074,12 +3177,12 @@ inline void TIA::updateFrameScanlineFast(uInt32 clocksToUpdate, uInt32 hpos)
       case myBLBit | myM0Bit | PriorityBit:
       case myBLBit | myM0Bit | ScoreBit | PriorityBit:
       {
-        uInt8* mBL = &myCurrentBLMask[hpos];
-        uInt8* mM0 = &myCurrentM0Mask[hpos];
+        const uInt8* mBL = &myCurrentBLMask[hpos];
+        const uInt8* mM0 = &myCurrentM0Mask[hpos];
 
         while(myFramePointer < ending)
         {
-          if(!((uintptr_t)myFramePointer & 0x03) && !*(uInt32*)mBL && !*(uInt32*)mM0)
+          if(!((uintptr_t)myFramePointer & 0x03) && !maskWord(mBL) && !maskWord(mM0))
           {
             // @strip *(uInt32*)myFramePointer = myCOLUBK;
             mBL += 4; mM0 += 4; myFramePointer += 4;
@@ -3089,7 +3192,7 @@ inline void TIA::updateFrameScanlineFast(uInt32 clocksToUpdate, uInt32 hpos)
             // @strip *myFramePointer = (*mBL ? myCOLUPF : (*mM0 ? myCOLUP0 : myCOLUBK));
 
             if(*mBL && *mM0)
-              myCollision |= ourCollisionTable[myBLBit | myM0Bit];
+              myCollision |= ourTables.collision[myBLBit | myM0Bit];
 
             ++mBL; ++mM0; ++myFramePointer;
           }
@@ -3101,13 +3204,13 @@ inline void TIA::updateFrameScanlineFast(uInt32 clocksToUpdate, uInt32 hpos)
       case myBLBit | myM1Bit:
       case myBLBit | myM1Bit | ScoreBit:
       {
-        uInt8* mBL = &myCurrentBLMask[hpos];
-        uInt8* mM1 = &myCurrentM1Mask[hpos];
+        const uInt8* mBL = &myCurrentBLMask[hpos];
+        const uInt8* mM1 = &myCurrentM1Mask[hpos];
 
         while(myFramePointer < ending)
         {
-          if(!((uintptr_t)myFramePointer & 0x03) && !*(uInt32*)mBL &&
-              !*(uInt32*)mM1)
+          if(!((uintptr_t)myFramePointer & 0x03) && !maskWord(mBL) &&
+              !maskWord(mM1))
           {
             // @strip *(uInt32*)myFramePointer = myCOLUBK;
             mBL += 4; mM1 += 4; myFramePointer += 4;
@@ -3117,7 +3220,7 @@ inline void TIA::updateFrameScanlineFast(uInt32 clocksToUpdate, uInt32 hpos)
             // @strip *myFramePointer = (*mM1 ? myCOLUP1 : (*mBL ? myCOLUPF : myCOLUBK));
 
             if(*mBL && *mM1)
-              myCollision |= ourCollisionTable[myBLBit | myM1Bit];
+              myCollision |= ourTables.collision[myBLBit | myM1Bit];
 
             ++mBL; ++mM1; ++myFramePointer;
           }
@@ -3129,13 +3232,13 @@ inline void TIA::updateFrameScanlineFast(uInt32 clocksToUpdate, uInt32 hpos)
       case myBLBit | myM1Bit | PriorityBit:
       case myBLBit | myM1Bit | ScoreBit | PriorityBit:
       {
-        uInt8* mBL = &myCurrentBLMask[hpos];
-        uInt8* mM1 = &myCurrentM1Mask[hpos];
+        const uInt8* mBL = &myCurrentBLMask[hpos];
+        const uInt8* mM1 = &myCurrentM1Mask[hpos];
 
         while(myFramePointer < ending)
         {
-          if(!((uintptr_t)myFramePointer & 0x03) && !*(uInt32*)mBL &&
-              !*(uInt32*)mM1)
+          if(!((uintptr_t)myFramePointer & 0x03) && !maskWord(mBL) &&
+              !maskWord(mM1))
           {
             // @strip *(uInt32*)myFramePointer = myCOLUBK;
             mBL += 4; mM1 += 4; myFramePointer += 4;
@@ -3145,7 +3248,7 @@ inline void TIA::updateFrameScanlineFast(uInt32 clocksToUpdate, uInt32 hpos)
             // @strip *myFramePointer = (*mBL ? myCOLUPF : (*mM1 ? myCOLUP1 : myCOLUBK));
 
             if(*mBL && *mM1)
-              myCollision |= ourCollisionTable[myBLBit | myM1Bit];
+              myCollision |= ourTables.collision[myBLBit | myM1Bit];
 
             ++mBL; ++mM1; ++myFramePointer;
           }
@@ -3157,12 +3260,12 @@ inline void TIA::updateFrameScanlineFast(uInt32 clocksToUpdate, uInt32 hpos)
       case myBLBit | myP1Bit:
       case myBLBit | myP1Bit | ScoreBit:
       {
-        uInt8* mBL = &myCurrentBLMask[hpos];
-        uInt8* mP1 = &myCurrentP1Mask[hpos];
+        const uInt8* mBL = &myCurrentBLMask[hpos];
+        const uInt8* mP1 = &myCurrentP1Mask[hpos];
 
         while(myFramePointer < ending)
         {
-          if(!((uintptr_t)myFramePointer & 0x03) && !*(uInt32*)mP1 && !*(uInt32*)mBL)
+          if(!((uintptr_t)myFramePointer & 0x03) && !maskWord(mP1) && !maskWord(mBL))
           {
             // @strip *(uInt32*)myFramePointer = myCOLUBK;
             mBL += 4; mP1 += 4; myFramePointer += 4;
@@ -3173,7 +3276,7 @@ inline void TIA::updateFrameScanlineFast(uInt32 clocksToUpdate, uInt32 hpos)
                 (*mBL ? myCOLUPF : myCOLUBK); */
 
             if(*mBL && (myCurrentGRP1 & *mP1))
-              myCollision |= ourCollisionTable[myBLBit | myP1Bit];
+              myCollision |= ourTables.collision[myBLBit | myP1Bit];
 
             ++mBL; ++mP1; ++myFramePointer;
           }
@@ -3185,12 +3288,12 @@ inline void TIA::updateFrameScanlineFast(uInt32 clocksToUpdate, uInt32 hpos)
       case myBLBit | myP1Bit | PriorityBit:
       case myBLBit | myP1Bit | PriorityBit | ScoreBit:
       {
-        uInt8* mBL = &myCurrentBLMask[hpos];
-        uInt8* mP1 = &myCurrentP1Mask[hpos];
+        const uInt8* mBL = &myCurrentBLMask[hpos];
+        const uInt8* mP1 = &myCurrentP1Mask[hpos];
 
         while(myFramePointer < ending)
         {
-          if(!((uintptr_t)myFramePointer & 0x03) && !*(uInt32*)mP1 && !*(uInt32*)mBL)
+          if(!((uintptr_t)myFramePointer & 0x03) && !maskWord(mP1) && !maskWord(mBL))
           {
             // @strip *(uInt32*)myFramePointer = myCOLUBK;
             mBL += 4; mP1 += 4; myFramePointer += 4;
@@ -3201,7 +3304,7 @@ inline void TIA::updateFrameScanlineFast(uInt32 clocksToUpdate, uInt32 hpos)
                 ((myCurrentGRP1 & *mP1) ? myCOLUP1 : myCOLUBK); */
 
             if(*mBL && (myCurrentGRP1 & *mP1))
-              myCollision |= ourCollisionTable[myBLBit | myP1Bit];
+              myCollision |= ourTables.collision[myBLBit | myP1Bit];
 
             ++mBL; ++mP1; ++myFramePointer;
           }
@@ -3212,12 +3315,12 @@ inline void TIA::updateFrameScanlineFast(uInt32 clocksToUpdate, uInt32 hpos)
       // Playfield and Player 0 are enabled and playfield priority is not set
       case myPFBit | myP0Bit:
       {
-        uInt32* mPF = &myCurrentPFMask[hpos];
-        uInt8* mP0 = &myCurrentP0Mask[hpos];
+        const uInt32* mPF = &myCurrentPFMask[hpos];
+        const uInt8* mP0 = &myCurrentP0Mask[hpos];
 
         while(myFramePointer < ending)
         {
-          if(!((uintptr_t)myFramePointer & 0x03) && !*(uInt32*)mP0)
+          if(!((uintptr_t)myFramePointer & 0x03) && !maskWord(mP0))
           {
             // @strip *(uInt32*)myFramePointer = (myPF & *mPF) ? myCOLUPF : myCOLUBK;
             mPF += 4; mP0 += 4; myFramePointer += 4;
@@ -3228,7 +3331,7 @@ inline void TIA::updateFrameScanlineFast(uInt32 clocksToUpdate, uInt32 hpos)
                   myCOLUP0 : ((myPF & *mPF) ? myCOLUPF : myCOLUBK); */
 
             if((myPF & *mPF) && (myCurrentGRP0 & *mP0))
-              myCollision |= ourCollisionTable[myPFBit | myP0Bit];
+              myCollision |= ourTables.collision[myPFBit | myP0Bit];
 
             ++mPF; ++mP0; ++myFramePointer;
           }
@@ -3240,12 +3343,12 @@ inline void TIA::updateFrameScanlineFast(uInt32 clocksToUpdate, uInt32 hpos)
       // Playfield and Player 0 are enabled and playfield priority is set
       case myPFBit | myP0Bit | PriorityBit:
       {
-        uInt32* mPF = &myCurrentPFMask[hpos];
-        uInt8* mP0 = &myCurrentP0Mask[hpos];
+        const uInt32* mPF = &myCurrentPFMask[hpos];
+        const uInt8* mP0 = &myCurrentP0Mask[hpos];
 
         while(myFramePointer < ending)
         {
-          if(!((uintptr_t)myFramePointer & 0x03) && !*(uInt32*)mP0)
+          if(!((uintptr_t)myFramePointer & 0x03) && !maskWord(mP0))
           {
             // @strip *(uInt32*)myFramePointer = (myPF & *mPF) ? myCOLUPF : myCOLUBK;
             mPF += 4; mP0 += 4; myFramePointer += 4;
@@ -3256,7 +3359,7 @@ inline void TIA::updateFrameScanlineFast(uInt32 clocksToUpdate, uInt32 hpos)
                 ((myCurrentGRP0 & *mP0) ? myCOLUP0 : myCOLUBK); */
 
             if((myPF & *mPF) && (myCurrentGRP0 & *mP0))
-              myCollision |= ourCollisionTable[myPFBit | myP0Bit];
+              myCollision |= ourTables.collision[myPFBit | myP0Bit];
 
             ++mPF; ++mP0; ++myFramePointer;
           }
@@ -3268,12 +3371,12 @@ inline void TIA::updateFrameScanlineFast(uInt32 clocksToUpdate, uInt32 hpos)
       // Playfield and Player 1 are enabled and playfield priority is not set
       case myPFBit | myP1Bit:
       {
-        uInt32* mPF = &myCurrentPFMask[hpos];
-        uInt8* mP1 = &myCurrentP1Mask[hpos];
+        const uInt32* mPF = &myCurrentPFMask[hpos];
+        const uInt8* mP1 = &myCurrentP1Mask[hpos];
 
         while(myFramePointer < ending)
         {
-          if(!((uintptr_t)myFramePointer & 0x03) && !*(uInt32*)mP1)
+          if(!((uintptr_t)myFramePointer & 0x03) && !maskWord(mP1))
           {
             // @strip *(uInt32*)myFramePointer = (myPF & *mPF) ? myCOLUPF : myCOLUBK;
             mPF += 4; mP1 += 4; myFramePointer += 4;
@@ -3284,7 +3387,7 @@ inline void TIA::updateFrameScanlineFast(uInt32 clocksToUpdate, uInt32 hpos)
                   myCOLUP1 : ((myPF & *mPF) ? myCOLUPF : myCOLUBK); */
 
             if((myPF & *mPF) && (myCurrentGRP1 & *mP1))
-              myCollision |= ourCollisionTable[myPFBit | myP1Bit];
+              myCollision |= ourTables.collision[myPFBit | myP1Bit];
 
             ++mPF; ++mP1; ++myFramePointer;
           }
@@ -3296,12 +3399,12 @@ inline void TIA::updateFrameScanlineFast(uInt32 clocksToUpdate, uInt32 hpos)
       // Playfield and Player 1 are enabled and playfield priority is set
       case myPFBit | myP1Bit | PriorityBit:
       {
-        uInt32* mPF = &myCurrentPFMask[hpos];
-        uInt8* mP1 = &myCurrentP1Mask[hpos];
+        const uInt32* mPF = &myCurrentPFMask[hpos];
+        const uInt8* mP1 = &myCurrentP1Mask[hpos];
 
         while(myFramePointer < ending)
         {
-          if(!((uintptr_t)myFramePointer & 0x03) && !*(uInt32*)mP1)
+          if(!((uintptr_t)myFramePointer & 0x03) && !maskWord(mP1))
           {
             // @strip *(uInt32*)myFramePointer = (myPF & *mPF) ? myCOLUPF : myCOLUBK;
             mPF += 4; mP1 += 4; myFramePointer += 4;
@@ -3312,7 +3415,7 @@ inline void TIA::updateFrameScanlineFast(uInt32 clocksToUpdate, uInt32 hpos)
                 ((myCurrentGRP1 & *mP1) ? myCOLUP1 : myCOLUBK); */
 
             if((myPF & *mPF) && (myCurrentGRP1 & *mP1))
-              myCollision |= ourCollisionTable[myPFBit | myP1Bit];
+              myCollision |= ourTables.collision[myPFBit | myP1Bit];
 
             ++mPF; ++mP1; ++myFramePointer;
           }
@@ -3325,12 +3428,12 @@ inline void TIA::updateFrameScanlineFast(uInt32 clocksToUpdate, uInt32 hpos)
       case myPFBit | myBLBit:
       case myPFBit | myBLBit | PriorityBit:
       {
-        uInt32* mPF = &myCurrentPFMask[hpos];
-        uInt8* mBL = &myCurrentBLMask[hpos];
+        const uInt32* mPF = &myCurrentPFMask[hpos];
+        const uInt8* mBL = &myCurrentBLMask[hpos];
 
         while(myFramePointer < ending)
         {
-          if(!((uintptr_t)myFramePointer & 0x03) && !*(uInt32*)mBL)
+          if(!((uintptr_t)myFramePointer & 0x03) && !maskWord(mBL))
           {
             // @strip *(uInt32*)myFramePointer = (myPF & *mPF) ? myCOLUPF : myCOLUBK;
             mPF += 4; mBL += 4; myFramePointer += 4;
@@ -3340,7 +3443,7 @@ inline void TIA::updateFrameScanlineFast(uInt32 clocksToUpdate, uInt32 hpos)
             // @strip *myFramePointer = ((myPF & *mPF) || *mBL) ? myCOLUPF : myCOLUBK;
 
             if((myPF & *mPF) && *mBL)
-              myCollision |= ourCollisionTable[myPFBit | myBLBit];
+              myCollision |= ourTables.collision[myPFBit | myBLBit];
 
             ++mPF; ++mBL; ++myFramePointer;
           }
@@ -3351,6 +3454,9 @@ inline void TIA::updateFrameScanlineFast(uInt32 clocksToUpdate, uInt32 hpos)
       // Handle all of the other cases
       default:
       {
+        if(myUseSIMD)
+          hpos = updateFrameScanlineSIMD(ending, hpos, false);
+
         for(; myFramePointer < ending; ++myFramePointer, ++hpos)
         {
           uInt8 enabled = (myPF & myCurrentPFMask[hpos]) ? myPFBit : 0;
@@ -3370,7 +3476,7 @@ inline void TIA::updateFrameScanlineFast(uInt32 clocksToUpdate, uInt32 hpos)
           if((myEnabledObjects & myM0Bit) && myCurrentM0Mask[hpos])
             enabled |= myM0Bit;
 
-          myCollision |= ourCollisionTable[enabled];
+          myCollision |= ourTables.collision[enabled];
           /* @strip *myFramePointer = myColor[myPriorityEncoder[hpos < 80 ? 0 : 1]
               [enabled | myPlayfieldPriorityAndScore]]; */
         }
@@ -142,6 +142,19 @@ class TIA : public Device , public MediaSource
     */
     virtual void update();
 
+    /**
+      The parts of update(), for drivers that run the processors of
+      several systems together: update() is startUpdate(), then the
+      processor's execute(ourInstructionsPerUpdate), then finishUpdate().
+    */
+    void startUpdate();
+    void finishUpdate();
+
+    /**
+      The most instructions the processor executes in an update()
+    */
+    static const uInt32 ourInstructionsPerUpdate = 25000;
+
     /**
       Answers the current frame buffer
 
@@ -156,6 +169,13 @@ class TIA : public Device , public MediaSource
     */
     uInt8* previousFrameBuffer() const { return myPreviousFrameBuffer; }
 
+    /**
+      Enables/disables writing pixels into the frame buffer
+
+      @param mode  Whether frames should be rendered
+    */
+    void enableRendering(bool mode) { myRenderingEnabled = mode; }
+
     /**
       Answers the height of the frame buffer
 
@@ -222,31 +242,68 @@ class TIA : public Device , public MediaSource
     void enableBits(bool mode) { for(uInt8 i = 0; i < 6; ++i) myBitEnabled[i] = mode; }
 
   private:
+    // Lookup tables shared by all TIA instances.  They're computed at
+    // compile time, so they're placed in read-only data.
+    struct Tables
+    {
+      // Ball mask table (entries are true or false)
+      uInt8 ballMask[4][320];
+
+      // Used to set the collision register to the correct value
+      uInt16 collision[64];
+
+      // A mask table which can be used when an object is disabled
+      uInt8 disabledMask[320];
+
+      // Missle mask table (entries are true or false)
+      uInt8 missleMask[8][4][320];
+
+      // Player mask table
+      uInt8 playerMask[2][8][320];
+
+      // Used to reflect a players graphics
+      uInt8 playerReflect[256];
+
+      // Playfield mask table for reflected and non-reflected playfields
+      uInt32 playfield[2][256];
+    };
+
+    // Compute all of the lookup tables
+    static constexpr Tables computeTables();
+
     // Compute the ball mask table
-    void computeBallMaskTable();
+    static constexpr void computeBallMaskTable(Tables& tables);
 
     // Compute the collision decode table
-    void computeCollisionTable();
+    static constexpr void computeCollisionTable(Tables& tables);
 
     // Compute the missle mask table
-    void computeMissleMaskTable();
+    static constexpr void computeMissleMaskTable(Tables& tables);
 
     // Compute the player mask table
-    void computePlayerMaskTable();
+    static constexpr void computePlayerMaskTable(Tables& tables);
 
-    // Compute the player position reset when table
-    void computePlayerPositionResetWhenTable();
+    // Answers if a player being reset to newx is in the delay (-1) or
+    // display (1) portion of one of its copies at oldx, or neither (0)
+    static Int8 playerPositionResetWhen(uInt32 mode, uInt32 oldx, uInt32 newx);
 
     // Compute the player reflect table
-    void computePlayerReflectTable();
+    static constexpr void computePlayerReflectTable(Tables& tables);
 
     // Compute playfield mask table
-    void computePlayfieldMaskTable();
+    static constexpr void computePlayfieldMaskTable(Tables& tables);
 
   private:
     // Update the current frame buffer up to one scanline
     void updateFrameScanline(uInt32 clocksToUpdate, uInt32 hpos);
    
+    // Handle the general (several objects enabled) case of the scanline
+    // update 16 pixels at a time using SIMD instructions, as far as whole
+    // groups of 16 fit before ending.  Frame pixels are only written when
+    // render is true.  Returns the updated hpos; the caller finishes the
+    // remaining pixels (or all of them if SIMD is unavailable).
+    uInt32 updateFrameScanlineSIMD(uInt8* ending, uInt32 hpos, bool render);
+
     // Update the current frame buffer to the specified color clock
     void updateFrame(Int32 clock);
 
@@ -438,27 +495,27 @@ class TIA : public Device , public MediaSource
     // reflected if the player is being reflected.
     uInt8 myCurrentGRP1;
 
-    // It's VERY important that the BL, M0, M1, P0 and P1 current
-    // mask pointers are always on a uInt32 boundary.  Otherwise,
-    // the TIA code will fail on a good number of CPUs.
+    // The BL, M0, M1, P0 and P1 current mask pointers are not uInt32
+    // aligned, so they must only be read four bytes at a time through
+    // maskWord() (see TIA.cxx).
 
     // Pointer to the currently active mask array for the ball
-    uInt8* myCurrentBLMask;
+    const uInt8* myCurrentBLMask;
 
     // Pointer to the currently active mask array for missle 0
-    uInt8* myCurrentM0Mask;
+    const uInt8* myCurrentM0Mask;
 
     // Pointer to the currently active mask array for missle 1
-    uInt8* myCurrentM1Mask;
+    const uInt8* myCurrentM1Mask;
 
     // Pointer to the currently active mask array for player 0
-    uInt8* myCurrentP0Mask;
+    const uInt8* myCurrentP0Mask;
 
     // Pointer to the currently active mask array for player 1
-    uInt8* myCurrentP1Mask;
+    const uInt8* myCurrentP1Mask;
 
     // Pointer to the currently active mask array for the playfield
-    uInt32* myCurrentPFMask;
+    const uInt32* myCurrentPFMask;
 
   private:
     // Indicates when the dump for paddles was last set
@@ -490,21 +547,12 @@ class TIA : public Device , public MediaSource
      bool myFrameGreyed;
 
   private:
-    // Ball mask table (entries are true or false)
-    static uInt8 ourBallMaskTable[4][4][512];
-
-    // Used to set the collision register to the correct value
-    static uInt16 ourCollisionTable[64];
-
-    // A mask table which can be used when an object is disabled
-    static uInt8 ourDisabledMaskTable[1024];
+    // Mask, collision, reflect and playfield lookup tables
+    static const Tables ourTables;
 
     // Indicates the update delay associated with poking at a TIA address
     static const Int16 ourPokeDelayTable[64];
 
-    // Missle mask table (entries are true or false)
-    static uInt8 ourMissleMaskTable[4][8][4][512];
-
     // Used to convert value written in a motion register into 
     // its internal representation
     static const Int32 ourCompleteMotionTable[128][16];
@@ -512,18 +560,6 @@ class TIA : public Device , public MediaSource
     // Indicates if HMOVE blanks should occur for the corresponding cycle
     static const bool ourHMOVEBlankEnableCycles[128];
 
-    // Player mask table
-    static uInt8 ourPlayerMaskTable[4][2][8][512];
-
-    // Indicates if player is being reset during delay, display or other times
-    static Int8 ourPlayerPositionResetWhenTable[8][256][256];
-
-    // Used to reflect a players graphics
-    static uInt8 ourPlayerReflectTable[256];
-
-    // Playfield mask table for reflected and non-reflected playfields
-    static uInt32 ourPlayfieldTable[2][256];
-
   private:
     // Copy constructor isn't supported by this class so make it private
     TIA(const TIA&);
@@ -534,13 +570,40 @@ class TIA : public Device , public MediaSource
   /** ALE-specific */
   private:
     bool fastUpdate;
-   
+
+    // Whether pixels are written into the frame buffer; when false only
+    // collisions are computed (see enableRendering())
+    bool myRenderingEnabled;
+
+    // Whether register writes which can't change the frame are combined
+    // into the next frame update instead of each forcing one
+    bool myCombineWrites;
+
+    // Whether the general case of the scanline update uses the SIMD
+    // renderer; when false every pixel goes through the scalar loop
+    bool myUseSIMD;
+
+    // Answers whether the given register write could change the frame
+    // drawn (or the collisions latched) since the last frame update
+    bool pokeAltersFrame(uInt16 addr, uInt8 value) const;
+
     // Updates the frame's scanline but not the frame buffer 
     void updateFrameScanlineFast(uInt32 clocksToUpdate, uInt32 hpos);
 
     /** Some new functions for speed-up.*/
     uInt8 INPT0_3(const uInt8 &noise, const Int32 &r);
-    
+
+#ifdef __USE_STEP_STATS
+  public:
+    // Ticks spent catching the frame up with the CPU, and how many times
+    // it was done (see common/step_stats.hpp)
+    uint64_t renderTicks() const { return myRenderTicks; }
+    uint64_t renderCalls() const { return myRenderCalls; }
+
+  private:
+    uint64_t myRenderTicks;
+    uint64_t myRenderCalls;
+#endif
 };
 
 } // namespace ale
@@ -29,6 +29,7 @@ class Serializer;
 class Deserializer;
 class Debugger;
 class CpuDebug;
+class M6502Lockstep;
 class Expression;
 class PackedBitArray;
 
@@ -58,6 +59,12 @@ class M6502
     */
     friend class CpuDebug;
 
+    /**
+      The lockstep processor runs the registers of several processors
+      itself, so it needs special access too
+    */
+    friend class M6502Lockstep;
+
   public:
     /**
       Enumeration of the 6502 addressing modes
@@ -55,6 +55,10 @@ bool M6502High::execute(uInt32 number)
 {
   // Clear all of the execution status bits except for the fatal error bit
   myExecutionStatus &= FatalErrorBit;
+
+#ifdef __USE_ROM_PROFILER
+  RomProfiler* profiler = mySystem->profiler();
+#endif
   
   {
     for(; !myExecutionStatus && number != 0; --number)
@@ -66,6 +70,12 @@ bool M6502High::execute(uInt32 number)
       debugStream << "PC=" << hex << setw(4) << PC << " ";
 #endif
 
+#ifdef __USE_ROM_PROFILER
+      // Charged to the bank the instruction starts in
+      RomProfiler::Counters* profile = profiler ? &profiler->counters(PC) : 0;
+      uInt32 profileCycles = mySystem->cycles();
+#endif
+
       // Fetch instruction at the program counter
       IR = peek(PC++);
 
@@ -87,6 +97,11 @@ bool M6502High::execute(uInt32 number)
 
       myTotalInstructionCount++;
 
+#ifdef __USE_ROM_PROFILER
+      if(profile)
+        profile->add(IR, mySystem->cycles() - profileCycles);
+#endif
+
 #ifdef DEBUG
       debugStream << hex << setw(4) << operandAddress << " ";
       debugStream << setw(4) << ourInstructionMnemonicTable[IR];
@@ -0,0 +1,355 @@
+//============================================================================
+//
+// MM     MM  6666  555555  0000   2222
+// MMMM MMMM 66  66 55     00  00 22  22
+// MM MMM MM 66     55     00  00     22
+// MM  M  MM 66666  55555  00  00  22222  --  "A 6502 Microprocessor Emulator"
+// MM     MM 66  66     55 00  00 22
+// MM     MM 66  66 55  55 00  00 22
+// MM     MM  6666   5555   0000  222222
+//
+// Copyright (c) 1995-2007 by Bradford W. Mott and the Stella team
+//
+// See the file "license" for information on usage and redistribution of
+// this file, and for a DISCLAIMER OF ALL WARRANTIES.
+//
+//============================================================================
+
+#include <cassert>
+
+#include "M6502Lockstep.hxx"
+#include "M6502Low.hxx"
+
+using namespace ale;
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+M6502Lockstep::M6502Lockstep(System* const* systems, uInt32 lanes)
+    : myLanes(lanes),
+      myLane(0),
+      myGroupedInstructions(0),
+      myAloneInstructions(0)
+{
+  mySystems = new System*[lanes];
+  myCPUs = new M6502Low*[lanes];
+  for(uInt32 lane = 0; lane < lanes; ++lane)
+  {
+    assert(supports(*systems[lane]));
+    mySystems[lane] = systems[lane];
+    myCPUs[lane] = static_cast<M6502Low*>(&systems[lane]->m6502());
+  }
+
+  myA = new uInt8[lanes];
+  myX = new uInt8[lanes];
+  myY = new uInt8[lanes];
+  mySP = new uInt8[lanes];
+  myIR = new uInt8[lanes];
+  myPC = new uInt16[lanes];
+  myN = new bool[lanes];
+  myV = new bool[lanes];
+  myB = new bool[lanes];
+  myD = new bool[lanes];
+  myI = new bool[lanes];
+  myNotZ = new bool[lanes];
+  myC = new bool[lanes];
+
+  myRemaining = new uInt32[lanes];
+  myRunning = new uInt32[lanes];
+  myGroup = new uInt32[lanes];
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+M6502Lockstep::~M6502Lockstep()
+{
+  delete[] mySystems;
+  delete[] myCPUs;
+
+  delete[] myA;
+  delete[] myX;
+  delete[] myY;
+  delete[] mySP;
+  delete[] myIR;
+  delete[] myPC;
+  delete[] myN;
+  delete[] myV;
+  delete[] myB;
+  delete[] myD;
+  delete[] myI;
+  delete[] myNotZ;
+  delete[] myC;
+
+  delete[] myRemaining;
+  delete[] myRunning;
+  delete[] myGroup;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+bool M6502Lockstep::supports(System& system)
+{
+#ifdef __USE_ROM_PROFILER
+  // The profiler is fed by M6502Low's own loop
+  if(system.profiler())
+    return false;
+#endif
+
+  return dynamic_cast<M6502Low*>(&system.m6502()) != 0;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+inline uInt8 M6502Lockstep::peek(uInt16 address)
+{
+  myCPUs[myLane]->myLastAccessWasRead = true;
+  return mySystems[myLane]->peek(address);
+}
+
+inline uInt8 M6502Lockstep::peekWithPC()
+{
+  myCPUs[myLane]->myLastAccessWasRead = true;
+  return mySystems[myLane]->peek(myPC[myLane]++);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+inline void M6502Lockstep::poke(uInt16 address, uInt8 value)
+{
+  mySystems[myLane]->poke(address, value);
+  myCPUs[myLane]->myLastAccessWasRead = false;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+inline uInt8 M6502Lockstep::PS() const
+{
+  uInt8 ps = 0x20;
+
+  if(myN[myLane])
+    ps |= 0x80;
+  if(myV[myLane])
+    ps |= 0x40;
+  if(myB[myLane])
+    ps |= 0x10;
+  if(myD[myLane])
+    ps |= 0x08;
+  if(myI[myLane])
+    ps |= 0x04;
+  if(!myNotZ[myLane])
+    ps |= 0x02;
+  if(myC[myLane])
+    ps |= 0x01;
+
+  return ps;
+}
+
+inline void M6502Lockstep::PS(uInt8 ps)
+{
+  myN[myLane] = ps & 0x80;
+  myV[myLane] = ps & 0x40;
+  myB[myLane] = true;        // The 6507's B flag always true
+  myD[myLane] = ps & 0x08;
+  myI[myLane] = ps & 0x04;
+  myNotZ[myLane] = !(ps & 0x02);
+  myC[myLane] = ps & 0x01;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void M6502Lockstep::load(uInt32 lane)
+{
+  const M6502Low& cpu = *myCPUs[lane];
+
+  myA[lane] = cpu.A;
+  myX[lane] = cpu.X;
+  myY[lane] = cpu.Y;
+  mySP[lane] = cpu.SP;
+  myIR[lane] = cpu.IR;
+  myPC[lane] = cpu.PC;
+  myN[lane] = cpu.N;
+  myV[lane] = cpu.V;
+  myB[lane] = cpu.B;
+  myD[lane] = cpu.D;
+  myI[lane] = cpu.I;
+  myNotZ[lane] = cpu.notZ;
+  myC[lane] = cpu.C;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void M6502Lockstep::store(uInt32 lane)
+{
+  M6502Low& cpu = *myCPUs[lane];
+
+  cpu.A = myA[lane];
+  cpu.X = myX[lane];
+  cpu.Y = myY[lane];
+  cpu.SP = mySP[lane];
+  cpu.IR = myIR[lane];
+  cpu.PC = myPC[lane];
+  cpu.N = myN[lane];
+  cpu.V = myV[lane];
+  cpu.B = myB[lane];
+  cpu.D = myD[lane];
+  cpu.I = myI[lane];
+  cpu.notZ = myNotZ[lane];
+  cpu.C = myC[lane];
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+uInt8 M6502Lockstep::status(uInt32 lane) const
+{
+  return myCPUs[lane]->myExecutionStatus;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void M6502Lockstep::execute(const uInt32* lanes, uInt32 count, uInt32 number)
+{
+  uInt32 running = 0;
+  for(uInt32 k = 0; k < count; ++k)
+  {
+    uInt32 lane = lanes[k];
+
+    // Clear all of the execution status bits except for the fatal error
+    // bit, as execute() does; a lane that can't execute stays as it is
+    myCPUs[lane]->myExecutionStatus &= M6502::FatalErrorBit;
+    if(status(lane) || number == 0)
+      continue;
+
+    load(lane);
+    myRemaining[lane] = number;
+    myRunning[running++] = lane;
+  }
+
+  while(running > 0)
+  {
+    // Group the lanes at the lowest program counter
+    uInt32 pc = 0x10000;
+    for(uInt32 k = 0; k < running; ++k)
+      if(myPC[myRunning[k]] < pc)
+        pc = myPC[myRunning[k]];
+
+    uInt32 size = 0;
+    uInt32 next = 0x10000;
+    for(uInt32 k = 0; k < running; ++k)
+    {
+      uInt32 lane = myRunning[k];
+      if(myPC[lane] == pc)
+        myGroup[size++] = lane;
+      else if(myPC[lane] < next)
+        next = myPC[lane];
+    }
+
+    if(size == 1)
+      runAlone(myGroup[0], next);
+    else
+      runGroup(size, next);
+
+    // Hand the lanes which are done back to their processors
+    uInt32 kept = 0;
+    for(uInt32 k = 0; k < running; ++k)
+    {
+      uInt32 lane = myRunning[k];
+      if(!status(lane) && myRemaining[lane] != 0)
+      {
+        myRunning[kept++] = lane;
+        continue;
+      }
+
+      store(lane);
+
+      // See if we need to handle an interrupt, as execute() does
+      M6502Low& cpu = *myCPUs[lane];
+      if((cpu.myExecutionStatus & M6502::MaskableInterruptBit) ||
+          (cpu.myExecutionStatus & M6502::NonmaskableInterruptBit))
+      {
+        cpu.interruptHandler();
+      }
+    }
+    running = kept;
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void M6502Lockstep::runAlone(uInt32 lane, uInt32 next)
+{
+  M6502Low& cpu = *myCPUs[lane];
+  uInt32& remaining = myRemaining[lane];
+
+  store(lane);
+  do
+  {
+    // Handles the interrupts itself, leaving none for execute() above
+    cpu.execute(1);
+    --remaining;
+    ++myAloneInstructions;
+  }
+  while(!cpu.myExecutionStatus && remaining != 0 && cpu.PC < next);
+  load(lane);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void M6502Lockstep::runGroup(uInt32 size, uInt32 next)
+{
+  for(;;)
+  {
+    for(uInt32 k = 0; k < size; ++k)
+      step(myGroup[k]);
+    myGroupedInstructions += size;
+
+    // Go on while the group stays together below the other lanes
+    uInt16 pc = myPC[myGroup[0]];
+    if(pc >= next)
+      return;
+    for(uInt32 k = 0; k < size; ++k)
+    {
+      uInt32 lane = myGroup[k];
+      if(myPC[lane] != pc || status(lane) || myRemaining[lane] == 0)
+        return;
+    }
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void M6502Lockstep::step(uInt32 lane)
+{
+  M6502Low& cpu = *myCPUs[lane];
+
+  // The registers of the lane, under the names the instructions use
+  uInt8& A = myA[lane];
+  uInt8& X = myX[lane];
+  uInt8& Y = myY[lane];
+  uInt8& SP = mySP[lane];
+  uInt8& IR = myIR[lane];
+  uInt16& PC = myPC[lane];
+  bool& N = myN[lane];
+  bool& V = myV[lane];
+  bool& B = myB[lane];
+  bool& D = myD[lane];
+  bool& I = myI[lane];
+  bool& notZ = myNotZ[lane];
+  bool& C = myC[lane];
+
+  System* mySystem = mySystems[lane];
+  const uInt32 mySystemCyclesPerProcessorCycle =
+      cpu.mySystemCyclesPerProcessorCycle;
+  const uInt8 (&ourBCDTable)[2][256] = M6502::ourBCDTable;
+
+  uInt16 operandAddress = 0;
+  uInt8 operand = 0;
+
+  myLane = lane;
+
+  // Fetch instruction at the program counter
+  IR = peekWithPC();
+
+  // Update system cycles
+  mySystem->incrementCycles(cpu.myInstructionSystemCycleTable[IR]);
+
+  // Call code to execute the instruction
+  switch(IR)
+  {
+    // The instructions of M6502Low itself
+    #include "M6502Low.ins"
+
+    default:
+      // Oops, illegal instruction executed so set fatal error flag
+      cpu.myExecutionStatus |= M6502::FatalErrorBit;
+      std::cerr << "Illegal Instruction! "
+        << std::hex << (int) IR << std::endl;
+  }
+
+  --myRemaining[lane];
+}
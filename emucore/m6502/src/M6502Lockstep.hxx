@@ -0,0 +1,231 @@
+//============================================================================
+//
+// MM     MM  6666  555555  0000   2222
+// MMMM MMMM 66  66 55     00  00 22  22
+// MM MMM MM 66     55     00  00     22
+// MM  M  MM 66666  55555  00  00  22222  --  "A 6502 Microprocessor Emulator"
+// MM     MM 66  66     55 00  00 22
+// MM     MM 66  66 55  55 00  00 22
+// MM     MM  6666   5555   0000  222222
+//
+// Copyright (c) 1995-2007 by Bradford W. Mott and the Stella team
+//
+// See the file "license" for information on usage and redistribution of
+// this file, and for a DISCLAIMER OF ALL WARRANTIES.
+//
+//============================================================================
+
+#ifndef M6502LOCKSTEP_HXX
+#define M6502LOCKSTEP_HXX
+
+namespace ale {
+
+class M6502Lockstep;
+class M6502Low;
+
+}
+
+#include "bspf/src/bspf.hxx"
+#include "M6502.hxx"
+
+namespace ale {
+
+/**
+  This class runs the processors of several systems, its lanes, together.
+  The systems are meant to run the same ROM, so their programs mostly go
+  through the same instructions.
+
+  The registers of every lane are held here in arrays indexed by lane,
+  loaded from the lane's M6502Low when execute() starts and stored back
+  when the lane stops.  The lanes whose program counters match form a
+  group, and each instruction of the group is executed for all of its
+  lanes one after the other, with the instruction code of M6502Low itself
+  (M6502Low.ins).  When the lanes branch apart, the group at the lowest
+  program counter goes first, so the lanes left behind catch up with the
+  others and form a group again where their paths meet.  A lane left in a
+  group of its own is run by its M6502Low until it meets another lane.
+
+  Every memory access still goes to the lane's own system and devices,
+  and each lane goes through exactly the instructions, accesses and
+  cycles its M6502Low would go through on its own, so the lanes end up in
+  the same state either way.  Only the interleaving of the lanes differs,
+  which is invisible since they share nothing.
+*/
+class M6502Lockstep
+{
+  public:
+    /**
+      Create a lockstep processor whose lanes are the given systems.  The
+      processor of every system must be supported (see supports()), and
+      the systems must outlive this object.
+
+      @param systems The systems, one per lane
+      @param lanes   The number of systems
+    */
+    M6502Lockstep(System* const* systems, uInt32 lanes);
+
+    /**
+      Destructor
+    */
+    ~M6502Lockstep();
+
+  public:
+    /**
+      Answer true iff the processor of the given system can run as a lane,
+      i.e. it is an M6502Low and no profiler watches it
+
+      @param system The system to check
+      @return true iff the system can be a lane
+    */
+    static bool supports(System& system);
+
+    /**
+      Execute instructions on the given lanes until each lane has executed
+      the specified number of instructions, someone stops it, or an error
+      occurs, just as each lane's own execute(number) would.
+
+      @param lanes  The indices of the lanes to run
+      @param count  The number of lanes to run
+      @param number The number of instructions each lane executes at most
+    */
+    void execute(const uInt32* lanes, uInt32 count, uInt32 number);
+
+    /**
+      Answer the number of lanes
+
+      @return The number of lanes
+    */
+    uInt32 lanes() const { return myLanes; }
+
+    /**
+      Answer the number of instructions executed in groups of two or more
+      lanes since this object was created
+
+      @return The number of instructions, counted once per lane
+    */
+    uint64_t groupedInstructions() const { return myGroupedInstructions; }
+
+    /**
+      Answer the number of instructions lanes executed on their own
+      M6502Low since this object was created
+
+      @return The number of instructions
+    */
+    uint64_t aloneInstructions() const { return myAloneInstructions; }
+
+  private:
+    /**
+      Copy the registers of the lane's processor into the arrays
+    */
+    void load(uInt32 lane);
+
+    /**
+      Copy the registers of the lane from the arrays into its processor
+    */
+    void store(uInt32 lane);
+
+    /**
+      Execute the next instruction of the lane on its registers in the
+      arrays
+    */
+    void step(uInt32 lane);
+
+    /**
+      Execute instructions on the lane's own processor while it stays
+      below the given program counter
+
+      @param lane The lane to run
+      @param next The lowest program counter of the other running lanes,
+                  or 0x10000 if there are none
+    */
+    void runAlone(uInt32 lane, uInt32 next);
+
+    /**
+      Execute instructions on the group's lanes, one lane after the other,
+      while they stay together below the given program counter
+
+      @param size The number of lanes in the group
+      @param next The lowest program counter of the running lanes outside
+                  the group, or 0x10000 if there are none
+    */
+    void runGroup(uInt32 size, uInt32 next);
+
+    /**
+      Execution status of the lane's processor; zero while it runs
+    */
+    uInt8 status(uInt32 lane) const;
+
+  private:
+    /*
+      Get the byte at the specified address of the lane being stepped,
+      as M6502Low does
+
+      @return The byte at the specified address
+    */
+    inline uInt8 peek(uInt16 address);
+    inline uInt8 peekWithPC();
+
+    /**
+      Change the byte at the specified address of the lane being stepped
+      to the given value, as M6502Low does
+
+      @param address The address where the value should be stored
+      @param value The value to be stored at the address
+    */
+    inline void poke(uInt16 address, uInt8 value);
+
+    /**
+      Get and set the processor status register of the lane being stepped,
+      as M6502 does
+    */
+    inline uInt8 PS() const;
+    inline void PS(uInt8 ps);
+
+  private:
+    // Copy constructor isn't supported by this class so make it private
+    M6502Lockstep(const M6502Lockstep&);
+
+    // Assignment operator isn't supported by this class so make it private
+    M6502Lockstep& operator = (const M6502Lockstep&);
+
+  private:
+    // Number of lanes
+    uInt32 myLanes;
+
+    // System and processor of each lane
+    System** mySystems;
+    M6502Low** myCPUs;
+
+    // Registers of each lane, indexed by lane
+    uInt8* myA;
+    uInt8* myX;
+    uInt8* myY;
+    uInt8* mySP;
+    uInt8* myIR;
+    uInt16* myPC;
+    bool* myN;
+    bool* myV;
+    bool* myB;
+    bool* myD;
+    bool* myI;
+    bool* myNotZ;
+    bool* myC;
+
+    // Number of instructions each running lane may still execute
+    uInt32* myRemaining;
+
+    // Lanes still running in execute(), and the group being stepped
+    uInt32* myRunning;
+    uInt32* myGroup;
+
+    // Lane whose instruction step() is executing
+    uInt32 myLane;
+
+    // Instructions executed in groups, and alone
+    uint64_t myGroupedInstructions;
+    uint64_t myAloneInstructions;
+};
+
+} // namespace ale
+
+#endif
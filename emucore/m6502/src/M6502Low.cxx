@@ -61,6 +61,10 @@ bool M6502Low::execute(uInt32 number)
   // Clear all of the execution status bits except for the fatal error bit
   myExecutionStatus &= FatalErrorBit;
 
+#ifdef __USE_ROM_PROFILER
+  RomProfiler* profiler = mySystem->profiler();
+#endif
+
   {
     for(; !myExecutionStatus && (number != 0); --number)
     {
@@ -71,6 +75,12 @@ bool M6502Low::execute(uInt32 number)
       debugStream << "PC=" << hex << setw(4) << PC << " ";
 #endif
 
+#ifdef __USE_ROM_PROFILER
+      // Charged to the bank the instruction starts in
+      RomProfiler::Counters* profile = profiler ? &profiler->counters(PC) : 0;
+      uInt32 profileCycles = mySystem->cycles();
+#endif
+
       // Fetch instruction at the program counter
       IR = peekWithPC();
 
@@ -95,6 +105,11 @@ bool M6502Low::execute(uInt32 number)
             << std::hex << (int) IR << std::endl;
       }
 
+#ifdef __USE_ROM_PROFILER
+      if(profile)
+        profile->add(IR, mySystem->cycles() - profileCycles);
+#endif
+
 #ifdef DEBUG
       debugStream << hex << setw(4) << operandAddress << " ";
       debugStream << setw(4) << ourInstructionMnemonicTable[IR];
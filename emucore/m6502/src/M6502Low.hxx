@@ -22,6 +22,7 @@
 namespace ale {
 
 class M6502Low;
+class M6502Lockstep;
 class Serializer;
 class Deserializer;
 
@@ -51,6 +52,12 @@ namespace ale {
 */
 class M6502Low : public M6502
 {
+  public:
+    /**
+      The lockstep processor hands the interrupts of its lanes to them
+    */
+    friend class M6502Lockstep;
+
   public:
     /**
       Create a new low compatibility 6502 microprocessor with the specified 
@@ -39,6 +39,9 @@ System::System(uInt16 n, uInt16 m)
     myTIA(0),
     myCycles(0),
     myDataBusState(0)
+#ifdef __USE_ROM_PROFILER
+    , myProfiler(0)
+#endif
 {
   // Make sure the arguments are reasonable
   assert((1 <= m) && (m <= n) && (n <= 16));
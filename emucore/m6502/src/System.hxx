@@ -33,6 +33,7 @@ class Deserializer;
 #include "bspf/src/bspf.hxx"
 #include "Device.hxx"
 #include "NullDev.hxx"
+#include "emucore/RomProfiler.hxx"
 
 namespace ale {
 
@@ -257,6 +258,11 @@ class System
       PageAccess& access = myPageAccessTable[(addr & myAddressMask) >> myPageShift];
 
       uInt8 result;
+
+#ifdef __USE_ROM_PROFILER
+      if(myProfiler)
+        myProfiler->read(addr);
+#endif
  
       // See if this page uses direct accessing or not
       if(access.directPeekBase != 0)
@@ -284,6 +290,11 @@ class System
     void poke(uInt16 addr, uInt8 value) {
     
       PageAccess& access = myPageAccessTable[(addr & myAddressMask) >> myPageShift];
+
+#ifdef __USE_ROM_PROFILER
+      if(myProfiler)
+        myProfiler->write(addr);
+#endif
   
       // See if this page uses direct accessing or not
       if(access.directPokeBase != 0)
@@ -311,6 +322,19 @@ class System
     void lockDataBus();
     void unlockDataBus();
 
+#ifdef __USE_ROM_PROFILER
+    /**
+      Set the profiler fed by the processor and by register accesses, or
+      the null pointer for none. The system doesn't own it.
+    */
+    void setProfiler(RomProfiler* profiler) { myProfiler = profiler; }
+
+    /**
+      Answer the profiler, or the null pointer
+    */
+    RomProfiler* profiler() const { return myProfiler; }
+#endif
+
   public:
     /**
       Structure used to specify access methods for a page
@@ -398,6 +422,11 @@ class System
     // debugger is active.
     bool myDataBusLocked;
 
+#ifdef __USE_ROM_PROFILER
+    // Profiler to feed, or the null pointer
+    RomProfiler* myProfiler;
+#endif
+
   private:
     // Copy constructor isn't supported by this class so make it private
     System(const System&);
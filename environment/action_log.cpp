@@ -0,0 +1,196 @@
+/* *****************************************************************************
+ * Xitari
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ * *****************************************************************************
+ *  action_log.cpp
+ *
+ *  Compact logs of the actions taken in an environment, from which a run
+ *  can be re-emulated exactly.
+ **************************************************************************** */
+
+#include "action_log.hpp"
+
+#include <cstring>
+#include <stdexcept>
+#include <zlib/zlib.h>
+
+namespace ale {
+
+
+ActionLogWriter::ActionLogWriter(const std::string &filename, uInt32 checksum_interval) :
+    m_file(NULL),
+    m_filename(filename),
+    m_interval(checksum_interval > 0 ? checksum_interval : 1),
+    m_steps(0),
+    m_reward_a(0),
+    m_reward_b(0),
+    m_last_frame(0),
+    m_checked(true) {
+    m_file = fopen(filename.c_str(), "wb");
+    if (m_file == NULL)
+        throw std::runtime_error("Cannot create action log " + filename);
+
+    ActionLogHeader header;
+    header.magic = ACTION_LOG_MAGIC;
+    header.version = ACTION_LOG_VERSION;
+    header.checksum_interval = m_interval;
+    if (fwrite(&header, sizeof(header), 1, m_file) != 1) {
+        fclose(m_file);
+        throw std::runtime_error("Cannot write action log " + filename);
+    }
+}
+
+
+ActionLogWriter::~ActionLogWriter() {
+    try {
+        close();
+    } catch (const std::runtime_error &) {
+    }
+}
+
+
+void ActionLogWriter::close() {
+    if (m_file == NULL) return;
+
+    if (!m_checked)
+        check(&m_last_ram[0], m_last_ram.size(), m_last_frame);
+    // fclose() flushes, so it can fail as well
+    if (fclose(m_file) != 0 && m_error.empty())
+        m_error = "Cannot write action log " + m_filename;
+    m_file = NULL;
+
+    if (!m_error.empty())
+        throw std::runtime_error(m_error);
+}
+
+
+void ActionLogWriter::write(const void *data, size_t size) {
+    if (fwrite(data, 1, size, m_file) != size && m_error.empty())
+        m_error = "Cannot write action log " + m_filename;
+}
+
+
+void ActionLogWriter::state(const std::string &snapshot) {
+    // Steps before the jump are checked against the state they led to
+    if (!m_checked)
+        check(&m_last_ram[0], m_last_ram.size(), m_last_frame);
+
+    uInt32 length = snapshot.size();
+    write(&ACTION_LOG_STATE, 1);
+    write(&length, sizeof(length));
+    write(snapshot.data(), length);
+}
+
+
+void ActionLogWriter::step(int action_a, int action_b, double reward_a, double reward_b,
+                           const uInt8 *ram, size_t ram_size, Int32 frame) {
+    uInt8 record[3] = { ACTION_LOG_STEP, static_cast<uInt8>(action_a),
+                        static_cast<uInt8>(action_b) };
+    write(record, sizeof(record));
+
+    m_steps++;
+    m_reward_a += reward_a;
+    m_reward_b += reward_b;
+
+    if (m_steps % m_interval == 0)
+        check(ram, ram_size, frame);
+    else {
+        m_last_ram.assign(ram, ram + ram_size);
+        m_last_frame = frame;
+        m_checked = false;
+    }
+}
+
+
+void ActionLogWriter::check(const uInt8 *ram, size_t ram_size, Int32 frame) {
+    ActionLogCheck check;
+    check.step = m_steps;
+    check.ram_checksum = crc32(0L, ram, ram_size);
+    check.frame = frame;
+    check.padding = 0;
+    check.reward_a = m_reward_a;
+    check.reward_b = m_reward_b;
+
+    write(&ACTION_LOG_CHECK, 1);
+    write(&check, sizeof(check));
+    m_checked = true;
+}
+
+
+ActionLogReader::ActionLogReader(const std::string &filename) :
+    m_pos(sizeof(ActionLogHeader)),
+    m_action_a(0),
+    m_action_b(0) {
+    memset(&m_check, 0, sizeof(m_check));
+
+    FILE *file = fopen(filename.c_str(), "rb");
+    if (file == NULL)
+        throw std::runtime_error("Cannot open action log " + filename);
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (size > 0) {
+        m_data.resize(size);
+        if (fread(&m_data[0], size, 1, file) != 1)
+            m_data.clear();
+    }
+    fclose(file);
+
+    if (m_data.size() < sizeof(m_header))
+        throw std::runtime_error(filename + " is not an action log");
+    memcpy(&m_header, &m_data[0], sizeof(m_header));
+    if (m_header.magic != ACTION_LOG_MAGIC || m_header.version != ACTION_LOG_VERSION)
+        throw std::runtime_error(filename + " is not an action log");
+}
+
+
+uInt8 ActionLogReader::next() {
+    if (m_pos == m_data.size())
+        return 0;
+
+    uInt8 tag = m_data[m_pos++];
+    size_t left = m_data.size() - m_pos;
+    const uInt8 *payload = &m_data[0] + m_pos;
+
+    if (tag == ACTION_LOG_STEP) {
+        if (left < 2)
+            throw std::runtime_error("Truncated action log");
+        m_action_a = payload[0];
+        m_action_b = payload[1];
+        m_pos += 2;
+    }
+    else if (tag == ACTION_LOG_CHECK) {
+        if (left < sizeof(m_check))
+            throw std::runtime_error("Truncated action log");
+        memcpy(&m_check, payload, sizeof(m_check));
+        m_pos += sizeof(m_check);
+    }
+    else if (tag == ACTION_LOG_STATE) {
+        uInt32 length;
+        if (left < sizeof(length))
+            throw std::runtime_error("Truncated action log");
+        memcpy(&length, payload, sizeof(length));
+        if (left - sizeof(length) < length)
+            throw std::runtime_error("Truncated action log");
+        m_snapshot.assign(reinterpret_cast<const char*>(payload + sizeof(length)), length);
+        m_pos += sizeof(length) + length;
+    }
+    else
+        throw std::runtime_error("Corrupt action log record");
+
+    return tag;
+}
+
+} // namespace ale
@@ -0,0 +1,156 @@
+/* *****************************************************************************
+ * Xitari
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ * *****************************************************************************
+ *  action_log.hpp
+ *
+ *  Compact logs of the actions taken in an environment, from which a run
+ *  can be re-emulated exactly.
+ *
+ *  An action log is an ActionLogHeader followed by records, each a tag byte
+ *  and its payload:
+ *    ACTION_LOG_STATE  uInt32 length, then a snapshot (getSnapshot()) of
+ *                      the environment, which replay restores. Logs start
+ *                      with one, and every reset or restore adds another,
+ *                      so replay never depends on the random seed.
+ *    ACTION_LOG_STEP   uInt8 player A action, uInt8 player B action.
+ *    ACTION_LOG_CHECK  An ActionLogCheck of the environment after the steps
+ *                      so far, every checksum_interval steps and at the end,
+ *                      against which replay detects divergence.
+ *  All numbers are in native byte order.
+ **************************************************************************** */
+
+#ifndef __ACTION_LOG_HPP__
+#define __ACTION_LOG_HPP__
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "emucore/m6502/src/bspf/src/bspf.hxx"
+
+namespace ale {
+
+static const uInt32 ACTION_LOG_MAGIC = 0x54434158; // "XACT"
+static const uInt32 ACTION_LOG_VERSION = 1;
+
+// Record tags
+static const uInt8 ACTION_LOG_STATE = 'S';
+static const uInt8 ACTION_LOG_STEP = 'A';
+static const uInt8 ACTION_LOG_CHECK = 'C';
+
+
+struct ActionLogHeader {
+    uInt32 magic;
+    uInt32 version;
+    uInt32 checksum_interval;
+};
+
+
+struct ActionLogCheck {
+    uInt32 step;                    // Steps logged before this check
+    uInt32 ram_checksum;            // CRC-32 of the RAM
+    Int32 frame;                    // Frame number
+    uInt32 padding;
+    double reward_a;                // Rewards summed over all logged steps
+    double reward_b;
+};
+
+
+// Writes an action log. Records go through stdio's buffer, so logging a
+// step costs a few bytes of memcpy.
+class ActionLogWriter {
+
+    public:
+
+        /** Creates filename; throws std::runtime_error if it can't. */
+        ActionLogWriter(const std::string &filename, uInt32 checksum_interval);
+
+        /** Closes the file, if close() hasn't; write errors are lost then. */
+        ~ActionLogWriter();
+
+        /** Writes a final check and closes the file. Throws
+            std::runtime_error if any record couldn't be written. */
+        void close();
+
+        /** Logs the environment's state, from which replay resumes. */
+        void state(const std::string &snapshot);
+
+        /** Logs a step and its rewards, then a check if one is due; ram is
+            the RAM after the step. */
+        void step(int action_a, int action_b, double reward_a, double reward_b,
+                  const uInt8 *ram, size_t ram_size, Int32 frame);
+
+    private:
+
+        void check(const uInt8 *ram, size_t ram_size, Int32 frame);
+
+        /** Writes size bytes, keeping the first error. */
+        void write(const void *data, size_t size);
+
+        /** Copying is explicitly disallowed. */
+        ActionLogWriter(const ActionLogWriter &);
+        ActionLogWriter &operator=(const ActionLogWriter &);
+
+        FILE *m_file;
+        std::string m_filename;
+        std::string m_error;            // The first write error, if any
+        uInt32 m_interval;
+        uInt32 m_steps;
+        double m_reward_a, m_reward_b;
+        // What the final check covers
+        std::vector<uInt8> m_last_ram;
+        Int32 m_last_frame;
+        bool m_checked;                 // No step since the last check
+};
+
+
+// Reads an action log, record by record. The whole log is loaded up front:
+// at three bytes a step (a tag and the two actions), even long runs are small.
+class ActionLogReader {
+
+    public:
+
+        /** Loads filename; throws std::runtime_error if it isn't an action
+            log. */
+        ActionLogReader(const std::string &filename);
+
+        const ActionLogHeader &header() const { return m_header; }
+
+        /** Moves to the next record and returns its tag, or 0 at the end of
+            the log. Throws std::runtime_error on a truncated or unknown
+            record. */
+        uInt8 next();
+
+        /** Payload of the current record, by tag. */
+        int actionA() const { return m_action_a; }
+        int actionB() const { return m_action_b; }
+        const std::string &snapshot() const { return m_snapshot; }
+        const ActionLogCheck &check() const { return m_check; }
+
+    private:
+
+        ActionLogHeader m_header;
+        std::vector<uInt8> m_data;
+        size_t m_pos;
+
+        int m_action_a, m_action_b;
+        std::string m_snapshot;
+        ActionLogCheck m_check;
+};
+
+} // namespace ale
+
+#endif // __ACTION_LOG_HPP__
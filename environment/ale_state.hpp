@@ -92,6 +92,8 @@ class ALEState {
 
   // Let StellaEnvironment access these methods: they are needed for emulation purposes
   friend class StellaEnvironment;
+  // The shadow translates states between CPU cores
+  friend class ShadowEnvironment;
 
   /** Resets the paddles */
   void resetPaddles(Event*);
@@ -70,7 +70,7 @@ private:
 template<typename T>
 void ArchiveBinaryIn::readPrimitive(T& value)
 {
-    static char bytes[sizeof(T)];
+    char bytes[sizeof(T)];
     m_sin.read(bytes,sizeof(T));
 
     value = *reinterpret_cast<T*>(bytes);
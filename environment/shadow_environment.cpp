@@ -0,0 +1,263 @@
+/* *****************************************************************************
+ * Xitari
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ * *****************************************************************************
+ *  shadow_environment.cpp
+ *
+ *  A reference emulator that follows a StellaEnvironment in lockstep, to
+ *  validate its fast paths.
+ **************************************************************************** */
+
+#include "shadow_environment.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <zlib/zlib.h>
+
+#include "stella_environment.hpp"
+#include "emucore/Serializer.hxx"
+#include "emucore/m6502/src/System.hxx"
+#include "emucore/m6502/src/M6502.hxx"
+#include "os_dependent/SettingsWin32.hxx"
+#include "os_dependent/OSystemWin32.hxx"
+#include "os_dependent/SettingsUNIX.hxx"
+#include "os_dependent/OSystemUNIX.hxx"
+
+namespace ale {
+
+
+ShadowEnvironment::ShadowEnvironment(OSystem *osystem, RomSettings *settings) :
+    m_osystem(NULL),
+    m_settings(NULL),
+    m_rom_settings(NULL),
+    m_environment(NULL),
+    m_prefix(osystem->settings().getString("shadow_prefix")),
+    m_diverged(false) {
+
+#ifdef WIN32
+    m_osystem = new OSystemWin32();
+    m_settings = new SettingsWin32(m_osystem);
+#else
+    m_osystem = new OSystemUNIX();
+    m_settings = new SettingsUNIX(m_osystem);
+#endif
+
+    // The same settings, less every fast path and the shadow itself
+    m_settings->copyFrom(osystem->settings());
+    m_settings->setString("cpu", "low");
+    m_settings->setBool("fast_tia_update", false);
+    m_settings->setBool("disable_tia_write_combining", true);
+    m_settings->setBool("disable_tia_simd", true);
+    m_settings->setBool("shadow_execution", false);
+    m_settings->setString("rom_profile", "");
+    m_settings->validate();
+    m_osystem->create();
+
+    std::string rom_file = osystem->settings().getString("rom_file");
+    if (!m_osystem->createConsole(rom_file))
+        throw std::runtime_error("Cannot load " + rom_file + " into the shadow emulator");
+    m_osystem->console().setPalette("standard");
+
+    m_rom_settings = settings->clone();
+    m_environment = new StellaEnvironment(m_osystem, m_rom_settings);
+    m_environment->m_render_all_frames = true;
+}
+
+
+ShadowEnvironment::~ShadowEnvironment() {
+    delete m_environment;
+    delete m_osystem;
+    delete m_settings;
+    delete m_rom_settings;
+}
+
+
+void ShadowEnvironment::reset(const StellaEnvironment &env, int noop_steps) {
+    if (m_diverged) return;
+    m_environment->reset(noop_steps);
+    check(env, "reset", true);
+}
+
+
+void ShadowEnvironment::act(const StellaEnvironment &env, Action player_a_action,
+                            Action player_b_action) {
+    if (m_diverged) return;
+    m_environment->act(player_a_action, player_b_action);
+    check(env, "step", true);
+}
+
+
+void ShadowEnvironment::save(const StellaEnvironment &env) {
+    if (m_diverged) return;
+    m_environment->save();
+    check(env, "save", false);
+}
+
+
+void ShadowEnvironment::load(const StellaEnvironment &env) {
+    if (m_diverged) return;
+    m_environment->load();
+    check(env, "load", false);
+}
+
+
+void ShadowEnvironment::restoreState(const StellaEnvironment &env, const ALEState &state) {
+    if (m_diverged) return;
+    m_environment->restoreState(translate(env, state));
+    check(env, "restore", false);
+}
+
+
+void ShadowEnvironment::setState(const ALEState &state) {
+    if (m_diverged) return;
+    m_environment->setState(state);
+}
+
+
+// Replaces the name of the CPU core that the serialized CPU state starts
+// with, the only part of a state that depends on the core
+static void renameCPU(std::string &state, const char *from, const char *to) {
+    if (strcmp(from, to) == 0) return;
+
+    Serializer from_name, to_name;
+    from_name.putString(from);
+    to_name.putString(to);
+    std::string old_name = from_name.get_str();
+    size_t pos = state.find(old_name);
+    if (pos != std::string::npos)
+        state.replace(pos, old_name.size(), to_name.get_str());
+}
+
+
+const char *ShadowEnvironment::cpuName(const StellaEnvironment &env) {
+    return env.m_osystem->console().system().m6502().name();
+}
+
+
+std::string ShadowEnvironment::machineState(const StellaEnvironment &env) const {
+    Serializer ser;
+    env.m_osystem->console().system().saveState(env.m_cartridge_md5, ser);
+    env.m_settings->saveState(ser);
+
+    std::string state = ser.get_str();
+    renameCPU(state, cpuName(env), cpuName(*m_environment));
+    return state;
+}
+
+
+ALEState ShadowEnvironment::translate(const StellaEnvironment &env,
+                                      const ALEState &state) const {
+    std::string serialized = state.m_serialized_state;
+    renameCPU(serialized, cpuName(env), cpuName(*m_environment));
+    return ALEState(state, serialized);
+}
+
+
+ShadowFingerprint ShadowEnvironment::fingerprint(const StellaEnvironment &env,
+                                                 bool screen) const {
+    ShadowFingerprint print;
+    std::string state = machineState(env);
+    const std::vector<pixel_t> &pixels = env.m_screen.getArray();
+
+    print.frame = env.getFrameNumber();
+    print.system = crc32(0L, reinterpret_cast<const Bytef*>(state.data()), state.size());
+    print.ram = crc32(0L, env.m_ram.array(), env.m_ram.size());
+    print.screen = screen ? crc32(0L, &pixels[0], pixels.size() * sizeof(pixel_t)) : 0;
+    print.pc = env.m_osystem->console().system().m6502().getPC();
+    print.reward_a = env.m_settings->getReward();
+    print.reward_b = env.m_settings->getRewardB();
+    print.terminal = env.isTerminal();
+    return print;
+}
+
+
+void ShadowEnvironment::check(const StellaEnvironment &env, const char *operation,
+                              bool emulated) {
+    // Only emulating renders the screen; unrendered it is stale, and so is
+    // the screen of a restored state
+    bool screen = emulated && env.m_rendering_enabled;
+    ShadowFingerprint got = fingerprint(env, screen);
+    ShadowFingerprint expected = fingerprint(*m_environment, screen);
+
+    if (got.frame == expected.frame && got.system == expected.system &&
+        got.ram == expected.ram && got.screen == expected.screen &&
+        got.reward_a == expected.reward_a && got.reward_b == expected.reward_b &&
+        got.terminal == expected.terminal)
+        return;
+
+    m_diverged = true;
+    writeDivergence(env, got, expected, operation);
+}
+
+
+static void writeFingerprint(FILE *file, const char *name, const ShadowFingerprint &print) {
+    fprintf(file, "%-10s frame %d, system %08lx, ram %08lx, screen %08lx, pc $%04X, "
+            "rewards %g/%g%s\n", name, print.frame, print.system, print.ram, print.screen,
+            print.pc, print.reward_a, print.reward_b, print.terminal ? ", terminal" : "");
+}
+
+
+static bool writeFile(const std::string &filename, const std::string &data) {
+    FILE *file = fopen(filename.c_str(), "wb");
+    if (file == NULL) return false;
+    bool ok = fwrite(data.data(), 1, data.size(), file) == data.size();
+    return (fclose(file) == 0) && ok;
+}
+
+
+void ShadowEnvironment::writeDivergence(const StellaEnvironment &env,
+                                        const ShadowFingerprint &got,
+                                        const ShadowFingerprint &expected,
+                                        const char *operation) const {
+    std::string what;
+    if (got.frame != expected.frame) what += " frame";
+    if (got.system != expected.system) what += " system";
+    if (got.ram != expected.ram) what += " ram";
+    if (got.screen != expected.screen) what += " screen";
+    if (got.reward_a != expected.reward_a || got.reward_b != expected.reward_b)
+        what += " rewards";
+    if (got.terminal != expected.terminal) what += " terminal";
+
+    char frame[16];
+    snprintf(frame, sizeof(frame), "%d", got.frame);
+    std::string prefix = m_prefix + "-" + frame;
+
+    // Each snapshot loads into an emulator running its own CPU core
+    const ALEState *optimized = env.cloneState();
+    const ALEState *reference = m_environment->cloneState();
+    bool written = writeFile(prefix + ".optimized.state", optimized->getStateAsString()) &&
+                   writeFile(prefix + ".reference.state", reference->getStateAsString());
+    env.destroyState(optimized);
+    m_environment->destroyState(reference);
+
+    FILE *file = fopen((prefix + ".txt").c_str(), "w");
+    if (file != NULL) {
+        fprintf(file, "Diverged after a %s at frame %d:%s\n", operation, got.frame, what.c_str());
+        writeFingerprint(file, "optimized", got);
+        writeFingerprint(file, "reference", expected);
+        written = (fclose(file) == 0) && written;
+    }
+    else
+        written = false;
+
+    std::cerr << "Shadow execution: diverged from the reference after a " << operation
+              << " at frame " << got.frame << " (" << what.substr(1) << "); "
+              << (written ? "states written to " + prefix + ".*"
+                          : "cannot write the states to " + prefix + ".*")
+              << std::endl;
+}
+
+} // namespace ale
@@ -0,0 +1,116 @@
+/* *****************************************************************************
+ * Xitari
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ * *****************************************************************************
+ *  shadow_environment.hpp
+ *
+ *  Shadow execution (-shadow_execution): a reference emulator that follows
+ *  a StellaEnvironment in lockstep, to validate its fast paths.
+ *
+ *  The reference runs the same ROM with the same settings, except that it
+ *  uses the low CPU core, catches the TIA up on every register write and
+ *  renders every frame. After each reset, step, save and load the two
+ *  environments' fingerprints are compared; on the first difference both
+ *  states are written to <shadow_prefix>-<frame>.optimized.state and
+ *  .reference.state (snapshots, as ALEInterface::getSnapshot() returns
+ *  them), with a report in <shadow_prefix>-<frame>.txt, and the shadow
+ *  stops.
+ **************************************************************************** */
+
+#ifndef __SHADOW_ENVIRONMENT_HPP__
+#define __SHADOW_ENVIRONMENT_HPP__
+
+#include <string>
+
+#include "ale_interface.hpp"
+
+namespace ale {
+
+class OSystem;
+class Settings;
+class RomSettings;
+class ALEState;
+class StellaEnvironment;
+
+
+// What is compared after every operation
+struct ShadowFingerprint {
+    int frame;
+    unsigned long system;           // CRC-32 of the machine and ROM settings state
+    unsigned long ram;              // CRC-32 of the RAM
+    unsigned long screen;           // CRC-32 of the screen
+    int pc;
+    reward_t reward_a;
+    reward_t reward_b;
+    bool terminal;
+};
+
+
+class ShadowEnvironment {
+
+    public:
+
+        /** Loads the ROM of osystem into a reference emulator. */
+        ShadowEnvironment(OSystem *osystem, RomSettings *settings);
+        ~ShadowEnvironment();
+
+        /** Mirror the operations of env on the reference, then compare the
+            two. Reset takes the number of no-op frames env started with. */
+        void reset(const StellaEnvironment &env, int noop_steps);
+        void act(const StellaEnvironment &env, Action player_a_action,
+                 Action player_b_action);
+        void save(const StellaEnvironment &env);
+        void load(const StellaEnvironment &env);
+        void restoreState(const StellaEnvironment &env, const ALEState &state);
+        void setState(const ALEState &state);
+
+        /** Whether the environments have diverged; the shadow stops then. */
+        bool diverged() const { return m_diverged; }
+
+    private:
+
+        /** Compares env with the reference after operation, which emulated
+            frames if emulated is set. */
+        void check(const StellaEnvironment &env, const char *operation, bool emulated);
+
+        ShadowFingerprint fingerprint(const StellaEnvironment &env, bool screen) const;
+
+        /** The machine state of env in the reference's CPU core's terms. */
+        std::string machineState(const StellaEnvironment &env) const;
+
+        /** state, as saved by env, for the reference. */
+        ALEState translate(const StellaEnvironment &env, const ALEState &state) const;
+
+        static const char *cpuName(const StellaEnvironment &env);
+
+        void writeDivergence(const StellaEnvironment &env, const ShadowFingerprint &got,
+                             const ShadowFingerprint &expected, const char *operation) const;
+
+        /** Copying is explicitly disallowed. */
+        ShadowEnvironment(const ShadowEnvironment &);
+        ShadowEnvironment &operator=(const ShadowEnvironment &);
+
+        OSystem *m_osystem;
+        Settings *m_settings;
+        RomSettings *m_rom_settings;
+        StellaEnvironment *m_environment;
+
+        std::string m_prefix;           // Of the divergence's files
+        bool m_diverged;
+};
+
+} // namespace ale
+
+#endif // __SHADOW_ENVIRONMENT_HPP__
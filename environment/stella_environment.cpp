@@ -34,6 +34,8 @@
 
 #include "stella_environment.hpp"
 #include "../emucore/m6502/src/System.hxx"
+#include "../emucore/TIA.hxx"
+#include "../emucore/M6532.hxx"
 #include <cstring>
 #include <unistd.h>
 #include <iostream>
@@ -45,7 +47,13 @@ StellaEnvironment::StellaEnvironment(OSystem* osystem, RomSettings* settings):
   m_settings(settings),
   m_phosphor_blend(osystem),
   m_screen(m_osystem->console().mediaSource().height(),
-        m_osystem->console().mediaSource().width()) {
+        m_osystem->console().mediaSource().width()),
+  m_rendering_enabled(true),
+  m_render_all_frames(false),
+  m_trace_env(Timeline::newEnvironment()),
+  m_shadow(NULL),
+  m_act_a_action(PLAYER_A_NOOP),
+  m_act_b_action(PLAYER_B_NOOP) {
 
   // Determine whether this is a paddle-based game
   if (m_osystem->console().properties().get(Controller_Left) == "PADDLES" ||
@@ -60,16 +68,45 @@ StellaEnvironment::StellaEnvironment(OSystem* osystem, RomSettings* settings):
   
   m_num_reset_steps = atoi(m_osystem->settings().getString("system_reset_steps").c_str());
   m_use_starting_actions = m_osystem->settings().getBool("use_starting_actions");
+  // Fixed for the ROM, and fetched once so that resets don't allocate
+  m_starting_actions = m_settings->getStartingActions();
   
   m_max_num_frames_per_episode = m_osystem->settings().getInt("max_num_frames_per_episode");
   m_colour_averaging = !m_osystem->settings().getBool("disable_color_averaging");
 
   m_backward_compatible_save = m_osystem->settings().getBool("backward_compatible_save");
   m_stochastic_start = m_osystem->settings().getBool("use_environment_distribution");
+
+  if (m_osystem->settings().getBool("shadow_execution"))
+    m_shadow = new ShadowEnvironment(osystem, settings);
+
+  // Leave out whatever the console ran before the environment existed
+  resetStepStats();
+}
+
+StellaEnvironment::~StellaEnvironment() {
+  delete m_shadow;
 }
 
 /** Resets the system to its start state. */
 void StellaEnvironment::reset() {
+  // NOOP for 60 steps in the deterministic environment setting, or some random amount otherwise 
+  int noopSteps;
+  if (m_stochastic_start)
+    noopSteps = 60 + rand() % NUM_RANDOM_ENVIRONMENTS;
+  else
+    noopSteps = 60;
+
+  reset(noopSteps);
+
+  if (m_shadow != NULL)
+    m_shadow->reset(*this, noopSteps);
+}
+
+void StellaEnvironment::reset(int noopSteps) {
+  TimelineScope trace("reset", m_trace_env);
+  STEP_STATS_BEGIN(reset);
+
   // RNG for generating environments
 
   Random randGen;
@@ -80,13 +117,6 @@ void StellaEnvironment::reset() {
   // Reset the emulator
   m_osystem->console().system().reset();
 
-  // NOOP for 60 steps in the deterministic environment setting, or some random amount otherwise 
-  int noopSteps;
-  if (m_stochastic_start)
-    noopSteps = 60 + rand() % NUM_RANDOM_ENVIRONMENTS;
-  else
-    noopSteps = 60;
-
   emulate(PLAYER_A_NOOP, PLAYER_B_NOOP, noopSteps);
   // reset for n steps
 
@@ -97,15 +127,18 @@ void StellaEnvironment::reset() {
  
   // Apply necessary actions specified by the rom itself
   if (m_use_starting_actions) {
-    ActionVect startingActions = m_settings->getStartingActions();
-    for (size_t i = 0; i < startingActions.size(); i++)
-      emulate(startingActions[i], PLAYER_B_NOOP);
+    for (size_t i = 0; i < m_starting_actions.size(); i++)
+      emulate(m_starting_actions[i], PLAYER_B_NOOP);
   }
 
+  STEP_STATS_END(m_stats, reset, ALEStepStats::RESET);
 }
 
 /** Save/restore the environment state. */
 void StellaEnvironment::save() {
+  TimelineScope trace("save_state", m_trace_env);
+  STEP_STATS_BEGIN(save);
+
   // Store the current state into a new object
   ALEState new_state = m_state.save(m_osystem, m_settings, m_cartridge_md5);
 
@@ -117,10 +150,17 @@ void StellaEnvironment::save() {
   else { // 0.4 and above: put it on the stack
     m_saved_states.push(new_state);
   }
+
+  STEP_STATS_END(m_stats, save, ALEStepStats::SAVE_STATE);
+
+  if (m_shadow != NULL)
+    m_shadow->save(*this);
 }
 
 /** Get a copy of the underlying environment state. */
 ALEState *StellaEnvironment::cloneState() const {
+    TimelineScope trace("save_state", m_trace_env);
+    STEP_STATS_BEGIN(save);
 
     // cast away const, to deal with legacy saving code not properly 
     // handling it. should be fine.
@@ -130,14 +170,22 @@ ALEState *StellaEnvironment::cloneState() const {
     //       which we can avoid later if performance is an issue.
     ALEState *rval = new ALEState(state->save(m_osystem, m_settings, m_cartridge_md5));
 
+    STEP_STATS_END(m_stats, save, ALEStepStats::SAVE_STATE);
     return rval;
 }
 
 /** Restore the environment to a previously saved state. */
 void StellaEnvironment::restoreState(const ALEState &state) {
+    TimelineScope trace("load_state", m_trace_env);
+    STEP_STATS_BEGIN(load);
 
     // Deserialize it into 'm_state'
     m_state.load(m_osystem, m_settings, m_cartridge_md5, state);
+
+    STEP_STATS_END(m_stats, load, ALEStepStats::LOAD_STATE);
+
+    if (m_shadow != NULL)
+      m_shadow->restoreState(*this, state);
 }
 
 /** Destroy a cloned state. */
@@ -149,6 +197,9 @@ bool StellaEnvironment::load() {
 
   if (m_saved_states.empty()) return false;  
 
+  TimelineScope trace("load_state", m_trace_env);
+  STEP_STATS_BEGIN(load);
+
   // Get the state on top of the stack
   ALEState& target_state = m_saved_states.top(); 
  
@@ -161,6 +212,10 @@ bool StellaEnvironment::load() {
     m_saved_states.pop();
   }
 
+  STEP_STATS_END(m_stats, load, ALEStepStats::LOAD_STATE);
+
+  if (m_shadow != NULL)
+    m_shadow->load(*this);
   return true;
 }
 
@@ -184,22 +239,55 @@ void StellaEnvironment::noopIllegalActions(Action & player_a_action, Action & pl
 /** Applies the given actions (e.g. updating paddle positions when the paddle is used)
   *  and performs one simulation step in Stella. */
 reward_t StellaEnvironment::act(Action player_a_action, Action player_b_action) {
+  TimelineScope trace("step", m_trace_env);
+  STEP_STATS_BEGIN(step);
  
+  if (!beginAct(player_a_action, player_b_action))
+    return 0;
+
+  // Emulate in the emulator
+  STEP_STATS_BEGIN(update);
+  m_osystem->console().mediaSource().update();
+  STEP_STATS_END(m_stats, update, ALEStepStats::CPU);
+
+  endAct();
+  //usleep(100000);
+  STEP_STATS_END_STEP(m_stats, step);
+  return m_settings->getReward();
+}
+
+bool StellaEnvironment::beginAct(Action player_a_action, Action player_b_action) {
   // Once in a terminal state, refuse to go any further (special actions must be handled
   //  outside of this environment; in particular reset() should be called rather than passing
   //  RESET or SYSTEM_RESET.
   if (isTerminal())
-    return 0;
+    return false;
 
   // Convert illegal actions into NOOPs; actions such as reset are always legal
   noopIllegalActions(player_a_action, player_b_action);
+  m_act_a_action = player_a_action;
+  m_act_b_action = player_b_action;
 
-  
-  // Emulate in the emulator
-  emulate(player_a_action, player_b_action);
-  m_state.incrementFrame(); 
-  //usleep(100000);
-  return m_settings->getReward();
+  // As emulate() does for a single step
+  Event* event = m_osystem->event();
+  if (m_use_paddles)
+    m_state.applyActionPaddles(event, player_a_action, player_b_action);
+  else
+    m_state.setActionJoysticks(event, player_a_action, player_b_action);
+  m_osystem->console().mediaSource().enableRendering(m_render_all_frames || m_rendering_enabled);
+  return true;
+}
+
+void StellaEnvironment::endAct() {
+  STEP_STATS_BEGIN(rom);
+  m_settings->step(m_osystem->console().system());
+  STEP_STATS_END(m_stats, rom, ALEStepStats::ROM_STEP);
+
+  observe();
+  m_state.incrementFrame();
+
+  if (m_shadow != NULL)
+    m_shadow->act(*this, m_act_a_action, m_act_b_action);
 }
 
 bool StellaEnvironment::isTerminal() const {
@@ -212,8 +300,12 @@ bool StellaEnvironment::isTerminal() const {
 
 void StellaEnvironment::emulate(Action player_a_action, Action player_b_action, size_t num_steps) {
   Event* event = m_osystem->event();
+  MediaSource& media = m_osystem->console().mediaSource();
 
-  
+  // Only the last frame (the last two when colour averaging) can end up in m_screen, so
+  //  the TIA does not need to draw the ones before it
+  size_t first_rendered_step = m_colour_averaging ? 1 : 0;
+  first_rendered_step = (num_steps > first_rendered_step) ? num_steps - 1 - first_rendered_step : 0;
 
   // Handle paddles separately: we have to manually update the paddle positions at each step
   if (m_use_paddles) {
@@ -222,8 +314,14 @@ void StellaEnvironment::emulate(Action player_a_action, Action player_b_action,
       // Update paddle position at every step
       m_state.applyActionPaddles(event, player_a_action, player_b_action);
 
-      m_osystem->console().mediaSource().update();
+      media.enableRendering(m_render_all_frames ||
+                           (m_rendering_enabled && t >= first_rendered_step));
+      STEP_STATS_BEGIN(update);
+      media.update();
+      STEP_STATS_END(m_stats, update, ALEStepStats::CPU);
+      STEP_STATS_BEGIN(rom);
       m_settings->step(m_osystem->console().system());
+      STEP_STATS_END(m_stats, rom, ALEStepStats::ROM_STEP);
 
     }
   }
@@ -234,19 +332,35 @@ void StellaEnvironment::emulate(Action player_a_action, Action player_b_action,
 
     for (size_t t = 0; t < num_steps; t++) {
 
-      m_osystem->console().mediaSource().update();
+      media.enableRendering(m_render_all_frames ||
+                           (m_rendering_enabled && t >= first_rendered_step));
+      STEP_STATS_BEGIN(update);
+      media.update();
+      STEP_STATS_END(m_stats, update, ALEStepStats::CPU);
  
-
+      STEP_STATS_BEGIN(rom);
       m_settings->step(m_osystem->console().system());
+      STEP_STATS_END(m_stats, rom, ALEStepStats::ROM_STEP);
 
     }
   }
  
+  observe();
+}
+
+void StellaEnvironment::observe() {
   // Parse screen and RAM into their respective data structures
+  TimelineScope trace("observe", m_trace_env);
 
-  processScreen();
+  if (m_rendering_enabled) {
+    STEP_STATS_BEGIN(screen);
+    processScreen();
+    STEP_STATS_END(m_stats, screen, ALEStepStats::PROCESS_SCREEN);
+  }
 
+  STEP_STATS_BEGIN(ram);
   processRAM();
+  STEP_STATS_END(m_stats, ram, ALEStepStats::PROCESS_RAM);
 
 }
 
@@ -254,6 +368,9 @@ void StellaEnvironment::emulate(Action player_a_action, Action player_b_action,
 void StellaEnvironment::setState(const ALEState& state) {
 
   m_state = state;
+
+  if (m_shadow != NULL)
+    m_shadow->setState(state);
 }
 
 const ALEState& StellaEnvironment::getState() const {
@@ -261,6 +378,27 @@ const ALEState& StellaEnvironment::getState() const {
   return m_state;
 }
 
+const byte_t *StellaEnvironment::getRAMView() const {
+
+  return m_osystem->console().riot().ram();
+}
+
+void StellaEnvironment::getStepStats(ALEStepStats &stats) const {
+#ifdef __USE_STEP_STATS
+  const TIA &tia = static_cast<const TIA&>(m_osystem->console().mediaSource());
+  m_stats.fill(stats, tia.renderTicks(), tia.renderCalls());
+#else
+  stats = ALEStepStats();
+#endif
+}
+
+void StellaEnvironment::resetStepStats() {
+#ifdef __USE_STEP_STATS
+  const TIA &tia = static_cast<const TIA&>(m_osystem->console().mediaSource());
+  m_stats.clear(tia.renderTicks(), tia.renderCalls());
+#endif
+}
+
 void StellaEnvironment::processScreen() {
 
   if (!m_colour_averaging) {
@@ -278,11 +416,7 @@ void StellaEnvironment::processScreen() {
 
 void StellaEnvironment::processRAM() {
 
-  // Copy RAM over
-  for (size_t i = 0; i < m_ram.size(); i++) {
-    unsigned int idx = static_cast<unsigned int>(i);
-    uInt16 idx2 = static_cast<uInt16>(i + 0x80);
-    *m_ram.byte(idx) = m_osystem->console().system().peek(idx2);
-  }
+  // Copy RAM over, straight from the RIOT
+  memcpy(m_ram.array(), getRAMView(), m_ram.size());
 }
 
@@ -38,9 +38,12 @@
 #include "ale_interface.hpp"
 #include "ale_state.hpp"
 #include "phosphor_blend.hpp"
+#include "shadow_environment.hpp"
 #include "emucore/OSystem.hxx"
 #include "emucore/Event.hxx"
 #include "games/RomSettings.hpp"
+#include "common/step_stats.hpp"
+#include "common/timeline.hpp"
 
 #include <stack>
 
@@ -52,6 +55,7 @@ namespace ale {
 class StellaEnvironment {
   public:
     StellaEnvironment(OSystem * system, RomSettings * settings);
+    ~StellaEnvironment();
 
     /** Resets the system to its start state. */
     void reset();
@@ -73,6 +77,17 @@ class StellaEnvironment {
       *  and performs one simulation step in Stella. Returns the resultant reward. */
     reward_t act(Action player_a_action, Action player_b_action);
 
+    /** act() in two parts, for drivers that emulate the frames of several environments
+      *  together (see ALEBatchInterface). beginAct() applies the actions and returns false
+      *  in a terminal state, where act() emulates nothing. Otherwise the driver runs the
+      *  frame, i.e. the TIA's update() or its parts, then calls endAct(), after which
+      *  everything is as act() would leave it. */
+    bool beginAct(Action player_a_action, Action player_b_action);
+    void endAct();
+
+    /** The console's system, for such drivers. */
+    System &system() { return m_osystem->console().system(); }
+
     /** Returns true once we reach a terminal state */
     bool isTerminal() const;
 
@@ -84,10 +99,34 @@ class StellaEnvironment {
     const ALEScreen &getScreen() const { return m_screen; }
     const ALERAM &getRAM() const { return m_ram; }
 
+    /** The console's RAM itself, getRAM().size() bytes, valid for the lifetime of
+      *  the environment. Unlike getRAM() it is not a copy taken after each step: it
+      *  changes as the emulator runs, and reflects restored states immediately. */
+    const byte_t *getRAMView() const;
+
+    /** Enables/disables screen rendering. While disabled the emulation proceeds exactly as
+      *  before (RAM, CPU and collision state are unaffected) but the TIA skips writing pixels
+      *  and getScreen() is left stale. Even when enabled, frames that cannot be observed
+      *  (e.g. the no-op frames of a reset) are not rendered. */
+    void enableRendering(bool mode) { m_rendering_enabled = mode; }
+
+    /** Time spent in each stage since the last resetStepStats(); all zero
+      *  unless built with __USE_STEP_STATS. */
+    void getStepStats(ALEStepStats &stats) const;
+    void resetStepStats();
+
     int getFrameNumber() const { return m_state.getFrameNumber(); } 
     int getEpisodeFrameNumber() const { return m_state.getEpisodeFrameNumber(); }
 
   private:
+    /** The micro-benchmarks (bench/ale_bench.cpp) time the private stages directly. */
+    friend class StellaEnvironmentBench;
+    /** The shadow drives its reference environment and compares it with this one. */
+    friend class ShadowEnvironment;
+
+    /** Resets, then runs noop_steps frames before pressing RESET. */
+    void reset(int noop_steps);
+
     /** Actually emulates the emulator for a given number of steps. */
     void emulate(Action player_a_action, Action player_b_action, size_t num_steps = 1);
 
@@ -95,11 +134,18 @@ class StellaEnvironment {
       *   from the minimal set of actions. */
     void noopIllegalActions(Action& player_a_action, Action& player_b_action);
 
+    /** Processes the emulator screen and RAM after the last frame of a step */
+    void observe();
+
     /** Processes the current emulator screen and saves it in m_screen */
     void processScreen();
     /** Processes the emulator RAM and saves it in m_ram */
     void processRAM();
 
+    /** Copying is explicitly disallowed. */
+    StellaEnvironment(const StellaEnvironment &);
+    StellaEnvironment &operator=(const StellaEnvironment &);
+
   private:
     OSystem * m_osystem;
     RomSettings * m_settings;
@@ -113,15 +159,27 @@ class StellaEnvironment {
     ALERAM m_ram; // The current ALE RAM
 
     bool m_use_paddles;  // Whether this game uses paddles
+    bool m_rendering_enabled; // Whether the screen is observed at all
+    bool m_render_all_frames; // Render even the frames that can't be observed
     
     /** Parameters loaded from Settings. */
     bool m_use_starting_actions; // Whether we run a set of starting actions after reset 
+    ActionVect m_starting_actions; // The ROM's starting actions
     int m_num_reset_steps; // Number of RESET frames per reset
     bool m_colour_averaging; // Whether to average frames
     bool m_stochastic_start; // Whether to "draw" the environment from a random distribution
     int m_max_num_frames_per_episode; // Maxmimum number of frames per episode 
 
     bool m_backward_compatible_save; // Enable the save/load mechanism from ALE 0.2 (no stack)
+
+    int m_trace_env; // Number of this environment in timeline traces
+
+    ShadowEnvironment *m_shadow; // Owned; set with -shadow_execution
+    Action m_act_a_action, m_act_b_action; // Of the act() under way, after noopIllegalActions()
+
+#ifdef __USE_STEP_STATS
+    mutable StepStats m_stats; // Also timed by cloneState()
+#endif
 };
 
 } // namespace ale
@@ -0,0 +1,444 @@
+/* *****************************************************************************
+ * Xitari
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ * *****************************************************************************
+ *  trajectory_dataset.cpp
+ *
+ *  Random access to a recorded trajectory file, for sampling minibatches.
+ **************************************************************************** */
+
+#include "trajectory_dataset.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+#include <zlib/zlib.h>
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ale {
+
+static const size_t NO_CHUNK = static_cast<size_t>(-1);
+
+
+TrajectoryDataset::TrajectoryDataset(const std::string &filename, int num_threads,
+                                     size_t cache_chunks) :
+    m_data(NULL),
+    m_size(0),
+    m_cache_chunks(cache_chunks > 0 ? cache_chunks : 1),
+    m_use(0),
+    m_num_threads(num_threads),
+    m_next_job(0),
+    m_busy_workers(0),
+    m_generation(0),
+    m_stopping(false),
+    m_failed(false) {
+    if (m_num_threads <= 0)
+        m_num_threads = std::max(1u, std::thread::hardware_concurrency());
+
+    // Index first, so that a missing one fails before anything is mapped
+    std::string index_name = filename + ".idx";
+    FILE *index = fopen(index_name.c_str(), "rb");
+    if (index == NULL)
+        throw std::runtime_error("Cannot open trajectory index " + index_name);
+    bool ok = fread(&m_index, sizeof(m_index), 1, index) == 1 &&
+              m_index.magic == TRAJECTORY_INDEX_MAGIC &&
+              m_index.version == TRAJECTORY_VERSION;
+    if (ok) {
+        m_chunks.resize(m_index.num_chunks);
+        m_episodes.resize(m_index.num_episodes);
+        ok = (m_chunks.empty() ||
+              fread(&m_chunks[0], sizeof(TrajectoryIndexChunk), m_chunks.size(), index) == m_chunks.size()) &&
+             (m_episodes.empty() ||
+              fread(&m_episodes[0], sizeof(TrajectoryIndexEpisode), m_episodes.size(), index) == m_episodes.size());
+    }
+    fclose(index);
+    if (!ok)
+        throw std::runtime_error(index_name + " is not a trajectory index");
+
+#ifndef WIN32
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error("Cannot open trajectory file " + filename);
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        m_size = st.st_size;
+        void *data = mmap(NULL, m_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (data != MAP_FAILED) {
+            m_data = static_cast<const uInt8*>(data);
+            // Minibatches jump all over the file
+            madvise(data, m_size, MADV_RANDOM);
+        }
+    }
+    ::close(fd);
+#else
+    FILE *file = fopen(filename.c_str(), "rb");
+    if (file == NULL)
+        throw std::runtime_error("Cannot open trajectory file " + filename);
+    fseek(file, 0, SEEK_END);
+    m_contents.resize(ftell(file));
+    fseek(file, 0, SEEK_SET);
+    if (!m_contents.empty() && fread(&m_contents[0], m_contents.size(), 1, file) == 1) {
+        m_data = &m_contents[0];
+        m_size = m_contents.size();
+    }
+    fclose(file);
+#endif
+    // The destructor won't run if this throws, so unmap before throwing
+    std::string error;
+    if (m_data == NULL || m_size < sizeof(m_header)) {
+        error = "Cannot map trajectory file " + filename;
+    } else {
+        memcpy(&m_header, m_data, sizeof(m_header));
+        if (m_header.magic != TRAJECTORY_MAGIC || m_header.version != TRAJECTORY_VERSION)
+            error = filename + " is not a trajectory file";
+        else if (!trajectoryHeaderValid(m_header))
+            error = filename + " has a malformed header";
+        else if (!indexMatches())
+            error = index_name + " does not match " + filename;
+    }
+    if (!error.empty()) {
+#ifndef WIN32
+        if (m_data != NULL)
+            munmap(const_cast<uInt8*>(m_data), m_size);
+#endif
+        throw std::runtime_error(error);
+    }
+
+    m_records.assign(m_chunks.size(), NULL);
+}
+
+
+bool TrajectoryDataset::indexMatches() const {
+    // Checked once, so that lookups needn't
+    ::uint64_t next_step = 0;
+    for (size_t c = 0; c < m_chunks.size(); c++) {
+        const TrajectoryIndexChunk &chunk = m_chunks[c];
+        if (chunk.first_step != next_step || chunk.num_steps > m_header.steps_per_chunk ||
+            chunk.offset > m_size || chunk.payload_size > m_size - chunk.offset)
+            return false;
+        next_step += chunk.num_steps;
+    }
+    return next_step == m_index.num_steps;
+}
+
+
+TrajectoryDataset::~TrajectoryDataset() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_work_ready.notify_all();
+    for (size_t i = 0; i < m_workers.size(); i++)
+        m_workers[i].join();
+
+#ifndef WIN32
+    if (m_data != NULL)
+        munmap(const_cast<uInt8*>(m_data), m_size);
+#endif
+}
+
+
+size_t TrajectoryDataset::observationSize() const {
+    if (m_header.flags & TRAJECTORY_SCREENS)
+        return m_header.width * m_header.height;
+    return m_header.ram_size;
+}
+
+
+size_t TrajectoryDataset::chunkOf(::uint64_t t) const {
+    // Every chunk but the last is full, which gives the answer directly
+    size_t c = t / m_header.steps_per_chunk;
+    if (c < m_chunks.size() && m_chunks[c].first_step <= t &&
+        t < m_chunks[c].first_step + m_chunks[c].num_steps)
+        return c;
+
+    size_t lo = 0, hi = m_chunks.size();
+    while (hi - lo > 1) {
+        size_t mid = (lo + hi) / 2;
+        if (m_chunks[mid].first_step <= t) lo = mid;
+        else hi = mid;
+    }
+    return lo;
+}
+
+
+::uint64_t TrajectoryDataset::episodeStart(::uint64_t t) const {
+    size_t lo = 0, hi = m_episodes.size();
+    if (hi == 0) return 0;
+    while (hi - lo > 1) {
+        size_t mid = (lo + hi) / 2;
+        if (m_episodes[mid].first_step <= t) lo = mid;
+        else hi = mid;
+    }
+    return m_episodes[lo].first_step;
+}
+
+
+void TrajectoryDataset::decodeChunk(size_t c, std::vector<uInt8> &records) const {
+    const TrajectoryIndexChunk &chunk = m_chunks[c];
+    uLong raw_size = chunk.num_steps * m_header.record_size;
+    const uInt8 *payload = m_data + chunk.offset;
+
+    if (chunk.compression != TRAJECTORY_STORED) {
+        std::vector<uInt8> scratch;
+        records.resize(m_header.steps_per_chunk * m_header.record_size);
+        if (!decodeTrajectoryChunk(m_header, chunk.compression, chunk.num_steps, payload,
+                                   chunk.payload_size, &records[0], scratch))
+            throw std::runtime_error("Corrupt trajectory chunk");
+        payload = &records[0];
+    }
+    else if (chunk.payload_size != raw_size)
+        throw std::runtime_error("Corrupt trajectory chunk");
+
+    if (crc32(0L, payload, raw_size) != chunk.checksum)
+        throw std::runtime_error("Trajectory chunk fails its checksum");
+}
+
+
+void TrajectoryDataset::loadChunks(const std::vector<size_t> &chunks) {
+    m_use++;
+
+    // Stored chunks need only be checked, the first time round. Compressed
+    //  ones already cached are kept from eviction for this batch.
+    std::vector<size_t> missing;
+    m_jobs.clear();
+    for (size_t i = 0; i < chunks.size(); i++) {
+        size_t c = chunks[i];
+        if (m_chunks[c].compression == TRAJECTORY_STORED) {
+            if (m_records[c] == NULL)
+                m_jobs.push_back(std::make_pair(c, NO_CHUNK));
+        }
+        else if (m_records[c] == NULL)
+            missing.push_back(c);
+    }
+    for (size_t s = 0; s < m_cache.size(); s++) {
+        if (m_cache[s].chunk != NO_CHUNK && m_records[m_cache[s].chunk] != NULL &&
+            std::binary_search(chunks.begin(), chunks.end(), m_cache[s].chunk))
+            m_cache[s].last_use = m_use;
+    }
+
+    // Give each missing chunk a free slot, else the least recently used one
+    //  this batch doesn't need, else a new one
+    for (size_t i = 0; i < missing.size(); i++) {
+        size_t slot = NO_CHUNK;
+        for (size_t s = 0; s < m_cache.size() && slot == NO_CHUNK; s++) {
+            if (m_cache[s].chunk == NO_CHUNK)
+                slot = s;
+        }
+        if (slot == NO_CHUNK && m_cache.size() < m_cache_chunks) {
+            m_cache.push_back(CacheSlot());
+            slot = m_cache.size() - 1;
+        }
+        if (slot == NO_CHUNK) {
+            for (size_t s = 0; s < m_cache.size(); s++) {
+                if (m_cache[s].last_use != m_use &&
+                    (slot == NO_CHUNK || m_cache[s].last_use < m_cache[slot].last_use))
+                    slot = s;
+            }
+        }
+        if (slot == NO_CHUNK) {
+            m_cache.push_back(CacheSlot());
+            slot = m_cache.size() - 1;
+        }
+        else if (m_cache[slot].chunk != NO_CHUNK)
+            m_records[m_cache[slot].chunk] = NULL;
+
+        m_cache[slot].chunk = missing[i];
+        m_cache[slot].last_use = m_use;
+        m_jobs.push_back(std::make_pair(missing[i], slot));
+    }
+
+    if (m_jobs.empty())
+        return;
+
+    try {
+        runJobs();
+    }
+    catch (const std::exception &) {
+        for (size_t j = 0; j < m_jobs.size(); j++) {
+            if (m_jobs[j].second != NO_CHUNK)
+                m_cache[m_jobs[j].second].chunk = NO_CHUNK;
+        }
+        throw;
+    }
+
+    // Only now that the cache has stopped growing are the slots' addresses final
+    for (size_t j = 0; j < m_jobs.size(); j++) {
+        size_t c = m_jobs[j].first, slot = m_jobs[j].second;
+        m_records[c] = (slot == NO_CHUNK) ? m_data + m_chunks[c].offset : &m_cache[slot].records[0];
+    }
+}
+
+
+void TrajectoryDataset::runJobs() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_next_job = 0;
+        m_failed = false;
+    }
+
+    // A single chunk isn't worth waking the pool for
+    if (m_jobs.size() > 1 && m_num_threads > 1) {
+        if (m_workers.empty()) {
+            for (int i = 1; i < m_num_threads; i++)
+                m_workers.push_back(std::thread(&TrajectoryDataset::work, this));
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_busy_workers = m_workers.size();
+            m_generation++;
+        }
+        m_work_ready.notify_all();
+        drainJobs();
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_work_done.wait(lock, [this] { return m_busy_workers == 0; });
+    }
+    else
+        drainJobs();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_failed)
+        throw std::runtime_error(m_error);
+}
+
+
+void TrajectoryDataset::work() {
+    uInt32 generation = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_work_ready.wait(lock, [&] { return m_stopping || m_generation != generation; });
+            if (m_stopping) return;
+            generation = m_generation;
+        }
+
+        drainJobs();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (--m_busy_workers == 0)
+            m_work_done.notify_one();
+    }
+}
+
+
+void TrajectoryDataset::drainJobs() {
+    for (;;) {
+        size_t j;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_failed || m_next_job >= m_jobs.size()) return;
+            j = m_next_job++;
+        }
+
+        size_t slot = m_jobs[j].second;
+        try {
+            std::vector<uInt8> unused;
+            decodeChunk(m_jobs[j].first, slot == NO_CHUNK ? unused : m_cache[slot].records);
+        }
+        catch (const std::exception &e) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_failed) {
+                m_failed = true;
+                m_error = e.what();
+            }
+        }
+    }
+}
+
+
+const uInt8 *TrajectoryDataset::record(::uint64_t t) const {
+    size_t c = chunkOf(t);
+    return m_records[c] + (t - m_chunks[c].first_step) * m_header.record_size;
+}
+
+
+void TrajectoryDataset::getStep(::uint64_t t, TrajectoryStep &step, uInt8 *ram, uInt8 *screen) {
+    if (t >= m_index.num_steps)
+        throw std::runtime_error("Trajectory step out of range");
+    loadChunks(std::vector<size_t>(1, chunkOf(t)));
+
+    // Records aren't aligned, so everything is copied out
+    const uInt8 *data = record(t);
+    memcpy(&step, data, sizeof(step));
+    data += sizeof(step);
+    memcpy(ram, data, m_header.ram_size);
+    data += m_header.ram_size;
+    if (screen != NULL && (m_header.flags & TRAJECTORY_SCREENS))
+        memcpy(screen, data, m_header.width * m_header.height);
+}
+
+
+void TrajectoryDataset::getBatch(const ::uint64_t *steps, size_t n, int stack, uInt8 *frames,
+                                 Int32 *actions_a, Int32 *actions_b,
+                                 double *rewards_a, double *rewards_b) {
+    if (stack < 1) stack = 1;
+
+    // Every observation of a stack lies between its episode's start and
+    //  its step, so the chunks of those two bound the chunks needed
+    std::vector<::uint64_t> starts(n);
+    std::vector<size_t> chunks;
+    for (size_t i = 0; i < n; i++) {
+        if (steps[i] >= m_index.num_steps)
+            throw std::runtime_error("Trajectory step out of range");
+        starts[i] = episodeStart(steps[i]);
+        ::uint64_t first = steps[i] - std::min<::uint64_t>(steps[i] - starts[i], stack - 1);
+        for (size_t c = chunkOf(first), last = chunkOf(steps[i]); c <= last; c++)
+            chunks.push_back(c);
+    }
+    std::sort(chunks.begin(), chunks.end());
+    chunks.erase(std::unique(chunks.begin(), chunks.end()), chunks.end());
+    loadChunks(chunks);
+
+    const size_t obs_size = observationSize();
+    const size_t obs_offset = sizeof(TrajectoryStep) +
+        ((m_header.flags & TRAJECTORY_SCREENS) ? m_header.ram_size : 0);
+
+    for (size_t i = 0; i < n; i++) {
+        const ::uint64_t t = steps[i];
+        if (frames != NULL) {
+            uInt8 *out = frames + i * stack * obs_size;
+            for (int k = 0; k < stack; k++) {
+                ::uint64_t back = stack - 1 - k;
+                ::uint64_t s = (t - starts[i] >= back) ? t - back : starts[i];
+                memcpy(out + k * obs_size, record(s) + obs_offset, obs_size);
+            }
+        }
+
+        TrajectoryStep step;
+        memcpy(&step, record(t), sizeof(step));
+        if (actions_a != NULL) actions_a[i] = step.action_a;
+        if (actions_b != NULL) actions_b[i] = step.action_b;
+        if (rewards_a != NULL) rewards_a[i] = step.reward_a;
+        if (rewards_b != NULL) rewards_b[i] = step.reward_b;
+    }
+
+    // Let the cache shrink back once an oversized batch is done with it
+    while (m_cache.size() > m_cache_chunks) {
+        if (m_cache.back().chunk != NO_CHUNK)
+            m_records[m_cache.back().chunk] = NULL;
+        m_cache.pop_back();
+    }
+}
+
+} // namespace ale
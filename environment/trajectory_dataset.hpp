@@ -0,0 +1,151 @@
+/* *****************************************************************************
+ * Xitari
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ * *****************************************************************************
+ *  trajectory_dataset.hpp
+ *
+ *  Random access to a recorded trajectory file, for sampling minibatches.
+ *
+ *  The file is memory-mapped and located through its "<file>.idx" index
+ *  (see trajectory_recorder.hpp). Records of stored chunks are read where
+ *  they lie in the mapping; compressed chunks are decoded, by a pool of
+ *  threads kept for the life of the dataset, into a cache of decoded
+ *  chunks.
+ *
+ *  Only stored chunks are read without decoding them first, and even then
+ *  nothing is handed out in place: records follow each other at a fixed
+ *  stride, but neither the stride nor the chunk payloads are aligned, so
+ *  every field and observation is copied out with memcpy.
+ **************************************************************************** */
+
+#ifndef __TRAJECTORY_DATASET_HPP__
+#define __TRAJECTORY_DATASET_HPP__
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "trajectory_recorder.hpp"
+
+namespace ale {
+
+
+class TrajectoryDataset {
+
+    public:
+
+        /** Maps filename and reads its index; throws std::runtime_error if
+            either is missing or malformed. num_threads decode compressed
+            chunks (0: one per core), the calling thread among them; the
+            others are started the first time there is more than one chunk
+            to decode. At most cache_chunks decoded chunks are kept between
+            batches. */
+        TrajectoryDataset(const std::string &filename, int num_threads = 0,
+                          size_t cache_chunks = 256);
+
+        ~TrajectoryDataset();
+
+        const TrajectoryFileHeader &header() const { return m_header; }
+
+        ::uint64_t numSteps() const { return m_index.num_steps; }
+        size_t numEpisodes() const { return m_episodes.size(); }
+        const TrajectoryIndexEpisode &episode(size_t i) const { return m_episodes[i]; }
+
+        /** Bytes of one observation: the screen if the file has screens,
+            the RAM otherwise. */
+        size_t observationSize() const;
+
+        /** Reads step t into step, ram (ram_size bytes) and, if not NULL and
+            the file has screens, screen. */
+        void getStep(::uint64_t t, TrajectoryStep &step, uInt8 *ram, uInt8 *screen);
+
+        /** Gathers a minibatch of n steps. For each steps[i], frames receives
+            the observations of steps[i] - stack + 1 ... steps[i], oldest
+            first (stack * observationSize() bytes), repeating the first
+            observation of the episode where the stack reaches before it;
+            the other arrays, each optional, receive the step's actions and
+            rewards. Throws std::runtime_error on a corrupt chunk. */
+        void getBatch(const ::uint64_t *steps, size_t n, int stack, uInt8 *frames,
+                      Int32 *actions_a, Int32 *actions_b,
+                      double *rewards_a, double *rewards_b);
+
+    private:
+
+        struct CacheSlot {
+            CacheSlot() : chunk(static_cast<size_t>(-1)), last_use(0) {}
+            std::vector<uInt8> records;
+            size_t chunk;               // Decoded chunk, or -1
+            ::uint64_t last_use;
+        };
+
+        /** Whether the index describes chunks that lie within the file. */
+        bool indexMatches() const;
+        /** Index of the chunk holding step t. */
+        size_t chunkOf(::uint64_t t) const;
+        /** First step of the episode holding step t. */
+        ::uint64_t episodeStart(::uint64_t t) const;
+        /** Makes every chunk in chunks readable through m_records. */
+        void loadChunks(const std::vector<size_t> &chunks);
+        /** Runs m_jobs on this thread and the pool's; throws the first
+            error any of them hit. */
+        void runJobs();
+        /** Worker thread body. */
+        void work();
+        /** Decodes jobs until none are left. */
+        void drainJobs();
+        void decodeChunk(size_t chunk, std::vector<uInt8> &records) const;
+        /** Record of step t; its chunk must be loaded. */
+        const uInt8 *record(::uint64_t t) const;
+
+        /** Copying is explicitly disallowed. */
+        TrajectoryDataset(const TrajectoryDataset &);
+        TrajectoryDataset &operator=(const TrajectoryDataset &);
+
+        TrajectoryFileHeader m_header;
+        TrajectoryIndexHeader m_index;
+        std::vector<TrajectoryIndexChunk> m_chunks;
+        std::vector<TrajectoryIndexEpisode> m_episodes;
+
+        const uInt8 *m_data;            // The whole file
+        size_t m_size;
+        std::vector<uInt8> m_contents;  // Backs m_data where there is no mmap
+
+        // Where each chunk's records are: in the mapping for stored chunks,
+        //  in a cache slot for decoded ones, NULL otherwise
+        std::vector<const uInt8*> m_records;
+        std::vector<CacheSlot> m_cache;
+        size_t m_cache_chunks;
+        ::uint64_t m_use;
+        int m_num_threads;
+
+        // Worker pool, and the (chunk, cache slot) jobs of the current batch
+        std::vector<std::thread> m_workers;
+        std::mutex m_mutex;
+        std::condition_variable m_work_ready;
+        std::condition_variable m_work_done;
+        std::vector<std::pair<size_t, size_t> > m_jobs;
+        size_t m_next_job;              // Guarded by m_mutex
+        size_t m_busy_workers;          // Guarded by m_mutex
+        uInt32 m_generation;            // Bumped for every batch
+        bool m_stopping;
+        bool m_failed;                  // Guarded by m_mutex
+        std::string m_error;            // Guarded by m_mutex
+};
+
+} // namespace ale
+
+#endif // __TRAJECTORY_DATASET_HPP__
@@ -0,0 +1,524 @@
+/* *****************************************************************************
+ * Xitari
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ * *****************************************************************************
+ *  trajectory_recorder.cpp
+ *
+ *  Records steps of an environment to a chunked, zlib-compressed file, and
+ *  reads them back.
+ **************************************************************************** */
+
+#include "trajectory_recorder.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <zlib/zlib.h>
+
+namespace ale {
+
+// Chunks that may wait for the writer thread before record() has to
+#define TRAJECTORY_QUEUE_SIZE 256
+
+
+// Largest a chunk of TRAJECTORY_DELTA or TRAJECTORY_PALETTE steps can get
+// before it is deflated
+static size_t encodedChunkBound(const TrajectoryFileHeader &header, uInt32 compression) {
+    size_t screen_size = header.width * header.height;
+    size_t fixed_size = header.record_size - screen_size;
+    if (compression == TRAJECTORY_PALETTE)
+        return 2 * sizeof(uInt32) + 256 + (fixed_size + screen_size) * header.steps_per_chunk;
+    size_t step_size = fixed_size + sizeof(uInt32) + ScreenDeltaEncoder::maxEncodedSize(screen_size);
+    return step_size * header.steps_per_chunk;
+}
+
+
+// Rebuilds each step's screen on top of the previous one
+static bool decodeDeltas(const TrajectoryFileHeader &header, uInt32 num_steps,
+                         const uInt8 *data, const uInt8 *end, uInt8 *records) {
+    const size_t screen_size = header.width * header.height;
+    const size_t fixed_size = header.record_size - screen_size;
+    ScreenDeltaDecoder decoder(screen_size);
+    for (uInt32 i = 0; i < num_steps; i++) {
+        uInt32 length;
+        if (static_cast<size_t>(end - data) < fixed_size + sizeof(length))
+            return false;
+        uInt8 *record = records + i * header.record_size;
+        memcpy(record, data, fixed_size);
+        memcpy(&length, data + fixed_size, sizeof(length));
+        data += fixed_size + sizeof(length);
+        if (length > static_cast<size_t>(end - data) || !decoder.decode(data, length))
+            return false;
+        memcpy(record + fixed_size, decoder.frame(), screen_size);
+        data += length;
+    }
+    return data == end;
+}
+
+
+// Maps each step's packed codes back through the chunk's palette; codes
+// holds codesBufferSize() of a screen
+static bool decodePalette(const TrajectoryFileHeader &header, uInt32 num_steps,
+                          const uInt8 *data, const uInt8 *end, uInt8 *records,
+                          uInt8 *codes) {
+    const size_t screen_size = header.width * header.height;
+    const size_t fixed_size = header.record_size - screen_size;
+
+    uInt32 num_colours, bits;
+    if (static_cast<size_t>(end - data) < sizeof(num_colours))
+        return false;
+    memcpy(&num_colours, data, sizeof(num_colours));
+    data += sizeof(num_colours);
+    if (num_colours > 256 || static_cast<size_t>(end - data) < num_colours + sizeof(bits))
+        return false;
+    const uInt8 *colours = data;
+    memcpy(&bits, data + num_colours, sizeof(bits));
+    data += num_colours + sizeof(bits);
+    if (bits != 1 && bits != 2 && bits != 4 && bits != 8)
+        return false;
+
+    const size_t packed_size = packedCodesSize(screen_size, bits);
+    for (uInt32 i = 0; i < num_steps; i++) {
+        if (static_cast<size_t>(end - data) < fixed_size + packed_size)
+            return false;
+        uInt8 *record = records + i * header.record_size;
+        memcpy(record, data, fixed_size);
+        memcpy(codes, data + fixed_size, packed_size);
+        data += fixed_size + packed_size;
+
+        unpackCodes(codes, screen_size, bits);
+        uInt8 *screen = record + fixed_size;
+        for (size_t p = 0; p < screen_size; p++) {
+            if (codes[p] >= num_colours)
+                return false;
+            screen[p] = colours[codes[p]];
+        }
+    }
+    return data == end;
+}
+
+
+::uint64_t trajectoryRecordSize(uInt32 flags, uInt32 ram_size, uInt32 width, uInt32 height) {
+    ::uint64_t screen_size = (flags & TRAJECTORY_SCREENS) ? (::uint64_t)width * height : 0;
+    return sizeof(TrajectoryStep) + (::uint64_t)ram_size + screen_size;
+}
+
+
+bool trajectoryHeaderValid(const TrajectoryFileHeader &header) {
+    ::uint64_t record_size = trajectoryRecordSize(header.flags, header.ram_size,
+                                                  header.width, header.height);
+    return header.steps_per_chunk > 0 && header.record_size == record_size &&
+        record_size * header.steps_per_chunk <= 0xFFFFFFFFu;
+}
+
+
+bool decodeTrajectoryChunk(const TrajectoryFileHeader &header, uInt32 compression,
+                           uInt32 num_steps, const uInt8 *payload, uInt32 payload_size,
+                           uInt8 *records, std::vector<uInt8> &scratch) {
+    uLong raw_size = num_steps * header.record_size;
+    if (num_steps > header.steps_per_chunk)
+        return false;
+
+    if (compression == TRAJECTORY_STORED) {
+        if (payload_size != raw_size)
+            return false;
+        memcpy(records, payload, raw_size);
+        return true;
+    }
+    if (compression == TRAJECTORY_ZLIB) {
+        uLongf size = header.steps_per_chunk * header.record_size;
+        return uncompress(records, &size, payload, payload_size) == Z_OK && size == raw_size;
+    }
+    if ((compression != TRAJECTORY_DELTA && compression != TRAJECTORY_PALETTE) ||
+        !(header.flags & TRAJECTORY_SCREENS))
+        return false;
+
+    // The encoded chunk, then room to unpack a screen's codes in
+    size_t bound = encodedChunkBound(header, compression);
+    scratch.resize(bound + codesBufferSize(header.width * header.height));
+    uLongf size = bound;
+    if (uncompress(&scratch[0], &size, payload, payload_size) != Z_OK)
+        return false;
+
+    const uInt8 *data = &scratch[0], *end = data + size;
+    if (compression == TRAJECTORY_DELTA)
+        return decodeDeltas(header, num_steps, data, end, records);
+    return decodePalette(header, num_steps, data, end, records, &scratch[bound]);
+}
+
+
+TrajectoryWriter::TrajectoryWriter(const std::string &filename, uInt32 ram_size,
+                                   uInt32 width, uInt32 height, bool screens,
+                                   uInt32 steps_per_chunk, uInt32 compression) :
+    m_filename(filename),
+    m_compression(compression),
+    m_file(NULL),
+    m_chunk(NULL),
+    m_num_steps(0),
+    m_offset(sizeof(TrajectoryFileHeader)),
+    m_last_episode_frame(0),
+    m_full(TRAJECTORY_QUEUE_SIZE),
+    m_full_head(0),
+    m_full_tail(0),
+    m_free(TRAJECTORY_QUEUE_SIZE),
+    m_free_head(0),
+    m_free_tail(0),
+    m_delta(screens ? width * height : 0),
+    m_closing(false),
+    m_closed(false) {
+    memset(&m_header, 0, sizeof(m_header));
+    m_header.magic = TRAJECTORY_MAGIC;
+    m_header.version = TRAJECTORY_VERSION;
+    m_header.flags = screens ? TRAJECTORY_SCREENS : 0;
+    m_header.ram_size = ram_size;
+    m_header.width = width;
+    m_header.height = height;
+    m_header.record_size = trajectoryRecordSize(m_header.flags, ram_size, width, height);
+    m_header.steps_per_chunk = steps_per_chunk > 0 ? steps_per_chunk : 1;
+    if ((m_compression == TRAJECTORY_DELTA || m_compression == TRAJECTORY_PALETTE) && !screens)
+        m_compression = TRAJECTORY_ZLIB;
+
+    m_file = fopen(filename.c_str(), "wb");
+    if (m_file == NULL)
+        throw std::runtime_error("Cannot create trajectory file " + filename);
+    if (fwrite(&m_header, sizeof(m_header), 1, m_file) != 1) {
+        fclose(m_file);
+        throw std::runtime_error("Cannot write trajectory file " + filename);
+    }
+
+    m_chunk = new Chunk();
+    m_chunk->records.resize(m_header.record_size * m_header.steps_per_chunk);
+    m_chunk->num_steps = 0;
+    if (m_compression == TRAJECTORY_DELTA || m_compression == TRAJECTORY_PALETTE) {
+        m_encoded.resize(encodedChunkBound(m_header, m_compression));
+        m_compressed.resize(compressBound(m_encoded.size()));
+    }
+    if (m_compression == TRAJECTORY_PALETTE)
+        m_codes.resize(m_header.steps_per_chunk * codesBufferSize(width * height));
+    else
+        m_compressed.resize(compressBound(m_chunk->records.size()));
+
+    m_thread = std::thread(&TrajectoryWriter::writeLoop, this);
+}
+
+
+TrajectoryWriter::~TrajectoryWriter() {
+    try {
+        close();
+    }
+    catch (const std::exception &) {
+        // Destructors mustn't throw; callers who care call close() first
+    }
+}
+
+
+void TrajectoryWriter::record(const TrajectoryStep &step, const uInt8 *ram,
+                              const uInt8 *screen) {
+    if (m_index_episodes.empty() || step.episode_frame <= m_last_episode_frame) {
+        TrajectoryIndexEpisode episode = { m_num_steps, 0 };
+        m_index_episodes.push_back(episode);
+    }
+    m_index_episodes.back().num_steps++;
+    m_last_episode_frame = step.episode_frame;
+    m_num_steps++;
+
+    uInt8 *data = &m_chunk->records[m_chunk->num_steps * m_header.record_size];
+    memcpy(data, &step, sizeof(step));
+    data += sizeof(step);
+    memcpy(data, ram, m_header.ram_size);
+    data += m_header.ram_size;
+    if (recordsScreens())
+        memcpy(data, screen, m_header.width * m_header.height);
+
+    if (++m_chunk->num_steps == m_header.steps_per_chunk)
+        submit();
+}
+
+
+void TrajectoryWriter::submit() {
+    // Wait only if the writer has fallen a whole queue behind
+    size_t head = m_full_head.load(std::memory_order_relaxed);
+    while (head - m_full_tail.load(std::memory_order_acquire) >= m_full.size())
+        std::this_thread::yield();
+    m_full[head % m_full.size()] = m_chunk;
+    m_full_head.store(head + 1, std::memory_order_release);
+
+    // Reuse a chunk the writer is done with, if there is one
+    size_t tail = m_free_tail.load(std::memory_order_relaxed);
+    if (tail != m_free_head.load(std::memory_order_acquire)) {
+        m_chunk = m_free[tail % m_free.size()];
+        m_free_tail.store(tail + 1, std::memory_order_release);
+    }
+    else {
+        m_chunk = new Chunk();
+        m_chunk->records.resize(m_header.record_size * m_header.steps_per_chunk);
+    }
+    m_chunk->num_steps = 0;
+}
+
+
+void TrajectoryWriter::writeLoop() {
+    for (;;) {
+        size_t tail = m_full_tail.load(std::memory_order_relaxed);
+        if (tail == m_full_head.load(std::memory_order_acquire)) {
+            // Everything submitted before closing is in the queue by now
+            if (m_closing.load() && tail == m_full_head.load(std::memory_order_acquire))
+                return;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+
+        Chunk *chunk = m_full[tail % m_full.size()];
+        m_full_tail.store(tail + 1, std::memory_order_release);
+        writeChunk(chunk);
+
+        size_t head = m_free_head.load(std::memory_order_relaxed);
+        if (head - m_free_tail.load(std::memory_order_acquire) < m_free.size()) {
+            m_free[head % m_free.size()] = chunk;
+            m_free_head.store(head + 1, std::memory_order_release);
+        }
+        else
+            delete chunk;
+    }
+}
+
+
+void TrajectoryWriter::writeChunk(Chunk *chunk) {
+    // The file is broken past the first failure, so later chunks are dropped
+    if (!m_error.empty())
+        return;
+
+    uLong raw_size = chunk->num_steps * m_header.record_size;
+
+    TrajectoryChunkHeader header;
+    header.magic = TRAJECTORY_CHUNK_MAGIC;
+    header.num_steps = chunk->num_steps;
+    header.checksum = crc32(0L, &chunk->records[0], raw_size);
+
+    // Keep the chunk as is if compression doesn't pay
+    const uInt8 *input = &chunk->records[0];
+    uLong input_size = raw_size;
+    if (m_compression == TRAJECTORY_DELTA) {
+        input = &m_encoded[0];
+        input_size = encodeDeltas(chunk);
+    }
+    else if (m_compression == TRAJECTORY_PALETTE) {
+        input = &m_encoded[0];
+        input_size = encodePalette(chunk);
+    }
+    uLongf compressed_size = m_compressed.size();
+    const uInt8 *payload = &chunk->records[0];
+    header.compression = TRAJECTORY_STORED;
+    header.payload_size = raw_size;
+    if (m_compression != TRAJECTORY_STORED &&
+        compress2(&m_compressed[0], &compressed_size, input, input_size,
+                  Z_BEST_SPEED) == Z_OK && compressed_size < raw_size) {
+        payload = &m_compressed[0];
+        header.compression = m_compression;
+        header.payload_size = compressed_size;
+    }
+
+    if (fwrite(&header, sizeof(header), 1, m_file) != 1 ||
+        fwrite(payload, header.payload_size, 1, m_file) != 1) {
+        m_error = "Cannot write trajectory file " + m_filename;
+        return;
+    }
+
+    TrajectoryIndexChunk entry;
+    entry.offset = m_offset + sizeof(header);
+    entry.first_step = m_index_chunks.empty() ? 0 :
+        m_index_chunks.back().first_step + m_index_chunks.back().num_steps;
+    entry.num_steps = header.num_steps;
+    entry.compression = header.compression;
+    entry.payload_size = header.payload_size;
+    entry.checksum = header.checksum;
+    m_index_chunks.push_back(entry);
+    m_offset += sizeof(header) + header.payload_size;
+}
+
+
+size_t TrajectoryWriter::encodeDeltas(const Chunk *chunk) {
+    const size_t screen_size = m_header.width * m_header.height;
+    const size_t fixed_size = m_header.record_size - screen_size;
+
+    // Every chunk starts from scratch, so that it decodes on its own
+    m_delta.reset();
+    uInt8 *out = &m_encoded[0];
+    for (uInt32 i = 0; i < chunk->num_steps; i++) {
+        const uInt8 *record = &chunk->records[i * m_header.record_size];
+        memcpy(out, record, fixed_size);
+        out += fixed_size;
+        uInt32 length = m_delta.encode(record + fixed_size, out + sizeof(length));
+        memcpy(out, &length, sizeof(length));
+        out += sizeof(length) + length;
+    }
+    return out - &m_encoded[0];
+}
+
+
+size_t TrajectoryWriter::encodePalette(const Chunk *chunk) {
+    const size_t screen_size = m_header.width * m_header.height;
+    const size_t fixed_size = m_header.record_size - screen_size;
+    const size_t codes_size = codesBufferSize(screen_size);
+
+    // The code width is only known once every screen of the chunk is in
+    //  the palette, which starts afresh so that it is as narrow as can be
+    m_palette.clear();
+    for (uInt32 i = 0; i < chunk->num_steps; i++)
+        m_palette.compact(&chunk->records[i * m_header.record_size + fixed_size],
+                          screen_size, &m_codes[i * codes_size]);
+    uInt32 num_colours = m_palette.size(), bits = m_palette.codeBits();
+
+    uInt8 *out = &m_encoded[0];
+    memcpy(out, &num_colours, sizeof(num_colours));
+    out += sizeof(num_colours);
+    for (uInt32 c = 0; c < num_colours; c++)
+        *out++ = m_palette.colour(c);
+    memcpy(out, &bits, sizeof(bits));
+    out += sizeof(bits);
+
+    for (uInt32 i = 0; i < chunk->num_steps; i++) {
+        memcpy(out, &chunk->records[i * m_header.record_size], fixed_size);
+        out += fixed_size;
+        size_t packed_size = packCodes(&m_codes[i * codes_size], screen_size, bits);
+        memcpy(out, &m_codes[i * codes_size], packed_size);
+        out += packed_size;
+    }
+    return out - &m_encoded[0];
+}
+
+
+void TrajectoryWriter::close() {
+    if (m_closed) return;
+    m_closed = true;
+
+    if (m_chunk->num_steps > 0)
+        submit();
+    m_closing.store(true);
+    m_thread.join();
+
+    // fclose() flushes, so it can fail as well
+    if (fclose(m_file) != 0 && m_error.empty())
+        m_error = "Cannot write trajectory file " + m_filename;
+    if (m_error.empty())
+        writeIndex();
+    delete m_chunk;
+    for (size_t i = m_free_tail.load(); i != m_free_head.load(); i++)
+        delete m_free[i % m_free.size()];
+
+    if (!m_error.empty())
+        throw std::runtime_error(m_error);
+}
+
+
+void TrajectoryWriter::writeIndex() {
+    std::string filename = m_filename + ".idx";
+    FILE *file = fopen(filename.c_str(), "wb");
+    if (file == NULL) {
+        m_error = "Cannot create trajectory index " + filename;
+        return;
+    }
+
+    TrajectoryIndexHeader header;
+    header.magic = TRAJECTORY_INDEX_MAGIC;
+    header.version = TRAJECTORY_VERSION;
+    header.num_chunks = m_index_chunks.size();
+    header.num_episodes = m_index_episodes.size();
+    header.num_steps = m_num_steps;
+
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+        (m_index_chunks.empty() ||
+         fwrite(&m_index_chunks[0], sizeof(TrajectoryIndexChunk), m_index_chunks.size(), file) == m_index_chunks.size()) &&
+        (m_index_episodes.empty() ||
+         fwrite(&m_index_episodes[0], sizeof(TrajectoryIndexEpisode), m_index_episodes.size(), file) == m_index_episodes.size());
+    if (fclose(file) != 0 || !ok)
+        m_error = "Cannot write trajectory index " + filename;
+}
+
+
+TrajectoryReader::TrajectoryReader(const std::string &filename) :
+    m_file(NULL),
+    m_num_steps(0),
+    m_next_step(0) {
+    m_file = fopen(filename.c_str(), "rb");
+    if (m_file == NULL)
+        throw std::runtime_error("Cannot open trajectory file " + filename);
+
+    if (fread(&m_header, sizeof(m_header), 1, m_file) != 1 ||
+        m_header.magic != TRAJECTORY_MAGIC || m_header.version != TRAJECTORY_VERSION) {
+        fclose(m_file);
+        throw std::runtime_error(filename + " is not a trajectory file");
+    }
+    if (!trajectoryHeaderValid(m_header)) {
+        fclose(m_file);
+        throw std::runtime_error(filename + " has a malformed header");
+    }
+
+    m_records.resize(m_header.record_size * m_header.steps_per_chunk);
+}
+
+
+TrajectoryReader::~TrajectoryReader() {
+    fclose(m_file);
+}
+
+
+bool TrajectoryReader::loadChunk() {
+    TrajectoryChunkHeader header;
+    if (fread(&header, sizeof(header), 1, m_file) != 1)
+        return false;
+
+    uLong raw_size = header.num_steps * m_header.record_size;
+    if (header.magic != TRAJECTORY_CHUNK_MAGIC || header.num_steps > m_header.steps_per_chunk)
+        throw std::runtime_error("Corrupt trajectory chunk header");
+
+    m_payload.resize(header.payload_size);
+    if (header.payload_size > 0 &&
+        fread(&m_payload[0], header.payload_size, 1, m_file) != 1)
+        throw std::runtime_error("Truncated trajectory chunk");
+
+    if (!decodeTrajectoryChunk(m_header, header.compression, header.num_steps,
+                               m_payload.empty() ? NULL : &m_payload[0], header.payload_size,
+                               &m_records[0], m_scratch))
+        throw std::runtime_error("Corrupt trajectory chunk");
+
+    if (crc32(0L, &m_records[0], raw_size) != header.checksum)
+        throw std::runtime_error("Trajectory chunk fails its checksum");
+
+    m_num_steps = header.num_steps;
+    m_next_step = 0;
+    return true;
+}
+
+
+bool TrajectoryReader::next(TrajectoryStep &step, uInt8 *ram, uInt8 *screen) {
+    while (m_next_step == m_num_steps) {
+        if (!loadChunk())
+            return false;
+    }
+
+    const uInt8 *data = &m_records[m_next_step * m_header.record_size];
+    memcpy(&step, data, sizeof(step));
+    data += sizeof(step);
+    memcpy(ram, data, m_header.ram_size);
+    data += m_header.ram_size;
+    if (screen != NULL && (m_header.flags & TRAJECTORY_SCREENS))
+        memcpy(screen, data, m_header.width * m_header.height);
+
+    m_next_step++;
+    return true;
+}
+
+} // namespace ale
@@ -0,0 +1,286 @@
+/* *****************************************************************************
+ * Xitari
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ * *****************************************************************************
+ *  trajectory_recorder.hpp
+ *
+ *  Records steps of an environment to a chunked, zlib-compressed file, and
+ *  reads them back.
+ *
+ *  A trajectory file is a TrajectoryFileHeader followed by chunks. Each
+ *  chunk is a TrajectoryChunkHeader followed by its payload, which decodes
+ *  (or is, for TRAJECTORY_STORED chunks) to num_steps fixed-size records.
+ *  A record is a TrajectoryStep, then ram_size bytes of RAM, then, if the
+ *  file has TRAJECTORY_SCREENS set, width * height palette indices. All
+ *  numbers are in native byte order.
+ *
+ *  TRAJECTORY_ZLIB payloads are the records deflated. TRAJECTORY_DELTA
+ *  payloads, for files with screens, deflate to each step's TrajectoryStep
+ *  and RAM, then a uInt32 length and that many bytes of its screen as a
+ *  difference from the previous step's (see common/screen_delta.hpp); the
+ *  first step of a chunk is encoded against an all-zero screen, so that
+ *  chunks decode on their own. TRAJECTORY_PALETTE payloads, also for files
+ *  with screens, deflate to the chunk's palette, a uInt32 count of colours
+ *  and their palette indices, and a uInt32 code width, then each step's
+ *  TrajectoryStep and RAM followed by its screen's codes packed at that
+ *  width (see common/screen_palette.hpp).
+ *
+ *  Next to it, "<file>.idx" holds a TrajectoryIndexHeader, one
+ *  TrajectoryIndexChunk per chunk and one TrajectoryIndexEpisode per
+ *  episode, so that readers can seek straight to any step (see
+ *  trajectory_dataset.hpp).
+ **************************************************************************** */
+
+#ifndef __TRAJECTORY_RECORDER_HPP__
+#define __TRAJECTORY_RECORDER_HPP__
+
+#include <atomic>
+#include <cstdio>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common/screen_delta.hpp"
+#include "common/screen_palette.hpp"
+#include "emucore/m6502/src/bspf/src/bspf.hxx"
+
+namespace ale {
+
+static const uInt32 TRAJECTORY_MAGIC = 0x4a525458; // "XTRJ"
+static const uInt32 TRAJECTORY_CHUNK_MAGIC = 0x4b4e4843; // "CHNK"
+static const uInt32 TRAJECTORY_INDEX_MAGIC = 0x58444958; // "XIDX"
+static const uInt32 TRAJECTORY_VERSION = 1;
+
+// File flags
+static const uInt32 TRAJECTORY_SCREENS = 0x1;
+
+// Chunk compression
+static const uInt32 TRAJECTORY_STORED = 0;
+static const uInt32 TRAJECTORY_ZLIB = 1;
+static const uInt32 TRAJECTORY_DELTA = 2;   // Screen deltas, then zlib
+static const uInt32 TRAJECTORY_PALETTE = 3; // Screens as palette codes, then zlib
+
+
+struct TrajectoryFileHeader {
+    uInt32 magic;
+    uInt32 version;
+    uInt32 flags;
+    uInt32 ram_size;
+    uInt32 width;                   // Screen geometry, in pixels
+    uInt32 height;
+    uInt32 record_size;             // Bytes per step, RAM and screen included
+    uInt32 steps_per_chunk;         // Every chunk but the last holds this many
+};
+
+
+struct TrajectoryChunkHeader {
+    uInt32 magic;
+    uInt32 compression;
+    uInt32 num_steps;
+    uInt32 payload_size;            // Bytes that follow this header
+    uInt32 checksum;                // CRC-32 of the uncompressed records
+};
+
+
+struct TrajectoryIndexHeader {
+    uInt32 magic;
+    uInt32 version;
+    uInt32 num_chunks;
+    uInt32 num_episodes;
+    ::uint64_t num_steps;
+};
+
+
+struct TrajectoryIndexChunk {
+    ::uint64_t offset;              // File offset of the chunk's payload
+    ::uint64_t first_step;
+    uInt32 num_steps;
+    uInt32 compression;
+    uInt32 payload_size;
+    uInt32 checksum;
+};
+
+
+// A new episode starts wherever the episode frame number fails to grow
+struct TrajectoryIndexEpisode {
+    ::uint64_t first_step;
+    ::uint64_t num_steps;
+};
+
+
+// One step of the environment, as returned by act2()
+struct TrajectoryStep {
+    Int32 frame;                    // Frame number after the step
+    Int32 episode_frame;
+    Int32 action_a;
+    Int32 action_b;
+    double reward_a;
+    double reward_b;
+    double side_bouncing;
+    Int32 points;
+    uInt8 wall_bouncing;
+    uInt8 crash;
+    uInt8 serving;
+    uInt8 game_over;
+};
+
+
+/** The bytes per step of a file with the given flags and geometry. */
+::uint64_t trajectoryRecordSize(uInt32 flags, uInt32 ram_size, uInt32 width, uInt32 height);
+
+
+/** Whether a trajectory file header, magic and version aside, describes a
+    layout the readers can trust: chunks of at least one step, records of
+    the size the flags and geometry make, and chunks of records that fit
+    in 32 bits. */
+bool trajectoryHeaderValid(const TrajectoryFileHeader &header);
+
+
+/** Decodes a chunk of num_steps steps of a file with the given header from
+    its payload into records, which must hold steps_per_chunk records;
+    scratch is working space kept between calls. Returns false if the
+    payload is malformed. The checksum is left to the caller. */
+bool decodeTrajectoryChunk(const TrajectoryFileHeader &header, uInt32 compression,
+                           uInt32 num_steps, const uInt8 *payload, uInt32 payload_size,
+                           uInt8 *records, std::vector<uInt8> &scratch);
+
+
+// Writes a trajectory file. Steps are gathered into chunks by the caller's
+// thread; full chunks are handed through a lock-free queue to a background
+// thread that compresses and writes them, so record() never waits on I/O.
+class TrajectoryWriter {
+
+    public:
+
+        /** Creates filename and its index; throws std::runtime_error if it
+            can't. Chunks are written with compression (TRAJECTORY_DELTA
+            and TRAJECTORY_PALETTE mean TRAJECTORY_ZLIB without screens),
+            or stored where that doesn't pay. With TRAJECTORY_STORED every chunk is stored, so
+            that readers can use the records in place. */
+        TrajectoryWriter(const std::string &filename, uInt32 ram_size,
+                         uInt32 width, uInt32 height, bool screens,
+                         uInt32 steps_per_chunk = 128,
+                         uInt32 compression = TRAJECTORY_ZLIB);
+
+        /** Flushes and closes the file, if close() hasn't; write errors
+            are lost then. */
+        ~TrajectoryWriter();
+
+        /** Appends a step. screen is ignored unless screens are recorded. */
+        void record(const TrajectoryStep &step, const uInt8 *ram, const uInt8 *screen);
+
+        /** Writes out every step recorded so far, closes the file and
+            writes the index. Throws std::runtime_error if any of it
+            couldn't be written; the index is left out then. */
+        void close();
+
+        bool recordsScreens() const { return (m_header.flags & TRAJECTORY_SCREENS) != 0; }
+
+    private:
+
+        struct Chunk {
+            std::vector<uInt8> records;
+            uInt32 num_steps;
+        };
+
+        /** Hands the current chunk to the writer thread. */
+        void submit();
+        /** Writer thread body. */
+        void writeLoop();
+        void writeChunk(Chunk *chunk);
+        /** Encode chunk into m_encoded; return the size. */
+        size_t encodeDeltas(const Chunk *chunk);
+        size_t encodePalette(const Chunk *chunk);
+        /** Writes "<file>.idx"; called once the writer thread is done. */
+        void writeIndex();
+
+        /** Copying is explicitly disallowed. */
+        TrajectoryWriter(const TrajectoryWriter &);
+        TrajectoryWriter &operator=(const TrajectoryWriter &);
+
+        TrajectoryFileHeader m_header;
+        std::string m_filename;
+        uInt32 m_compression;
+        FILE *m_file;
+        Chunk *m_chunk;                 // Being filled by record()
+
+        // Index, written out on close
+        std::vector<TrajectoryIndexChunk> m_index_chunks; // Writer thread only
+        std::vector<TrajectoryIndexEpisode> m_index_episodes;
+        ::uint64_t m_num_steps;
+        ::uint64_t m_offset;            // Of the next chunk, writer thread only
+        Int32 m_last_episode_frame;
+
+        // Single-producer/single-consumer rings: full chunks go to the
+        //  writer thread, written ones come back to be reused
+        std::vector<Chunk*> m_full;
+        std::atomic<size_t> m_full_head, m_full_tail;
+        std::vector<Chunk*> m_free;
+        std::atomic<size_t> m_free_head, m_free_tail;
+
+        std::vector<uInt8> m_compressed;
+        // Writer thread only: chunks of TRAJECTORY_DELTA and
+        //  TRAJECTORY_PALETTE as they are before being deflated
+        ScreenDeltaEncoder m_delta;
+        ScreenPalette m_palette;
+        std::vector<uInt8> m_codes;
+        std::vector<uInt8> m_encoded;
+        std::string m_error;            // First write error; writer thread until joined
+        std::atomic<bool> m_closing;
+        std::thread m_thread;
+        bool m_closed;
+};
+
+
+// Reads a trajectory file back, step by step.
+class TrajectoryReader {
+
+    public:
+
+        /** Opens filename; throws std::runtime_error if it isn't a
+            trajectory file. */
+        TrajectoryReader(const std::string &filename);
+
+        ~TrajectoryReader();
+
+        const TrajectoryFileHeader &header() const { return m_header; }
+
+        /** Reads the next step into step, ram (ram_size bytes) and, if not
+            NULL and the file has screens, screen. Returns false at the end
+            of the file; throws std::runtime_error on a corrupt chunk. */
+        bool next(TrajectoryStep &step, uInt8 *ram, uInt8 *screen);
+
+    private:
+
+        /** Loads the next chunk; false at the end of the file. */
+        bool loadChunk();
+
+        /** Copying is explicitly disallowed. */
+        TrajectoryReader(const TrajectoryReader &);
+        TrajectoryReader &operator=(const TrajectoryReader &);
+
+        TrajectoryFileHeader m_header;
+        FILE *m_file;
+        std::vector<uInt8> m_records;
+        std::vector<uInt8> m_payload;
+        std::vector<uInt8> m_scratch;
+        uInt32 m_num_steps;             // In the current chunk
+        uInt32 m_next_step;
+};
+
+} // namespace ale
+
+#endif // __TRAJECTORY_RECORDER_HPP__
@@ -44,6 +44,11 @@ bool RomSettings::isLegalB(const Action& a) const {
   return a > PLAYER_A_MAX && a < PLAYER_B_MAX;
 }
 
+void RomSettings::getFeatures(ALEFeatures& features) const {
+  for (int i = 0; i < ALEFeatures::SIZE; i++)
+    features.values[i] = 0;
+}
+
 ActionVect& RomSettings::getMinimalActionSet() {
   if (actions.empty()) {
     for (int a = 0; a < PLAYER_B_MAX; a++)
@@ -65,6 +65,9 @@ struct RomSettings {
     virtual bool getCrash () const {return false;};
     virtual bool getServing () const {return false;};
     virtual int getPoints () const {return 0;};
+
+    // game state decoded from RAM after the latest frame (default: zeros)
+    virtual void getFeatures(ALEFeatures &features) const;
     // the rom-name
     virtual const char *rom() const = 0;
 
@@ -50,6 +50,7 @@ RomSettings* Pong2PlayerSettings::clone() const {
 
 /* process the latest information from ALE */
 void Pong2PlayerSettings::step(const System& system) {
+    m_features.step(system);
     crash=readRam(&system, 0x90)==0;
     if (crash) {
       m_reward = 0;
@@ -112,6 +113,12 @@ int Pong2PlayerSettings::getPoints() const {
 
     return points; 
 }
+
+void Pong2PlayerSettings::getFeatures(ALEFeatures& features) const {
+
+    features = m_features.get();
+}
+
 bool Pong2PlayerSettings::getCrash() const { 
 
     return crash; 
@@ -162,6 +169,7 @@ void Pong2PlayerSettings::reset() {
     m_score    = 0;
     m_scoreB   = 0;
     m_terminal = false;
+    m_features.reset();
 }
 
         
@@ -181,6 +189,7 @@ void Pong2PlayerSettings::loadState(Deserializer & ser) {
   m_rewardB = ser.getInt();
   m_scoreB = ser.getInt();
   m_terminal = ser.getBool();
+  m_features.reset();
 }
 
 ActionVect Pong2PlayerSettings::getStartingActions() {
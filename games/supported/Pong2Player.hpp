@@ -30,6 +30,7 @@
 #define __Pong2Player_HPP__
 
 #include "../RomSettings.hpp"
+#include "PongFeatures.hpp"
 
 namespace ale {
 
@@ -56,6 +57,7 @@ class Pong2PlayerSettings : public RomSettings {
         bool getCrash() const;
         bool getServing()const;
         int getPoints() const;
+        void getFeatures(ALEFeatures& features) const;
         // the rom-name
         const char* rom() const { return "Pong2Player"; }
 
@@ -96,6 +98,7 @@ class Pong2PlayerSettings : public RomSettings {
         int points;
         bool crash;
         bool serving;
+        PongFeatures m_features;
 };
 
 } // namespace ale
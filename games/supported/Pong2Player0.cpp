@@ -50,6 +50,7 @@ RomSettings* Pong2Player0Settings::clone() const {
 
 /* process the latest information from ALE */
 void Pong2Player0Settings::step(const System& system) {
+    m_features.step(system);
     crash=readRam(&system, 0x90)==0;
     if (crash) {
       m_reward = 0;
@@ -116,6 +117,12 @@ int Pong2Player0Settings::getPoints() const {
 
     return points; 
 }
+
+void Pong2Player0Settings::getFeatures(ALEFeatures& features) const {
+
+    features = m_features.get();
+}
+
 bool Pong2Player0Settings::getCrash() const { 
 
     return crash; 
@@ -166,6 +173,7 @@ void Pong2Player0Settings::reset() {
     m_score    = 0;
     m_scoreB   = 0;
     m_terminal = false;
+    m_features.reset();
 }
 
         
@@ -185,6 +193,7 @@ void Pong2Player0Settings::loadState(Deserializer & ser) {
   m_rewardB = ser.getInt();
   m_scoreB = ser.getInt();
   m_terminal = ser.getBool();
+  m_features.reset();
 }
 
 ActionVect Pong2Player0Settings::getStartingActions() {
@@ -30,6 +30,7 @@
 #define __Pong2Player0_HPP__
 
 #include "../RomSettings.hpp"
+#include "PongFeatures.hpp"
 
 namespace ale {
 
@@ -79,6 +80,7 @@ class Pong2Player0Settings : public RomSettings {
         double getSideBouncing() const;
         bool getWallBouncing() const;
         int getPoints() const;
+        void getFeatures(ALEFeatures& features) const;
         bool getCrash() const;
         bool getServing() const;
 
@@ -95,6 +97,7 @@ class Pong2Player0Settings : public RomSettings {
         bool crash;
         int points;
         bool serving;
+        PongFeatures m_features;
 };
 
 } // namespace ale
@@ -50,6 +50,7 @@ RomSettings* Pong2Player05pSettings::clone() const {
 
 /* process the latest information from ALE */
 void Pong2Player05pSettings::step(const System& system) {
+    m_features.step(system);
     crash=readRam(&system, 0x90)==0;
     if (crash) {
       m_reward = 0;
@@ -113,6 +114,12 @@ int Pong2Player05pSettings::getPoints() const {
 
     return points; 
 }
+
+void Pong2Player05pSettings::getFeatures(ALEFeatures& features) const {
+
+    features = m_features.get();
+}
+
 bool Pong2Player05pSettings::getCrash() const { 
 
     return crash; 
@@ -162,6 +169,7 @@ void Pong2Player05pSettings::reset() {
     m_score    = 0;
     m_scoreB   = 0;
     m_terminal = false;
+    m_features.reset();
 }
 
         
@@ -181,6 +189,7 @@ void Pong2Player05pSettings::loadState(Deserializer & ser) {
   m_rewardB = ser.getInt();
   m_scoreB = ser.getInt();
   m_terminal = ser.getBool();
+  m_features.reset();
 }
 
 ActionVect Pong2Player05pSettings::getStartingActions() {
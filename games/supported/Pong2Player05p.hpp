@@ -30,6 +30,7 @@
 #define __Pong2Player05p_HPP__
 
 #include "../RomSettings.hpp"
+#include "PongFeatures.hpp"
 
 namespace ale {
 
@@ -79,6 +80,7 @@ class Pong2Player05pSettings : public RomSettings {
         double getSideBouncing() const;
         bool getWallBouncing() const;
         int getPoints() const;
+        void getFeatures(ALEFeatures& features) const;
         bool getCrash() const;
         bool getServing() const;
     private:
@@ -93,6 +95,7 @@ class Pong2Player05pSettings : public RomSettings {
         int points;
         bool crash;
         bool serving;
+        PongFeatures m_features;
 };
 
 } // namespace ale
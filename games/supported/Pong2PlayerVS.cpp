@@ -50,6 +50,7 @@ RomSettings* Pong2PlayerVSSettings::clone() const {
 
 /* process the latest information from ALE */
 void Pong2PlayerVSSettings::step(const System& system) {
+    m_features.step(system);
     crash=readRam(&system, 0x90)==0;
     if (crash) {
       m_reward = 0;
@@ -114,6 +115,12 @@ int Pong2PlayerVSSettings::getPoints() const {
 
     return points; 
 }
+
+void Pong2PlayerVSSettings::getFeatures(ALEFeatures& features) const {
+
+    features = m_features.get();
+}
+
 bool Pong2PlayerVSSettings::getCrash() const { 
 
     return crash; 
@@ -165,6 +172,7 @@ void Pong2PlayerVSSettings::reset() {
     m_score    = 0;
     m_scoreB   = 0;
     m_terminal = false;
+    m_features.reset();
 }
 
         
@@ -184,6 +192,7 @@ void Pong2PlayerVSSettings::loadState(Deserializer & ser) {
   m_rewardB = ser.getInt();
   m_scoreB = ser.getInt();
   m_terminal = ser.getBool();
+  m_features.reset();
 }
 
 ActionVect Pong2PlayerVSSettings::getStartingActions() {
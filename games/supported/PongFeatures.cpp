@@ -0,0 +1,77 @@
+/* *****************************************************************************
+ * Xitari
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ * *****************************************************************************
+ *  PongFeatures.cpp
+ *
+ *  Decodes the game state of the 2-player Pong ROMs into ALEFeatures.
+ **************************************************************************** */
+
+#include "PongFeatures.hpp"
+#include "../RomUtils.hpp"
+
+namespace ale {
+
+
+PongFeatures::PongFeatures() :
+    m_has_previous(false) {
+
+    for (int i = 0; i < ALEFeatures::SIZE; i++)
+        m_features.values[i] = 0;
+    m_features.values[ALEFeatures::PHASE] = ALEFeatures::STOPPED;
+}
+
+
+void PongFeatures::step(const System &system) {
+    float *values = m_features.values;
+
+    bool running = readRam(&system, 0x90) != 0;
+    int left = readRam(&system, 13);    // left player score
+    int right = readRam(&system, 14);   // right player score
+    int ball_x = readRam(&system, 0xB1);
+    int ball_y = readRam(&system, 0xB6);
+
+    // The ball is out of play while serving, at y = 0
+    bool was_in_play = m_has_previous && values[ALEFeatures::PHASE] == ALEFeatures::RALLY;
+    float phase;
+    if (!running)
+        phase = ALEFeatures::STOPPED;
+    else if (left == 21 || right == 21)
+        phase = ALEFeatures::OVER;
+    else if (ball_y == 0)
+        phase = ALEFeatures::SERVING;
+    else
+        phase = ALEFeatures::RALLY;
+
+    if (was_in_play && phase == ALEFeatures::RALLY) {
+        values[ALEFeatures::BALL_DX] = ball_x - values[ALEFeatures::BALL_X];
+        values[ALEFeatures::BALL_DY] = ball_y - values[ALEFeatures::BALL_Y];
+    }
+    else {
+        values[ALEFeatures::BALL_DX] = 0;
+        values[ALEFeatures::BALL_DY] = 0;
+    }
+
+    values[ALEFeatures::BALL_X] = ball_x;
+    values[ALEFeatures::BALL_Y] = ball_y;
+    values[ALEFeatures::PADDLE_A] = readRam(&system, 0xB3);
+    values[ALEFeatures::PADDLE_B] = readRam(&system, 0xB2);
+    values[ALEFeatures::SCORE_A] = right;
+    values[ALEFeatures::SCORE_B] = left;
+    values[ALEFeatures::PHASE] = phase;
+    m_has_previous = true;
+}
+
+} // namespace ale
@@ -0,0 +1,56 @@
+/* *****************************************************************************
+ * Xitari
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ * *****************************************************************************
+ *  PongFeatures.hpp
+ *
+ *  Decodes the game state of the 2-player Pong ROMs, which all share their
+ *  RAM layout, into ALEFeatures.
+ **************************************************************************** */
+
+#ifndef __PONGFEATURES_HPP__
+#define __PONGFEATURES_HPP__
+
+#include "ale_interface.hpp"
+
+namespace ale {
+
+class System;
+
+
+class PongFeatures {
+
+    public:
+
+        PongFeatures();
+
+        /** Forgets the previous frame, after a reset or a state restore:
+            the ball doesn't move in the first frame after. */
+        void reset() { m_has_previous = false; }
+
+        /** Decodes the latest frame. */
+        void step(const System &system);
+
+        const ALEFeatures &get() const { return m_features; }
+
+    private:
+
+        ALEFeatures m_features;
+        bool m_has_previous;    // m_features holds the previous frame
+};
+
+} // namespace ale
+
+#endif // __PONGFEATURES_HPP__
@@ -28,10 +28,13 @@
  *
  * *****************************************************************************
  */
+#include <atomic>
+#include <chrono>
 #include <cstdlib>
 #include <ctime>
 #include <sstream>
 #include <memory>
+#include <thread>
 
 #include "emucore/m6502/src/bspf/src/bspf.hxx"
 #include "emucore/Console.hxx"
@@ -55,6 +58,10 @@
 #include "controllers/fifo_controller.hpp"
 #include "controllers/rlglue_controller.hpp"
 #include "controllers/internal_controller.hpp"
+#include "controllers/shm_controller.hpp"
+#include "controllers/server_controller.hpp"
+#include "controllers/dataset_controller.hpp"
+#include "controllers/replay_controller.hpp"
 #include "common/Constants.h"
 #include "ale_interface.hpp"
 
@@ -99,6 +106,22 @@ static ALEController* createController(OSystem* osystem, std::string type) {
     std::cerr << "Game will be controlled through named FIFO pipes." << std::endl;
     return new FIFOController(osystem, true);
   }
+  else if (type == "shm") {
+    std::cerr << "Game will be controlled through shared memory." << std::endl;
+    return new SHMController(osystem);
+  }
+  else if (type == "server") {
+    std::cerr << "Game will be served to clients over a socket." << std::endl;
+    return new ServerController(osystem);
+  }
+  else if (type == "dataset") {
+    std::cerr << "Game will be played by worker threads to generate a dataset." << std::endl;
+    return new DatasetController(osystem);
+  }
+  else if (type == "replay") {
+    std::cerr << "Action logs will be replayed." << std::endl;
+    return new ReplayController(osystem);
+  }
   else if (type == "rlglue") {
     std::cerr << "Game will be controlled through RL-Glue." << std::endl;
     return new RLGlueController(osystem);
@@ -114,6 +137,39 @@ static ALEController* createController(OSystem* osystem, std::string type) {
 }
 
 
+// Traces the environments to trace_file, if set, for as long as it lives.
+//  The trace is flushed every second, so that the threads' buffers don't
+//  fill up.
+class TraceSession {
+  public:
+    TraceSession(const std::string &trace_file) : m_done(false) {
+      if (trace_file.empty()) return;
+      ALEInterface::startTrace(trace_file);
+      m_flusher = std::thread(&TraceSession::flushLoop, this);
+    }
+
+    ~TraceSession() {
+      if (!m_flusher.joinable()) return;
+      m_done.store(true);
+      m_flusher.join();
+      ALEInterface::stopTrace();
+    }
+
+  private:
+    void flushLoop() {
+      int ticks = 0;
+      while (!m_done.load()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        if (++ticks % 10 == 0)
+          ALEInterface::flushTrace();
+      }
+    }
+
+    std::atomic<bool> m_done;
+    std::thread m_flusher;
+};
+
+
 /* application entry point */
 int main(int argc, char* argv[]) {
 
@@ -129,7 +185,10 @@ int main(int argc, char* argv[]) {
         std::string controller_type = theOSystem->settings().getString("game_controller");
         std::auto_ptr<ALEController> controller(createController(theOSystem, controller_type));
 
-        controller->run();
+        {
+            TraceSession trace(theOSystem->settings().getString("trace_file"));
+            controller->run();
+        }
 
         // MUST delete theOSystem to avoid a segfault (theOSystem relies on Settings
         //  still being a valid construct)